@@ -733,12 +733,16 @@ bool Sender::RequestToSendCrash(const CrashDetails& details) {
                                           &proxy_servers_);
     }
 
-    std::shared_ptr<brillo::http::Transport> transport;
-    if (proxy_servers_.empty() || proxy_servers_[0] == "direct://") {
-      transport = brillo::http::Transport::CreateDefault();
-    } else {
-      transport =
-          brillo::http::Transport::CreateDefaultWithProxy(proxy_servers_[0]);
+    // All crashes of this run are sent through the same transport, so that
+    // later uploads can skip the DNS lookup and the TCP and TLS handshakes.
+    if (!transport_) {
+      if (proxy_servers_.empty() || proxy_servers_[0] == "direct://") {
+        transport_ = brillo::http::Transport::CreateDefault();
+      } else {
+        transport_ =
+            brillo::http::Transport::CreateDefaultWithProxy(proxy_servers_[0]);
+      }
+      transport_->EnableConnectionReuse();
     }
 
     brillo::ErrorPtr upload_error;
@@ -748,8 +752,8 @@ bool Sender::RequestToSendCrash(const CrashDetails& details) {
           allow_dev_sending_ ? kReportUploadStagingUrl : kReportUploadProdUrl,
           compressed_form_data.data(), compressed_form_data.size(),
           form_data->GetContentType(),
-          {{brillo::http::request_header::kContentEncoding, "gzip"}}, transport,
-          &upload_error);
+          {{brillo::http::request_header::kContentEncoding, "gzip"}},
+          transport_, &upload_error);
     } else {
       LOG(ERROR) << "Failed compressing crash data for upload, perform the "
                  << "upload uncompressed";
@@ -763,7 +767,7 @@ bool Sender::RequestToSendCrash(const CrashDetails& details) {
       }
       response = brillo::http::PostFormDataAndBlock(
           allow_dev_sending_ ? kReportUploadStagingUrl : kReportUploadProdUrl,
-          std::move(form_data), {} /* headers */, transport, &upload_error);
+          std::move(form_data), {} /* headers */, transport_, &upload_error);
     }
 
     if (!response) {
@@ -17,6 +17,7 @@
 #include <base/time/time.h>
 #include <base/values.h>
 #include <brillo/http/http_form_data.h>
+#include <brillo/http/http_transport.h>
 #include <gtest/gtest_prod.h>  // for FRIEND_TEST
 #include <metrics/metrics_library.h>
 #include <session_manager/dbus-proxies.h>
@@ -219,6 +220,8 @@ class Sender : public SenderBase {
   std::unique_ptr<MetricsLibraryInterface> metrics_lib_;
   std::unique_ptr<org::chromium::flimflam::ManagerProxyInterface> shill_proxy_;
   std::vector<std::string> proxy_servers_;
+  // Transport used for all uploads, created on the first one.
+  std::shared_ptr<brillo::http::Transport> transport_;
   std::string form_data_boundary_;
   bool always_write_uploads_log_;
   const int max_crash_rate_;
@@ -134,6 +134,8 @@ constexpr char kCryptohomeDeprecatedApiHistogramName[] =
 
 constexpr char kAttestationStatusHistogramPrefix[] = "Hwsec.Attestation.Status";
 
+constexpr char kMountStepHistogramPrefix[] = "Cryptohome.MountStep";
+
 MetricsLibraryInterface* g_metrics = NULL;
 chromeos_metrics::TimerReporter* g_timers[cryptohome::kNumTimerTypes] = {NULL};
 
@@ -546,4 +548,15 @@ void ReportInvalidateDirCryptoKeyResult(bool result) {
   g_metrics->SendBoolToUMA(kInvalidateDirCryptoKeyResultHistogram, result);
 }
 
+void ReportMountStepTime(const std::string& step, base::TimeDelta duration) {
+  if (!g_metrics) {
+    return;
+  }
+
+  // Same scale as Cryptohome.TimeToPerformMount.
+  const std::string histogram =
+      std::string(kMountStepHistogramPrefix) + "." + step;
+  g_metrics->SendToUMA(histogram, duration.InMilliseconds(), 0, 3000, 50);
+}
+
 }  // namespace cryptohome
@@ -453,6 +453,10 @@ void ReportAttestationOpsStatus(const std::string& operation,
 // Reports the result of an InvalidateDirCryptoKey operation.
 void ReportInvalidateDirCryptoKeyResult(bool result);
 
+// Reports the time taken by one step of the mount or unmount path to the
+// "Cryptohome.MountStep.<step>" histogram. See MountStep in mount_tracer.h.
+void ReportMountStepTime(const std::string& step, base::TimeDelta duration);
+
 // Initialization helper.
 class ScopedMetricsInitializer {
  public:
@@ -6,6 +6,7 @@
 
 #include <algorithm>
 #include <deque>
+#include <limits>
 #include <memory>
 #include <string>
 #include <vector>
@@ -164,6 +165,10 @@ constexpr char kSkippedFileListFileName[] =
 // frequency.
 constexpr base::TimeDelta kStatusSignalInterval =
     base::TimeDelta::FromSeconds(1);
+// How long each number of concurrent jobs is tried for before deciding whether
+// more jobs help. Long enough to average over files of different sizes.
+constexpr base::TimeDelta kParallelismSampleInterval =
+    base::TimeDelta::FromSeconds(5);
 // {Source,Referrer}URL xattrs are from chrome downloads and are not used on
 // ChromeOS.  They may be very large though, potentially preventing the
 // migration of other attributes.
@@ -245,6 +250,15 @@ class MigrationHelper::WorkerPool {
            !should_abort_;
   }
 
+  // Limits how many job threads may process jobs at once. Threads beyond the
+  // limit wait until it's raised again.
+  // Can be called on any thread.
+  void SetMaxActiveJobs(size_t max_active_jobs) {
+    base::AutoLock lock(jobs_lock_);
+    max_active_jobs_ = std::max<size_t>(max_active_jobs, 1);
+    job_thread_wakeup_condition_.Broadcast();
+  }
+
   // Aborts job processing.
   // Can be called on any thread.
   void Abort() {
@@ -266,7 +280,9 @@ class MigrationHelper::WorkerPool {
         *result = true;
         return;
       }
-      if (!migration_helper_->ProcessJob(job)) {
+      const bool success = migration_helper_->ProcessJob(job);
+      FinishJob();
+      if (!success) {
         LOG(ERROR) << "Failed to migrate \"" << job.child.value() << "\"";
         Abort();
         *result = false;
@@ -279,8 +295,8 @@ class MigrationHelper::WorkerPool {
   // Must be called on a job thread.
   bool PopJob(Job* job) {
     base::AutoLock lock(jobs_lock_);
-    while (jobs_.empty()) {
-      if (no_more_new_jobs_)
+    while (jobs_.empty() || num_active_jobs_ >= max_active_jobs_) {
+      if (should_abort_ || (jobs_.empty() && no_more_new_jobs_))
         return false;
       job_thread_wakeup_condition_.Wait();
     }
@@ -289,11 +305,21 @@ class MigrationHelper::WorkerPool {
     }
     *job = jobs_.front();
     jobs_.pop_front();
+    ++num_active_jobs_;
     // Let the main thread feed new jobs.
     main_thread_wakeup_condition_.Signal();
     return true;
   }
 
+  // Marks a job returned by PopJob() as done.
+  // Must be called on a job thread.
+  void FinishJob() {
+    base::AutoLock lock(jobs_lock_);
+    --num_active_jobs_;
+    // Let a job thread that is waiting for its turn take the next job.
+    job_thread_wakeup_condition_.Signal();
+  }
+
   MigrationHelper* migration_helper_;
   std::vector<std::unique_ptr<base::Thread>> job_threads_;  // The job threads.
   // deque instead of vector to avoid vector<bool> specialization.
@@ -303,7 +329,11 @@ class MigrationHelper::WorkerPool {
   std::deque<Job> jobs_;  // The FIFO job list.
   bool no_more_new_jobs_ = false;
   bool should_abort_ = false;
-  // Lock for jobs_, no_more_new_jobs_, and should_abort_.
+  // Number of jobs being processed, and how many may be processed at once.
+  size_t num_active_jobs_ = 0;
+  size_t max_active_jobs_ = std::numeric_limits<size_t>::max();
+  // Lock for jobs_, no_more_new_jobs_, should_abort_, num_active_jobs_ and
+  // max_active_jobs_.
   base::Lock jobs_lock_;
   // Condition variables associated with jobs_lock_.
   base::ConditionVariable job_thread_wakeup_condition_;
@@ -406,6 +436,12 @@ bool MigrationHelper::Migrate(const ProgressCallback& progress_callback) {
     num_job_threads_ =
         std::min(static_cast<uint64_t>(base::SysInfo::NumberOfProcessors() * 2),
                  kFreeSpaceForJobThreads / kErasureBlockSize);
+    // How many of them actually run at once is picked from the throughput
+    // achieved during the migration, starting from one per CPU.
+    parallelism_tuner_ = std::make_unique<ParallelismTuner>(
+        base::SysInfo::NumberOfProcessors(), num_job_threads_,
+        kParallelismSampleInterval);
+    worker_pool_->SetMaxActiveJobs(parallelism_tuner_->parallelism());
   }
   effective_chunk_size_ =
       std::min(max_chunk_size_, kFreeSpaceForJobThreads / num_job_threads_);
@@ -443,6 +479,7 @@ bool MigrationHelper::Migrate(const ProgressCallback& progress_callback) {
             << " ms.";
   // MigrateDir() recursively traverses the directory tree on the main thread,
   // while the job threads migrate files and symlinks.
+  migration_start_time_ = base::TimeTicks::Now();
   bool success =
       worker_pool_->Start(num_job_threads_, max_job_list_size_) &&
       MigrateDir(base::FilePath(base::FilePath::kCurrentDirectory),
@@ -517,7 +554,12 @@ bool MigrationHelper::CalculateDataToMigrate(const base::FilePath& from) {
 void MigrationHelper::IncrementMigratedBytes(uint64_t bytes) {
   base::AutoLock lock(migrated_byte_count_lock_);
   migrated_byte_count_ += bytes;
-  if (next_report_ < base::TimeTicks::Now())
+  const base::TimeTicks now = base::TimeTicks::Now();
+  if (parallelism_tuner_ &&
+      parallelism_tuner_->Update(now, migrated_byte_count_)) {
+    worker_pool_->SetMaxActiveJobs(parallelism_tuner_->parallelism());
+  }
+  if (next_report_ < now)
     ReportStatus(user_data_auth::DIRCRYPTO_MIGRATION_IN_PROGRESS);
 }
 
@@ -532,9 +574,23 @@ void MigrationHelper::ReportStatus(
   progress.set_status(status);
   progress.set_current_bytes(migrated_byte_count_);
   progress.set_total_bytes(total_byte_count_);
+
+  const base::TimeTicks now = base::TimeTicks::Now();
+  const double elapsed_seconds = (now - migration_start_time_).InSecondsF();
+  if (!migration_start_time_.is_null() && elapsed_seconds > 0 &&
+      migrated_byte_count_ > 0) {
+    const double bytes_per_second = migrated_byte_count_ / elapsed_seconds;
+    const uint64_t remaining_bytes =
+        total_byte_count_ > migrated_byte_count_
+            ? total_byte_count_ - migrated_byte_count_
+            : 0;
+    progress.set_bytes_per_second(static_cast<uint64_t>(bytes_per_second));
+    progress.set_estimated_seconds_remaining(
+        static_cast<uint64_t>(remaining_bytes / bytes_per_second));
+  }
   progress_callback_.Run(progress);
 
-  next_report_ = base::TimeTicks::Now() + kStatusSignalInterval;
+  next_report_ = now + kStatusSignalInterval;
 }
 
 bool MigrationHelper::ShouldMigrateFile(const base::FilePath& child) {
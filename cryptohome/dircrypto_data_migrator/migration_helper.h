@@ -18,6 +18,7 @@
 
 #include "cryptohome/cryptohome_metrics.h"
 #include "cryptohome/dircrypto_data_migrator/atomic_flag.h"
+#include "cryptohome/dircrypto_data_migrator/parallelism_tuner.h"
 #include "cryptohome/migration_type.h"
 #include "cryptohome/platform.h"
 #include "cryptohome/UserDataAuth.pb.h"
@@ -56,6 +57,9 @@ class MigrationHelper {
   // be migrated, including what has already been migrated.  If
   // |progress.status| is not DIRCRYPTO_MIGRATION_IN_PROGRESS the two
   // aforementioned values should be ignored as they are undefined.
+  // |progress.bytes_per_second| and |progress.estimated_seconds_remaining| are
+  // derived from the average throughput since files started being migrated,
+  // and are 0 until it's known.
   using ProgressCallback = base::Callback<void(
       const user_data_auth::DircryptoMigrationProgress& progress)>;
 
@@ -81,6 +85,8 @@ class MigrationHelper {
   void set_namespaced_atime_xattr_name_for_testing(const std::string& name) {
     namespaced_atime_xattr_name_ = name;
   }
+  // Setting a number of job threads also disables tuning how many of them may
+  // migrate files at once.
   void set_num_job_threads_for_testing(size_t num_job_threads) {
     num_job_threads_ = num_job_threads;
   }
@@ -228,8 +234,13 @@ class MigrationHelper {
 
   uint64_t migrated_byte_count_;
   base::TimeTicks next_report_;
-  // Lock for migrated_byte_count_ and next_report_.
+  // Adjusts the number of jobs processed at once as |migrated_byte_count_|
+  // grows. Null if the number of job threads was fixed for testing.
+  std::unique_ptr<ParallelismTuner> parallelism_tuner_;
+  // Lock for migrated_byte_count_, next_report_ and parallelism_tuner_.
   base::Lock migrated_byte_count_lock_;
+  // Time at which job threads started migrating files.
+  base::TimeTicks migration_start_time_;
 
   std::string namespaced_mtime_xattr_name_;
   std::string namespaced_atime_xattr_name_;
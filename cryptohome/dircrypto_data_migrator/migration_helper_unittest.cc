@@ -143,6 +143,7 @@ class MigrationHelperTest : public ::testing::Test {
     migrated_values_.push_back(progress.current_bytes());
     total_values_.push_back(progress.total_bytes());
     status_values_.push_back(progress.status());
+    last_progress_ = progress;
   }
 
  protected:
@@ -152,6 +153,7 @@ class MigrationHelperTest : public ::testing::Test {
   std::vector<uint64_t> migrated_values_;
   std::vector<uint64_t> total_values_;
   std::vector<user_data_auth::DircryptoMigrationStatus> status_values_;
+  user_data_auth::DircryptoMigrationProgress last_progress_;
 };
 
 TEST_F(MigrationHelperTest, EmptyTest) {
@@ -801,6 +803,10 @@ TEST_F(MigrationHelperTest, ProgressCallback) {
     SCOPED_TRACE(i);
     EXPECT_EQ(expected_size, total_values_[i]);
   }
+
+  // The final report should include the throughput, with nothing remaining.
+  EXPECT_GT(last_progress_.bytes_per_second(), 0);
+  EXPECT_EQ(0, last_progress_.estimated_seconds_remaining());
 }
 
 TEST_F(MigrationHelperTest, NotEnoughFreeSpace) {
@@ -0,0 +1,120 @@
+// Copyright 2020 The Chromium OS Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "cryptohome/dircrypto_data_migrator/parallelism_tuner.h"
+
+#include <algorithm>
+
+#include <base/logging.h>
+
+namespace cryptohome {
+namespace dircrypto_data_migrator {
+
+constexpr double ParallelismTuner::kMinImprovement;
+constexpr int ParallelismTuner::kNumSamplesBeforeSettling;
+constexpr int ParallelismTuner::kNumSamplesBetweenProbes;
+
+ParallelismTuner::ParallelismTuner(size_t initial_parallelism,
+                                   size_t max_parallelism,
+                                   base::TimeDelta sample_interval)
+    : max_parallelism_(std::max<size_t>(max_parallelism, 1)),
+      sample_interval_(sample_interval),
+      parallelism_(std::min(std::max<size_t>(initial_parallelism, 1),
+                            max_parallelism_)),
+      settled_(max_parallelism_ == 1),
+      probing_up_(parallelism_ < max_parallelism_),
+      probe_start_parallelism_(parallelism_),
+      best_parallelism_(parallelism_) {}
+
+bool ParallelismTuner::Update(base::TimeTicks now, uint64_t total_bytes) {
+  if (sample_start_.is_null()) {
+    sample_start_ = now;
+    sample_start_bytes_ = total_bytes;
+    return false;
+  }
+  const base::TimeDelta elapsed = now - sample_start_;
+  if (elapsed < sample_interval_)
+    return false;
+
+  const double bytes_per_second =
+      (total_bytes - sample_start_bytes_) / elapsed.InSecondsF();
+  sample_start_ = now;
+  sample_start_bytes_ = total_bytes;
+
+  const size_t old_parallelism = parallelism_;
+  const bool was_settled = settled_;
+  OnSample(bytes_per_second);
+  if (parallelism_ != old_parallelism || settled_ != was_settled) {
+    LOG(INFO) << "Migrating with " << old_parallelism << " job(s) ran at "
+              << static_cast<int64_t>(bytes_per_second / 1024) << " KB/s"
+              << (settled_ ? ", settling on " : ", trying ") << parallelism_;
+  }
+  return parallelism_ != old_parallelism;
+}
+
+void ParallelismTuner::OnSample(double bytes_per_second) {
+  if (settled_) {
+    if (++num_settled_samples_ < kNumSamplesBetweenProbes)
+      return;
+    // Measure the settled parallelism again before stepping away from it.
+    best_bytes_per_second_ = bytes_per_second;
+    StartProbing();
+    return;
+  }
+
+  if (bytes_per_second >= best_bytes_per_second_ * (1 + kMinImprovement) &&
+      bytes_per_second > 0) {
+    best_bytes_per_second_ = bytes_per_second;
+    best_parallelism_ = parallelism_;
+    num_samples_without_improvement_ = 0;
+    const size_t next = Step(parallelism_, probing_up_);
+    if (next == parallelism_)
+      Settle();
+    else
+      parallelism_ = next;
+    return;
+  }
+
+  if (++num_samples_without_improvement_ < kNumSamplesBeforeSettling)
+    return;
+  num_samples_without_improvement_ = 0;
+
+  // If adding jobs didn't help at all, try removing some.
+  if (probing_up_ && best_parallelism_ == probe_start_parallelism_) {
+    probing_up_ = false;
+    const size_t next = Step(best_parallelism_, false);
+    if (next != best_parallelism_) {
+      parallelism_ = next;
+      return;
+    }
+  }
+  Settle();
+}
+
+void ParallelismTuner::StartProbing() {
+  settled_ = false;
+  num_samples_without_improvement_ = 0;
+  probe_start_parallelism_ = best_parallelism_;
+  probing_up_ = Step(best_parallelism_, true) != best_parallelism_;
+  const size_t next = Step(best_parallelism_, probing_up_);
+  if (next == best_parallelism_)
+    Settle();
+  else
+    parallelism_ = next;
+}
+
+size_t ParallelismTuner::Step(size_t parallelism, bool up) const {
+  return up ? std::min(parallelism * 2, max_parallelism_)
+            : std::max<size_t>(parallelism / 2, 1);
+}
+
+void ParallelismTuner::Settle() {
+  parallelism_ = best_parallelism_;
+  settled_ = true;
+  num_settled_samples_ = 0;
+  num_samples_without_improvement_ = 0;
+}
+
+}  // namespace dircrypto_data_migrator
+}  // namespace cryptohome
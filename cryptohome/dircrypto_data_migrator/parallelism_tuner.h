@@ -0,0 +1,96 @@
+// Copyright 2020 The Chromium OS Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef CRYPTOHOME_DIRCRYPTO_DATA_MIGRATOR_PARALLELISM_TUNER_H_
+#define CRYPTOHOME_DIRCRYPTO_DATA_MIGRATOR_PARALLELISM_TUNER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <base/macros.h>
+#include <base/time/time.h>
+
+namespace cryptohome {
+namespace dircrypto_data_migrator {
+
+// Picks how many files should be migrated at once from the throughput that is
+// actually achieved, since the best number depends on the storage device
+// rather than on the number of CPUs.
+//
+// Starting from the initial parallelism, the parallelism is doubled after
+// every sample interval for as long as that improves throughput by at least
+// kMinImprovement. If the first doubling doesn't help, halving is tried
+// instead. A step is only abandoned after kNumSamplesBeforeSettling
+// consecutive samples fail to improve on the best throughput, so that a single
+// noisy sample doesn't end the search. The best parallelism seen is then kept
+// for kNumSamplesBetweenProbes samples, after which probing starts again from
+// it, since the best parallelism changes with the files being migrated.
+class ParallelismTuner {
+ public:
+  // Minimum relative throughput gain required to keep changing parallelism.
+  static constexpr double kMinImprovement = 0.1;
+  // Number of consecutive samples without that gain before a step is given
+  // up on.
+  static constexpr int kNumSamplesBeforeSettling = 3;
+  // Number of samples to keep the chosen parallelism before probing again.
+  static constexpr int kNumSamplesBetweenProbes = 12;
+
+  // Parallelism starts at |initial_parallelism| and is chosen in
+  // [1, |max_parallelism|]. It is reconsidered every |sample_interval|.
+  ParallelismTuner(size_t initial_parallelism,
+                   size_t max_parallelism,
+                   base::TimeDelta sample_interval);
+  ~ParallelismTuner() = default;
+
+  size_t parallelism() const { return parallelism_; }
+  bool is_settled() const { return settled_; }
+
+  // Records that |total_bytes| had been migrated as of |now|. Returns true if
+  // parallelism() changed as a result.
+  bool Update(base::TimeTicks now, uint64_t total_bytes);
+
+ private:
+  // Handles a complete sample of |bytes_per_second| taken at parallelism_.
+  void OnSample(double bytes_per_second);
+
+  // Makes |best_parallelism_| the baseline and steps away from it, upwards if
+  // possible. Settles if there's nowhere to step.
+  void StartProbing();
+
+  // Returns |parallelism| stepped up or down, clamped to the allowed range.
+  size_t Step(size_t parallelism, bool up) const;
+
+  // Goes back to |best_parallelism_| and stops probing.
+  void Settle();
+
+  const size_t max_parallelism_;
+  const base::TimeDelta sample_interval_;
+
+  size_t parallelism_;
+  // True while parallelism_ is not being probed.
+  bool settled_ = false;
+  // Direction in which parallelism_ is being probed, and the parallelism the
+  // current probe started from.
+  bool probing_up_ = true;
+  size_t probe_start_parallelism_;
+  // Consecutive samples at parallelism_ that didn't improve enough.
+  int num_samples_without_improvement_ = 0;
+  // Samples taken since settling.
+  int num_settled_samples_ = 0;
+
+  // Best throughput seen during the current probe and the parallelism that
+  // achieved it.
+  double best_bytes_per_second_ = 0;
+  size_t best_parallelism_;
+
+  // Start of the current sample.
+  base::TimeTicks sample_start_;
+  uint64_t sample_start_bytes_ = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(ParallelismTuner);
+};
+
+}  // namespace dircrypto_data_migrator
+}  // namespace cryptohome
+
+#endif  // CRYPTOHOME_DIRCRYPTO_DATA_MIGRATOR_PARALLELISM_TUNER_H_
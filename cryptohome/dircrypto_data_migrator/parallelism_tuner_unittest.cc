@@ -0,0 +1,147 @@
+// Copyright 2020 The Chromium OS Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "cryptohome/dircrypto_data_migrator/parallelism_tuner.h"
+
+#include <gtest/gtest.h>
+
+namespace cryptohome {
+namespace dircrypto_data_migrator {
+
+namespace {
+constexpr base::TimeDelta kInterval = base::TimeDelta::FromSeconds(5);
+}  // namespace
+
+class ParallelismTunerTest : public ::testing::Test {
+ public:
+  ParallelismTunerTest()
+      : tuner_(kInitialParallelism, kMaxParallelism, kInterval) {}
+
+ protected:
+  static constexpr size_t kInitialParallelism = 2;
+  static constexpr size_t kMaxParallelism = 8;
+
+  // Reports |bytes_per_second| for |count| whole sample intervals and returns
+  // whether the parallelism changed on the last one.
+  bool RunSamples(int count, uint64_t bytes_per_second) {
+    bool changed = false;
+    for (int i = 0; i < count; ++i)
+      changed = RunSample(bytes_per_second);
+    return changed;
+  }
+
+  // Reports |bytes_per_second| for a whole sample interval and returns whether
+  // the parallelism changed.
+  bool RunSample(uint64_t bytes_per_second) {
+    now_ += kInterval;
+    bytes_ += bytes_per_second * kInterval.InSeconds();
+    return tuner_.Update(now_, bytes_);
+  }
+
+  ParallelismTuner tuner_;
+  base::TimeTicks now_ = base::TimeTicks() + base::TimeDelta::FromHours(1);
+  uint64_t bytes_ = 0;
+};
+
+constexpr size_t ParallelismTunerTest::kInitialParallelism;
+constexpr size_t ParallelismTunerTest::kMaxParallelism;
+
+TEST_F(ParallelismTunerTest, StartsFromInitialParallelism) {
+  EXPECT_EQ(kInitialParallelism, tuner_.parallelism());
+  EXPECT_FALSE(tuner_.is_settled());
+
+  ParallelismTuner tuner(2 * kMaxParallelism, kMaxParallelism, kInterval);
+  EXPECT_EQ(kMaxParallelism, tuner.parallelism());
+}
+
+TEST_F(ParallelismTunerTest, DoublesWhileThroughputImproves) {
+  EXPECT_FALSE(tuner_.Update(now_, bytes_));
+
+  // Samples shorter than the interval are ignored.
+  EXPECT_FALSE(tuner_.Update(now_ + kInterval / 2, 1 << 30));
+
+  EXPECT_TRUE(RunSample(10 << 20));
+  EXPECT_EQ(4u, tuner_.parallelism());
+  EXPECT_TRUE(RunSample(18 << 20));
+  EXPECT_EQ(8u, tuner_.parallelism());
+
+  // Still improving at the maximum, so it should stay there.
+  EXPECT_FALSE(RunSample(30 << 20));
+  EXPECT_EQ(8u, tuner_.parallelism());
+  EXPECT_TRUE(tuner_.is_settled());
+}
+
+TEST_F(ParallelismTunerTest, NoisySampleDoesNotSettle) {
+  tuner_.Update(now_, bytes_);
+  EXPECT_TRUE(RunSample(10 << 20));
+  EXPECT_EQ(4u, tuner_.parallelism());
+
+  // A single slow sample doesn't end the search.
+  EXPECT_FALSE(RunSample(9 << 20));
+  EXPECT_EQ(4u, tuner_.parallelism());
+  EXPECT_FALSE(tuner_.is_settled());
+
+  EXPECT_TRUE(RunSample(15 << 20));
+  EXPECT_EQ(8u, tuner_.parallelism());
+}
+
+TEST_F(ParallelismTunerTest, SettlesAfterSamplesWithoutImprovement) {
+  tuner_.Update(now_, bytes_);
+  EXPECT_TRUE(RunSample(10 << 20));
+  EXPECT_EQ(4u, tuner_.parallelism());
+
+  // Going from 2 to 4 jobs doesn't help enough, so fewer jobs are tried once
+  // enough samples agree.
+  EXPECT_FALSE(
+      RunSamples(ParallelismTuner::kNumSamplesBeforeSettling - 1, 10 << 20));
+  EXPECT_EQ(4u, tuner_.parallelism());
+  EXPECT_FALSE(tuner_.is_settled());
+  EXPECT_TRUE(RunSample(10 << 20));
+  EXPECT_EQ(1u, tuner_.parallelism());
+
+  // One job is slower, so it should go back to 2.
+  EXPECT_TRUE(RunSamples(ParallelismTuner::kNumSamplesBeforeSettling, 5 << 20));
+  EXPECT_EQ(2u, tuner_.parallelism());
+  EXPECT_TRUE(tuner_.is_settled());
+
+  EXPECT_FALSE(RunSample(100 << 20));
+  EXPECT_EQ(2u, tuner_.parallelism());
+}
+
+TEST_F(ParallelismTunerTest, ReprobesPeriodically) {
+  tuner_.Update(now_, bytes_);
+  uint64_t rate = 1 << 20;
+  while (!tuner_.is_settled()) {
+    rate *= 2;
+    RunSample(rate);
+  }
+  EXPECT_EQ(kMaxParallelism, tuner_.parallelism());
+
+  // The maximum is kept for a while, and then fewer jobs are tried.
+  EXPECT_FALSE(
+      RunSamples(ParallelismTuner::kNumSamplesBetweenProbes - 1, rate));
+  EXPECT_TRUE(tuner_.is_settled());
+  EXPECT_TRUE(RunSample(rate));
+  EXPECT_FALSE(tuner_.is_settled());
+  EXPECT_EQ(kMaxParallelism / 2, tuner_.parallelism());
+
+  // They are slower, so it should go back to the maximum.
+  EXPECT_TRUE(
+      RunSamples(ParallelismTuner::kNumSamplesBeforeSettling, rate / 2));
+  EXPECT_EQ(kMaxParallelism, tuner_.parallelism());
+  EXPECT_TRUE(tuner_.is_settled());
+}
+
+TEST_F(ParallelismTunerTest, SingleJob) {
+  ParallelismTuner tuner(1, 1, kInterval);
+  EXPECT_TRUE(tuner.is_settled());
+  EXPECT_FALSE(tuner.Update(now_, 0));
+  for (int i = 1; i <= 2 * ParallelismTuner::kNumSamplesBetweenProbes; ++i)
+    EXPECT_FALSE(tuner.Update(now_ + i * kInterval, i << 20));
+  EXPECT_EQ(1u, tuner.parallelism());
+  EXPECT_TRUE(tuner.is_settled());
+}
+
+}  // namespace dircrypto_data_migrator
+}  // namespace cryptohome
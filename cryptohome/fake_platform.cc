@@ -155,6 +155,12 @@ bool FakePlatform::WriteSecureBlobToFileAtomic(const base::FilePath& path,
                                                     mode);
 }
 
+bool FakePlatform::WriteStringToFileAtomic(const base::FilePath& path,
+                                           const std::string& str,
+                                           mode_t mode) {
+  return real_platform_.WriteStringToFileAtomic(TestFilePath(path), str, mode);
+}
+
 bool FakePlatform::WriteFileAtomicDurable(const base::FilePath& path,
                                           const brillo::Blob& blob,
                                           mode_t mode) {
@@ -85,6 +85,9 @@ class FakePlatform final : public Platform {
   bool WriteSecureBlobToFileAtomic(const base::FilePath& path,
                                    const brillo::SecureBlob& sblob,
                                    mode_t mode) override;
+  bool WriteStringToFileAtomic(const base::FilePath& path,
+                               const std::string& str,
+                               mode_t mode) override;
   bool WriteFileAtomicDurable(const base::FilePath& path,
                               const brillo::Blob& blob,
                               mode_t mode) override;
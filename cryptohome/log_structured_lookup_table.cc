@@ -0,0 +1,363 @@
+// Copyright 2020 The Chromium OS Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "cryptohome/log_structured_lookup_table.h"
+
+#include <string.h>
+
+#include <memory>
+#include <utility>
+
+#include <base/files/file_util.h>
+#include <base/logging.h>
+#include <base/strings/string_number_conversions.h>
+#include <brillo/secure_blob.h>
+
+#include "cryptohome/crc32.h"
+
+namespace {
+
+// Name of the log inside the table directory, and of the file a compacted log
+// is written to before it replaces the log.
+constexpr char kLogFileName[] = "table.log";
+constexpr char kNewLogExtension[] = "new";
+
+// Written at the start of the log.
+constexpr char kLogMagic[] = "CrPLTLog";
+constexpr size_t kLogMagicSize = sizeof(kLogMagic) - 1;
+
+// Record types.
+constexpr uint8_t kRecordStore = 1;
+constexpr uint8_t kRecordRemove = 2;
+
+// Each record is a header of:
+//   uint32_t payload_size;
+//   uint32_t payload_crc32;
+// followed by a payload of:
+//   uint8_t type;
+//   uint64_t key;
+//   uint8_t value[];
+// with integers in host byte order.
+constexpr size_t kRecordHeaderSize = 2 * sizeof(uint32_t);
+constexpr size_t kPayloadPrefixSize = sizeof(uint8_t) + sizeof(uint64_t);
+
+// Logs are not compacted until they're at least this large.
+constexpr int64_t kMinCompactionSize = 64 * 1024;
+
+std::vector<uint8_t> SerializeRecord(uint8_t type,
+                                     uint64_t key,
+                                     const std::vector<uint8_t>& value) {
+  const uint32_t payload_size = kPayloadPrefixSize + value.size();
+  std::vector<uint8_t> record(kRecordHeaderSize + payload_size);
+  uint8_t* payload = record.data() + kRecordHeaderSize;
+  payload[0] = type;
+  memcpy(payload + sizeof(type), &key, sizeof(key));
+  if (!value.empty())
+    memcpy(payload + kPayloadPrefixSize, value.data(), value.size());
+
+  const uint32_t crc = cryptohome::Crc32(payload, payload_size);
+  memcpy(record.data(), &payload_size, sizeof(payload_size));
+  memcpy(record.data() + sizeof(payload_size), &crc, sizeof(crc));
+  return record;
+}
+
+}  // namespace
+
+namespace cryptohome {
+
+LogStructuredLookupTable::LogStructuredLookupTable(Platform* platform,
+                                                   base::FilePath basedir)
+    : platform_(platform),
+      table_dir_(basedir),
+      log_path_(basedir.Append(kLogFileName)) {
+  CHECK(platform_);
+}
+
+LogStructuredLookupTable::~LogStructuredLookupTable() = default;
+
+bool LogStructuredLookupTable::InitOnBoot() {
+  if (!platform_->DirectoryExists(table_dir_) &&
+      !platform_->CreateDirectory(table_dir_)) {
+    PLOG(ERROR) << "Failed to create dir: " << table_dir_.value();
+    return false;
+  }
+
+  // A compaction was interrupted before it replaced the log.
+  platform_->DeleteFile(log_path_.AddExtension(kNewLogExtension), false);
+
+  if (platform_->FileExists(log_path_)) {
+    if (!LoadLog())
+      return false;
+  } else if (!ImportLegacyTable()) {
+    return false;
+  }
+  DeleteLegacyTable();
+  return true;
+}
+
+PLTError LogStructuredLookupTable::GetValue(const uint64_t key,
+                                            std::vector<uint8_t>* value) {
+  auto it = index_.find(key);
+  if (it == index_.end()) {
+    VLOG(1) << "No entry exists for this key: " << key;
+    return PLT_KEY_NOT_FOUND;
+  }
+
+  std::vector<uint8_t> buf(it->second.size);
+  if (log_file_.Read(it->second.offset, reinterpret_cast<char*>(buf.data()),
+                     buf.size()) != static_cast<int>(buf.size())) {
+    PLOG(ERROR) << "Failed to read value for key " << key;
+    return PLT_STORAGE_ERROR;
+  }
+  *value = std::move(buf);
+  return PLT_SUCCESS;
+}
+
+PLTError LogStructuredLookupTable::StoreValue(
+    const uint64_t key, const std::vector<uint8_t>& new_val) {
+  // PersistentLookupTable reads an empty value back as a deleted key, so do
+  // the same.
+  if (new_val.empty())
+    return RemoveKey(key);
+  return AppendRecord(kRecordStore, key, new_val);
+}
+
+PLTError LogStructuredLookupTable::RemoveKey(const uint64_t key) {
+  if (!KeyExists(key))
+    return PLT_SUCCESS;
+  return AppendRecord(kRecordRemove, key, std::vector<uint8_t>());
+}
+
+bool LogStructuredLookupTable::KeyExists(const uint64_t key) {
+  return index_.count(key) != 0;
+}
+
+void LogStructuredLookupTable::GetUsedKeys(std::vector<uint64_t>* key_list) {
+  for (const auto& entry : index_)
+    key_list->push_back(entry.first);
+}
+
+bool LogStructuredLookupTable::LoadLog() {
+  brillo::Blob log;
+  if (!platform_->ReadFile(log_path_, &log)) {
+    LOG(ERROR) << "Failed to read " << log_path_.value();
+    return false;
+  }
+  if (log.size() < kLogMagicSize ||
+      memcmp(log.data(), kLogMagic, kLogMagicSize) != 0) {
+    LOG(ERROR) << "Bad header in " << log_path_.value();
+    return false;
+  }
+
+  index_.clear();
+  live_bytes_ = 0;
+  size_t pos = kLogMagicSize;
+  while (pos + kRecordHeaderSize <= log.size()) {
+    uint32_t payload_size, crc;
+    memcpy(&payload_size, log.data() + pos, sizeof(payload_size));
+    memcpy(&crc, log.data() + pos + sizeof(payload_size), sizeof(crc));
+    const uint8_t* payload = log.data() + pos + kRecordHeaderSize;
+    // A record that runs past the end of the log was torn while it was
+    // appended.
+    if (payload_size > log.size() - pos - kRecordHeaderSize)
+      break;
+    const int64_t record_size = kRecordHeaderSize + payload_size;
+    if (payload_size < kPayloadPrefixSize ||
+        Crc32(payload, payload_size) != crc) {
+      // Only the last record can have been torn, since every record is
+      // synced before the next one is appended. A bad record followed by
+      // others is corruption, and dropping everything after it would lose
+      // good records, so leave the log alone.
+      if (pos + record_size == log.size())
+        break;
+      LOG(ERROR) << "Corrupt record at offset " << pos << " of "
+                 << log_path_.value();
+      return false;
+    }
+
+    const uint8_t type = payload[0];
+    if (type != kRecordStore && type != kRecordRemove) {
+      LOG(WARNING) << "Ignoring record of unknown type "
+                   << static_cast<int>(type);
+      pos += record_size;
+      continue;
+    }
+
+    uint64_t key;
+    memcpy(&key, payload + sizeof(type), sizeof(key));
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+      live_bytes_ -= kRecordHeaderSize + kPayloadPrefixSize + it->second.size;
+      index_.erase(it);
+    }
+    if (type == kRecordStore) {
+      index_[key] = {
+          static_cast<int64_t>(pos + kRecordHeaderSize + kPayloadPrefixSize),
+          static_cast<uint32_t>(payload_size - kPayloadPrefixSize)};
+      live_bytes_ += record_size;
+    }
+    pos += record_size;
+  }
+
+  platform_->InitializeFile(&log_file_, log_path_,
+                            base::File::FLAG_OPEN | base::File::FLAG_READ |
+                                base::File::FLAG_WRITE);
+  if (!log_file_.IsValid()) {
+    LOG(ERROR) << "Failed to open " << log_path_.value() << ": "
+               << base::File::ErrorToString(log_file_.error_details());
+    return false;
+  }
+  if (pos < log.size()) {
+    LOG(WARNING) << "Discarding " << log.size() - pos
+                 << " bytes of torn records at the end of "
+                 << log_path_.value();
+    if (!log_file_.SetLength(pos) || !log_file_.Flush()) {
+      PLOG(ERROR) << "Failed to truncate " << log_path_.value();
+      return false;
+    }
+  }
+  log_size_ = pos;
+  return true;
+}
+
+bool LogStructuredLookupTable::RewriteLog(
+    const std::map<uint64_t, std::vector<uint8_t>>& values) {
+  const base::FilePath new_path = log_path_.AddExtension(kNewLogExtension);
+  base::File new_file;
+  platform_->InitializeFile(&new_file, new_path,
+                            base::File::FLAG_CREATE_ALWAYS |
+                                base::File::FLAG_READ |
+                                base::File::FLAG_WRITE);
+  if (!new_file.IsValid()) {
+    LOG(ERROR) << "Failed to create " << new_path.value() << ": "
+               << base::File::ErrorToString(new_file.error_details());
+    return false;
+  }
+
+  std::vector<uint8_t> contents(kLogMagic, kLogMagic + kLogMagicSize);
+  std::map<uint64_t, ValueLocation> index;
+  for (const auto& entry : values) {
+    std::vector<uint8_t> record =
+        SerializeRecord(kRecordStore, entry.first, entry.second);
+    index[entry.first] = {static_cast<int64_t>(contents.size() +
+                                               kRecordHeaderSize +
+                                               kPayloadPrefixSize),
+                          static_cast<uint32_t>(entry.second.size())};
+    contents.insert(contents.end(), record.begin(), record.end());
+  }
+
+  if (new_file.Write(0, reinterpret_cast<const char*>(contents.data()),
+                     contents.size()) != static_cast<int>(contents.size()) ||
+      !new_file.Flush()) {
+    PLOG(ERROR) << "Failed to write " << new_path.value();
+    platform_->DeleteFile(new_path, false);
+    return false;
+  }
+  if (!platform_->Rename(new_path, log_path_) ||
+      !platform_->SyncDirectory(table_dir_)) {
+    PLOG(ERROR) << "Failed to replace " << log_path_.value();
+    platform_->DeleteFile(new_path, false);
+    return false;
+  }
+
+  log_file_ = std::move(new_file);
+  log_size_ = contents.size();
+  live_bytes_ = contents.size() - kLogMagicSize;
+  index_ = std::move(index);
+  return true;
+}
+
+bool LogStructuredLookupTable::ImportLegacyTable() {
+  // PersistentLookupTable::InitOnBoot() also drops stale value versions.
+  PersistentLookupTable legacy_table(platform_, table_dir_);
+  if (!legacy_table.InitOnBoot())
+    return false;
+
+  std::vector<uint64_t> keys;
+  legacy_table.GetUsedKeys(&keys);
+  std::map<uint64_t, std::vector<uint8_t>> values;
+  for (uint64_t key : keys) {
+    std::vector<uint8_t> value;
+    switch (legacy_table.GetValue(key, &value)) {
+      case PLT_SUCCESS:
+        values[key] = std::move(value);
+        break;
+      case PLT_KEY_NOT_FOUND:
+        break;
+      case PLT_STORAGE_ERROR:
+        // Leave the old table alone so that nothing is lost.
+        return false;
+    }
+  }
+  if (!values.empty())
+    LOG(INFO) << "Importing " << values.size() << " keys into new log";
+  return RewriteLog(values);
+}
+
+void LogStructuredLookupTable::DeleteLegacyTable() {
+  std::unique_ptr<FileEnumerator> enumerator(platform_->GetFileEnumerator(
+      table_dir_, false /* recursive */, base::FileEnumerator::DIRECTORIES));
+  for (base::FilePath dir = enumerator->Next(); !dir.empty();
+       dir = enumerator->Next()) {
+    uint64_t key;
+    if (!base::StringToUint64(dir.BaseName().value(), &key))
+      continue;
+    if (!platform_->DeleteFile(dir, true /* recursive */))
+      LOG(WARNING) << "Failed to delete dir: " << dir.value();
+  }
+}
+
+PLTError LogStructuredLookupTable::AppendRecord(
+    uint8_t type, uint64_t key, const std::vector<uint8_t>& value) {
+  if (!log_file_.IsValid()) {
+    LOG(ERROR) << "Lookup table log is not open";
+    return PLT_STORAGE_ERROR;
+  }
+
+  const std::vector<uint8_t> record = SerializeRecord(type, key, value);
+  if (log_file_.Write(log_size_, reinterpret_cast<const char*>(record.data()),
+                      record.size()) != static_cast<int>(record.size()) ||
+      !log_file_.Flush()) {
+    PLOG(ERROR) << "Failed to append to " << log_path_.value();
+    // Drop whatever part of the record made it to the file.
+    log_file_.SetLength(log_size_);
+    return PLT_STORAGE_ERROR;
+  }
+
+  auto it = index_.find(key);
+  if (it != index_.end()) {
+    live_bytes_ -= kRecordHeaderSize + kPayloadPrefixSize + it->second.size;
+    index_.erase(it);
+  }
+  if (type == kRecordStore) {
+    index_[key] = {
+        static_cast<int64_t>(log_size_ + kRecordHeaderSize +
+                             kPayloadPrefixSize),
+        static_cast<uint32_t>(value.size())};
+    live_bytes_ += record.size();
+  }
+  log_size_ += record.size();
+
+  MaybeCompact();
+  return PLT_SUCCESS;
+}
+
+void LogStructuredLookupTable::MaybeCompact() {
+  if (log_size_ < kMinCompactionSize ||
+      log_size_ < 2 * (live_bytes_ + static_cast<int64_t>(kLogMagicSize))) {
+    return;
+  }
+
+  std::map<uint64_t, std::vector<uint8_t>> values;
+  for (const auto& entry : index_) {
+    if (GetValue(entry.first, &values[entry.first]) != PLT_SUCCESS)
+      return;
+  }
+  // The update that triggered compaction is already durable in the current
+  // log, so failing to compact isn't an error.
+  if (!RewriteLog(values))
+    LOG(WARNING) << "Failed to compact " << log_path_.value();
+}
+
+}  // namespace cryptohome
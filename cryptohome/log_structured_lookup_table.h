@@ -0,0 +1,107 @@
+// Copyright 2020 The Chromium OS Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef CRYPTOHOME_LOG_STRUCTURED_LOOKUP_TABLE_H_
+#define CRYPTOHOME_LOG_STRUCTURED_LOOKUP_TABLE_H_
+
+#include <map>
+#include <vector>
+
+#include <base/files/file.h>
+#include <base/files/file_path.h>
+#include <base/macros.h>
+
+#include "cryptohome/persistent_lookup_table.h"
+#include "cryptohome/platform.h"
+
+namespace cryptohome {
+
+// An alternative to PersistentLookupTable with the same interface, which keeps
+// the whole table in a single append-only log file instead of a directory per
+// key and a file per value version.
+//
+// Every StoreValue() and RemoveKey() appends one checksummed record to the log
+// and fdatasync()s it, so an update costs one write and one sync regardless of
+// the size of the table. The log is only read in full by InitOnBoot(), which
+// rebuilds an in-memory index from key to the location of its latest value.
+// If the last record was torn by a crash, it fails its checksum and the log is
+// truncated back to the end of the previous record. A bad record anywhere else
+// is corruption rather than a torn write, and fails InitOnBoot().
+//
+// Once the log holds more than twice as many bytes as the live records, it is
+// compacted by writing the live records to a new file which atomically
+// replaces the log. A crash during compaction leaves the old log in place.
+//
+// If InitOnBoot() finds a table written by PersistentLookupTable in the same
+// directory and no log, the table is imported into a new log and the old key
+// directories are deleted.
+class LogStructuredLookupTable {
+ public:
+  LogStructuredLookupTable(Platform* platform, base::FilePath basedir);
+  ~LogStructuredLookupTable();
+
+  // See PersistentLookupTable. Must be called before any other method.
+  bool InitOnBoot();
+
+  PLTError GetValue(const uint64_t key, std::vector<uint8_t>* value);
+  // Storing an empty value removes |key|.
+  PLTError StoreValue(const uint64_t key, const std::vector<uint8_t>& new_val);
+  PLTError RemoveKey(const uint64_t key);
+  bool KeyExists(const uint64_t key);
+  void GetUsedKeys(std::vector<uint64_t>* key_list);
+
+ private:
+  friend class LogStructuredLookupTableTest;
+
+  // Location of a value in the log.
+  struct ValueLocation {
+    int64_t offset;
+    uint32_t size;
+  };
+
+  // Reads |log_path_|, populating |index_|, and truncates any torn record at
+  // its end. Records of unknown type are skipped. Returns false if the log
+  // can't be read, doesn't have the expected header, or has a corrupt record
+  // before its last one.
+  bool LoadLog();
+
+  // Writes |values| as a new log, replacing |log_path_| and reopening
+  // |log_file_| on success.
+  bool RewriteLog(const std::map<uint64_t, std::vector<uint8_t>>& values);
+
+  // Moves the values of a table written by PersistentLookupTable in
+  // |table_dir_| into a new log. Does nothing if there are none.
+  bool ImportLegacyTable();
+
+  // Deletes the key directories of a table written by PersistentLookupTable.
+  void DeleteLegacyTable();
+
+  // Appends a record to the log and syncs it.
+  PLTError AppendRecord(uint8_t type,
+                        uint64_t key,
+                        const std::vector<uint8_t>& value);
+
+  // Compacts the log if enough of it is taken by stale records.
+  void MaybeCompact();
+
+  Platform* platform_;
+
+  base::FilePath table_dir_;
+  base::FilePath log_path_;
+
+  // The log, opened for reading and writing.
+  base::File log_file_;
+  int64_t log_size_ = 0;
+
+  // Total size of the records that |index_| points into, including their
+  // headers.
+  int64_t live_bytes_ = 0;
+
+  std::map<uint64_t, ValueLocation> index_;
+
+  DISALLOW_COPY_AND_ASSIGN(LogStructuredLookupTable);
+};
+
+}  // namespace cryptohome
+
+#endif  // CRYPTOHOME_LOG_STRUCTURED_LOOKUP_TABLE_H_
@@ -0,0 +1,284 @@
+// Copyright 2020 The Chromium OS Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Unit tests for LogStructuredLookupTable.
+
+#include <string.h>
+#include <unistd.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <base/files/file_util.h>
+#include <base/files/scoped_temp_dir.h>
+#include <base/logging.h>
+#include <base/time/time.h>
+#include <gtest/gtest.h>
+
+#include "cryptohome/crc32.h"
+#include "cryptohome/log_structured_lookup_table.h"
+#include "cryptohome/persistent_lookup_table.h"
+
+namespace cryptohome {
+
+namespace {
+
+const uint64_t kKey1 = 123456;
+const uint64_t kKey2 = 0;
+const std::vector<uint8_t> kValue1_1 = {{0x34, 0x32, 0x31}};
+const std::vector<uint8_t> kValue1_2 = {{0xDE, 0xAD, 0xBE, 0xEF}};
+const std::vector<uint8_t> kValue2_1 = {{0x97, 0x98, 0x99}};
+
+// Size of the values stored by the benchmark, close to that of a serialized
+// sign-in hash tree leaf.
+constexpr size_t kBenchmarkValueSize = 400;
+
+// Fills a table of |num_keys| keys, then updates each key once, and logs how
+// long the updates and reloading the table took.
+template <typename Table>
+void RunBenchmark(const char* name, size_t num_keys) {
+  base::ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  Platform platform;
+  std::vector<uint8_t> value(kBenchmarkValueSize, 0xAB);
+  {
+    Table table(&platform, temp_dir.GetPath());
+    ASSERT_TRUE(table.InitOnBoot());
+    for (uint64_t key = 0; key < num_keys; ++key)
+      ASSERT_EQ(PLT_SUCCESS, table.StoreValue(key, value));
+
+    value[0] = 0xCD;
+    const base::TimeTicks start = base::TimeTicks::Now();
+    for (uint64_t key = 0; key < num_keys; ++key)
+      ASSERT_EQ(PLT_SUCCESS, table.StoreValue(key, value));
+    LOG(INFO) << name << " with " << num_keys << " keys: "
+              << (base::TimeTicks::Now() - start).InMicroseconds() / num_keys
+              << " us per update";
+  }
+
+  Table table(&platform, temp_dir.GetPath());
+  const base::TimeTicks start = base::TimeTicks::Now();
+  ASSERT_TRUE(table.InitOnBoot());
+  LOG(INFO) << name << " with " << num_keys << " keys: InitOnBoot took "
+            << (base::TimeTicks::Now() - start).InMilliseconds() << " ms";
+  std::vector<uint8_t> result;
+  ASSERT_EQ(PLT_SUCCESS, table.GetValue(num_keys - 1, &result));
+  EXPECT_EQ(value, result);
+}
+
+}  // namespace
+
+class LogStructuredLookupTableTest : public ::testing::Test {
+ public:
+  void SetUp() override { ASSERT_TRUE(temp_dir_.CreateUniqueTempDir()); }
+
+ protected:
+  std::unique_ptr<LogStructuredLookupTable> CreateTable() {
+    auto table = std::make_unique<LogStructuredLookupTable>(
+        &platform_, temp_dir_.GetPath());
+    EXPECT_TRUE(table->InitOnBoot());
+    return table;
+  }
+
+  base::FilePath GetLogPath(const LogStructuredLookupTable& table) const {
+    return table.log_path_;
+  }
+
+  // Appends a well-formed record of any |type| to the log at |log_path|, as
+  // a newer version of the table might.
+  void AppendRawRecord(const base::FilePath& log_path,
+                       uint8_t type,
+                       uint64_t key,
+                       const std::vector<uint8_t>& value) {
+    std::vector<uint8_t> payload(sizeof(type) + sizeof(key));
+    payload[0] = type;
+    memcpy(payload.data() + sizeof(type), &key, sizeof(key));
+    payload.insert(payload.end(), value.begin(), value.end());
+    const uint32_t payload_size = payload.size();
+    const uint32_t crc = Crc32(payload.data(), payload_size);
+    std::vector<uint8_t> record(sizeof(payload_size) + sizeof(crc));
+    memcpy(record.data(), &payload_size, sizeof(payload_size));
+    memcpy(record.data() + sizeof(payload_size), &crc, sizeof(crc));
+    record.insert(record.end(), payload.begin(), payload.end());
+    ASSERT_TRUE(base::AppendToFile(
+        log_path, reinterpret_cast<const char*>(record.data()), record.size()));
+  }
+
+  Platform platform_;
+  base::ScopedTempDir temp_dir_;
+};
+
+// Check basic Store, Get and Remove operations, and that they're persisted.
+TEST_F(LogStructuredLookupTableTest, StoreRemoveAndRestore) {
+  std::unique_ptr<LogStructuredLookupTable> table = CreateTable();
+  std::vector<uint8_t> result;
+  EXPECT_EQ(PLT_KEY_NOT_FOUND, table->GetValue(kKey1, &result));
+
+  ASSERT_EQ(PLT_SUCCESS, table->StoreValue(kKey1, kValue1_1));
+  ASSERT_EQ(PLT_SUCCESS, table->StoreValue(kKey2, kValue2_1));
+  ASSERT_EQ(PLT_SUCCESS, table->StoreValue(kKey1, kValue1_2));
+  EXPECT_EQ(PLT_SUCCESS, table->GetValue(kKey1, &result));
+  EXPECT_EQ(kValue1_2, result);
+
+  ASSERT_EQ(PLT_SUCCESS, table->RemoveKey(kKey2));
+  EXPECT_FALSE(table->KeyExists(kKey2));
+  EXPECT_EQ(PLT_SUCCESS, table->RemoveKey(kKey2));
+
+  table = CreateTable();
+  EXPECT_EQ(PLT_SUCCESS, table->GetValue(kKey1, &result));
+  EXPECT_EQ(kValue1_2, result);
+  EXPECT_EQ(PLT_KEY_NOT_FOUND, table->GetValue(kKey2, &result));
+  std::vector<uint64_t> keys;
+  table->GetUsedKeys(&keys);
+  EXPECT_EQ(std::vector<uint64_t>({kKey1}), keys);
+}
+
+// Storing an empty value should remove the key, as in PersistentLookupTable.
+TEST_F(LogStructuredLookupTableTest, StoreEmptyValue) {
+  std::unique_ptr<LogStructuredLookupTable> table = CreateTable();
+  ASSERT_EQ(PLT_SUCCESS, table->StoreValue(kKey1, kValue1_1));
+  ASSERT_EQ(PLT_SUCCESS, table->StoreValue(kKey1, std::vector<uint8_t>()));
+  EXPECT_FALSE(table->KeyExists(kKey1));
+  ASSERT_EQ(PLT_SUCCESS, table->StoreValue(kKey2, std::vector<uint8_t>()));
+  EXPECT_FALSE(table->KeyExists(kKey2));
+
+  table = CreateTable();
+  std::vector<uint8_t> result;
+  EXPECT_EQ(PLT_KEY_NOT_FOUND, table->GetValue(kKey1, &result));
+  EXPECT_EQ(PLT_KEY_NOT_FOUND, table->GetValue(kKey2, &result));
+}
+
+// A record torn by a crash while it was appended should be dropped.
+TEST_F(LogStructuredLookupTableTest, DiscardTornRecord) {
+  std::unique_ptr<LogStructuredLookupTable> table = CreateTable();
+  ASSERT_EQ(PLT_SUCCESS, table->StoreValue(kKey1, kValue1_1));
+  const base::FilePath log_path = GetLogPath(*table);
+  int64_t good_size = 0;
+  ASSERT_TRUE(base::GetFileSize(log_path, &good_size));
+
+  ASSERT_EQ(PLT_SUCCESS, table->StoreValue(kKey1, kValue1_2));
+  int64_t full_size = 0;
+  ASSERT_TRUE(base::GetFileSize(log_path, &full_size));
+  table.reset();
+  ASSERT_EQ(0, truncate(log_path.value().c_str(), full_size - 2));
+
+  table = CreateTable();
+  std::vector<uint8_t> result;
+  EXPECT_EQ(PLT_SUCCESS, table->GetValue(kKey1, &result));
+  EXPECT_EQ(kValue1_1, result);
+  int64_t size = 0;
+  ASSERT_TRUE(base::GetFileSize(log_path, &size));
+  EXPECT_EQ(good_size, size);
+
+  // New records should be appended after the last good one.
+  ASSERT_EQ(PLT_SUCCESS, table->StoreValue(kKey2, kValue2_1));
+  table = CreateTable();
+  EXPECT_EQ(PLT_SUCCESS, table->GetValue(kKey2, &result));
+  EXPECT_EQ(kValue2_1, result);
+}
+
+// A corrupt record followed by good ones isn't a torn write, so the table
+// should refuse to load rather than truncate the good records.
+TEST_F(LogStructuredLookupTableTest, CorruptRecordInMiddle) {
+  std::unique_ptr<LogStructuredLookupTable> table = CreateTable();
+  ASSERT_EQ(PLT_SUCCESS, table->StoreValue(kKey1, kValue1_1));
+  int64_t first_size = 0;
+  const base::FilePath log_path = GetLogPath(*table);
+  ASSERT_TRUE(base::GetFileSize(log_path, &first_size));
+  ASSERT_EQ(PLT_SUCCESS, table->StoreValue(kKey2, kValue2_1));
+  table.reset();
+
+  // Flip the last byte of the first record's value.
+  std::string contents;
+  ASSERT_TRUE(base::ReadFileToString(log_path, &contents));
+  contents[first_size - 1] ^= 0xFF;
+  ASSERT_EQ(static_cast<int>(contents.size()),
+            base::WriteFile(log_path, contents.data(), contents.size()));
+
+  table = std::make_unique<LogStructuredLookupTable>(&platform_,
+                                                     temp_dir_.GetPath());
+  EXPECT_FALSE(table->InitOnBoot());
+  int64_t size = 0;
+  ASSERT_TRUE(base::GetFileSize(log_path, &size));
+  EXPECT_EQ(static_cast<int64_t>(contents.size()), size);
+}
+
+// Records of a type this version doesn't know should be skipped without
+// affecting the keys they name.
+TEST_F(LogStructuredLookupTableTest, SkipUnknownRecordType) {
+  std::unique_ptr<LogStructuredLookupTable> table = CreateTable();
+  ASSERT_EQ(PLT_SUCCESS, table->StoreValue(kKey1, kValue1_1));
+  const base::FilePath log_path = GetLogPath(*table);
+  table.reset();
+  AppendRawRecord(log_path, 0x7F, kKey1, kValue1_2);
+  AppendRawRecord(log_path, 0x7F, kKey2, kValue2_1);
+
+  table = CreateTable();
+  std::vector<uint8_t> result;
+  EXPECT_EQ(PLT_SUCCESS, table->GetValue(kKey1, &result));
+  EXPECT_EQ(kValue1_1, result);
+  EXPECT_FALSE(table->KeyExists(kKey2));
+
+  // Records appended after the unknown ones are still read back.
+  ASSERT_EQ(PLT_SUCCESS, table->StoreValue(kKey2, kValue2_1));
+  table = CreateTable();
+  EXPECT_EQ(PLT_SUCCESS, table->GetValue(kKey2, &result));
+  EXPECT_EQ(kValue2_1, result);
+}
+
+// Overwriting the same key shouldn't grow the log without bound.
+TEST_F(LogStructuredLookupTableTest, Compaction) {
+  std::unique_ptr<LogStructuredLookupTable> table = CreateTable();
+  std::vector<uint8_t> value(1024);
+  for (int i = 0; i < 1000; ++i) {
+    value[0] = i % 256;
+    ASSERT_EQ(PLT_SUCCESS, table->StoreValue(kKey1, value));
+  }
+  ASSERT_EQ(PLT_SUCCESS, table->StoreValue(kKey2, kValue2_1));
+
+  int64_t size = 0;
+  ASSERT_TRUE(base::GetFileSize(GetLogPath(*table), &size));
+  EXPECT_LT(size, 128 * 1024);
+
+  table = CreateTable();
+  std::vector<uint8_t> result;
+  EXPECT_EQ(PLT_SUCCESS, table->GetValue(kKey1, &result));
+  EXPECT_EQ(value, result);
+  EXPECT_EQ(PLT_SUCCESS, table->GetValue(kKey2, &result));
+  EXPECT_EQ(kValue2_1, result);
+}
+
+// A table written by PersistentLookupTable should be moved into the log.
+TEST_F(LogStructuredLookupTableTest, ImportLegacyTable) {
+  {
+    PersistentLookupTable legacy_table(&platform_, temp_dir_.GetPath());
+    ASSERT_TRUE(legacy_table.InitOnBoot());
+    ASSERT_EQ(PLT_SUCCESS, legacy_table.StoreValue(kKey1, kValue1_1));
+    ASSERT_EQ(PLT_SUCCESS, legacy_table.StoreValue(kKey1, kValue1_2));
+    ASSERT_EQ(PLT_SUCCESS, legacy_table.StoreValue(kKey2, kValue2_1));
+  }
+
+  std::unique_ptr<LogStructuredLookupTable> table = CreateTable();
+  std::vector<uint8_t> result;
+  EXPECT_EQ(PLT_SUCCESS, table->GetValue(kKey1, &result));
+  EXPECT_EQ(kValue1_2, result);
+  EXPECT_EQ(PLT_SUCCESS, table->GetValue(kKey2, &result));
+  EXPECT_EQ(kValue2_1, result);
+  EXPECT_FALSE(
+      base::PathExists(temp_dir_.GetPath().Append(std::to_string(kKey1))));
+}
+
+// Compares InitOnBoot() time and update latency with PersistentLookupTable.
+// This syncs every update, so it is only run on request with
+// --gtest_also_run_disabled_tests.
+TEST_F(LogStructuredLookupTableTest, DISABLED_Benchmark) {
+  for (size_t num_keys : {1000, 10000}) {
+    RunBenchmark<PersistentLookupTable>("PersistentLookupTable", num_keys);
+    RunBenchmark<LogStructuredLookupTable>("LogStructuredLookupTable",
+                                           num_keys);
+  }
+}
+
+}  // namespace cryptohome
@@ -67,6 +67,9 @@ MockPlatform::MockPlatform()
   ON_CALL(*this, WriteSecureBlobToFileAtomic(_, _, _))
       .WillByDefault(Invoke(fake_platform_.get(),
                             &FakePlatform::WriteSecureBlobToFileAtomic));
+  ON_CALL(*this, WriteStringToFileAtomic(_, _, _))
+      .WillByDefault(
+          Invoke(fake_platform_.get(), &FakePlatform::WriteStringToFileAtomic));
   ON_CALL(*this, WriteFileAtomicDurable(_, _, _))
       .WillByDefault(
           Invoke(fake_platform_.get(), &FakePlatform::WriteFileAtomicDurable));
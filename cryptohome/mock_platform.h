@@ -139,6 +139,10 @@ class MockPlatform : public Platform {
               WriteSecureBlobToFileAtomic,
               (const base::FilePath&, const brillo::SecureBlob&, mode_t mode),
               (override));
+  MOCK_METHOD(bool,
+              WriteStringToFileAtomic,
+              (const base::FilePath&, const std::string&, mode_t mode),
+              (override));
   MOCK_METHOD(bool,
               WriteFileAtomicDurable,
               (const base::FilePath&, const brillo::Blob&, mode_t mode),
@@ -20,6 +20,7 @@
 #include <base/files/file_path.h>
 #include <base/logging.h>
 #include <base/hash/sha1.h>
+#include <base/optional.h>
 #include <base/strings/string_number_conversions.h>
 #include <base/strings/string_util.h>
 #include <base/strings/stringprintf.h>
@@ -42,6 +43,7 @@
 #include "cryptohome/dircrypto_data_migrator/migration_helper.h"
 #include "cryptohome/dircrypto_util.h"
 #include "cryptohome/homedirs.h"
+#include "cryptohome/mount_tracer.h"
 #include "cryptohome/mount_utils.h"
 #include "cryptohome/pkcs11_init.h"
 #include "cryptohome/platform.h"
@@ -287,6 +289,7 @@ bool Mount::AddEcryptfsAuthToken(const FileSystemKeys& file_system_keys,
 }
 
 MountError Mount::MountEphemeralCryptohome(const std::string& username) {
+  ScopedMountTrace trace(platform_, "MountEphemeralCryptohome");
   username_ = username;
 
   if (homedirs_->IsOrWillBeOwner(username_)) {
@@ -329,6 +332,9 @@ bool Mount::MountCryptohome(const std::string& username,
                             const Mount::MountArgs& mount_args,
                             bool is_pristine,
                             MountError* mount_error) {
+  // Joins the trace started by UserSession::MountVault(), if any.
+  ScopedMountTrace trace(platform_, "MountCryptohome");
+
   username_ = username;
   std::string obfuscated_username =
       SanitizeUserNameWithSalt(username_, system_salt_);
@@ -378,6 +384,8 @@ bool Mount::MountCryptohome(const std::string& username,
     return false;
   }
 
+  base::Optional<ScopedMountStep> keyring_step;
+  keyring_step.emplace(MountStep::kSetUpKeyring);
   if (!platform_->SetupProcessKeyring()) {
     LOG(ERROR) << "Failed to set up a process keyring.";
     *mount_error = MOUNT_ERROR_SETUP_PROCESS_KEYRING_FAILED;
@@ -435,6 +443,7 @@ bool Mount::MountCryptohome(const std::string& username,
       return false;
     }
   }
+  keyring_step.reset();
 
   // Mount cryptohome
   // /home/.shadow: owned by root
@@ -475,6 +484,7 @@ bool Mount::MountCryptohome(const std::string& username,
   }
 
   if (should_mount_dircrypto) {
+    ScopedMountStep step(MountStep::kSetDirCryptoKey);
     if (!platform_->SetDirCryptoKey(mount_point_, dircrypto_key_reference_)) {
       LOG(ERROR) << "Failed to set directory encryption policy for "
                  << mount_point_.value();
@@ -486,14 +496,18 @@ bool Mount::MountCryptohome(const std::string& username,
   MountHelper::Options mount_opts = {
       mount_type_, mount_args.to_migrate_from_ecryptfs, mount_args.shadow_only};
 
-  cryptohome::ReportTimerStart(cryptohome::kPerformMountTimer);
-  if (!helper->PerformMount(mount_opts, username_, key_signature,
-                            fnek_signature, is_pristine, mount_error)) {
-    LOG(ERROR) << "MountHelper::PerformMount failed, error = " << *mount_error;
-    return false;
-  }
+  {
+    ScopedMountStep step(MountStep::kPerformMount);
+    cryptohome::ReportTimerStart(cryptohome::kPerformMountTimer);
+    if (!helper->PerformMount(mount_opts, username_, key_signature,
+                              fnek_signature, is_pristine, mount_error)) {
+      LOG(ERROR) << "MountHelper::PerformMount failed, error = "
+                 << *mount_error;
+      return false;
+    }
 
-  cryptohome::ReportTimerStop(cryptohome::kPerformMountTimer);
+    cryptohome::ReportTimerStop(cryptohome::kPerformMountTimer);
+  }
 
   if (!UserSignInEffects(true /* is_mount */, is_owner)) {
     LOG(ERROR) << "Failed to set user type, aborting mount";
@@ -544,9 +558,12 @@ bool Mount::MountEphemeralCryptohomeInternal(
 
   base::ScopedClosureRunner cleanup_runner(cleanup);
 
-  if (!ephemeral_mounter->PerformEphemeralMount(username)) {
-    LOG(ERROR) << "PerformEphemeralMount() failed, aborting ephemeral mount";
-    return false;
+  {
+    ScopedMountStep step(MountStep::kPerformEphemeralMount);
+    if (!ephemeral_mounter->PerformEphemeralMount(username)) {
+      LOG(ERROR) << "PerformEphemeralMount() failed, aborting ephemeral mount";
+      return false;
+    }
   }
 
   if (!UserSignInEffects(true /* is_mount */, false /* is_owner */)) {
@@ -608,6 +625,10 @@ void Mount::UnmountAndDropKeys(base::OnceClosure unmounter) {
 }
 
 bool Mount::UnmountCryptohome() {
+  // Declared first so that the trace is written after |unmount_step| ends.
+  ScopedMountTrace trace(platform_, "UnmountCryptohome");
+  ScopedMountStep unmount_step(MountStep::kUnmount);
+
   if (!UserSignInEffects(false /* is_mount */, false /* is_owner */)) {
     LOG(WARNING) << "Failed to set user type, but continuing with unmount";
   }
@@ -747,6 +768,7 @@ bool Mount::StoreTimestampForUser(const std::string& obfuscated_username,
 }
 
 bool Mount::MountGuestCryptohome() {
+  ScopedMountTrace trace(platform_, "MountGuestCryptohome");
   username_ = "";
   MountHelperInterface* ephemeral_mounter = nullptr;
   base::Closure cleanup;
@@ -22,6 +22,7 @@
 #include "cryptohome/cryptohome_common.h"
 #include "cryptohome/homedirs.h"
 #include "cryptohome/mount_constants.h"
+#include "cryptohome/mount_tracer.h"
 
 using base::FilePath;
 using base::StringPrintf;
@@ -770,6 +771,7 @@ bool MountHelper::PerformMount(const Options& mount_opts,
     FilePath dest = mount_opts.to_migrate_from_ecryptfs
                         ? GetUserTemporaryMountDirectory(obfuscated_username)
                         : mount_point;
+    ScopedMountStep step(MountStep::kMountEcryptfs);
     if (!MountAndPush(vault_path, dest, "ecryptfs", ecryptfs_options)) {
       LOG(ERROR) << "eCryptfs mount failed";
       *error = MOUNT_ERROR_MOUNT_ECRYPTFS_FAILED;
@@ -777,8 +779,10 @@ bool MountHelper::PerformMount(const Options& mount_opts,
     }
   }
 
-  if (is_pristine)
+  if (is_pristine) {
+    ScopedMountStep step(MountStep::kCopySkeleton);
     CopySkeleton(user_home);
+  }
 
   if (!SetUpGroupAccess(FilePath(user_home))) {
     *error = MOUNT_ERROR_SETUP_GROUP_ACCESS_FAILED;
@@ -787,11 +791,13 @@ bool MountHelper::PerformMount(const Options& mount_opts,
 
   // When migrating, it's better to avoid exposing the new ext4 crypto dir.
   // Also don't expose the home directory if a shadow-only mount was requested.
-  if (!mount_opts.to_migrate_from_ecryptfs && !mount_opts.shadow_only &&
-      !MountHomesAndDaemonStores(username, obfuscated_username, user_home,
-                                 root_home)) {
-    *error = MOUNT_ERROR_MOUNT_HOMES_AND_DAEMON_STORES_FAILED;
-    return false;
+  if (!mount_opts.to_migrate_from_ecryptfs && !mount_opts.shadow_only) {
+    ScopedMountStep step(MountStep::kBindMounts);
+    if (!MountHomesAndDaemonStores(username, obfuscated_username, user_home,
+                                   root_home)) {
+      *error = MOUNT_ERROR_MOUNT_HOMES_AND_DAEMON_STORES_FAILED;
+      return false;
+    }
   }
 
   return true;
@@ -0,0 +1,165 @@
+// Copyright 2020 The Chromium OS Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "cryptohome/mount_tracer.h"
+
+#include <unistd.h>
+
+#include <utility>
+#include <vector>
+
+#include <base/json/json_writer.h>
+#include <base/logging.h>
+#include <base/no_destructor.h>
+#include <base/synchronization/lock.h>
+#include <base/values.h>
+
+#include "cryptohome/cryptohome_metrics.h"
+
+namespace cryptohome {
+
+namespace {
+
+// Maximum number of steps kept per trace. Mounts record about ten.
+constexpr size_t kMaxSteps = 100;
+
+struct StepRecord {
+  MountStep step;
+  base::TimeTicks start;
+  base::TimeDelta duration;
+};
+
+struct MountTrace {
+  base::Lock lock;
+  std::string operation;
+  base::TimeTicks start;
+  std::vector<StepRecord> steps;
+};
+
+MountTrace* GetTrace() {
+  static base::NoDestructor<MountTrace> trace;
+  return trace.get();
+}
+
+// Returns |time| in microseconds, as expected by the trace format. Doubles are
+// used since base::Value's integers are only 32 bits wide.
+double ToTraceMicroseconds(base::TimeTicks time) {
+  return static_cast<double>((time - base::TimeTicks()).InMicroseconds());
+}
+
+base::Value CreateTraceEvent(const std::string& name,
+                             base::TimeTicks start,
+                             base::TimeDelta duration) {
+  base::Value event(base::Value::Type::DICTIONARY);
+  event.SetStringKey("name", name);
+  event.SetStringKey("cat", "cryptohome");
+  event.SetStringKey("ph", "X");
+  event.SetIntKey("pid", getpid());
+  event.SetIntKey("tid", 1);
+  event.SetDoubleKey("ts", ToTraceMicroseconds(start));
+  event.SetDoubleKey("dur", duration.InMicrosecondsF());
+  return event;
+}
+
+}  // namespace
+
+const char kMountTracePath[] = "/run/cryptohome/mount_trace.json";
+
+const char* MountStepToString(MountStep step) {
+  switch (step) {
+    case MountStep::kLoadKeyset:
+      return "LoadKeyset";
+    case MountStep::kSetUpKeyring:
+      return "SetUpKeyring";
+    case MountStep::kSetDirCryptoKey:
+      return "SetDirCryptoKey";
+    case MountStep::kPerformMount:
+      return "PerformMount";
+    case MountStep::kOutOfProcessRoundTrip:
+      return "OutOfProcessRoundTrip";
+    case MountStep::kMountEcryptfs:
+      return "MountEcryptfs";
+    case MountStep::kCopySkeleton:
+      return "CopySkeleton";
+    case MountStep::kBindMounts:
+      return "BindMounts";
+    case MountStep::kPerformEphemeralMount:
+      return "PerformEphemeralMount";
+    case MountStep::kUnmount:
+      return "Unmount";
+  }
+  NOTREACHED();
+  return "Unknown";
+}
+
+std::string GetMountTraceJson() {
+  MountTrace* trace = GetTrace();
+  base::AutoLock lock(trace->lock);
+
+  base::Value events(base::Value::Type::LIST);
+  if (!trace->operation.empty()) {
+    events.Append(CreateTraceEvent(trace->operation, trace->start,
+                                   base::TimeTicks::Now() - trace->start));
+  }
+  for (const StepRecord& record : trace->steps) {
+    events.Append(CreateTraceEvent(MountStepToString(record.step),
+                                   record.start, record.duration));
+  }
+  base::Value root(base::Value::Type::DICTIONARY);
+  root.SetKey("traceEvents", std::move(events));
+  root.SetStringKey("displayTimeUnit", "ms");
+
+  std::string json;
+  if (!base::JSONWriter::Write(root, &json))
+    LOG(ERROR) << "Failed to serialize mount trace";
+  return json;
+}
+
+ScopedMountTrace::ScopedMountTrace(Platform* platform,
+                                   const std::string& operation)
+    : ScopedMountTrace(platform, operation, base::FilePath(kMountTracePath)) {}
+
+ScopedMountTrace::ScopedMountTrace(Platform* platform,
+                                   const std::string& operation,
+                                   const base::FilePath& path)
+    : platform_(platform), path_(path) {
+  MountTrace* trace = GetTrace();
+  base::AutoLock lock(trace->lock);
+  owns_trace_ = trace->operation.empty();
+  if (!owns_trace_)
+    return;
+  trace->operation = operation;
+  trace->start = base::TimeTicks::Now();
+  trace->steps.clear();
+}
+
+ScopedMountTrace::~ScopedMountTrace() {
+  if (!owns_trace_)
+    return;
+
+  const std::string json = GetMountTraceJson();
+  {
+    MountTrace* trace = GetTrace();
+    base::AutoLock lock(trace->lock);
+    trace->operation.clear();
+    trace->steps.clear();
+  }
+  if (!platform_->WriteStringToFileAtomic(path_, json, 0644))
+    LOG(WARNING) << "Failed to write mount trace to " << path_.value();
+}
+
+ScopedMountStep::ScopedMountStep(MountStep step)
+    : step_(step), start_(base::TimeTicks::Now()) {}
+
+ScopedMountStep::~ScopedMountStep() {
+  const base::TimeDelta duration = base::TimeTicks::Now() - start_;
+  ReportMountStepTime(MountStepToString(step_), duration);
+
+  MountTrace* trace = GetTrace();
+  base::AutoLock lock(trace->lock);
+  if (!trace->operation.empty() && trace->steps.size() < kMaxSteps)
+    trace->steps.push_back({step_, start_, duration});
+}
+
+}  // namespace cryptohome
@@ -0,0 +1,95 @@
+// Copyright 2020 The Chromium OS Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CRYPTOHOME_MOUNT_TRACER_H_
+#define CRYPTOHOME_MOUNT_TRACER_H_
+
+#include <string>
+
+#include <base/files/file_path.h>
+#include <base/macros.h>
+#include <base/time/time.h>
+
+#include "cryptohome/platform.h"
+
+namespace cryptohome {
+
+// Where the trace of the latest mount or unmount is written.
+extern const char kMountTracePath[];
+
+// Steps of the mount and unmount paths that are timed individually, so that a
+// login latency regression can be attributed to one of them.
+enum class MountStep {
+  // Decrypting the vault keyset (scrypt or TPM unsealing).
+  kLoadKeyset,
+  // Setting up the process keyring and adding the eCryptfs or dircrypto keys
+  // to it.
+  kSetUpKeyring,
+  // Setting the dircrypto policy on the vault.
+  kSetDirCryptoKey,
+  // MountHelperInterface::PerformMount(), in or out of process.
+  kPerformMount,
+  // Running cryptohome-namespace-mounter until it reports back.
+  kOutOfProcessRoundTrip,
+  // Mounting the eCryptfs vault.
+  kMountEcryptfs,
+  // Copying the skeleton into a new home.
+  kCopySkeleton,
+  // Bind-mounting the user's homes and daemon store directories.
+  kBindMounts,
+  // MountHelperInterface::PerformEphemeralMount(), in or out of process.
+  kPerformEphemeralMount,
+  // Mount::UnmountCryptohome().
+  kUnmount,
+};
+
+// Returns the name of |step| as used in histograms and traces.
+const char* MountStepToString(MountStep step);
+
+// Returns the steps recorded by the current trace in the Chrome JSON trace
+// event format, which can be loaded in Perfetto.
+std::string GetMountTraceJson();
+
+// Traces a mount or unmount operation named |operation| (e.g. "MountVault")
+// for as long as it's in scope. When it goes out of scope, the steps recorded
+// are written to kMountTracePath and discarded, whether or not the operation
+// succeeded. If a trace is already in progress, as when MountVault() calls
+// MountCryptohome(), the steps go to that trace, and only the outermost scope
+// writes it out.
+class ScopedMountTrace {
+ public:
+  ScopedMountTrace(Platform* platform, const std::string& operation);
+  // Only override |path| for testing.
+  ScopedMountTrace(Platform* platform,
+                   const std::string& operation,
+                   const base::FilePath& path);
+  ~ScopedMountTrace();
+
+ private:
+  Platform* const platform_;
+  const base::FilePath path_;
+  // Whether this scope started the current trace.
+  bool owns_trace_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScopedMountTrace);
+};
+
+// Times a MountStep for as long as it's in scope. The duration is reported to
+// the "Cryptohome.MountStep.<step>" histogram and recorded in the current
+// trace, if there is one.
+class ScopedMountStep {
+ public:
+  explicit ScopedMountStep(MountStep step);
+  ~ScopedMountStep();
+
+ private:
+  const MountStep step_;
+  const base::TimeTicks start_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScopedMountStep);
+};
+
+}  // namespace cryptohome
+
+#endif  // CRYPTOHOME_MOUNT_TRACER_H_
@@ -0,0 +1,112 @@
+// Copyright 2020 The Chromium OS Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Unit tests for the mount step tracer.
+
+#include "cryptohome/mount_tracer.h"
+
+#include <string>
+#include <vector>
+
+#include <base/files/file_util.h>
+#include <base/files/scoped_temp_dir.h>
+#include <base/json/json_reader.h>
+#include <base/values.h>
+#include <gtest/gtest.h>
+
+#include "cryptohome/platform.h"
+
+namespace cryptohome {
+
+namespace {
+
+// Returns the names of the events in |json|, in order.
+std::vector<std::string> GetTraceEventNames(const std::string& json) {
+  std::vector<std::string> names;
+  base::Optional<base::Value> trace = base::JSONReader::Read(json);
+  EXPECT_TRUE(trace);
+  if (!trace)
+    return names;
+  const base::Value* events = trace->FindListKey("traceEvents");
+  EXPECT_TRUE(events);
+  if (!events)
+    return names;
+  for (const base::Value& event : events->GetList()) {
+    EXPECT_EQ("X", *event.FindStringKey("ph"));
+    EXPECT_TRUE(event.FindDoubleKey("dur"));
+    names.push_back(*event.FindStringKey("name"));
+  }
+  return names;
+}
+
+}  // namespace
+
+class MountTracerTest : public ::testing::Test {
+ public:
+  void SetUp() override {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    trace_path_ = temp_dir_.GetPath().Append("mount_trace.json");
+  }
+
+ protected:
+  // Returns the names of the events in the trace written to |trace_path_|.
+  std::vector<std::string> GetWrittenEventNames() {
+    std::string json;
+    EXPECT_TRUE(base::ReadFileToString(trace_path_, &json));
+    return GetTraceEventNames(json);
+  }
+
+  Platform platform_;
+  base::ScopedTempDir temp_dir_;
+  base::FilePath trace_path_;
+};
+
+TEST_F(MountTracerTest, RecordsSteps) {
+  {
+    ScopedMountTrace trace(&platform_, "MountVault", trace_path_);
+    { ScopedMountStep step(MountStep::kLoadKeyset); }
+    { ScopedMountStep step(MountStep::kPerformMount); }
+    EXPECT_EQ(std::vector<std::string>(
+                  {"MountVault", "LoadKeyset", "PerformMount"}),
+              GetTraceEventNames(GetMountTraceJson()));
+  }
+
+  EXPECT_EQ(
+      std::vector<std::string>({"MountVault", "LoadKeyset", "PerformMount"}),
+      GetWrittenEventNames());
+  // The trace is discarded once written.
+  EXPECT_TRUE(GetTraceEventNames(GetMountTraceJson()).empty());
+}
+
+TEST_F(MountTracerTest, NestedTraceJoinsOuterTrace) {
+  {
+    ScopedMountTrace trace(&platform_, "MountVault", trace_path_);
+    { ScopedMountStep step(MountStep::kLoadKeyset); }
+    {
+      ScopedMountTrace inner_trace(&platform_, "MountCryptohome",
+                                   trace_path_);
+      ScopedMountStep step(MountStep::kPerformMount);
+    }
+    EXPECT_FALSE(base::PathExists(trace_path_));
+  }
+
+  EXPECT_EQ(
+      std::vector<std::string>({"MountVault", "LoadKeyset", "PerformMount"}),
+      GetWrittenEventNames());
+}
+
+TEST_F(MountTracerTest, StepsOutsideTraceAreNotRecorded) {
+  for (int i = 0; i < 200; ++i)
+    ScopedMountStep step(MountStep::kLoadKeyset);
+
+  {
+    ScopedMountTrace trace(&platform_, "UnmountCryptohome", trace_path_);
+    ScopedMountStep step(MountStep::kUnmount);
+  }
+
+  EXPECT_EQ(std::vector<std::string>({"UnmountCryptohome", "Unmount"}),
+            GetWrittenEventNames());
+}
+
+}  // namespace cryptohome
@@ -46,6 +46,7 @@
 #include "cryptohome/mock_tpm_init.h"
 #include "cryptohome/mock_vault_keyset.h"
 #include "cryptohome/mount_helper.h"
+#include "cryptohome/mount_tracer.h"
 #include "cryptohome/timestamp.pb.h"
 #include "cryptohome/user_oldest_activity_timestamp_cache.h"
 #include "cryptohome/vault_keyset.h"
@@ -54,11 +55,13 @@
 using base::FilePath;
 using brillo::SecureBlob;
 using ::testing::_;
+using ::testing::AllOf;
 using ::testing::AnyNumber;
 using ::testing::AnyOf;
 using ::testing::AnyOfArray;
 using ::testing::DoAll;
 using ::testing::EndsWith;
+using ::testing::HasSubstr;
 using ::testing::InSequence;
 using ::testing::Invoke;
 using ::testing::Mock;
@@ -547,6 +550,48 @@ TEST_P(MountTest, MountCryptohomeHasPrivileges) {
   EXPECT_TRUE(mount_->UnmountCryptohome());
 }
 
+TEST_P(MountTest, MountAndUnmountWriteMountTrace) {
+  // Check that the steps of a mount and of an unmount are written out.
+  InsertTestUsers(&kDefaultUsers[10], 1);
+  EXPECT_CALL(platform_, DirectoryExists(kImageDir))
+      .WillRepeatedly(Return(true));
+  EXPECT_TRUE(DoMountInit());
+
+  TestUser* user = &helper_.users[0];
+  user->InjectUserPaths(&platform_, fake_platform::kChronosUID,
+                        fake_platform::kChronosGID, fake_platform::kSharedGID,
+                        kDaemonGid, ShouldTestEcryptfs());
+
+  ExpectCryptohomeMount(*user);
+  EXPECT_CALL(platform_, ClearUserKeyring()).WillRepeatedly(Return(true));
+  EXPECT_CALL(platform_, FileExists(base::FilePath(kLockedToSingleUserFile)))
+      .WillRepeatedly(Return(false));
+
+  {
+    InSequence s;
+    EXPECT_CALL(platform_,
+                WriteStringToFileAtomic(
+                    FilePath(kMountTracePath),
+                    AllOf(HasSubstr("\"MountCryptohome\""),
+                          HasSubstr("\"PerformMount\"")),
+                    _));
+    EXPECT_CALL(
+        platform_,
+        WriteStringToFileAtomic(FilePath(kMountTracePath),
+                                AllOf(HasSubstr("\"UnmountCryptohome\""),
+                                      HasSubstr("\"Unmount\"")),
+                                _));
+  }
+
+  MountError error = MOUNT_ERROR_NONE;
+  ASSERT_TRUE(mount_->MountCryptohome(user->username, FileSystemKeys(),
+                                      GetDefaultMountArgs(),
+                                      /* is_pristine */ false, &error));
+
+  EXPECT_CALL(platform_, Unmount(_, _, _)).WillRepeatedly(Return(true));
+  EXPECT_TRUE(mount_->UnmountCryptohome());
+}
+
 TEST_P(MountTest, BindMyFilesDownloadsSuccess) {
   FilePath dest_dir("/home/chronos/u-userhash");
   auto downloads_path = dest_dir.Append("Downloads");
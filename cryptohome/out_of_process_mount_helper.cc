@@ -27,6 +27,7 @@
 #include "cryptohome/cryptohome_common.h"
 #include "cryptohome/cryptohome_metrics.h"
 #include "cryptohome/mount_constants.h"
+#include "cryptohome/mount_tracer.h"
 #include "cryptohome/mount_utils.h"
 
 #include "cryptohome/namespace_mounter_ipc.pb.h"
@@ -172,6 +173,7 @@ bool OutOfProcessMountHelper::LaunchOutOfProcessHelper(
       STDOUT_FILENO, false /* is_input, from child's perspective */);
 
   ReportTimerStart(kOOPMountOperationTimer);
+  ScopedMountStep round_trip_step(MountStep::kOutOfProcessRoundTrip);
 
   if (!mount_helper->Start()) {
     LOG(ERROR) << "Failed to start OOP mount helper";
@@ -12,6 +12,7 @@
 #include <cryptohome/aes_deprecated_password_verifier.h>
 #include "cryptohome/credentials.h"
 #include "cryptohome/mount.h"
+#include "cryptohome/mount_tracer.h"
 
 namespace cryptohome {
 
@@ -24,6 +25,7 @@ UserSession::UserSession(HomeDirs* homedirs,
 
 MountError UserSession::MountVault(const Credentials& credentials,
                                    const Mount::MountArgs& mount_args) {
+  ScopedMountTrace trace(homedirs_->platform(), "MountVault");
   const std::string obfuscated_username =
       credentials.GetObfuscatedUsername(system_salt_);
   bool created = false;
@@ -49,8 +51,11 @@ MountError UserSession::MountVault(const Credentials& credentials,
   // Verifies user's credentials and retrieves the user's file system encryption
   // keys.
   MountError code = MOUNT_ERROR_NONE;
-  std::unique_ptr<VaultKeyset> vk =
-      homedirs_->LoadUnwrappedKeyset(credentials, &code);
+  std::unique_ptr<VaultKeyset> vk;
+  {
+    ScopedMountStep step(MountStep::kLoadKeyset);
+    vk = homedirs_->LoadUnwrappedKeyset(credentials, &code);
+  }
   if (code != MOUNT_ERROR_NONE) {
     return code;
   }
@@ -96,6 +96,9 @@ int diag_main(int argc, char** argv) {
   DEFINE_string(disk_read_routine_type, "linear",
                 "Disk read routine type for the disk_read routine. Options are:"
                 "\n\tlinear - linear read.\n\trandom - random read.");
+  DEFINE_uint32(queue_depth, 0,
+                "Number of reads kept in flight by the disk_read routine. 0 "
+                "uses the routine's default.");
   DEFINE_uint64(max_num, 1000000,
                 "max. prime number to search for in "
                 "prime-search routine. Max. is 1000000");
@@ -200,7 +203,7 @@ int diag_main(int argc, char** argv) {
         }
         routine_result = actions.ActionRunDiskReadRoutine(
             type, base::TimeDelta::FromSeconds(FLAGS_length_seconds),
-            FLAGS_file_size_mb);
+            FLAGS_file_size_mb, FLAGS_queue_depth);
         break;
       case mojo_ipc::DiagnosticRoutineEnum::kPrimeSearch:
         routine_result = actions.ActionRunPrimeSearchRoutine(
@@ -192,9 +192,10 @@ bool DiagActions::ActionRunCpuStressRoutine(base::TimeDelta exec_duration) {
 bool DiagActions::ActionRunDiskReadRoutine(
     mojo_ipc::DiskReadRoutineTypeEnum type,
     base::TimeDelta exec_duration,
-    uint32_t file_size_mb) {
-  auto response =
-      adapter_->RunDiskReadRoutine(type, exec_duration, file_size_mb);
+    uint32_t file_size_mb,
+    uint32_t queue_depth) {
+  auto response = adapter_->RunDiskReadRoutine(type, exec_duration,
+                                               file_size_mb, queue_depth);
   id_ = response->id;
   CHECK(response) << "No RunRoutineResponse received.";
   return PollRoutineAndProcessResult();
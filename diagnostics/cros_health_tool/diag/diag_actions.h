@@ -56,7 +56,8 @@ class DiagActions final {
   bool ActionRunDiskReadRoutine(
       chromeos::cros_healthd::mojom::DiskReadRoutineTypeEnum type,
       base::TimeDelta exec_duration,
-      uint32_t file_size_mb);
+      uint32_t file_size_mb,
+      uint32_t queue_depth);
   bool ActionRunDnsLatencyRoutine();
   bool ActionRunDnsResolutionRoutine();
   bool ActionRunDnsResolverPresentRoutine();
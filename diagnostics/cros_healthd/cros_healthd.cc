@@ -27,7 +27,17 @@
 
 namespace diagnostics {
 
-CrosHealthd::CrosHealthd(Context* context)
+namespace {
+
+// How much storage I/O history to keep.
+constexpr base::TimeDelta kStorageIoHistoryDuration =
+    base::TimeDelta::FromMinutes(10);
+
+}  // namespace
+
+CrosHealthd::CrosHealthd(Context* context,
+                         base::TimeDelta probe_snapshot_max_age,
+                         base::TimeDelta storage_io_sample_interval)
     : DBusServiceDaemon(kCrosHealthdServiceName /* service_name */),
       context_(context) {
   DCHECK(context_);
@@ -39,7 +49,8 @@ CrosHealthd::CrosHealthd(Context* context)
 
   CHECK(context_->Initialize()) << "Failed to initialize context.";
 
-  fetch_aggregator_ = std::make_unique<FetchAggregator>(context_);
+  fetch_aggregator_ =
+      std::make_unique<FetchAggregator>(context_, probe_snapshot_max_age);
 
   bluetooth_events_ = std::make_unique<BluetoothEventsImpl>(context_);
 
@@ -47,6 +58,14 @@ CrosHealthd::CrosHealthd(Context* context)
 
   power_events_ = std::make_unique<PowerEventsImpl>(context_);
 
+  if (!storage_io_sample_interval.is_zero()) {
+    storage_io_monitor_ = std::make_unique<StorageIoMonitor>(
+        context_->root_dir(), std::make_unique<StorageDeviceLister>(),
+        context_->tick_clock(), storage_io_sample_interval,
+        kStorageIoHistoryDuration);
+    storage_io_monitor_->StartSampling();
+  }
+
   routine_factory_ = std::make_unique<CrosHealthdRoutineFactoryImpl>(context_);
 
   routine_service_ = std::make_unique<CrosHealthdRoutineService>(
@@ -54,7 +73,7 @@ CrosHealthd::CrosHealthd(Context* context)
 
   mojo_service_ = std::make_unique<CrosHealthdMojoService>(
       fetch_aggregator_.get(), bluetooth_events_.get(), lid_events_.get(),
-      power_events_.get());
+      power_events_.get(), storage_io_monitor_.get());
 
   service_factory_binding_set_.set_connection_error_handler(
       base::Bind(&CrosHealthd::OnDisconnect, base::Unretained(this)));
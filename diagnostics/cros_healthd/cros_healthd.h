@@ -9,6 +9,7 @@
 #include <string>
 
 #include <base/files/scoped_file.h>
+#include <base/time/time.h>
 #include <brillo/daemons/dbus_daemon.h>
 #include <brillo/dbus/dbus_object.h>
 #include <mojo/core/embedder/scoped_ipc_support.h>
@@ -20,6 +21,7 @@
 #include "diagnostics/cros_healthd/events/lid_events.h"
 #include "diagnostics/cros_healthd/events/power_events.h"
 #include "diagnostics/cros_healthd/fetch_aggregator.h"
+#include "diagnostics/cros_healthd/fetchers/storage/storage_io_monitor.h"
 #include "diagnostics/cros_healthd/system/context.h"
 #include "mojo/cros_healthd.mojom.h"
 
@@ -30,7 +32,12 @@ class CrosHealthd final
     : public brillo::DBusServiceDaemon,
       public chromeos::cros_healthd::mojom::CrosHealthdServiceFactory {
  public:
-  explicit CrosHealthd(Context* context);
+  // |probe_snapshot_max_age| is how long a fetched probe result may be reused
+  // for later requests of the same category. |storage_io_sample_interval| is
+  // how often storage I/O statistics are sampled; zero disables sampling.
+  CrosHealthd(Context* context,
+              base::TimeDelta probe_snapshot_max_age,
+              base::TimeDelta storage_io_sample_interval);
   CrosHealthd(const CrosHealthd&) = delete;
   CrosHealthd& operator=(const CrosHealthd&) = delete;
   ~CrosHealthd() override;
@@ -90,6 +97,9 @@ class CrosHealthd final
   // Provides support for power-related events.
   std::unique_ptr<PowerEvents> power_events_;
 
+  // Samples storage I/O statistics in the background. Null if disabled.
+  std::unique_ptr<StorageIoMonitor> storage_io_monitor_;
+
   // |routine_service_| delegates routine creation to |routine_factory_|.
   std::unique_ptr<CrosHealthdRoutineFactory> routine_factory_;
   // Creates new diagnostic routines and controls existing diagnostic routines.
@@ -8,9 +8,13 @@
 
 #include <utility>
 
+#include <base/bind.h>
 #include <base/logging.h>
+#include <base/task_runner_util.h>
+#include <base/time/time.h>
 
 #include "diagnostics/cros_healthd/fetchers/process_fetcher.h"
+#include "diagnostics/cros_healthd/utils/error_utils.h"
 #include "mojo/cros_healthd_probe.mojom.h"
 
 namespace diagnostics {
@@ -20,15 +24,20 @@ CrosHealthdMojoService::CrosHealthdMojoService(
     FetchAggregator* fetch_aggregator,
     BluetoothEvents* bluetooth_events,
     LidEvents* lid_events,
-    PowerEvents* power_events)
+    PowerEvents* power_events,
+    StorageIoMonitor* storage_io_monitor)
     : fetch_aggregator_(fetch_aggregator),
       bluetooth_events_(bluetooth_events),
       lid_events_(lid_events),
-      power_events_(power_events) {
+      power_events_(power_events),
+      storage_io_monitor_(storage_io_monitor) {
   DCHECK(fetch_aggregator_);
   DCHECK(bluetooth_events_);
   DCHECK(lid_events_);
   DCHECK(power_events_);
+
+  CHECK(process_table_worker_.Start())
+      << "Failed to start process table worker thread.";
 }
 
 CrosHealthdMojoService::~CrosHealthdMojoService() = default;
@@ -60,6 +69,34 @@ void CrosHealthdMojoService::ProbeTelemetryInfo(
   return fetch_aggregator_->Run(categories, std::move(callback));
 }
 
+void CrosHealthdMojoService::ProbeMultipleProcessInfo(
+    chromeos::cros_healthd::mojom::ProcessQueryPtr query,
+    ProbeMultipleProcessInfoCallback callback) {
+  // The fetcher is only touched on the worker thread, which is joined before
+  // the fetcher is destroyed.
+  base::PostTaskAndReplyWithResult(
+      process_table_worker_.task_runner().get(), FROM_HERE,
+      base::BindOnce(
+          [](ProcessTableFetcher* fetcher, mojo_ipc::ProcessQueryPtr query) {
+            return fetcher->FetchProcessTable(*query);
+          },
+          base::Unretained(&process_table_fetcher_), std::move(query)),
+      std::move(callback));
+}
+
+void CrosHealthdMojoService::ProbeStorageIoHistory(
+    uint32_t duration_seconds, ProbeStorageIoHistoryCallback callback) {
+  if (!storage_io_monitor_) {
+    std::move(callback).Run(
+        mojo_ipc::StorageIoHistoryResult::NewError(CreateAndLogProbeError(
+            mojo_ipc::ErrorType::kServiceUnavailable,
+            "Storage I/O sampling is disabled")));
+    return;
+  }
+  std::move(callback).Run(storage_io_monitor_->GetHistory(
+      base::TimeDelta::FromSeconds(duration_seconds)));
+}
+
 void CrosHealthdMojoService::AddProbeBinding(
     chromeos::cros_healthd::mojom::CrosHealthdProbeServiceRequest request) {
   probe_binding_set_.AddBinding(this /* impl */, std::move(request));
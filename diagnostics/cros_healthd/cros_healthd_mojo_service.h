@@ -8,12 +8,15 @@
 #include <cstdint>
 #include <vector>
 
+#include <base/threading/thread.h>
 #include <mojo/public/cpp/bindings/binding_set.h>
 
 #include "diagnostics/cros_healthd/events/bluetooth_events.h"
 #include "diagnostics/cros_healthd/events/lid_events.h"
 #include "diagnostics/cros_healthd/events/power_events.h"
 #include "diagnostics/cros_healthd/fetch_aggregator.h"
+#include "diagnostics/cros_healthd/fetchers/process_table_fetcher.h"
+#include "diagnostics/cros_healthd/fetchers/storage/storage_io_monitor.h"
 #include "mojo/cros_healthd.mojom.h"
 
 namespace diagnostics {
@@ -30,10 +33,13 @@ class CrosHealthdMojoService final
   // |bluetooth_events| - BluetoothEvents implementation.
   // |lid_events| - LidEvents implementation.
   // |power_events| - PowerEvents implementation.
+  // |storage_io_monitor| - storage I/O sampler, or null if sampling is
+  //                        disabled.
   CrosHealthdMojoService(FetchAggregator* fetch_aggregator,
                          BluetoothEvents* bluetooth_events,
                          LidEvents* lid_events,
-                         PowerEvents* power_events);
+                         PowerEvents* power_events,
+                         StorageIoMonitor* storage_io_monitor);
   CrosHealthdMojoService(const CrosHealthdMojoService&) = delete;
   CrosHealthdMojoService& operator=(const CrosHealthdMojoService&) = delete;
   ~CrosHealthdMojoService() override;
@@ -53,6 +59,11 @@ class CrosHealthdMojoService final
                         ProbeProcessInfoCallback callback) override;
   void ProbeTelemetryInfo(const std::vector<ProbeCategoryEnum>& categories,
                           ProbeTelemetryInfoCallback callback) override;
+  void ProbeMultipleProcessInfo(
+      chromeos::cros_healthd::mojom::ProcessQueryPtr query,
+      ProbeMultipleProcessInfoCallback callback) override;
+  void ProbeStorageIoHistory(uint32_t duration_seconds,
+                             ProbeStorageIoHistoryCallback callback) override;
 
   // Adds a new binding to the internal binding sets.
   void AddProbeBinding(
@@ -70,12 +81,22 @@ class CrosHealthdMojoService final
 
   // Unowned. The FetchAggregator instance should outlive this instance.
   FetchAggregator* fetch_aggregator_;
+  // Keeps per-process CPU samples between multiple-process probes. Only used
+  // on |process_table_worker_|.
+  ProcessTableFetcher process_table_fetcher_;
+  // Scans /proc off the daemon thread. Declared after
+  // |process_table_fetcher_| so that the thread is joined before the fetcher
+  // is destroyed.
+  base::Thread process_table_worker_{"ProcessTableWorker"};
   // Unowned. The BluetoothEvents instance should outlive this instance.
   BluetoothEvents* const bluetooth_events_ = nullptr;
   // Unowned. The lid events should outlive this instance.
   LidEvents* const lid_events_ = nullptr;
   // Unowned. The power events should outlive this instance.
   PowerEvents* const power_events_ = nullptr;
+  // Unowned. May be null. The storage I/O monitor should outlive this
+  // instance.
+  StorageIoMonitor* const storage_io_monitor_ = nullptr;
 };
 
 }  // namespace diagnostics
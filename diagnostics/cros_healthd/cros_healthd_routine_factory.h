@@ -68,7 +68,8 @@ class CrosHealthdRoutineFactory {
   virtual std::unique_ptr<DiagnosticRoutine> MakeDiskReadRoutine(
       chromeos::cros_healthd::mojom::DiskReadRoutineTypeEnum type,
       base::TimeDelta exec_duration,
-      uint32_t file_size_mb) = 0;
+      uint32_t file_size_mb,
+      uint32_t queue_depth) = 0;
   // Constructs a new instance of the prime search routine. See
   // diagnostics/routines/prime_search for details on the routine itself.
   virtual std::unique_ptr<DiagnosticRoutine> MakePrimeSearchRoutine(
@@ -124,8 +124,9 @@ std::unique_ptr<DiagnosticRoutine>
 CrosHealthdRoutineFactoryImpl::MakeDiskReadRoutine(
     chromeos::cros_healthd::mojom::DiskReadRoutineTypeEnum type,
     base::TimeDelta exec_duration,
-    uint32_t file_size_mb) {
-  return CreateDiskReadRoutine(type, exec_duration, file_size_mb);
+    uint32_t file_size_mb,
+    uint32_t queue_depth) {
+  return CreateDiskReadRoutine(type, exec_duration, file_size_mb, queue_depth);
 }
 
 std::unique_ptr<DiagnosticRoutine>
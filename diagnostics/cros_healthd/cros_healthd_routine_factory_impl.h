@@ -50,7 +50,8 @@ class CrosHealthdRoutineFactoryImpl final : public CrosHealthdRoutineFactory {
   std::unique_ptr<DiagnosticRoutine> MakeDiskReadRoutine(
       chromeos::cros_healthd::mojom::DiskReadRoutineTypeEnum type,
       base::TimeDelta exec_duration,
-      uint32_t file_size_mb) override;
+      uint32_t file_size_mb,
+      uint32_t queue_depth) override;
   std::unique_ptr<DiagnosticRoutine> MakePrimeSearchRoutine(
       base::TimeDelta exec_duration, uint64_t max_num) override;
   std::unique_ptr<DiagnosticRoutine> MakeBatteryDischargeRoutine(
@@ -162,10 +162,12 @@ void CrosHealthdRoutineService::RunDiskReadRoutine(
     mojo_ipc::DiskReadRoutineTypeEnum type,
     uint32_t length_seconds,
     uint32_t file_size_mb,
+    uint32_t queue_depth,
     RunDiskReadRoutineCallback callback) {
   RunRoutine(
       routine_factory_->MakeDiskReadRoutine(
-          type, base::TimeDelta::FromSeconds(length_seconds), file_size_mb),
+          type, base::TimeDelta::FromSeconds(length_seconds), file_size_mb,
+          queue_depth),
       mojo_ipc::DiagnosticRoutineEnum::kDiskRead, std::move(callback));
 }
 
@@ -65,6 +65,7 @@ class CrosHealthdRoutineService final
       chromeos::cros_healthd::mojom::DiskReadRoutineTypeEnum type,
       uint32_t length_seconds,
       uint32_t file_size_mb,
+      uint32_t queue_depth,
       RunDiskReadRoutineCallback callback) override;
   void RunDnsLatencyRoutine(RunDnsLatencyRoutineCallback callback) override;
   void RunDnsResolutionRoutine(
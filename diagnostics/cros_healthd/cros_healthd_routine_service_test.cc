@@ -505,7 +505,7 @@ TEST_F(CrosHealthdRoutineServiceTest, RunDiskReadRoutine) {
   base::RunLoop run_loop;
   service()->RunDiskReadRoutine(
       /*type*/ mojo_ipc::DiskReadRoutineTypeEnum::kLinearRead,
-      /*length_seconds=*/10, /*file_size_mb=*/1024,
+      /*length_seconds=*/10, /*file_size_mb=*/1024, /*queue_depth=*/32,
       base::BindLambdaForTesting(
           [&](mojo_ipc::RunRoutineResponsePtr received_response) {
             response = std::move(received_response);
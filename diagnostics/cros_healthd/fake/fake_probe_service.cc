@@ -22,4 +22,15 @@ void FakeProbeService::ProbeTelemetryInfo(
   NOTIMPLEMENTED();
 }
 
+void FakeProbeService::ProbeMultipleProcessInfo(
+    chromeos::cros_healthd::mojom::ProcessQueryPtr query,
+    ProbeMultipleProcessInfoCallback callback) {
+  NOTIMPLEMENTED();
+}
+
+void FakeProbeService::ProbeStorageIoHistory(
+    uint32_t duration_seconds, ProbeStorageIoHistoryCallback callback) {
+  NOTIMPLEMENTED();
+}
+
 }  // namespace diagnostics
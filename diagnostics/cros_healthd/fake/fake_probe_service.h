@@ -28,6 +28,11 @@ class FakeProbeService final
                         ProbeProcessInfoCallback callback) override;
   void ProbeTelemetryInfo(const std::vector<ProbeCategoryEnum>& categories,
                           ProbeTelemetryInfoCallback callback) override;
+  void ProbeMultipleProcessInfo(
+      chromeos::cros_healthd::mojom::ProcessQueryPtr query,
+      ProbeMultipleProcessInfoCallback callback) override;
+  void ProbeStorageIoHistory(uint32_t duration_seconds,
+                             ProbeStorageIoHistoryCallback callback) override;
 };
 
 }  // namespace diagnostics
@@ -87,6 +87,7 @@ void FakeRoutineService::RunDiskReadRoutine(
     mojo_ipc::DiskReadRoutineTypeEnum type,
     uint32_t length_seconds,
     uint32_t file_size_mb,
+    uint32_t queue_depth,
     RunDiskReadRoutineCallback callback) {
   NOTIMPLEMENTED();
 }
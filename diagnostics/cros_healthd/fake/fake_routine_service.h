@@ -63,6 +63,7 @@ class FakeRoutineService final
       chromeos::cros_healthd::mojom::DiskReadRoutineTypeEnum type,
       uint32_t length_seconds,
       uint32_t file_size_mb,
+      uint32_t queue_depth,
       RunDiskReadRoutineCallback callback) override;
   void RunPrimeSearchRoutine(uint32_t length_seconds,
                              uint64_t max_num,
@@ -260,7 +260,8 @@ std::unique_ptr<DiagnosticRoutine>
 FakeCrosHealthdRoutineFactory::MakeDiskReadRoutine(
     mojo_ipc::DiskReadRoutineTypeEnum type,
     base::TimeDelta exec_duration,
-    uint32_t file_size_mb) {
+    uint32_t file_size_mb,
+    uint32_t queue_depth) {
   return std::move(next_routine_);
 }
 
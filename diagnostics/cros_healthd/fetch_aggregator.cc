@@ -9,8 +9,11 @@
 #include <utility>
 #include <vector>
 
+#include <base/bind.h>
 #include <base/callback.h>
 #include <base/logging.h>
+#include <base/strings/stringprintf.h>
+#include <base/task_runner_util.h>
 
 #include "diagnostics/cros_healthd/fetchers/memory_fetcher.h"
 #include "diagnostics/cros_healthd/fetchers/stateful_partition_fetcher.h"
@@ -24,8 +27,11 @@ namespace mojo_ipc = chromeos::cros_healthd::mojom;
 
 }  // namespace
 
-FetchAggregator::FetchAggregator(Context* context)
-    : backlight_fetcher_(std::make_unique<BacklightFetcher>(context)),
+FetchAggregator::FetchAggregator(Context* context,
+                                 base::TimeDelta snapshot_max_age)
+    : context_(context),
+      snapshot_max_age_(snapshot_max_age),
+      backlight_fetcher_(std::make_unique<BacklightFetcher>(context)),
       battery_fetcher_(std::make_unique<BatteryFetcher>(context)),
       bluetooth_fetcher_(std::make_unique<BluetoothFetcher>(context)),
       cpu_fetcher_(std::make_unique<CpuFetcher>(context)),
@@ -33,6 +39,7 @@ FetchAggregator::FetchAggregator(Context* context)
       fan_fetcher_(std::make_unique<FanFetcher>(context)),
       system_fetcher_(std::make_unique<SystemFetcher>(context)),
       network_fetcher_(std::make_unique<NetworkFetcher>(context)) {
+  DCHECK(context_);
   DCHECK(backlight_fetcher_);
   DCHECK(battery_fetcher_);
   DCHECK(bluetooth_fetcher_);
@@ -41,6 +48,13 @@ FetchAggregator::FetchAggregator(Context* context)
   DCHECK(fan_fetcher_);
   DCHECK(system_fetcher_);
   DCHECK(network_fetcher_);
+
+  for (int i = 0; i < kNumWorkerThreads; i++) {
+    auto worker = std::make_unique<base::Thread>(
+        base::StringPrintf("FetchWorker%d", i));
+    CHECK(worker->Start()) << "Failed to start fetch worker thread.";
+    workers_.push_back(std::move(worker));
+  }
 }
 
 FetchAggregator::~FetchAggregator() = default;
@@ -48,99 +62,178 @@ FetchAggregator::~FetchAggregator() = default;
 void FetchAggregator::Run(
     const std::vector<mojo_ipc::ProbeCategoryEnum>& categories_to_probe,
     mojo_ipc::CrosHealthdProbeService::ProbeTelemetryInfoCallback callback) {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+
   std::unique_ptr<ProbeState> state = std::make_unique<ProbeState>();
   state->remaining_categories = std::set<mojo_ipc::ProbeCategoryEnum>(
       categories_to_probe.begin(), categories_to_probe.end());
   state->callback = std::move(callback);
 
+  // Iterate over the deduplicated categories: the last one to complete
+  // releases |state|, so no category may be handled twice.
+  const std::set<mojo_ipc::ProbeCategoryEnum> categories =
+      state->remaining_categories;
+
   auto itr_bool_pair =
       pending_calls_.emplace(GetNextAvailableKey(), std::move(state));
   DCHECK(itr_bool_pair.second);
   auto itr = itr_bool_pair.first;
 
-  mojo_ipc::TelemetryInfo* info = &itr->second->fetched_data;
-
-  for (const auto category : categories_to_probe) {
+  const base::FilePath& root = context_->root_dir();
+  const base::TimeTicks now = context_->tick_clock()->NowTicks();
+  for (const auto category : categories) {
     switch (category) {
       case mojo_ipc::ProbeCategoryEnum::kBattery: {
-        WrapFetchProbeData(category, itr, &info->battery_result,
-                           battery_fetcher_->FetchBatteryInfo());
+        // Battery and Bluetooth fetchers make blocking D-Bus calls, which
+        // must be made from the daemon thread.
+        if (TryFetchFromSnapshot(category, itr,
+                                 &mojo_ipc::TelemetryInfo::battery_result))
+          break;
+        WrapFetchProbeData(category, itr,
+                           &mojo_ipc::TelemetryInfo::battery_result,
+                           now, battery_fetcher_->FetchBatteryInfo());
         break;
       }
       case mojo_ipc::ProbeCategoryEnum::kCpu: {
-        WrapFetchProbeData(category, itr, &info->cpu_result,
-                           cpu_fetcher_->FetchCpuInfo(base::FilePath("/")));
+        PostFetchProbeData(
+            category, itr, &mojo_ipc::TelemetryInfo::cpu_result,
+            base::BindOnce(&CpuFetcher::FetchCpuInfo,
+                           base::Unretained(cpu_fetcher_.get()), root));
         break;
       }
       case mojo_ipc::ProbeCategoryEnum::kNonRemovableBlockDevices: {
-        WrapFetchProbeData(category, itr, &info->block_device_result,
-                           disk_fetcher_->FetchNonRemovableBlockDevicesInfo(
-                               base::FilePath("/")));
+        PostFetchProbeData(
+            category, itr, &mojo_ipc::TelemetryInfo::block_device_result,
+            base::BindOnce(&DiskFetcher::FetchNonRemovableBlockDevicesInfo,
+                           base::Unretained(disk_fetcher_.get()), root));
         break;
       }
       case mojo_ipc::ProbeCategoryEnum::kTimezone: {
-        WrapFetchProbeData(category, itr, &info->timezone_result,
-                           FetchTimezoneInfo(base::FilePath("/")));
+        PostFetchProbeData(category, itr,
+                           &mojo_ipc::TelemetryInfo::timezone_result,
+                           base::BindOnce(&FetchTimezoneInfo, root));
         break;
       }
       case mojo_ipc::ProbeCategoryEnum::kMemory: {
-        WrapFetchProbeData(category, itr, &info->memory_result,
-                           FetchMemoryInfo(base::FilePath("/")));
+        PostFetchProbeData(category, itr,
+                           &mojo_ipc::TelemetryInfo::memory_result,
+                           base::BindOnce(&FetchMemoryInfo, root));
         break;
       }
       case mojo_ipc::ProbeCategoryEnum::kBacklight: {
-        WrapFetchProbeData(
-            category, itr, &info->backlight_result,
-            backlight_fetcher_->FetchBacklightInfo(base::FilePath("/")));
+        PostFetchProbeData(
+            category, itr, &mojo_ipc::TelemetryInfo::backlight_result,
+            base::BindOnce(&BacklightFetcher::FetchBacklightInfo,
+                           base::Unretained(backlight_fetcher_.get()), root));
         break;
       }
       case mojo_ipc::ProbeCategoryEnum::kFan: {
+        if (TryFetchFromSnapshot(category, itr,
+                                 &mojo_ipc::TelemetryInfo::fan_result))
+          break;
         fan_fetcher_->FetchFanInfo(
-            base::FilePath("/"),
+            root,
             base::BindOnce(
                 &FetchAggregator::WrapFetchProbeData<mojo_ipc::FanResultPtr>,
-                weak_factory_.GetWeakPtr(), category, itr, &info->fan_result));
+                weak_factory_.GetWeakPtr(), category, itr,
+                &mojo_ipc::TelemetryInfo::fan_result, now));
         break;
       }
       case mojo_ipc::ProbeCategoryEnum::kStatefulPartition: {
-        WrapFetchProbeData(category, itr, &info->stateful_partition_result,
-                           FetchStatefulPartitionInfo(base::FilePath("/")));
+        PostFetchProbeData(category, itr,
+                           &mojo_ipc::TelemetryInfo::stateful_partition_result,
+                           base::BindOnce(&FetchStatefulPartitionInfo, root));
         break;
       }
       case mojo_ipc::ProbeCategoryEnum::kBluetooth: {
-        WrapFetchProbeData(category, itr, &info->bluetooth_result,
-                           bluetooth_fetcher_->FetchBluetoothInfo());
+        if (TryFetchFromSnapshot(category, itr,
+                                 &mojo_ipc::TelemetryInfo::bluetooth_result))
+          break;
+        WrapFetchProbeData(category, itr,
+                           &mojo_ipc::TelemetryInfo::bluetooth_result,
+                           now, bluetooth_fetcher_->FetchBluetoothInfo());
         break;
       }
       case mojo_ipc::ProbeCategoryEnum::kSystem: {
-        WrapFetchProbeData(
-            category, itr, &info->system_result,
-            system_fetcher_->FetchSystemInfo(base::FilePath("/")));
+        PostFetchProbeData(
+            category, itr, &mojo_ipc::TelemetryInfo::system_result,
+            base::BindOnce(&SystemFetcher::FetchSystemInfo,
+                           base::Unretained(system_fetcher_.get()), root));
         break;
       }
       case mojo_ipc::ProbeCategoryEnum::kNetwork: {
+        if (TryFetchFromSnapshot(category, itr,
+                                 &mojo_ipc::TelemetryInfo::network_result))
+          break;
         network_fetcher_->FetchNetworkInfo(base::BindOnce(
             &FetchAggregator::WrapFetchProbeData<mojo_ipc::NetworkResultPtr>,
-            weak_factory_.GetWeakPtr(), category, itr, &info->network_result));
+            weak_factory_.GetWeakPtr(), category, itr,
+            &mojo_ipc::TelemetryInfo::network_result, now));
         break;
       }
     }
   }
 }
 
+template <class T>
+void FetchAggregator::PostFetchProbeData(
+    mojo_ipc::ProbeCategoryEnum category,
+    std::map<uint32_t, std::unique_ptr<ProbeState>>::iterator itr,
+    ResultField<T> field,
+    base::OnceCallback<T()> fetch) {
+  if (TryFetchFromSnapshot(category, itr, field))
+    return;
+
+  const auto& worker =
+      workers_[static_cast<size_t>(category) % workers_.size()];
+  base::PostTaskAndReplyWithResult(
+      worker->task_runner().get(), FROM_HERE, std::move(fetch),
+      base::BindOnce(&FetchAggregator::WrapFetchProbeData<T>,
+                     weak_factory_.GetWeakPtr(), category, itr, field,
+                     context_->tick_clock()->NowTicks()));
+}
+
+template <class T>
+bool FetchAggregator::TryFetchFromSnapshot(
+    mojo_ipc::ProbeCategoryEnum category,
+    std::map<uint32_t, std::unique_ptr<ProbeState>>::iterator itr,
+    ResultField<T> field) {
+  const auto snapshot_time = snapshot_times_.find(category);
+  if (snapshot_time == snapshot_times_.end() ||
+      context_->tick_clock()->NowTicks() - snapshot_time->second >
+          snapshot_max_age_) {
+    return false;
+  }
+
+  VLOG(1) << "Using snapshot of category " << category;
+  WrapFetchProbeData(category, itr, field, base::TimeTicks(),
+                     (snapshot_.*field).Clone());
+  return true;
+}
+
 template <class T>
 void FetchAggregator::WrapFetchProbeData(
     mojo_ipc::ProbeCategoryEnum category,
     std::map<uint32_t, std::unique_ptr<ProbeState>>::iterator itr,
-    T* response_data,
+    ResultField<T> field,
+    base::TimeTicks start_time,
     T fetched_data) {
-  DCHECK(response_data);
-
-  *response_data = std::move(fetched_data);
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
 
-  base::AutoLock auto_lock(lock_);
+  // A null |start_time| marks a result served from the snapshot.
+  if (!start_time.is_null()) {
+    const base::TimeTicks now = context_->tick_clock()->NowTicks();
+    VLOG(1) << "Fetched category " << category << " in "
+            << (now - start_time).InMicroseconds() << " us";
+    if (!snapshot_max_age_.is_zero() && fetched_data &&
+        !fetched_data->is_error()) {
+      snapshot_.*field = fetched_data.Clone();
+      snapshot_times_[category] = now;
+    }
+  }
 
   ProbeState* state = itr->second.get();
+  state->fetched_data.*field = std::move(fetched_data);
 
   auto* remaining_categories = &state->remaining_categories;
   // Remove the current category, since it's been fetched.
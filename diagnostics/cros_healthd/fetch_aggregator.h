@@ -12,7 +12,9 @@
 #include <vector>
 
 #include <base/memory/weak_ptr.h>
-#include <base/synchronization/lock.h>
+#include <base/sequence_checker.h>
+#include <base/threading/thread.h>
+#include <base/time/time.h>
 
 #include "diagnostics/cros_healthd/fetchers/backlight_fetcher.h"
 #include "diagnostics/cros_healthd/fetchers/battery_fetcher.h"
@@ -31,9 +33,22 @@ namespace diagnostics {
 // This class is responsible for aggregating probe data from various fetchers,
 // some of which may be asynchronous, and running the given callback when all
 // probe data has been fetched.
+//
+// Fetchers which only read sysfs, procfs or other files run concurrently on a
+// small pool of worker threads. Each such category is pinned to one worker, so
+// a fetcher is never run on two threads at once. Fetchers which talk to D-Bus
+// still run on the daemon thread.
+//
+// Successful results are kept as a per-category snapshot, and a later request
+// for a category whose snapshot is younger than |snapshot_max_age| is answered
+// from the snapshot without fetching.
 class FetchAggregator final {
  public:
-  explicit FetchAggregator(Context* context);
+  // Number of worker threads used for file-backed fetchers.
+  static constexpr int kNumWorkerThreads = 3;
+
+  // |snapshot_max_age| of zero disables the snapshot cache.
+  FetchAggregator(Context* context, base::TimeDelta snapshot_max_age);
   FetchAggregator(const FetchAggregator&) = delete;
   FetchAggregator& operator=(const FetchAggregator&) = delete;
   ~FetchAggregator();
@@ -59,14 +74,36 @@ class FetchAggregator final {
     chromeos::cros_healthd::mojom::TelemetryInfo fetched_data;
   };
 
+  // A field of TelemetryInfo holding one category's result.
+  template <class T>
+  using ResultField = T chromeos::cros_healthd::mojom::TelemetryInfo::*;
+
   // Wraps a fetch operation from either a synchronous or asynchronous fetcher.
   template <class T>
   void WrapFetchProbeData(
       chromeos::cros_healthd::mojom::ProbeCategoryEnum category,
       std::map<uint32_t, std::unique_ptr<ProbeState>>::iterator itr,
-      T* response_data,
+      ResultField<T> field,
+      base::TimeTicks start_time,
       T fetched_data);
 
+  // Runs |fetch| on the worker pinned to |category| and hands its result to
+  // WrapFetchProbeData() on the calling thread.
+  template <class T>
+  void PostFetchProbeData(
+      chromeos::cros_healthd::mojom::ProbeCategoryEnum category,
+      std::map<uint32_t, std::unique_ptr<ProbeState>>::iterator itr,
+      ResultField<T> field,
+      base::OnceCallback<T()> fetch);
+
+  // Completes |category| for |itr| from the snapshot cache if it holds a
+  // fresh result. Returns false if the category must be fetched.
+  template <class T>
+  bool TryFetchFromSnapshot(
+      chromeos::cros_healthd::mojom::ProbeCategoryEnum category,
+      std::map<uint32_t, std::unique_ptr<ProbeState>>::iterator itr,
+      ResultField<T> field);
+
   // Returns the next available key in |pending_calls_|.
   uint32_t GetNextAvailableKey();
 
@@ -75,12 +112,15 @@ class FetchAggregator final {
   // corresponding to distinct Run() calls.
   std::map<uint32_t, std::unique_ptr<ProbeState>> pending_calls_;
 
-  // Protects against one fetcher setting the last bit of a |fetched_data| map
-  // to true while another fetcher reads it. Without the lock, the reading
-  // fetcher would then take ownership of the callback and run it, then the
-  // setting fetcher would later attempt to run the invalid callback a second
-  // time.
-  base::Lock lock_;
+  // Unowned. Provides the root directory fetchers read from and the clock
+  // snapshots are aged with. Should outlive this instance.
+  Context* const context_ = nullptr;
+
+  // Most recent successful result of each category, and when it was fetched.
+  chromeos::cros_healthd::mojom::TelemetryInfo snapshot_;
+  std::map<chromeos::cros_healthd::mojom::ProbeCategoryEnum, base::TimeTicks>
+      snapshot_times_;
+  const base::TimeDelta snapshot_max_age_;
 
   // Unowned. The backlight fetcher should outlive this instance.
   std::unique_ptr<BacklightFetcher> const backlight_fetcher_ = nullptr;
@@ -99,6 +139,14 @@ class FetchAggregator final {
   // Unowned. The network fetcher should outlive this instance.
   std::unique_ptr<NetworkFetcher> const network_fetcher_ = nullptr;
 
+  // Run file-backed fetchers. Declared after the fetchers so that the threads
+  // are joined before the fetchers they use are destroyed.
+  std::vector<std::unique_ptr<base::Thread>> workers_;
+
+  // Results of the workers are posted back, so |pending_calls_| and the
+  // snapshot are only used on the sequence Run() is called on.
+  SEQUENCE_CHECKER(sequence_checker_);
+
   // Must be the last member of the class.
   base::WeakPtrFactory<FetchAggregator> weak_factory_{this};
 };
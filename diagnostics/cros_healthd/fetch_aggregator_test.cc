@@ -0,0 +1,215 @@
+// Copyright 2020 The Chromium OS Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <cstdlib>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <base/files/file_util.h>
+#include <base/logging.h>
+#include <base/run_loop.h>
+#include <base/test/bind_test_util.h>
+#include <base/test/simple_test_tick_clock.h>
+#include <base/test/task_environment.h>
+#include <base/time/time.h>
+#include <base/timer/elapsed_timer.h>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "diagnostics/cros_healthd/executor/mock_executor_adapter.h"
+#include "diagnostics/cros_healthd/fetch_aggregator.h"
+#include "diagnostics/cros_healthd/fetchers/fan_fetcher.h"
+#include "diagnostics/cros_healthd/system/mock_context.h"
+#include "mojo/cros_healthd_executor.mojom.h"
+#include "mojo/cros_healthd_probe.mojom.h"
+
+namespace diagnostics {
+
+namespace {
+
+namespace executor_ipc = chromeos::cros_healthd_executor::mojom;
+namespace mojo_ipc = chromeos::cros_healthd::mojom;
+
+using ::testing::_;
+using ::testing::AnyNumber;
+using ::testing::Invoke;
+using ::testing::WithArg;
+
+constexpr base::TimeDelta kSnapshotMaxAge = base::TimeDelta::FromSeconds(10);
+
+// Runs |callback| with the output of a single fan spinning at 2000 RPM.
+void RespondWithFanSpeed(executor_ipc::Executor::GetFanSpeedCallback callback) {
+  executor_ipc::ProcessResult result;
+  result.return_code = EXIT_SUCCESS;
+  result.out = "Fan 0 RPM: 2000\n";
+  std::move(callback).Run(result.Clone());
+}
+
+}  // namespace
+
+class FetchAggregatorTest : public ::testing::Test {
+ protected:
+  FetchAggregatorTest() = default;
+  FetchAggregatorTest(const FetchAggregatorTest&) = delete;
+  FetchAggregatorTest& operator=(const FetchAggregatorTest&) = delete;
+
+  void SetUp() override {
+    ASSERT_TRUE(mock_context_.Initialize());
+    ASSERT_TRUE(base::CreateDirectory(
+        mock_context_.root_dir().Append(kRelativeCrosEcPath)));
+  }
+
+  void CreateAggregator(base::TimeDelta snapshot_max_age) {
+    fetch_aggregator_ =
+        std::make_unique<FetchAggregator>(&mock_context_, snapshot_max_age);
+  }
+
+  // Expects the fan speed to be read from the executor |times| times.
+  void ExpectFanSpeedReads(int times) {
+    EXPECT_CALL(*mock_context_.mock_executor(), GetFanSpeed(_))
+        .Times(times)
+        .WillRepeatedly(WithArg<0>(Invoke(&RespondWithFanSpeed)));
+  }
+
+  mojo_ipc::TelemetryInfoPtr Probe(
+      const std::vector<mojo_ipc::ProbeCategoryEnum>& categories) {
+    base::RunLoop run_loop;
+    mojo_ipc::TelemetryInfoPtr result;
+    fetch_aggregator_->Run(
+        categories,
+        base::BindLambdaForTesting([&](mojo_ipc::TelemetryInfoPtr info) {
+          result = std::move(info);
+          run_loop.Quit();
+        }));
+    run_loop.Run();
+    return result;
+  }
+
+  void AdvanceTime(base::TimeDelta delta) {
+    mock_context_.mock_tick_clock()->Advance(delta);
+  }
+
+  const base::FilePath& root_dir() { return mock_context_.root_dir(); }
+
+  MockContext* mock_context() { return &mock_context_; }
+
+ private:
+  base::test::TaskEnvironment task_environment_{
+      base::test::TaskEnvironment::ThreadingMode::MAIN_THREAD_ONLY};
+  MockContext mock_context_;
+  std::unique_ptr<FetchAggregator> fetch_aggregator_;
+};
+
+// Test that the callback runs once every category is fetched, even when the
+// categories complete in a different order than they were requested in.
+TEST_F(FetchAggregatorTest, CategoriesCompleteOutOfOrder) {
+  CreateAggregator(base::TimeDelta());
+  // The fan is answered synchronously, while the timezone and memory
+  // categories requested before it are still being fetched on the workers.
+  ExpectFanSpeedReads(1);
+
+  auto info = Probe({mojo_ipc::ProbeCategoryEnum::kTimezone,
+                     mojo_ipc::ProbeCategoryEnum::kMemory,
+                     mojo_ipc::ProbeCategoryEnum::kFan});
+
+  ASSERT_TRUE(info);
+  EXPECT_TRUE(info->timezone_result);
+  EXPECT_TRUE(info->memory_result);
+  ASSERT_TRUE(info->fan_result);
+  ASSERT_TRUE(info->fan_result->is_fan_info());
+  EXPECT_EQ(info->fan_result->get_fan_info().size(), 1);
+  EXPECT_FALSE(info->battery_result);
+}
+
+// Test that a category probed again within the snapshot max age is answered
+// from the snapshot.
+TEST_F(FetchAggregatorTest, SnapshotHitWithinMaxAge) {
+  CreateAggregator(kSnapshotMaxAge);
+  ExpectFanSpeedReads(1);
+
+  auto first = Probe({mojo_ipc::ProbeCategoryEnum::kFan});
+  AdvanceTime(kSnapshotMaxAge);
+  auto second = Probe({mojo_ipc::ProbeCategoryEnum::kFan});
+
+  ASSERT_TRUE(second->fan_result);
+  EXPECT_TRUE(second->fan_result.Equals(first->fan_result));
+}
+
+// Test that a category is fetched again once its snapshot has expired.
+TEST_F(FetchAggregatorTest, SnapshotMissAfterExpiry) {
+  CreateAggregator(kSnapshotMaxAge);
+  ExpectFanSpeedReads(2);
+
+  Probe({mojo_ipc::ProbeCategoryEnum::kFan});
+  AdvanceTime(kSnapshotMaxAge + base::TimeDelta::FromMilliseconds(1));
+  auto info = Probe({mojo_ipc::ProbeCategoryEnum::kFan});
+
+  ASSERT_TRUE(info->fan_result);
+  EXPECT_TRUE(info->fan_result->is_fan_info());
+}
+
+// Test that every probe fetches when the snapshot max age is zero.
+TEST_F(FetchAggregatorTest, ZeroMaxAgeBypassesSnapshot) {
+  CreateAggregator(base::TimeDelta());
+  ExpectFanSpeedReads(2);
+
+  Probe({mojo_ipc::ProbeCategoryEnum::kFan});
+  auto info = Probe({mojo_ipc::ProbeCategoryEnum::kFan});
+
+  ASSERT_TRUE(info->fan_result);
+  EXPECT_TRUE(info->fan_result->is_fan_info());
+}
+
+// Reports the time to probe each file-backed category on its own, fetched
+// and from the snapshot, then all of them at once. The procfs files read by
+// the CPU and memory fetchers are copied from the host, so those run on real
+// data; the other categories measure the aggregator and an empty sysfs. Run
+// with --gtest_also_run_disabled_tests.
+TEST_F(FetchAggregatorTest, DISABLED_PerCategoryBenchmark) {
+  const int kIterations = 100;
+  const std::vector<mojo_ipc::ProbeCategoryEnum> kCategories = {
+      mojo_ipc::ProbeCategoryEnum::kNonRemovableBlockDevices,
+      mojo_ipc::ProbeCategoryEnum::kCpu,
+      mojo_ipc::ProbeCategoryEnum::kTimezone,
+      mojo_ipc::ProbeCategoryEnum::kMemory,
+      mojo_ipc::ProbeCategoryEnum::kBacklight,
+      mojo_ipc::ProbeCategoryEnum::kFan,
+      mojo_ipc::ProbeCategoryEnum::kStatefulPartition,
+      mojo_ipc::ProbeCategoryEnum::kSystem,
+  };
+
+  for (const char* path : {"proc/cpuinfo", "proc/meminfo", "proc/stat",
+                           "proc/uptime", "proc/vmstat"}) {
+    const base::FilePath target = root_dir().Append(path);
+    ASSERT_TRUE(base::CreateDirectory(target.DirName()));
+    base::CopyFile(base::FilePath("/").Append(path), target);
+  }
+  EXPECT_CALL(*mock_context()->mock_executor(), GetFanSpeed(_))
+      .Times(AnyNumber())
+      .WillRepeatedly(WithArg<0>(Invoke(&RespondWithFanSpeed)));
+
+  for (base::TimeDelta max_age : {base::TimeDelta(), kSnapshotMaxAge}) {
+    const char* mode = max_age.is_zero() ? "fetched" : "from snapshot";
+    CreateAggregator(max_age);
+    for (const auto category : kCategories) {
+      // Fills the snapshot, if enabled.
+      Probe({category});
+
+      base::ElapsedTimer timer;
+      for (int i = 0; i < kIterations; i++)
+        Probe({category});
+      LOG(INFO) << category << " " << mode << ": "
+                << timer.Elapsed().InMicroseconds() / kIterations << " us";
+    }
+
+    base::ElapsedTimer timer;
+    for (int i = 0; i < kIterations; i++)
+      Probe(kCategories);
+    LOG(INFO) << "All categories " << mode << ": "
+              << timer.Elapsed().InMicroseconds() / kIterations << " us";
+  }
+}
+
+}  // namespace diagnostics
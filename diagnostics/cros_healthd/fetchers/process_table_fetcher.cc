@@ -0,0 +1,332 @@
+// Copyright 2020 The Chromium OS Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "diagnostics/cros_healthd/fetchers/process_table_fetcher.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include <base/files/file_enumerator.h>
+#include <base/files/file_util.h>
+#include <base/strings/string_number_conversions.h>
+#include <base/strings/string_split.h>
+#include <base/strings/string_util.h>
+
+#include "diagnostics/cros_healthd/utils/error_utils.h"
+#include "diagnostics/cros_healthd/utils/procfs_utils.h"
+
+namespace diagnostics {
+
+namespace {
+
+namespace mojo_ipc = chromeos::cros_healthd::mojom;
+
+// Indices of the fields of /proc/<pid>/stat that follow the process name,
+// counted from the state field.
+enum ProcPidStatFieldsAfterName {
+  kStateField = 0,
+  kUtimeField = 11,
+  kStimeField = 12,
+  kPriorityField = 15,
+  kNiceField = 16,
+  kStartTimeField = 19,
+  kVsizeField = 20,
+  kRssField = 21,
+  kNumFields,
+};
+
+// Converts the raw state character from /proc/<pid>/stat. Returns false for
+// an unknown state.
+bool GetProcessState(base::StringPiece raw_state,
+                     mojo_ipc::ProcessState* state) {
+  if (raw_state.size() != 1)
+    return false;
+
+  switch (raw_state[0]) {
+    case 'R':
+      *state = mojo_ipc::ProcessState::kRunning;
+      return true;
+    case 'S':
+      *state = mojo_ipc::ProcessState::kSleeping;
+      return true;
+    case 'D':
+      *state = mojo_ipc::ProcessState::kWaiting;
+      return true;
+    case 'Z':
+      *state = mojo_ipc::ProcessState::kZombie;
+      return true;
+    case 'T':
+      *state = mojo_ipc::ProcessState::kStopped;
+      return true;
+    case 't':
+      *state = mojo_ipc::ProcessState::kTracingStop;
+      return true;
+    case 'X':
+      *state = mojo_ipc::ProcessState::kDead;
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool GetInt8(base::StringPiece str, int8_t* out) {
+  int value;
+  if (!base::StringToInt(str, &value) ||
+      value < std::numeric_limits<int8_t>::min() ||
+      value > std::numeric_limits<int8_t>::max()) {
+    return false;
+  }
+  *out = static_cast<int8_t>(value);
+  return true;
+}
+
+// Returns the system uptime from /proc/uptime, in seconds.
+base::Optional<double> ReadUptimeSeconds(const base::FilePath& root_dir) {
+  std::string contents;
+  if (!base::ReadFileToString(GetProcUptimePath(root_dir), &contents))
+    return base::nullopt;
+
+  const base::StringPiece uptime = base::StringPiece(contents).substr(
+      0, contents.find_first_of(base::kWhitespaceASCII));
+  double uptime_seconds;
+  if (!base::StringToDouble(uptime.as_string(), &uptime_seconds))
+    return base::nullopt;
+  return uptime_seconds;
+}
+
+}  // namespace
+
+ProcessTableFetcher::ProcessTableFetcher(const base::FilePath& root_dir)
+    : root_dir_(root_dir) {}
+
+ProcessTableFetcher::~ProcessTableFetcher() = default;
+
+// static
+bool ProcessTableFetcher::ParseProcPidStat(base::StringPiece contents,
+                                           ProcPidStat* stat) {
+  DCHECK(stat);
+
+  // The name is enclosed in parentheses and may itself contain spaces and
+  // parentheses, so it ends at the last closing parenthesis.
+  const size_t name_start = contents.find('(');
+  const size_t name_end = contents.rfind(')');
+  if (name_start == base::StringPiece::npos ||
+      name_end == base::StringPiece::npos || name_end < name_start) {
+    return false;
+  }
+
+  const base::StringPiece rest = contents.substr(name_end + 1);
+  base::StringPiece fields[kNumFields];
+  size_t num_fields = 0;
+  size_t pos = 0;
+  while (num_fields < kNumFields) {
+    pos = rest.find_first_not_of(base::kWhitespaceASCII, pos);
+    if (pos == base::StringPiece::npos)
+      break;
+    const size_t end = rest.find_first_of(base::kWhitespaceASCII, pos);
+    fields[num_fields++] = rest.substr(
+        pos, end == base::StringPiece::npos ? end : end - pos);
+    pos = end;
+  }
+  if (num_fields < kNumFields)
+    return false;
+
+  uint64_t utime;
+  uint64_t stime;
+  if (!GetProcessState(fields[kStateField], &stat->state) ||
+      !GetInt8(fields[kPriorityField], &stat->priority) ||
+      !GetInt8(fields[kNiceField], &stat->nice) ||
+      !base::StringToUint64(fields[kUtimeField], &utime) ||
+      !base::StringToUint64(fields[kStimeField], &stime) ||
+      !base::StringToUint64(fields[kStartTimeField],
+                            &stat->start_time_ticks) ||
+      !base::StringToUint64(fields[kVsizeField],
+                            &stat->virtual_memory_bytes) ||
+      !base::StringToUint64(fields[kRssField], &stat->resident_memory_pages)) {
+    return false;
+  }
+  stat->cpu_time_ticks = utime + stime;
+  contents.substr(name_start + 1, name_end - name_start - 1)
+      .CopyToString(&stat->name);
+  return true;
+}
+
+// static
+bool ProcessTableFetcher::ParseProcPidStatusEffectiveUid(
+    base::StringPiece contents, uint32_t* uid) {
+  DCHECK(uid);
+
+  constexpr base::StringPiece kUidKey = "Uid:";
+  size_t line_start = 0;
+  while (line_start < contents.size()) {
+    size_t line_end = contents.find('\n', line_start);
+    if (line_end == base::StringPiece::npos)
+      line_end = contents.size();
+    const base::StringPiece line =
+        contents.substr(line_start, line_end - line_start);
+    line_start = line_end + 1;
+    if (!line.starts_with(kUidKey))
+      continue;
+
+    // The line holds the real, effective, saved set and filesystem UIDs.
+    const std::vector<base::StringPiece> uids = base::SplitStringPiece(
+        line.substr(kUidKey.size()), base::kWhitespaceASCII,
+        base::TRIM_WHITESPACE, base::SPLIT_WANT_NONEMPTY);
+    return uids.size() == 4 && base::StringToUint(uids[1], uid);
+  }
+  return false;
+}
+
+mojo_ipc::MultipleProcessResultPtr ProcessTableFetcher::FetchProcessTable(
+    const mojo_ipc::ProcessQuery& query) {
+  const auto kClockTicksPerSecond = sysconf(_SC_CLK_TCK);
+  const auto kPageSizeInBytes = sysconf(_SC_PAGESIZE);
+  if (kClockTicksPerSecond == -1 || kPageSizeInBytes == -1) {
+    return mojo_ipc::MultipleProcessResult::NewError(
+        CreateAndLogProbeError(mojo_ipc::ErrorType::kSystemUtilityError,
+                               "Failed to run sysconf."));
+  }
+  const uint64_t kPageSizeInKiB = kPageSizeInBytes / 1024;
+
+  const base::Optional<double> uptime_seconds = ReadUptimeSeconds(root_dir_);
+  if (!uptime_seconds.has_value()) {
+    return mojo_ipc::MultipleProcessResult::NewError(CreateAndLogProbeError(
+        mojo_ipc::ErrorType::kFileReadError,
+        "Failed to read " + GetProcUptimePath(root_dir_).value()));
+  }
+
+  // Elapsed time since the previous call, in clock ticks. Zero on the first
+  // call, in which case no usage is reported.
+  double elapsed_ticks = 0;
+  if (previous_uptime_seconds_.has_value() &&
+      uptime_seconds.value() > previous_uptime_seconds_.value()) {
+    elapsed_ticks =
+        (uptime_seconds.value() - previous_uptime_seconds_.value()) *
+        kClockTicksPerSecond;
+  }
+
+  base::Optional<std::set<uint32_t>> user_ids;
+  if (query.user_ids.has_value()) {
+    user_ids.emplace(query.user_ids->begin(), query.user_ids->end());
+  }
+
+  const base::FilePath proc_dir = root_dir_.Append("proc");
+  if (!base::DirectoryExists(proc_dir)) {
+    return mojo_ipc::MultipleProcessResult::NewError(
+        CreateAndLogProbeError(mojo_ipc::ErrorType::kFileReadError,
+                               "Failed to enumerate " + proc_dir.value()));
+  }
+
+  std::map<pid_t, CpuSample> samples;
+  std::vector<mojo_ipc::ProcessSummaryPtr> processes;
+  // Reused for every stat and status file, so that the scan does not allocate
+  // per process beyond the result itself.
+  std::string contents;
+  ProcPidStat stat;
+  base::FileEnumerator enumerator(proc_dir, false /* recursive */,
+                                  base::FileEnumerator::DIRECTORIES);
+  for (base::FilePath path = enumerator.Next(); !path.empty();
+       path = enumerator.Next()) {
+    int pid;
+    if (!base::StringToInt(path.BaseName().value(), &pid) || pid <= 0)
+      continue;
+
+    // The process may have exited since it was listed.
+    if (!base::ReadFileToString(path.Append(kProcessStatFile), &contents))
+      continue;
+    if (!ParseProcPidStat(contents, &stat)) {
+      LOG(WARNING) << "Failed to parse " << path.Append(kProcessStatFile);
+      continue;
+    }
+
+    // Every scanned process is sampled, whatever |query| filters out, so that
+    // a later call with a different filter still reports its usage.
+    samples[pid] = {stat.start_time_ticks, stat.cpu_time_ticks};
+
+    if (!base::ReadFileToString(path.Append(kProcessStatusFile), &contents))
+      continue;
+    uint32_t user_id;
+    if (!ParseProcPidStatusEffectiveUid(contents, &user_id)) {
+      LOG(WARNING) << "Failed to parse " << path.Append(kProcessStatusFile);
+      continue;
+    }
+    if (user_ids.has_value() && !user_ids->count(user_id))
+      continue;
+
+    double cpu_usage_percent = 0;
+    const auto previous = previous_samples_.find(pid);
+    if (elapsed_ticks > 0 && previous != previous_samples_.end() &&
+        previous->second.start_time_ticks == stat.start_time_ticks &&
+        stat.cpu_time_ticks >= previous->second.cpu_time_ticks) {
+      cpu_usage_percent =
+          (stat.cpu_time_ticks - previous->second.cpu_time_ticks) * 100.0 /
+          elapsed_ticks;
+    }
+
+    auto summary = mojo_ipc::ProcessSummary::New();
+    summary->process_id = static_cast<uint32_t>(pid);
+    summary->name = std::move(stat.name);
+    summary->user_id = user_id;
+    summary->state = stat.state;
+    summary->priority = stat.priority;
+    summary->nice = stat.nice;
+    summary->cpu_time_ticks = stat.cpu_time_ticks;
+    summary->cpu_usage_percent = cpu_usage_percent;
+    summary->total_memory_kib =
+        static_cast<uint32_t>(stat.virtual_memory_bytes / 1024);
+    summary->resident_memory_kib =
+        static_cast<uint32_t>(stat.resident_memory_pages * kPageSizeInKiB);
+    processes.push_back(std::move(summary));
+  }
+
+  // Only processes seen by this call are kept, so exited processes do not
+  // accumulate.
+  previous_samples_ = std::move(samples);
+  previous_uptime_seconds_ = uptime_seconds;
+
+  using SummaryPtr = mojo_ipc::ProcessSummaryPtr;
+  // Orders by PID unless another order is requested.
+  std::function<bool(const SummaryPtr&, const SummaryPtr&)> compare =
+      [](const SummaryPtr& a, const SummaryPtr& b) {
+        return a->process_id < b->process_id;
+      };
+  switch (query.sort_order) {
+    case mojo_ipc::ProcessSortOrder::kProcessId:
+      break;
+    case mojo_ipc::ProcessSortOrder::kCpuUsage:
+      compare = [](const SummaryPtr& a, const SummaryPtr& b) {
+        return a->cpu_usage_percent > b->cpu_usage_percent ||
+               (a->cpu_usage_percent == b->cpu_usage_percent &&
+                a->process_id < b->process_id);
+      };
+      break;
+    case mojo_ipc::ProcessSortOrder::kResidentMemory:
+      compare = [](const SummaryPtr& a, const SummaryPtr& b) {
+        return a->resident_memory_kib > b->resident_memory_kib ||
+               (a->resident_memory_kib == b->resident_memory_kib &&
+                a->process_id < b->process_id);
+      };
+      break;
+  }
+
+  // Only the requested prefix needs to be ordered.
+  if (query.max_processes > 0 && query.max_processes < processes.size()) {
+    std::partial_sort(processes.begin(),
+                      processes.begin() + query.max_processes, processes.end(),
+                      compare);
+    processes.erase(processes.begin() + query.max_processes, processes.end());
+  } else {
+    std::sort(processes.begin(), processes.end(), compare);
+  }
+
+  return mojo_ipc::MultipleProcessResult::NewProcesses(std::move(processes));
+}
+
+}  // namespace diagnostics
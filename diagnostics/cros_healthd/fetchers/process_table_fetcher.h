@@ -0,0 +1,82 @@
+// Copyright 2020 The Chromium OS Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef DIAGNOSTICS_CROS_HEALTHD_FETCHERS_PROCESS_TABLE_FETCHER_H_
+#define DIAGNOSTICS_CROS_HEALTHD_FETCHERS_PROCESS_TABLE_FETCHER_H_
+
+#include <sys/types.h>
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+#include <base/files/file_path.h>
+#include <base/optional.h>
+#include <base/strings/string_piece.h>
+
+#include "mojo/cros_healthd_probe.mojom.h"
+
+namespace diagnostics {
+
+// The ProcessTableFetcher class is responsible for gathering a summary of every
+// process on the device. Each call reads only /proc/uptime and
+// /proc/<pid>/stat and /proc/<pid>/status for each process, and keeps the CPU
+// time of each process so that the next call can report CPU usage over the
+// interval between the calls. The scan blocks on file I/O, so callers should
+// run it off the daemon thread, always on the same sequence.
+class ProcessTableFetcher final {
+ public:
+  // Only override |root_dir| for testing.
+  explicit ProcessTableFetcher(
+      const base::FilePath& root_dir = base::FilePath("/"));
+  ProcessTableFetcher(const ProcessTableFetcher&) = delete;
+  ProcessTableFetcher& operator=(const ProcessTableFetcher&) = delete;
+  ~ProcessTableFetcher();
+
+  // Returns the processes matching |query|, or the error that occurred
+  // listing them. Processes which exit during the scan are omitted.
+  chromeos::cros_healthd::mojom::MultipleProcessResultPtr FetchProcessTable(
+      const chromeos::cros_healthd::mojom::ProcessQuery& query);
+
+  // Fields of /proc/<pid>/stat used by FetchProcessTable().
+  struct ProcPidStat {
+    std::string name;
+    chromeos::cros_healthd::mojom::ProcessState state;
+    int8_t priority;
+    int8_t nice;
+    uint64_t cpu_time_ticks;
+    uint64_t start_time_ticks;
+    uint64_t virtual_memory_bytes;
+    uint64_t resident_memory_pages;
+  };
+
+  // Parses the contents of a /proc/<pid>/stat file without allocating, other
+  // than for the process name. Returns false if |contents| is malformed.
+  static bool ParseProcPidStat(base::StringPiece contents, ProcPidStat* stat);
+
+  // Parses the effective UID from the contents of a /proc/<pid>/status file.
+  // Returns false if |contents| has no valid Uid line.
+  static bool ParseProcPidStatusEffectiveUid(base::StringPiece contents,
+                                             uint32_t* uid);
+
+ private:
+  // CPU time of a process at the previous call, used to compute its usage.
+  struct CpuSample {
+    // Distinguishes a reused PID from the process previously sampled.
+    uint64_t start_time_ticks;
+    uint64_t cpu_time_ticks;
+  };
+
+  // File paths read will be relative to |root_dir_|. In production, this should
+  // be "/", but it can be overridden for testing.
+  const base::FilePath root_dir_;
+  // Samples taken by the previous call, keyed by PID.
+  std::map<pid_t, CpuSample> previous_samples_;
+  // System uptime at the previous call.
+  base::Optional<double> previous_uptime_seconds_;
+};
+
+}  // namespace diagnostics
+
+#endif  // DIAGNOSTICS_CROS_HEALTHD_FETCHERS_PROCESS_TABLE_FETCHER_H_
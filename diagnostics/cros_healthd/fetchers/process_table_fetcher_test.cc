@@ -0,0 +1,294 @@
+// Copyright 2020 The Chromium OS Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <base/files/file_path.h>
+#include <base/files/file_util.h>
+#include <base/files/scoped_temp_dir.h>
+#include <base/logging.h>
+#include <base/strings/stringprintf.h>
+#include <base/timer/elapsed_timer.h>
+#include <gtest/gtest.h>
+
+#include "diagnostics/common/file_test_utils.h"
+#include "diagnostics/cros_healthd/fetchers/process_table_fetcher.h"
+#include "diagnostics/cros_healthd/utils/procfs_utils.h"
+#include "mojo/cros_healthd_probe.mojom.h"
+
+namespace diagnostics {
+
+namespace {
+
+namespace mojo_ipc = ::chromeos::cros_healthd::mojom;
+
+// Number of fake processes written by the scale test.
+constexpr int kNumManyProcesses = 600;
+// Number of fake processes written by the scan benchmark, and the number of
+// scans it times.
+constexpr int kNumBenchmarkProcesses = 1000;
+constexpr int kNumBenchmarkScans = 20;
+
+// Returns fake /proc/<pid>/stat contents with the given values.
+std::string FakeStat(pid_t pid,
+                     const std::string& name,
+                     uint64_t utime,
+                     uint64_t stime,
+                     uint64_t start_time,
+                     uint64_t rss_pages) {
+  return base::StringPrintf(
+      "%d (%s) S 1 1015 1015 0 -1 4210944 1536 158 1 0 %llu %llu 19 37 20 0 "
+      "1 0 %llu 36884480 %llu 18446744073709551615 1 1 0 0 0 0 0 0 0\n",
+      pid, name.c_str(), static_cast<unsigned long long>(utime),
+      static_cast<unsigned long long>(stime),
+      static_cast<unsigned long long>(start_time),
+      static_cast<unsigned long long>(rss_pages));
+}
+
+// Returns fake /proc/<pid>/status contents with the given real and effective
+// UIDs.
+std::string FakeStatus(uint32_t real_uid, uint32_t effective_uid) {
+  return base::StringPrintf(
+      "Name:\tfake_exe\nState:\tS (sleeping)\nUid:\t%u\t%u\t%u\t%u\n"
+      "Gid:\t0\t0\t0\t0\n",
+      real_uid, effective_uid, effective_uid, effective_uid);
+}
+
+}  // namespace
+
+class ProcessTableFetcherTest : public testing::Test {
+ protected:
+  ProcessTableFetcherTest() = default;
+
+  void SetUp() override {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    fetcher_ = std::make_unique<ProcessTableFetcher>(temp_dir_path());
+    SetUptime(100.0);
+  }
+
+  const base::FilePath& temp_dir_path() const { return temp_dir_.GetPath(); }
+
+  void SetUptime(double seconds) {
+    ASSERT_TRUE(WriteFileAndCreateParentDirs(
+        GetProcUptimePath(temp_dir_path()),
+        base::StringPrintf("%.2f 2707855.71", seconds)));
+  }
+
+  // Also writes a status file owned by the current user, unless the process
+  // already has one.
+  void WriteStat(pid_t pid, const std::string& contents) {
+    const base::FilePath pid_dir =
+        GetProcProcessDirectoryPath(temp_dir_path(), pid);
+    ASSERT_TRUE(WriteFileAndCreateParentDirs(pid_dir.Append(kProcessStatFile),
+                                             contents));
+    if (!base::PathExists(pid_dir.Append(kProcessStatusFile)))
+      WriteStatus(pid, FakeStatus(getuid(), getuid()));
+  }
+
+  void WriteStatus(pid_t pid, const std::string& contents) {
+    ASSERT_TRUE(WriteFileAndCreateParentDirs(
+        GetProcProcessDirectoryPath(temp_dir_path(), pid)
+            .Append(kProcessStatusFile),
+        contents));
+  }
+
+  mojo_ipc::MultipleProcessResultPtr Fetch(
+      mojo_ipc::ProcessSortOrder sort_order, uint32_t max_processes) {
+    mojo_ipc::ProcessQuery query;
+    query.sort_order = sort_order;
+    query.max_processes = max_processes;
+    return fetcher_->FetchProcessTable(query);
+  }
+
+  std::unique_ptr<ProcessTableFetcher> fetcher_;
+
+ private:
+  base::ScopedTempDir temp_dir_;
+};
+
+// Test that names containing spaces and parentheses are parsed correctly.
+TEST(ProcessTableFetcherParseTest, NameWithParentheses) {
+  ProcessTableFetcher::ProcPidStat stat;
+  ASSERT_TRUE(ProcessTableFetcher::ParseProcPidStat(
+      FakeStat(42, "a (b) c", 7, 3, 358, 3515), &stat));
+  EXPECT_EQ(stat.name, "a (b) c");
+  EXPECT_EQ(stat.state, mojo_ipc::ProcessState::kSleeping);
+  EXPECT_EQ(stat.priority, 20);
+  EXPECT_EQ(stat.nice, 0);
+  EXPECT_EQ(stat.cpu_time_ticks, 10);
+  EXPECT_EQ(stat.start_time_ticks, 358);
+  EXPECT_EQ(stat.virtual_memory_bytes, 36884480);
+  EXPECT_EQ(stat.resident_memory_pages, 3515);
+}
+
+// Test that truncated and malformed stat files are rejected.
+TEST(ProcessTableFetcherParseTest, Malformed) {
+  ProcessTableFetcher::ProcPidStat stat;
+  EXPECT_FALSE(ProcessTableFetcher::ParseProcPidStat(
+      "6098 (fake_exe) S 1 1015 1015 0 -1 4210944", &stat));
+  EXPECT_FALSE(ProcessTableFetcher::ParseProcPidStat("6098 fake_exe", &stat));
+  EXPECT_FALSE(ProcessTableFetcher::ParseProcPidStat(
+      "6098 (fake_exe) Q 1 1015 1015 0 -1 4210944 1536 158 1 0 1 1 19 37 20 0 "
+      "1 0 358 36884480 3515",
+      &stat));
+}
+
+// Test that the effective UID is parsed from the status file.
+TEST(ProcessTableFetcherParseTest, StatusEffectiveUid) {
+  uint32_t uid;
+  ASSERT_TRUE(ProcessTableFetcher::ParseProcPidStatusEffectiveUid(
+      FakeStatus(1000, 0), &uid));
+  EXPECT_EQ(uid, 0);
+
+  EXPECT_FALSE(ProcessTableFetcher::ParseProcPidStatusEffectiveUid(
+      "Name:\tfake_exe\nGid:\t0\t0\t0\t0\n", &uid));
+  EXPECT_FALSE(ProcessTableFetcher::ParseProcPidStatusEffectiveUid(
+      "Uid:\t1000\n", &uid));
+  EXPECT_FALSE(ProcessTableFetcher::ParseProcPidStatusEffectiveUid(
+      "Uid:\t1000\tx\t0\t0\n", &uid));
+}
+
+// Test that a missing uptime file is reported as an error.
+TEST_F(ProcessTableFetcherTest, NoUptimeFile) {
+  ASSERT_TRUE(base::DeleteFile(GetProcUptimePath(temp_dir_path()), false));
+  auto result = Fetch(mojo_ipc::ProcessSortOrder::kProcessId, 0);
+  ASSERT_TRUE(result->is_error());
+  EXPECT_EQ(result->get_error()->type, mojo_ipc::ErrorType::kFileReadError);
+}
+
+// Test that CPU usage is computed between calls, and that a reused PID is not
+// compared against the previous process.
+TEST_F(ProcessTableFetcherTest, CpuUsageBetweenCalls) {
+  const auto kTicksPerSecond = sysconf(_SC_CLK_TCK);
+  WriteStat(10, FakeStat(10, "busy", 100, 0, 5, 1));
+  WriteStat(11, FakeStat(11, "reused", 100, 0, 5, 1));
+  auto result = Fetch(mojo_ipc::ProcessSortOrder::kCpuUsage, 0);
+  ASSERT_TRUE(result->is_processes());
+  ASSERT_EQ(result->get_processes().size(), 2);
+  EXPECT_EQ(result->get_processes()[0]->cpu_usage_percent, 0);
+
+  // Over two seconds, pid 10 uses one second of CPU time, and pid 11 is
+  // replaced by a new process.
+  SetUptime(102.0);
+  WriteStat(10, FakeStat(10, "busy", 100 + kTicksPerSecond, 0, 5, 1));
+  WriteStat(11, FakeStat(11, "reused", 100 + kTicksPerSecond, 0, 900, 1));
+  result = Fetch(mojo_ipc::ProcessSortOrder::kCpuUsage, 0);
+  ASSERT_TRUE(result->is_processes());
+  const auto& processes = result->get_processes();
+  ASSERT_EQ(processes.size(), 2);
+  EXPECT_EQ(processes[0]->process_id, 10);
+  EXPECT_DOUBLE_EQ(processes[0]->cpu_usage_percent, 50.0);
+  EXPECT_EQ(processes[1]->process_id, 11);
+  EXPECT_EQ(processes[1]->cpu_usage_percent, 0);
+}
+
+// Test that processes are reported and filtered by their effective UID.
+TEST_F(ProcessTableFetcherTest, FilterByEffectiveUser) {
+  constexpr uint32_t kRealUid = 1000;
+  constexpr uint32_t kEffectiveUid = 20104;
+  WriteStatus(10, FakeStatus(kRealUid, kEffectiveUid));
+  WriteStat(10, FakeStat(10, "fake_exe", 1, 1, 5, 1));
+  mojo_ipc::ProcessQuery query;
+  query.sort_order = mojo_ipc::ProcessSortOrder::kProcessId;
+  query.max_processes = 0;
+  query.user_ids = std::vector<uint32_t>{kRealUid};
+  auto result = fetcher_->FetchProcessTable(query);
+  ASSERT_TRUE(result->is_processes());
+  EXPECT_TRUE(result->get_processes().empty());
+
+  query.user_ids = std::vector<uint32_t>{kEffectiveUid};
+  result = fetcher_->FetchProcessTable(query);
+  ASSERT_TRUE(result->is_processes());
+  ASSERT_EQ(result->get_processes().size(), 1);
+  EXPECT_EQ(result->get_processes()[0]->user_id, kEffectiveUid);
+}
+
+// Test that processes filtered out of one call are still sampled, so that a
+// later call with a different filter reports their CPU usage.
+TEST_F(ProcessTableFetcherTest, FilteredProcessesAreSampled) {
+  const auto kTicksPerSecond = sysconf(_SC_CLK_TCK);
+  constexpr uint32_t kFirstUid = 1000;
+  constexpr uint32_t kSecondUid = 20104;
+  WriteStatus(10, FakeStatus(kFirstUid, kFirstUid));
+  WriteStat(10, FakeStat(10, "first", 100, 0, 5, 1));
+  WriteStatus(11, FakeStatus(kSecondUid, kSecondUid));
+  WriteStat(11, FakeStat(11, "second", 100, 0, 5, 1));
+  mojo_ipc::ProcessQuery query;
+  query.sort_order = mojo_ipc::ProcessSortOrder::kProcessId;
+  query.max_processes = 0;
+  query.user_ids = std::vector<uint32_t>{kFirstUid};
+  auto result = fetcher_->FetchProcessTable(query);
+  ASSERT_TRUE(result->is_processes());
+  ASSERT_EQ(result->get_processes().size(), 1);
+
+  SetUptime(102.0);
+  WriteStat(10, FakeStat(10, "first", 100 + kTicksPerSecond, 0, 5, 1));
+  WriteStat(11, FakeStat(11, "second", 100 + kTicksPerSecond, 0, 5, 1));
+  query.user_ids = std::vector<uint32_t>{kSecondUid};
+  result = fetcher_->FetchProcessTable(query);
+  ASSERT_TRUE(result->is_processes());
+  ASSERT_EQ(result->get_processes().size(), 1);
+  EXPECT_EQ(result->get_processes()[0]->process_id, 11);
+  EXPECT_DOUBLE_EQ(result->get_processes()[0]->cpu_usage_percent, 50.0);
+}
+
+// Test that a process without a status file is omitted.
+TEST_F(ProcessTableFetcherTest, MissingStatusFile) {
+  WriteStat(10, FakeStat(10, "fake_exe", 1, 1, 5, 1));
+  WriteStat(11, FakeStat(11, "fake_exe", 1, 1, 5, 1));
+  ASSERT_TRUE(base::DeleteFile(GetProcProcessDirectoryPath(temp_dir_path(), 11)
+                                   .Append(kProcessStatusFile),
+                               false));
+  auto result = Fetch(mojo_ipc::ProcessSortOrder::kProcessId, 0);
+  ASSERT_TRUE(result->is_processes());
+  ASSERT_EQ(result->get_processes().size(), 1);
+  EXPECT_EQ(result->get_processes()[0]->process_id, 10);
+}
+
+// Test that a large process table is scanned and the top entries returned in
+// order.
+TEST_F(ProcessTableFetcherTest, TopResidentMemoryOfManyProcesses) {
+  for (int pid = 1; pid <= kNumManyProcesses; pid++)
+    WriteStat(pid, FakeStat(pid, "fake_exe", 1, 1, 5, pid));
+  // Non-process entries in /proc are ignored.
+  ASSERT_TRUE(WriteFileAndCreateParentDirs(
+      temp_dir_path().Append("proc/sys/kernel/pid_max"), "32768"));
+
+  auto result = Fetch(mojo_ipc::ProcessSortOrder::kResidentMemory, 5);
+  ASSERT_TRUE(result->is_processes());
+  const auto& processes = result->get_processes();
+  ASSERT_EQ(processes.size(), 5);
+  for (int i = 0; i < 5; i++)
+    EXPECT_EQ(processes[i]->process_id, kNumManyProcesses - i);
+
+  result = Fetch(mojo_ipc::ProcessSortOrder::kProcessId, 0);
+  ASSERT_TRUE(result->is_processes());
+  EXPECT_EQ(result->get_processes().size(), kNumManyProcesses);
+}
+
+// Benchmarks repeated scans of a large process table. Run manually with
+// --gtest_also_run_disabled_tests.
+TEST_F(ProcessTableFetcherTest, DISABLED_ScanManyProcessesBenchmark) {
+  for (int pid = 1; pid <= kNumBenchmarkProcesses; pid++)
+    WriteStat(pid, FakeStat(pid, "fake_exe", pid, 1, 5, pid));
+
+  const base::ElapsedTimer timer;
+  for (int i = 0; i < kNumBenchmarkScans; i++) {
+    SetUptime(100.0 + i);
+    auto result = Fetch(mojo_ipc::ProcessSortOrder::kCpuUsage, 10);
+    ASSERT_TRUE(result->is_processes());
+    ASSERT_EQ(result->get_processes().size(), 10);
+  }
+  LOG(INFO) << "Scanned " << kNumBenchmarkProcesses << " processes in "
+            << timer.Elapsed().InMicroseconds() / kNumBenchmarkScans
+            << " us per call";
+}
+
+}  // namespace diagnostics
@@ -90,4 +90,20 @@ base::Optional<base::TimeDelta> DiskIoStat::GetDiscardTime() const {
   return base::nullopt;
 }
 
+uint64_t DiskIoStat::GetReadIos() const {
+  DCHECK(iostat_populated_);
+  return read_ios;
+}
+
+uint64_t DiskIoStat::GetWriteIos() const {
+  DCHECK(iostat_populated_);
+  return write_ios;
+}
+
+base::TimeDelta DiskIoStat::GetWeightedIoTime() const {
+  DCHECK(iostat_populated_);
+  return base::TimeDelta::FromMilliseconds(
+      static_cast<int64_t>(time_in_queue));
+}
+
 }  // namespace diagnostics
@@ -30,6 +30,11 @@ class DiskIoStat {
   uint64_t GetWrittenSectors() const;
   base::TimeDelta GetIoTime() const;
   base::Optional<base::TimeDelta> GetDiscardTime() const;
+  uint64_t GetReadIos() const;
+  uint64_t GetWriteIos() const;
+  // Sum of the time each request spent queued or in flight. Dividing its
+  // increase by the elapsed time gives the average queue depth.
+  base::TimeDelta GetWeightedIoTime() const;
 
   // Retrieves current I/O statistics for the device.
   // Must be called before using getters of the class.
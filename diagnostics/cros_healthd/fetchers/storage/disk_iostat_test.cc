@@ -21,6 +21,9 @@ TEST(DiskIoStat, Extended) {
   EXPECT_EQ(35505772, iostat.GetReadSectors());
   EXPECT_EQ(665648234, iostat.GetWrittenSectors());
   EXPECT_EQ(4646032, iostat.GetIoTime().InMilliseconds());
+  EXPECT_EQ(974807, iostat.GetReadIos());
+  EXPECT_EQ(9100120, iostat.GetWriteIos());
+  EXPECT_EQ(14886828, iostat.GetWeightedIoTime().InMilliseconds());
   ASSERT_TRUE(iostat.GetDiscardTime().has_value());
   EXPECT_EQ(200092, iostat.GetDiscardTime().value().InMilliseconds());
 }
@@ -0,0 +1,224 @@
+// Copyright 2020 The Chromium OS Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "diagnostics/cros_healthd/fetchers/storage/storage_io_monitor.h"
+
+#include <algorithm>
+#include <set>
+#include <utility>
+
+#include <base/bind.h>
+#include <base/logging.h>
+
+namespace diagnostics {
+
+namespace {
+
+namespace mojo_ipc = ::chromeos::cros_healthd::mojom;
+
+constexpr char kSysBlockPath[] = "sys/block/";
+// The sector counts in the stat file are always in 512-byte units, regardless
+// of the device's logical block size.
+constexpr uint64_t kStatSectorBytes = 512;
+
+}  // namespace
+
+StorageIoMonitor::Interval::Interval() = default;
+StorageIoMonitor::Interval::Interval(Interval&&) = default;
+StorageIoMonitor::Interval& StorageIoMonitor::Interval::operator=(Interval&&) =
+    default;
+StorageIoMonitor::Interval::~Interval() = default;
+
+StorageIoMonitor::StorageIoMonitor(
+    const base::FilePath& root,
+    std::unique_ptr<StorageDeviceLister> device_lister,
+    const base::TickClock* tick_clock,
+    base::TimeDelta sample_interval,
+    base::TimeDelta history_duration)
+    : root_(root),
+      device_lister_(std::move(device_lister)),
+      tick_clock_(tick_clock),
+      sample_interval_(sample_interval),
+      history_duration_(history_duration),
+      max_intervals_(std::max<int64_t>(
+          1, history_duration.InMilliseconds() /
+                 std::max<int64_t>(1, sample_interval.InMilliseconds()))) {
+  DCHECK(device_lister_);
+  DCHECK(tick_clock_);
+  DCHECK_GT(sample_interval_, base::TimeDelta());
+}
+
+StorageIoMonitor::~StorageIoMonitor() = default;
+
+void StorageIoMonitor::Start() {
+  VLOG(1) << "Starting storage I/O sampling";
+  Sample();
+  timer_.Start(FROM_HERE, sample_interval_,
+               base::BindRepeating(&StorageIoMonitor::OnTimer,
+                                   base::Unretained(this)));
+}
+
+void StorageIoMonitor::Stop() {
+  VLOG(1) << "Stopping storage I/O sampling";
+  timer_.Stop();
+  devices_.clear();
+  refresh_devices_ = true;
+  last_counters_.clear();
+  last_sample_time_ = base::TimeTicks();
+  history_.clear();
+}
+
+void StorageIoMonitor::OnTimer() {
+  // None of the history kept would have been seen by anyone, so sampling
+  // only costs wakeups until it's requested again.
+  if (tick_clock_->NowTicks() - last_request_time_ > history_duration_) {
+    Stop();
+    return;
+  }
+  Sample();
+}
+
+bool StorageIoMonitor::IsSampling() const {
+  return timer_.IsRunning();
+}
+
+void StorageIoMonitor::Sample() {
+  if (refresh_devices_ || devices_.empty())
+    RefreshDevices();
+
+  const base::TimeTicks now = tick_clock_->NowTicks();
+  std::map<std::string, Counters> counters;
+  for (auto it = devices_.begin(); it != devices_.end();) {
+    const auto& device = *it;
+    DiskIoStat* iostat = device.second.get();
+    Status status = iostat->Update();
+    if (!status.ok()) {
+      LOG(WARNING) << "Failed to sample " << device.first << ": "
+                   << status.message();
+      // Only the lost device is dropped. The others keep their counters, and
+      // devices that appeared meanwhile are picked up by the next sample.
+      it = devices_.erase(it);
+      refresh_devices_ = true;
+      continue;
+    }
+    Counters& sample = counters[device.first];
+    sample.read_ios = iostat->GetReadIos();
+    sample.write_ios = iostat->GetWriteIos();
+    sample.read_sectors = iostat->GetReadSectors();
+    sample.written_sectors = iostat->GetWrittenSectors();
+    sample.read_time = iostat->GetReadTime();
+    sample.write_time = iostat->GetWriteTime();
+    sample.io_time = iostat->GetIoTime();
+    sample.weighted_io_time = iostat->GetWeightedIoTime();
+    ++it;
+  }
+
+  if (!last_sample_time_.is_null() && now > last_sample_time_) {
+    Interval interval;
+    interval.end = now;
+    interval.length = now - last_sample_time_;
+    for (const auto& device : counters) {
+      const auto last = last_counters_.find(device.first);
+      if (last == last_counters_.end())
+        continue;
+      interval.devices.push_back(ComputeRates(device.first, last->second,
+                                              device.second, interval.length));
+    }
+    if (history_.size() == max_intervals_)
+      history_.pop_front();
+    history_.push_back(std::move(interval));
+  }
+
+  last_counters_ = std::move(counters);
+  last_sample_time_ = now;
+}
+
+void StorageIoMonitor::StartSampling() {
+  last_request_time_ = tick_clock_->NowTicks();
+  if (!IsSampling())
+    Start();
+}
+
+mojo_ipc::StorageIoHistoryResultPtr StorageIoMonitor::GetHistory(
+    base::TimeDelta duration) {
+  StartSampling();
+  const base::TimeTicks now = tick_clock_->NowTicks();
+
+  std::vector<mojo_ipc::StorageIoSamplePtr> samples;
+  for (const auto& interval : history_) {
+    const base::TimeDelta age = now - interval.end;
+    if (age > duration)
+      continue;
+
+    auto sample = mojo_ipc::StorageIoSample::New();
+    sample->age_ms = age.InMilliseconds();
+    sample->interval_ms = interval.length.InMilliseconds();
+    for (const auto& rates : interval.devices)
+      sample->devices.push_back(rates.Clone());
+    samples.push_back(std::move(sample));
+  }
+  return mojo_ipc::StorageIoHistoryResult::NewSamples(std::move(samples));
+}
+
+void StorageIoMonitor::RefreshDevices() {
+  refresh_devices_ = false;
+  const std::vector<std::string> names = device_lister_->ListDevices(root_);
+  const std::set<std::string> present(names.begin(), names.end());
+  for (auto it = devices_.begin(); it != devices_.end();) {
+    if (present.count(it->first))
+      ++it;
+    else
+      it = devices_.erase(it);
+  }
+  for (const auto& name : present) {
+    if (devices_.count(name))
+      continue;
+    devices_[name] = std::make_unique<DiskIoStat>(
+        root_.Append(kSysBlockPath).Append(name));
+  }
+}
+
+// static
+mojo_ipc::StorageIoRatesPtr StorageIoMonitor::ComputeRates(
+    const std::string& device_name,
+    const Counters& begin,
+    const Counters& end,
+    base::TimeDelta length) {
+  // Counters only decrease if the device was removed and re-added between
+  // samples, in which case the interval has no meaningful rates.
+  auto delta = [](uint64_t from, uint64_t to) {
+    return to >= from ? to - from : 0;
+  };
+  auto delta_time = [](base::TimeDelta from, base::TimeDelta to) {
+    return to >= from ? to - from : base::TimeDelta();
+  };
+
+  const double seconds = length.InSecondsF();
+  const uint64_t ios = delta(begin.read_ios, end.read_ios) +
+                       delta(begin.write_ios, end.write_ios);
+  const base::TimeDelta service_time =
+      delta_time(begin.read_time, end.read_time) +
+      delta_time(begin.write_time, end.write_time);
+
+  auto rates = mojo_ipc::StorageIoRates::New();
+  rates->device_name = device_name;
+  rates->read_bytes_per_second = static_cast<uint64_t>(
+      delta(begin.read_sectors, end.read_sectors) * kStatSectorBytes /
+      seconds);
+  rates->write_bytes_per_second = static_cast<uint64_t>(
+      delta(begin.written_sectors, end.written_sectors) * kStatSectorBytes /
+      seconds);
+  rates->read_iops = delta(begin.read_ios, end.read_ios) / seconds;
+  rates->write_iops = delta(begin.write_ios, end.write_ios) / seconds;
+  rates->average_latency_ms = ios ? service_time.InMillisecondsF() / ios : 0.0;
+  rates->utilization_percent = std::min(
+      100.0, delta_time(begin.io_time, end.io_time).InSecondsF() * 100.0 /
+                 seconds);
+  rates->average_queue_depth =
+      delta_time(begin.weighted_io_time, end.weighted_io_time).InSecondsF() /
+      seconds;
+  return rates;
+}
+
+}  // namespace diagnostics
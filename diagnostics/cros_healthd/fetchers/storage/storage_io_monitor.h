@@ -0,0 +1,134 @@
+// Copyright 2020 The Chromium OS Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef DIAGNOSTICS_CROS_HEALTHD_FETCHERS_STORAGE_STORAGE_IO_MONITOR_H_
+#define DIAGNOSTICS_CROS_HEALTHD_FETCHERS_STORAGE_STORAGE_IO_MONITOR_H_
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <base/containers/circular_deque.h>
+#include <base/files/file_path.h>
+#include <base/time/tick_clock.h>
+#include <base/time/time.h>
+#include <base/timer/timer.h>
+
+#include "diagnostics/cros_healthd/fetchers/storage/device_lister.h"
+#include "diagnostics/cros_healthd/fetchers/storage/disk_iostat.h"
+#include "mojo/cros_healthd_probe.mojom.h"
+
+namespace diagnostics {
+
+// Samples the I/O statistics of every non-removable block device at a fixed
+// interval, and keeps the rates computed for each interval over a bounded
+// window of history. Sampling starts with StartSampling() or the first request
+// for the history, and stops once no request has been made for as long as the
+// history covers. The first sample only sets the baseline, so history is
+// available one |sample_interval| after sampling starts.
+// All methods must be called on the same sequence.
+class StorageIoMonitor final {
+ public:
+  // |root| is the root of the filesystem holding sysfs. History older than
+  // |history_duration| is discarded.
+  StorageIoMonitor(const base::FilePath& root,
+                   std::unique_ptr<StorageDeviceLister> device_lister,
+                   const base::TickClock* tick_clock,
+                   base::TimeDelta sample_interval,
+                   base::TimeDelta history_duration);
+  StorageIoMonitor(const StorageIoMonitor&) = delete;
+  StorageIoMonitor(StorageIoMonitor&&) = delete;
+  StorageIoMonitor& operator=(const StorageIoMonitor&) = delete;
+  StorageIoMonitor& operator=(StorageIoMonitor&&) = delete;
+  ~StorageIoMonitor();
+
+  // Starts sampling if it was stopped, as if the history had just been
+  // requested. Called at daemon start so that the first request already finds
+  // history.
+  void StartSampling();
+
+  // Returns the samples whose intervals ended within the last |duration|,
+  // oldest first. Starts sampling if it was stopped, in which case no sample
+  // is returned yet.
+  chromeos::cros_healthd::mojom::StorageIoHistoryResultPtr GetHistory(
+      base::TimeDelta duration);
+
+  // Whether devices are currently being sampled.
+  bool IsSampling() const;
+
+ private:
+  // Counters of a device at the time of a sample.
+  struct Counters {
+    uint64_t read_ios;
+    uint64_t write_ios;
+    uint64_t read_sectors;
+    uint64_t written_sectors;
+    base::TimeDelta read_time;
+    base::TimeDelta write_time;
+    base::TimeDelta io_time;
+    base::TimeDelta weighted_io_time;
+  };
+
+  // Rates of every device over one interval.
+  struct Interval {
+    Interval();
+    Interval(Interval&&);
+    Interval& operator=(Interval&&);
+    ~Interval();
+
+    base::TimeTicks end;
+    base::TimeDelta length;
+    std::vector<chromeos::cros_healthd::mojom::StorageIoRatesPtr> devices;
+  };
+
+  // Takes the first sample and starts sampling every |sample_interval_|.
+  void Start();
+  // Stops sampling and drops the history.
+  void Stop();
+  // Called by |timer_|. Takes a sample, or stops sampling if the history is
+  // no longer requested.
+  void OnTimer();
+
+  // Reads the current statistics of every device and, if a previous sample
+  // exists, records the rates since then.
+  void Sample();
+
+  // Updates |devices_| to the non-removable block devices present now. Devices
+  // that are still present keep their last counters.
+  void RefreshDevices();
+
+  static chromeos::cros_healthd::mojom::StorageIoRatesPtr ComputeRates(
+      const std::string& device_name,
+      const Counters& begin,
+      const Counters& end,
+      base::TimeDelta length);
+
+  const base::FilePath root_;
+  const std::unique_ptr<const StorageDeviceLister> device_lister_;
+  // Unowned. Must outlive this instance.
+  const base::TickClock* const tick_clock_;
+  const base::TimeDelta sample_interval_;
+  const base::TimeDelta history_duration_;
+  const size_t max_intervals_;
+  // Time of the most recent call to GetHistory().
+  base::TimeTicks last_request_time_;
+
+  // Statistics readers, keyed by device name.
+  std::map<std::string, std::unique_ptr<DiskIoStat>> devices_;
+  // Whether |devices_| must be refreshed before the next sample.
+  bool refresh_devices_ = true;
+  // Counters read by the previous sample, keyed by device name.
+  std::map<std::string, Counters> last_counters_;
+  base::TimeTicks last_sample_time_;
+  // Most recent intervals, oldest first.
+  base::circular_deque<Interval> history_;
+
+  base::RepeatingTimer timer_;
+};
+
+}  // namespace diagnostics
+
+#endif  // DIAGNOSTICS_CROS_HEALTHD_FETCHERS_STORAGE_STORAGE_IO_MONITOR_H_
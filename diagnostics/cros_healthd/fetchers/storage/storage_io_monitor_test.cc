@@ -0,0 +1,232 @@
+// Copyright 2020 The Chromium OS Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <base/files/file_path.h>
+#include <base/files/scoped_temp_dir.h>
+#include <base/strings/string_number_conversions.h>
+#include <base/test/task_environment.h>
+#include <base/time/time.h>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "diagnostics/common/file_test_utils.h"
+#include "diagnostics/cros_healthd/fetchers/storage/mock/mock_device_lister.h"
+#include "diagnostics/cros_healthd/fetchers/storage/storage_io_monitor.h"
+#include "mojo/cros_healthd_probe.mojom.h"
+
+namespace diagnostics {
+
+namespace {
+
+namespace mojo_ipc = ::chromeos::cros_healthd::mojom;
+
+using ::testing::_;
+using ::testing::Return;
+using ::testing::StrictMock;
+
+constexpr char kDevice[] = "nvme0n1";
+constexpr char kOtherDevice[] = "mmcblk0";
+constexpr base::TimeDelta kSampleInterval = base::TimeDelta::FromSeconds(10);
+constexpr base::TimeDelta kHistoryDuration = base::TimeDelta::FromMinutes(1);
+
+class StorageIoMonitorTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    auto lister = std::make_unique<StrictMock<MockStorageDeviceLister>>();
+    lister_ = lister.get();
+    EXPECT_CALL(*lister_, ListDevices(_))
+        .WillRepeatedly(Return(std::vector<std::string>{kDevice}));
+    monitor_ = std::make_unique<StorageIoMonitor>(
+        temp_dir_.GetPath(), std::move(lister),
+        task_environment_.GetMockTickClock(), kSampleInterval,
+        kHistoryDuration);
+  }
+
+  // Writes the stat file of |device|.
+  void WriteStat(uint64_t read_ios,
+                 uint64_t read_sectors,
+                 uint64_t read_ticks,
+                 uint64_t write_ios,
+                 uint64_t write_sectors,
+                 uint64_t write_ticks,
+                 uint64_t io_ticks,
+                 uint64_t time_in_queue,
+                 const std::string& device = kDevice) {
+    // Merges and in-flight requests are not used, so are left at zero.
+    const uint64_t fields[] = {read_ios,      0,           read_sectors,
+                               read_ticks,    write_ios,   0,
+                               write_sectors, write_ticks, 0,
+                               io_ticks,      time_in_queue};
+    std::string contents;
+    for (uint64_t field : fields)
+      contents += base::NumberToString(field) + " ";
+    ASSERT_TRUE(WriteFileAndCreateParentDirs(
+        temp_dir_.GetPath().Append("sys/block").Append(device).Append("stat"),
+        contents));
+  }
+
+  std::vector<mojo_ipc::StorageIoSamplePtr> GetSamples(
+      base::TimeDelta duration) {
+    auto result = monitor_->GetHistory(duration);
+    EXPECT_TRUE(result->is_samples());
+    if (!result->is_samples())
+      return {};
+    return std::move(result->get_samples());
+  }
+
+  // Advances time by one sample interval, which runs one sample.
+  void NextSample() { task_environment_.FastForwardBy(kSampleInterval); }
+
+  base::test::TaskEnvironment task_environment_{
+      base::test::TaskEnvironment::TimeSource::MOCK_TIME};
+  base::ScopedTempDir temp_dir_;
+  StrictMock<MockStorageDeviceLister>* lister_ = nullptr;
+  std::unique_ptr<StorageIoMonitor> monitor_;
+};
+
+// Test that sampling only starts with the first request.
+TEST_F(StorageIoMonitorTest, StartsOnFirstRequest) {
+  WriteStat(0, 0, 0, 0, 0, 0, 0, 0);
+  NextSample();
+  EXPECT_FALSE(monitor_->IsSampling());
+
+  EXPECT_TRUE(GetSamples(kHistoryDuration).empty());
+  EXPECT_TRUE(monitor_->IsSampling());
+  NextSample();
+  EXPECT_EQ(GetSamples(kHistoryDuration).size(), 1u);
+}
+
+// Test that sampling started ahead of the first request has history ready for
+// it.
+TEST_F(StorageIoMonitorTest, StartSamplingAheadOfRequest) {
+  WriteStat(0, 0, 0, 0, 0, 0, 0, 0);
+  monitor_->StartSampling();
+  EXPECT_TRUE(monitor_->IsSampling());
+  NextSample();
+  EXPECT_EQ(GetSamples(kHistoryDuration).size(), 1u);
+}
+
+// Test that sampling stops once the history hasn't been requested for as long
+// as it covers, and starts over with the next request.
+TEST_F(StorageIoMonitorTest, StopsWhenNoLongerRequested) {
+  WriteStat(0, 0, 0, 0, 0, 0, 0, 0);
+  GetSamples(kHistoryDuration);
+  task_environment_.FastForwardBy(kHistoryDuration);
+  EXPECT_TRUE(monitor_->IsSampling());
+  NextSample();
+  EXPECT_FALSE(monitor_->IsSampling());
+
+  // Nothing is sampled while stopped, and the old history is gone.
+  task_environment_.FastForwardBy(kHistoryDuration);
+  EXPECT_TRUE(GetSamples(kHistoryDuration).empty());
+  EXPECT_TRUE(monitor_->IsSampling());
+}
+
+// Test that the rates of an interval are derived from the counter deltas.
+TEST_F(StorageIoMonitorTest, ComputesRates) {
+  WriteStat(100, 1000, 50, 200, 4000, 150, 1000, 2000);
+  EXPECT_TRUE(GetSamples(kHistoryDuration).empty());
+
+  // Over 10 seconds: 1000 reads of 20480 sectors taking 1000ms, 3000 writes
+  // of 61440 sectors taking 3000ms, 5000ms busy and 20000ms queued.
+  WriteStat(1100, 21480, 1050, 3200, 65440, 3150, 6000, 22000);
+  NextSample();
+
+  auto samples = GetSamples(kHistoryDuration);
+  ASSERT_EQ(samples.size(), 1u);
+  EXPECT_EQ(samples[0]->age_ms, 0u);
+  EXPECT_EQ(samples[0]->interval_ms, 10000u);
+  ASSERT_EQ(samples[0]->devices.size(), 1u);
+  const auto& rates = samples[0]->devices[0];
+  EXPECT_EQ(rates->device_name, kDevice);
+  EXPECT_EQ(rates->read_bytes_per_second, 20480u * 512 / 10);
+  EXPECT_EQ(rates->write_bytes_per_second, 61440u * 512 / 10);
+  EXPECT_DOUBLE_EQ(rates->read_iops, 100);
+  EXPECT_DOUBLE_EQ(rates->write_iops, 300);
+  EXPECT_DOUBLE_EQ(rates->average_latency_ms, 1);
+  EXPECT_DOUBLE_EQ(rates->utilization_percent, 50);
+  EXPECT_DOUBLE_EQ(rates->average_queue_depth, 2);
+}
+
+// Test that only the requested duration is returned, and that history is
+// bounded.
+TEST_F(StorageIoMonitorTest, BoundedHistory) {
+  WriteStat(0, 0, 0, 0, 0, 0, 0, 0);
+  for (int i = 0; i < 10; i++) {
+    // Keep the history requested.
+    GetSamples(kHistoryDuration);
+    NextSample();
+  }
+
+  // One minute of history at 10 second intervals.
+  auto samples = GetSamples(base::TimeDelta::FromHours(1));
+  ASSERT_EQ(samples.size(), 6u);
+  EXPECT_EQ(samples.front()->age_ms, 50000u);
+  EXPECT_EQ(samples.back()->age_ms, 0u);
+
+  EXPECT_EQ(GetSamples(base::TimeDelta::FromSeconds(25)).size(), 3u);
+}
+
+// Test that a device whose stat file disappears is dropped, and picked up
+// again once it returns.
+TEST_F(StorageIoMonitorTest, DeviceLost) {
+  WriteStat(0, 0, 0, 0, 0, 0, 0, 0);
+  GetSamples(kHistoryDuration);
+
+  ASSERT_TRUE(base::DeleteFile(
+      temp_dir_.GetPath().Append("sys/block").Append(kDevice).Append("stat"),
+      false));
+  NextSample();
+
+  WriteStat(10, 0, 0, 0, 0, 0, 0, 0);
+  NextSample();
+  NextSample();
+
+  auto samples = GetSamples(kHistoryDuration);
+  ASSERT_EQ(samples.size(), 3u);
+  EXPECT_TRUE(samples[0]->devices.empty());
+  EXPECT_TRUE(samples[1]->devices.empty());
+  EXPECT_EQ(samples[2]->devices.size(), 1u);
+}
+
+// Test that losing one device keeps the counters of the others, so they still
+// report rates for the next interval.
+TEST_F(StorageIoMonitorTest, OtherDevicesSurviveDeviceLost) {
+  EXPECT_CALL(*lister_, ListDevices(_))
+      .WillRepeatedly(
+          Return(std::vector<std::string>{kDevice, kOtherDevice}));
+  WriteStat(0, 0, 0, 0, 0, 0, 0, 0);
+  WriteStat(0, 0, 0, 0, 0, 0, 0, 0, kOtherDevice);
+  GetSamples(kHistoryDuration);
+  NextSample();
+
+  ASSERT_TRUE(base::DeleteFile(
+      temp_dir_.GetPath().Append("sys/block").Append(kDevice).Append("stat"),
+      false));
+  WriteStat(10, 0, 0, 0, 0, 0, 0, 0, kOtherDevice);
+  NextSample();
+  WriteStat(30, 0, 0, 0, 0, 0, 0, 0, kOtherDevice);
+  NextSample();
+
+  auto samples = GetSamples(kHistoryDuration);
+  ASSERT_EQ(samples.size(), 3u);
+  EXPECT_EQ(samples[0]->devices.size(), 2u);
+  for (size_t i = 1; i < samples.size(); i++) {
+    ASSERT_EQ(samples[i]->devices.size(), 1u);
+    EXPECT_EQ(samples[i]->devices[0]->device_name, kOtherDevice);
+  }
+  EXPECT_DOUBLE_EQ(samples[1]->devices[0]->read_iops, 1);
+  EXPECT_DOUBLE_EQ(samples[2]->devices[0]->read_iops, 2);
+}
+
+}  // namespace
+
+}  // namespace diagnostics
@@ -8,6 +8,7 @@
 #include <cstdlib>
 
 #include <base/logging.h>
+#include <base/time/time.h>
 #include <brillo/flag_helper.h>
 #include <brillo/syslog_logging.h>
 #include <mojo/core/embedder/embedder.h>
@@ -19,6 +20,13 @@
 #include "diagnostics/cros_healthd/system/context.h"
 
 int main(int argc, char** argv) {
+  DEFINE_uint32(probe_cache_max_age_ms, 0,
+                "Reuse a probe result for later requests of the same category "
+                "for up to this many milliseconds. Zero disables reuse.");
+  DEFINE_uint32(storage_io_sample_interval_ms, 10000,
+                "Sample storage I/O statistics every this many milliseconds "
+                "while their history is being requested. Zero disables "
+                "sampling.");
   brillo::FlagHelper::Init(
       argc, argv, "cros_healthd - Device telemetry and diagnostics daemon.");
 
@@ -57,6 +65,11 @@ int main(int argc, char** argv) {
     diagnostics::Context context{channel.TakeRemoteEndpoint()};
 
     // Run the cros_healthd daemon.
-    return diagnostics::CrosHealthd(&context).Run();
+    return diagnostics::CrosHealthd(
+               &context,
+               base::TimeDelta::FromMilliseconds(FLAGS_probe_cache_max_age_ms),
+               base::TimeDelta::FromMilliseconds(
+                   FLAGS_storage_io_sample_interval_ms))
+        .Run();
   }
 }
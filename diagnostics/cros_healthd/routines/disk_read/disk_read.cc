@@ -4,96 +4,189 @@
 
 #include "diagnostics/cros_healthd/routines/disk_read/disk_read.h"
 
-#include <list>
-#include <string>
+#include <algorithm>
 #include <utility>
-#include <vector>
 
 #include <base/bind.h>
-#include <base/command_line.h>
 #include <base/files/file_util.h>
-#include <base/numerics/safe_conversions.h>
-#include <base/strings/string_number_conversions.h>
+#include <base/json/json_writer.h>
+#include <base/logging.h>
 #include <base/system/sys_info.h>
+#include <base/strings/string_piece.h>
+#include <base/task_runner_util.h>
+
+#include "diagnostics/common/mojo_utils.h"
+
+namespace diagnostics {
 
 namespace {
 
 namespace mojo_ipc = ::chromeos::cros_healthd::mojom;
 
 constexpr char kTmpPath[] = "/var/cache/diagnostics";
-constexpr char kTestFileName[] = "fio-test-file";
-constexpr char kFioExePath[] = "/usr/bin/fio";
-constexpr float kFileCreationTimePerMB = 0.005;
-constexpr uint32_t kSpaceLowMB = 1024;
+constexpr char kTestFileName[] = "disk-read-test-file";
+constexpr double kFileCreationSecondsPerMB = 0.005;
+constexpr int64_t kSpaceLowMB = 1024;
 
 }  // namespace
 
-namespace diagnostics {
+const char kDiskReadRoutineSucceededMessage[] = "Disk read routine passed.";
+const char kDiskReadRoutineFailedMessage[] = "Disk read routine failed.";
+const char kDiskReadRoutineInsufficientSpaceMessage[] =
+    "Insufficient storage space for the disk read routine.";
+const char kDiskReadRoutineRunningMessage[] = "Disk read routine running.";
+const char kDiskReadRoutineCancelledMessage[] = "Disk read routine cancelled.";
+
+// static
+uint32_t DiskReadRoutine::ComputeQueueDepth(uint32_t requested_queue_depth) {
+  if (requested_queue_depth == 0)
+    return kDefaultQueueDepth;
+  return std::min(requested_queue_depth, kMaxQueueDepth);
+}
 
-std::unique_ptr<DiagnosticRoutine> CreateDiskReadRoutine(
-    chromeos::cros_healthd::mojom::DiskReadRoutineTypeEnum type,
-    base::TimeDelta exec_duration,
-    uint32_t file_size_mb) {
-  std::vector<std::string> prepare_cmd{
-      kFioExePath,
-      "--name=prepare",
-      "--filename=" + base::FilePath(kTmpPath).Append(kTestFileName).value(),
-      "--size=" + base::NumberToString(file_size_mb) + "MB",
-      "--verify=md5",
-      "--rw=write",
-      "--end_fsync=1"};
-
-  std::vector<std::string> run_cmd{
-      kFioExePath,
-      "--name=run",
-      "--filename=" + base::FilePath(kTmpPath).Append(kTestFileName).value(),
-      "--time_based=1",
-      "--runtime=" + base::NumberToString(exec_duration.InSeconds()),
-      "--direct=1",
-      (type == mojo_ipc::DiskReadRoutineTypeEnum::kLinearRead)
-          ? "--rw=read"
-          : "--rw=randread"};
-
-  auto subproc_routine_ptr = std::make_unique<SubprocRoutine>(
-      std::list<base::CommandLine>{base::CommandLine(prepare_cmd),
-                                   base::CommandLine(run_cmd)},
-      exec_duration.InSeconds() +
-          static_cast<int>(kFileCreationTimePerMB * file_size_mb));
-
-  // Ensure DUT has sufficient storage space and prevent storage space state
-  // from falling into 'low' state during test.
-  auto storage_space_check = base::BindOnce(
-      [=](uint32_t file_size_mb) {
-        int64_t available_storage_space_byte =
-            base::SysInfo::AmountOfFreeDiskSpace(base::FilePath(kTmpPath));
-        if (available_storage_space_byte == -1) {
-          LOG(ERROR) << "Failed to retrieve available disk space";
-          return false;
-        }
-        uint32_t available_storage_space_mb =
-            base::checked_cast<uint32_t>(available_storage_space_byte / 1024 /
-                                         1024) -
-            kSpaceLowMB;
-        if (available_storage_space_mb < file_size_mb) {
-          LOG(ERROR) << "Insufficient storage space";
-          return false;
-        }
-        return true;
-      },
-      file_size_mb);
-
-  // Clean up test file created by fio.
-  auto test_file_deletion = base::BindOnce([]() {
-    auto test_file = base::FilePath(kTmpPath).Append(kTestFileName);
-    if (base::PathExists(test_file)) {
-      base::DeleteFile(test_file, false);
+DiskReadRoutine::DiskReadRoutine(mojo_ipc::DiskReadRoutineTypeEnum type,
+                                 base::TimeDelta exec_duration,
+                                 uint32_t file_size_mb,
+                                 uint32_t queue_depth,
+                                 const base::FilePath& test_dir)
+    : file_size_mb_(file_size_mb),
+      status_(mojo_ipc::DiagnosticRoutineStatusEnum::kReady) {
+  options_.file_path = (test_dir.empty() ? base::FilePath(kTmpPath) : test_dir)
+                           .Append(kTestFileName);
+  options_.file_size_bytes = static_cast<uint64_t>(file_size_mb) * 1024 * 1024;
+  options_.pattern = type == mojo_ipc::DiskReadRoutineTypeEnum::kLinearRead
+                         ? DiskReadJobOptions::Pattern::kSequential
+                         : DiskReadJobOptions::Pattern::kRandom;
+  options_.queue_depth = ComputeQueueDepth(queue_depth);
+  options_.block_size_bytes = kBlockSizeBytes;
+  options_.duration = exec_duration;
+  expected_duration_ =
+      exec_duration +
+      base::TimeDelta::FromSecondsD(kFileCreationSecondsPerMB * file_size_mb);
+}
+
+DiskReadRoutine::~DiskReadRoutine() {
+  cancelled_ = true;
+  io_thread_.Stop();
+}
+
+void DiskReadRoutine::Start() {
+  DCHECK_EQ(status_, mojo_ipc::DiagnosticRoutineStatusEnum::kReady);
+
+  if (!HasSufficientStorageSpace()) {
+    status_ = mojo_ipc::DiagnosticRoutineStatusEnum::kFailed;
+    status_message_ = kDiskReadRoutineInsufficientSpaceMessage;
+    return;
+  }
+
+  if (!io_thread_.Start()) {
+    LOG(ERROR) << "Failed to start disk read thread";
+    status_ = mojo_ipc::DiagnosticRoutineStatusEnum::kError;
+    status_message_ = kDiskReadRoutineFailedMessage;
+    return;
+  }
+
+  start_ticks_ = base::TimeTicks::Now();
+  status_ = mojo_ipc::DiagnosticRoutineStatusEnum::kRunning;
+  status_message_ = kDiskReadRoutineRunningMessage;
+  base::PostTaskAndReplyWithResult(
+      io_thread_.task_runner().get(), FROM_HERE,
+      base::BindOnce(&RunDiskReadJob, options_, &cancelled_),
+      base::BindOnce(&DiskReadRoutine::OnJobComplete,
+                     weak_ptr_factory_.GetWeakPtr()));
+}
+
+// The disk read routine is not interactive.
+void DiskReadRoutine::Resume() {}
+
+void DiskReadRoutine::Cancel() {
+  if (status_ != mojo_ipc::DiagnosticRoutineStatusEnum::kRunning)
+    return;
+  cancelled_ = true;
+  status_ = mojo_ipc::DiagnosticRoutineStatusEnum::kCancelling;
+}
+
+void DiskReadRoutine::PopulateStatusUpdate(mojo_ipc::RoutineUpdate* response,
+                                           bool include_output) {
+  DCHECK(response);
+
+  mojo_ipc::NonInteractiveRoutineUpdate update;
+  update.status = status_;
+  update.status_message = status_message_;
+  response->routine_update_union->set_noninteractive_update(update.Clone());
+
+  if (include_output && !output_dict_.DictEmpty()) {
+    std::string json;
+    base::JSONWriter::WriteWithOptions(
+        output_dict_, base::JSONWriter::Options::OPTIONS_PRETTY_PRINT, &json);
+    response->output =
+        CreateReadOnlySharedMemoryRegionMojoHandle(base::StringPiece(json));
+  }
+
+  switch (status_) {
+    case mojo_ipc::DiagnosticRoutineStatusEnum::kReady:
+      response->progress_percent = 0;
+      return;
+    case mojo_ipc::DiagnosticRoutineStatusEnum::kRunning:
+    case mojo_ipc::DiagnosticRoutineStatusEnum::kCancelling: {
+      // Cap the progress at 99, in case it's taking longer than estimated.
+      const base::TimeDelta elapsed = base::TimeTicks::Now() - start_ticks_;
+      response->progress_percent = std::min<int64_t>(
+          99, elapsed.InMicroseconds() * 100 /
+                  std::max<int64_t>(1, expected_duration_.InMicroseconds()));
+      return;
     }
-  });
+    default:
+      response->progress_percent = 100;
+      return;
+  }
+}
+
+mojo_ipc::DiagnosticRoutineStatusEnum DiskReadRoutine::GetStatus() {
+  return status_;
+}
+
+bool DiskReadRoutine::HasSufficientStorageSpace() {
+  // Keep the stateful partition out of its "low space" state during the test.
+  const int64_t available_bytes =
+      base::SysInfo::AmountOfFreeDiskSpace(options_.file_path.DirName());
+  if (available_bytes == -1) {
+    LOG(ERROR) << "Failed to retrieve available disk space";
+    return false;
+  }
+  if (available_bytes / 1024 / 1024 - kSpaceLowMB < file_size_mb_) {
+    LOG(ERROR) << "Insufficient storage space";
+    return false;
+  }
+  return true;
+}
 
-  subproc_routine_ptr->RegisterPreStartCallback(std::move(storage_space_check));
-  subproc_routine_ptr->RegisterPostStopCallback(std::move(test_file_deletion));
+void DiskReadRoutine::OnJobComplete(DiskReadJobResult result) {
+  output_dict_.SetKey("resultDetails",
+                      DiskReadJobResultToValue(options_, result));
+
+  if (status_ == mojo_ipc::DiagnosticRoutineStatusEnum::kCancelling) {
+    status_ = mojo_ipc::DiagnosticRoutineStatusEnum::kCancelled;
+    status_message_ = kDiskReadRoutineCancelledMessage;
+    return;
+  }
+
+  if (result.success) {
+    status_ = mojo_ipc::DiagnosticRoutineStatusEnum::kPassed;
+    status_message_ = kDiskReadRoutineSucceededMessage;
+  } else {
+    status_ = mojo_ipc::DiagnosticRoutineStatusEnum::kFailed;
+    status_message_ = kDiskReadRoutineFailedMessage;
+  }
+}
 
-  return std::move(subproc_routine_ptr);
+std::unique_ptr<DiagnosticRoutine> CreateDiskReadRoutine(
+    mojo_ipc::DiskReadRoutineTypeEnum type,
+    base::TimeDelta exec_duration,
+    uint32_t file_size_mb,
+    uint32_t queue_depth) {
+  return std::make_unique<DiskReadRoutine>(type, exec_duration, file_size_mb,
+                                           queue_depth);
 }
 
 }  // namespace diagnostics
@@ -5,21 +5,103 @@
 #ifndef DIAGNOSTICS_CROS_HEALTHD_ROUTINES_DISK_READ_DISK_READ_H_
 #define DIAGNOSTICS_CROS_HEALTHD_ROUTINES_DISK_READ_DISK_READ_H_
 
+#include <atomic>
 #include <cstdint>
 #include <memory>
+#include <string>
 
+#include <base/files/file_path.h>
+#include <base/memory/weak_ptr.h>
+#include <base/threading/thread.h>
 #include <base/time/time.h>
-#include <brillo/process/process.h>
+#include <base/values.h>
 
-#include "diagnostics/cros_healthd/routines/subproc_routine.h"
+#include "diagnostics/cros_healthd/routines/diag_routine.h"
+#include "diagnostics/cros_healthd/routines/disk_read/disk_read_job.h"
 #include "mojo/cros_healthd_diagnostics.mojom.h"
 
 namespace diagnostics {
 
+// Status messages reported by the disk read routine.
+extern const char kDiskReadRoutineSucceededMessage[];
+extern const char kDiskReadRoutineFailedMessage[];
+extern const char kDiskReadRoutineInsufficientSpaceMessage[];
+extern const char kDiskReadRoutineRunningMessage[];
+extern const char kDiskReadRoutineCancelledMessage[];
+
+// The disk read routine creates a test file and reads it back with O_DIRECT
+// asynchronous I/O for a fixed time, reporting IOPS, bandwidth and latency
+// percentiles in its output. The I/O runs on a dedicated thread.
+class DiskReadRoutine final : public DiagnosticRoutine {
+ public:
+  // Number of reads kept in flight when the caller asks for 0.
+  static constexpr uint32_t kDefaultQueueDepth = 32;
+  // Larger requested queue depths are capped to this one.
+  static constexpr uint32_t kMaxQueueDepth = 256;
+  // Size of each read.
+  static constexpr uint32_t kBlockSizeBytes = 4096;
+
+  // Returns the queue depth used when |requested_queue_depth| is requested.
+  static uint32_t ComputeQueueDepth(uint32_t requested_queue_depth);
+
+  // |queue_depth| goes through ComputeQueueDepth(), and the depth used is
+  // reported in the routine's output. Override |test_dir| for testing only.
+  DiskReadRoutine(chromeos::cros_healthd::mojom::DiskReadRoutineTypeEnum type,
+                  base::TimeDelta exec_duration,
+                  uint32_t file_size_mb,
+                  uint32_t queue_depth,
+                  const base::FilePath& test_dir = base::FilePath());
+  DiskReadRoutine(const DiskReadRoutine&) = delete;
+  DiskReadRoutine& operator=(const DiskReadRoutine&) = delete;
+  ~DiskReadRoutine() override;
+
+  // DiagnosticRoutine overrides:
+  void Start() override;
+  void Resume() override;
+  void Cancel() override;
+  void PopulateStatusUpdate(
+      chromeos::cros_healthd::mojom::RoutineUpdate* response,
+      bool include_output) override;
+  chromeos::cros_healthd::mojom::DiagnosticRoutineStatusEnum GetStatus()
+      override;
+
+ private:
+  // Returns whether the test file fits without leaving the stateful partition
+  // low on space.
+  bool HasSufficientStorageSpace();
+  // Records the outcome of the job run on |io_thread_|.
+  void OnJobComplete(DiskReadJobResult result);
+
+  DiskReadJobOptions options_;
+  const uint32_t file_size_mb_;
+
+  // Status of the routine, reported by GetStatus() or routine updates.
+  chromeos::cros_healthd::mojom::DiagnosticRoutineStatusEnum status_;
+  // Details of the routine's status, reported in all status updates.
+  std::string status_message_;
+  // Results of the job. Reported in status updates when requested.
+  base::Value output_dict_{base::Value::Type::DICTIONARY};
+
+  // When the routine started, and how long it is expected to take. Used to
+  // calculate the routine's progress percent.
+  base::TimeTicks start_ticks_;
+  base::TimeDelta expected_duration_;
+
+  // Set to stop the job early. Read on |io_thread_|.
+  std::atomic<bool> cancelled_{false};
+  // Runs the job. Declared after every member the job uses, so that it is
+  // joined before they are destroyed.
+  base::Thread io_thread_{"DiskReadRoutine"};
+
+  // Must be the last class member.
+  base::WeakPtrFactory<DiskReadRoutine> weak_ptr_factory_{this};
+};
+
 std::unique_ptr<DiagnosticRoutine> CreateDiskReadRoutine(
     chromeos::cros_healthd::mojom::DiskReadRoutineTypeEnum type,
     base::TimeDelta exec_duration,
-    uint32_t file_size_mb);
+    uint32_t file_size_mb,
+    uint32_t queue_depth);
 
 }  // namespace diagnostics
 
@@ -0,0 +1,421 @@
+// Copyright 2020 The Chromium OS Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "diagnostics/cros_healthd/routines/disk_read/disk_read_job.h"
+
+#include <fcntl.h>
+#include <linux/aio_abi.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <utility>
+
+#include <base/files/file_util.h>
+#include <base/files/scoped_file.h>
+#include <base/logging.h>
+#include <base/posix/eintr_wrapper.h>
+#include <base/rand_util.h>
+#include <base/strings/stringprintf.h>
+
+namespace diagnostics {
+
+namespace {
+
+// Number of linear sub-buckets per power of two in LatencyHistogram.
+constexpr int kSubBucketBits = 4;
+constexpr uint64_t kSubBuckets = 1 << kSubBucketBits;
+constexpr size_t kNumBuckets =
+    kSubBuckets + (64 - kSubBucketBits) * kSubBuckets;
+
+// Alignment required of buffers used for O_DIRECT.
+constexpr size_t kDirectIoAlignment = 4096;
+// Size of each write used to fill the test file.
+constexpr uint64_t kFillChunkBytes = 1024 * 1024;
+// How long to wait for completions before checking for cancellation.
+constexpr int64_t kCompletionPollMilliseconds = 100;
+
+// The first bytes of each block of the test file hold the block's offset, so
+// that a read returning the wrong block is detected.
+using BlockStamp = uint64_t;
+
+struct FreeDeleter {
+  void operator()(void* ptr) const { free(ptr); }
+};
+using AlignedBuffer = std::unique_ptr<uint8_t, FreeDeleter>;
+
+AlignedBuffer AllocateAlignedBuffer(size_t size) {
+  void* ptr = nullptr;
+  if (posix_memalign(&ptr, kDirectIoAlignment, size))
+    return nullptr;
+  memset(ptr, 0, size);
+  return AlignedBuffer(static_cast<uint8_t*>(ptr));
+}
+
+// glibc provides no wrappers for the kernel AIO interface.
+int IoSetup(unsigned int nr_events, aio_context_t* ctx) {
+  return syscall(__NR_io_setup, nr_events, ctx);
+}
+
+int IoDestroy(aio_context_t ctx) {
+  return syscall(__NR_io_destroy, ctx);
+}
+
+int IoSubmit(aio_context_t ctx, int64_t nr, struct iocb** iocbs) {
+  return syscall(__NR_io_submit, ctx, nr, iocbs);
+}
+
+int IoGetevents(aio_context_t ctx,
+                int64_t min_nr,
+                int64_t max_nr,
+                struct io_event* events,
+                struct timespec* timeout) {
+  return syscall(__NR_io_getevents, ctx, min_nr, max_nr, events, timeout);
+}
+
+// Opens |path| with O_DIRECT if the filesystem supports it, or without
+// otherwise. Sets |direct_io| to whether O_DIRECT was used.
+base::ScopedFD OpenMaybeDirect(const base::FilePath& path,
+                               int flags,
+                               bool* direct_io) {
+  base::ScopedFD fd(HANDLE_EINTR(
+      open(path.value().c_str(), flags | O_DIRECT | O_CLOEXEC, 0600)));
+  if (fd.is_valid() || errno != EINVAL) {
+    *direct_io = fd.is_valid();
+    return fd;
+  }
+  *direct_io = false;
+  return base::ScopedFD(
+      HANDLE_EINTR(open(path.value().c_str(), flags | O_CLOEXEC, 0600)));
+}
+
+// Creates |path| with |num_blocks| stamped blocks of |block_size| bytes, and
+// flushes it to storage. Returns false and sets |error| on failure.
+bool CreateTestFile(const base::FilePath& path,
+                    uint64_t num_blocks,
+                    uint32_t block_size,
+                    bool* direct_io,
+                    std::string* error) {
+  base::ScopedFD fd =
+      OpenMaybeDirect(path, O_WRONLY | O_CREAT | O_TRUNC, direct_io);
+  if (!fd.is_valid()) {
+    *error = "Failed to create " + path.value();
+    PLOG(ERROR) << *error;
+    return false;
+  }
+
+  const uint64_t file_size = num_blocks * block_size;
+  // Reserve the whole file up front, so that running out of space fails fast
+  // and the file is laid out as contiguously as the filesystem allows.
+  if (fallocate(fd.get(), 0, 0, file_size) && errno != EOPNOTSUPP) {
+    *error = "Failed to allocate " + path.value();
+    PLOG(ERROR) << *error;
+    return false;
+  }
+
+  // fallocate() leaves the blocks unwritten, and reads of unwritten blocks
+  // never reach the device, so the file must be filled.
+  const uint64_t chunk_size =
+      std::max<uint64_t>(block_size, kFillChunkBytes / block_size * block_size);
+  AlignedBuffer chunk = AllocateAlignedBuffer(chunk_size);
+  if (!chunk) {
+    *error = "Failed to allocate I/O buffer";
+    return false;
+  }
+  for (uint64_t offset = 0; offset < file_size; offset += chunk_size) {
+    const uint64_t length = std::min(chunk_size, file_size - offset);
+    for (uint64_t block = 0; block < length; block += block_size) {
+      const BlockStamp stamp = offset + block;
+      memcpy(chunk.get() + block, &stamp, sizeof(stamp));
+    }
+    if (HANDLE_EINTR(pwrite(fd.get(), chunk.get(), length, offset)) !=
+        static_cast<ssize_t>(length)) {
+      *error = "Failed to write " + path.value();
+      PLOG(ERROR) << *error;
+      return false;
+    }
+  }
+
+  if (HANDLE_EINTR(fdatasync(fd.get()))) {
+    *error = "Failed to sync " + path.value();
+    PLOG(ERROR) << *error;
+    return false;
+  }
+  return true;
+}
+
+// Reads |num_blocks| blocks of |fd| with the kernel AIO interface, keeping
+// |options.queue_depth| reads in flight, until the deadline or cancellation.
+void RunReads(int fd,
+              uint64_t num_blocks,
+              const DiskReadJobOptions& options,
+              const std::atomic<bool>* cancelled,
+              DiskReadJobResult* result) {
+  const uint32_t depth = options.queue_depth;
+  const uint32_t block_size = options.block_size_bytes;
+
+  aio_context_t ctx = 0;
+  if (IoSetup(depth, &ctx)) {
+    result->error = "io_setup failed";
+    PLOG(ERROR) << result->error;
+    return;
+  }
+
+  AlignedBuffer buffers = AllocateAlignedBuffer(depth * block_size);
+  if (!buffers) {
+    IoDestroy(ctx);
+    result->error = "Failed to allocate I/O buffers";
+    return;
+  }
+
+  std::mt19937_64 random(base::RandUint64());
+  uint64_t next_sequential_block = 0;
+  auto next_offset = [&]() -> uint64_t {
+    uint64_t block;
+    if (options.pattern == DiskReadJobOptions::Pattern::kRandom) {
+      block = random() % num_blocks;
+    } else {
+      block = next_sequential_block;
+      next_sequential_block = (next_sequential_block + 1) % num_blocks;
+    }
+    return block * block_size;
+  };
+
+  std::vector<struct iocb> iocbs(depth);
+  std::vector<base::TimeTicks> submit_times(depth);
+  std::vector<struct iocb*> to_submit;
+  to_submit.reserve(depth);
+  std::vector<struct io_event> events(depth);
+
+  auto prepare = [&](uint32_t slot) {
+    struct iocb* cb = &iocbs[slot];
+    memset(cb, 0, sizeof(*cb));
+    cb->aio_data = slot;
+    cb->aio_lio_opcode = IOCB_CMD_PREAD;
+    cb->aio_fildes = fd;
+    cb->aio_buf = reinterpret_cast<uint64_t>(buffers.get() +
+                                             static_cast<size_t>(slot) *
+                                                 block_size);
+    cb->aio_nbytes = block_size;
+    cb->aio_offset = next_offset();
+    to_submit.push_back(cb);
+  };
+
+  // Submits everything in |to_submit|. Returns false on error, leaving the
+  // reads which were not submitted in |to_submit|.
+  auto submit = [&]() -> bool {
+    size_t submitted = 0;
+    const base::TimeTicks now = base::TimeTicks::Now();
+    for (auto* cb : to_submit)
+      submit_times[cb->aio_data] = now;
+    while (submitted < to_submit.size()) {
+      int ret = IoSubmit(ctx, to_submit.size() - submitted,
+                         to_submit.data() + submitted);
+      if (ret < 0 && errno == EINTR)
+        continue;
+      if (ret <= 0) {
+        result->error = "io_submit failed";
+        PLOG(ERROR) << result->error;
+        to_submit.erase(to_submit.begin(), to_submit.begin() + submitted);
+        return false;
+      }
+      submitted += ret;
+    }
+    to_submit.clear();
+    return true;
+  };
+
+  const base::TimeTicks start = base::TimeTicks::Now();
+  const base::TimeTicks deadline = start + options.duration;
+  for (uint32_t slot = 0; slot < depth; slot++)
+    prepare(slot);
+  uint32_t in_flight = depth;
+  if (!submit()) {
+    in_flight -= to_submit.size();
+    to_submit.clear();
+  }
+
+  while (in_flight > 0) {
+    struct timespec timeout = {0, kCompletionPollMilliseconds * 1000 * 1000};
+    int num_events = IoGetevents(ctx, 1, depth, events.data(), &timeout);
+    if (num_events < 0) {
+      if (errno == EINTR)
+        continue;
+      result->error = "io_getevents failed";
+      PLOG(ERROR) << result->error;
+      break;
+    }
+
+    const base::TimeTicks now = base::TimeTicks::Now();
+    const bool keep_going =
+        now < deadline && !cancelled->load() && result->error.empty();
+    for (int i = 0; i < num_events; i++) {
+      const struct io_event& event = events[i];
+      const uint32_t slot = static_cast<uint32_t>(event.data);
+      result->latency_us.Add((now - submit_times[slot]).InMicroseconds());
+
+      if (event.res != static_cast<int64_t>(block_size)) {
+        if (result->error.empty()) {
+          result->error = base::StringPrintf(
+              "Read at offset %llu returned %lld",
+              static_cast<unsigned long long>(iocbs[slot].aio_offset),
+              static_cast<long long>(event.res));
+          LOG(ERROR) << result->error;
+        }
+      } else {
+        result->reads_completed++;
+        result->bytes_read += block_size;
+        BlockStamp stamp;
+        memcpy(&stamp,
+               buffers.get() + static_cast<size_t>(slot) * block_size,
+               sizeof(stamp));
+        if (stamp != iocbs[slot].aio_offset)
+          result->verification_failures++;
+      }
+
+      if (keep_going)
+        prepare(slot);
+      else
+        in_flight--;
+    }
+    if (!to_submit.empty() && !submit()) {
+      // Reads that were not submitted will never complete.
+      in_flight -= to_submit.size();
+      to_submit.clear();
+    }
+  }
+  result->elapsed = base::TimeTicks::Now() - start;
+
+  // Destroying the context waits for anything still in flight after an error.
+  IoDestroy(ctx);
+}
+
+}  // namespace
+
+LatencyHistogram::LatencyHistogram() : buckets_(kNumBuckets) {}
+
+LatencyHistogram::~LatencyHistogram() = default;
+
+void LatencyHistogram::Add(uint64_t value) {
+  buckets_[BucketIndex(value)]++;
+  count_++;
+  max_ = std::max(max_, value);
+}
+
+uint64_t LatencyHistogram::Percentile(double percentile) const {
+  if (count_ == 0)
+    return 0;
+
+  const uint64_t rank = std::max<uint64_t>(
+      1, static_cast<uint64_t>(std::ceil(percentile / 100 * count_)));
+  uint64_t seen = 0;
+  for (size_t i = 0; i < buckets_.size(); i++) {
+    seen += buckets_[i];
+    if (seen >= rank)
+      return BucketLowerBound(i);
+  }
+  return max_;
+}
+
+// static
+size_t LatencyHistogram::BucketIndex(uint64_t value) {
+  if (value < kSubBuckets)
+    return value;
+  const int msb = 63 - __builtin_clzll(value);
+  const uint64_t sub_bucket =
+      (value >> (msb - kSubBucketBits)) & (kSubBuckets - 1);
+  return kSubBuckets + (msb - kSubBucketBits) * kSubBuckets + sub_bucket;
+}
+
+// static
+uint64_t LatencyHistogram::BucketLowerBound(size_t index) {
+  if (index < kSubBuckets)
+    return index;
+  const size_t shift = (index - kSubBuckets) / kSubBuckets;
+  const uint64_t sub_bucket = (index - kSubBuckets) % kSubBuckets;
+  return (kSubBuckets + sub_bucket) << shift;
+}
+
+DiskReadJobResult::DiskReadJobResult() = default;
+DiskReadJobResult::DiskReadJobResult(const DiskReadJobResult&) = default;
+DiskReadJobResult& DiskReadJobResult::operator=(const DiskReadJobResult&) =
+    default;
+DiskReadJobResult::~DiskReadJobResult() = default;
+
+DiskReadJobResult RunDiskReadJob(const DiskReadJobOptions& options,
+                                 const std::atomic<bool>* cancelled) {
+  DCHECK(cancelled);
+  DCHECK_GT(options.queue_depth, 0);
+  DCHECK_GT(options.block_size_bytes, 0);
+
+  DiskReadJobResult result;
+  const uint64_t num_blocks =
+      std::max<uint64_t>(1, options.file_size_bytes / options.block_size_bytes);
+
+  if (!CreateTestFile(options.file_path, num_blocks, options.block_size_bytes,
+                      &result.direct_io, &result.error)) {
+    base::DeleteFile(options.file_path, false);
+    return result;
+  }
+
+  bool direct_io;
+  base::ScopedFD fd = OpenMaybeDirect(options.file_path, O_RDONLY, &direct_io);
+  if (!fd.is_valid()) {
+    result.error = "Failed to open " + options.file_path.value();
+    PLOG(ERROR) << result.error;
+  } else {
+    result.direct_io = direct_io;
+    // Without O_DIRECT, at least start with none of the file cached.
+    if (!direct_io)
+      posix_fadvise(fd.get(), 0, 0, POSIX_FADV_DONTNEED);
+    RunReads(fd.get(), num_blocks, options, cancelled, &result);
+  }
+
+  fd.reset();
+  base::DeleteFile(options.file_path, false);
+  result.success = result.error.empty() && result.verification_failures == 0 &&
+                   !cancelled->load();
+  return result;
+}
+
+base::Value DiskReadJobResultToValue(const DiskReadJobOptions& options,
+                                     const DiskReadJobResult& result) {
+  base::Value value(base::Value::Type::DICTIONARY);
+  value.SetStringKey("pattern",
+                     options.pattern == DiskReadJobOptions::Pattern::kRandom
+                         ? "random"
+                         : "sequential");
+  value.SetBoolKey("directIo", result.direct_io);
+  value.SetIntKey("queueDepth", options.queue_depth);
+  value.SetIntKey("blockSizeBytes", options.block_size_bytes);
+  value.SetDoubleKey("readsCompleted", result.reads_completed);
+  value.SetDoubleKey("bytesRead", result.bytes_read);
+  value.SetDoubleKey("verificationFailures", result.verification_failures);
+
+  const double seconds = result.elapsed.InSecondsF();
+  if (seconds > 0) {
+    value.SetDoubleKey("iops", result.reads_completed / seconds);
+    value.SetDoubleKey("bandwidthKiBPerSecond",
+                       result.bytes_read / 1024.0 / seconds);
+  }
+
+  base::Value latency(base::Value::Type::DICTIONARY);
+  latency.SetDoubleKey("p50", result.latency_us.Percentile(50));
+  latency.SetDoubleKey("p90", result.latency_us.Percentile(90));
+  latency.SetDoubleKey("p99", result.latency_us.Percentile(99));
+  latency.SetDoubleKey("p999", result.latency_us.Percentile(99.9));
+  latency.SetDoubleKey("max", result.latency_us.max());
+  value.SetKey("latencyMicroseconds", std::move(latency));
+
+  if (!result.error.empty())
+    value.SetStringKey("error", result.error);
+  return value;
+}
+
+}  // namespace diagnostics
@@ -0,0 +1,104 @@
+// Copyright 2020 The Chromium OS Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef DIAGNOSTICS_CROS_HEALTHD_ROUTINES_DISK_READ_DISK_READ_JOB_H_
+#define DIAGNOSTICS_CROS_HEALTHD_ROUTINES_DISK_READ_DISK_READ_JOB_H_
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <base/files/file_path.h>
+#include <base/time/time.h>
+#include <base/values.h>
+
+namespace diagnostics {
+
+// Records latencies in power-of-two buckets, each split into 16 linear
+// sub-buckets, so percentiles are accurate to about 6% in constant memory.
+class LatencyHistogram {
+ public:
+  LatencyHistogram();
+  LatencyHistogram(const LatencyHistogram&) = default;
+  LatencyHistogram& operator=(const LatencyHistogram&) = default;
+  ~LatencyHistogram();
+
+  void Add(uint64_t value);
+
+  // Returns the lower bound of the bucket holding the value at |percentile|,
+  // which must be in [0, 100], or 0 if no values were added.
+  uint64_t Percentile(double percentile) const;
+
+  uint64_t count() const { return count_; }
+  uint64_t max() const { return max_; }
+
+ private:
+  static size_t BucketIndex(uint64_t value);
+  static uint64_t BucketLowerBound(size_t index);
+
+  std::vector<uint64_t> buckets_;
+  uint64_t count_ = 0;
+  uint64_t max_ = 0;
+};
+
+// Parameters of a disk read job.
+struct DiskReadJobOptions {
+  enum class Pattern {
+    kSequential,
+    kRandom,
+  };
+
+  // Test file to create, read and delete.
+  base::FilePath file_path;
+  // Size of the test file. Rounded down to a whole number of blocks.
+  uint64_t file_size_bytes = 0;
+  Pattern pattern = Pattern::kSequential;
+  // Number of reads kept in flight at once.
+  uint32_t queue_depth = 0;
+  // Size of each read. Must be a multiple of the logical block size of the
+  // underlying device.
+  uint32_t block_size_bytes = 0;
+  // How long to read for, not counting creation of the test file.
+  base::TimeDelta duration;
+};
+
+// Outcome of a disk read job.
+struct DiskReadJobResult {
+  DiskReadJobResult();
+  DiskReadJobResult(const DiskReadJobResult&);
+  DiskReadJobResult& operator=(const DiskReadJobResult&);
+  ~DiskReadJobResult();
+
+  // Whether the job ran to completion with no I/O or verification errors.
+  bool success = false;
+  // Describes the first error, if any.
+  std::string error;
+  // Whether the file was accessed with O_DIRECT. False if the filesystem does
+  // not support it, in which case reads may be served from the page cache.
+  bool direct_io = false;
+  uint64_t reads_completed = 0;
+  uint64_t bytes_read = 0;
+  // Reads which returned data belonging to a different block.
+  uint64_t verification_failures = 0;
+  // Time spent reading.
+  base::TimeDelta elapsed;
+  // Latency of each read, in microseconds.
+  LatencyHistogram latency_us;
+};
+
+// Creates the test file with fallocate() and fills it, then reads it with
+// |options.queue_depth| asynchronous reads in flight until |options.duration|
+// has elapsed or |cancelled| is set, and deletes it. This blocks for the whole
+// job, so must not be called on the daemon thread.
+DiskReadJobResult RunDiskReadJob(const DiskReadJobOptions& options,
+                                 const std::atomic<bool>* cancelled);
+
+// Returns the report of |result| included in the disk read routine's output.
+base::Value DiskReadJobResultToValue(const DiskReadJobOptions& options,
+                                     const DiskReadJobResult& result);
+
+}  // namespace diagnostics
+
+#endif  // DIAGNOSTICS_CROS_HEALTHD_ROUTINES_DISK_READ_DISK_READ_JOB_H_
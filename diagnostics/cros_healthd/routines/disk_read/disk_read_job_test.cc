@@ -0,0 +1,116 @@
+// Copyright 2020 The Chromium OS Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <atomic>
+#include <cstdint>
+
+#include <base/files/file_util.h>
+#include <base/files/scoped_temp_dir.h>
+#include <base/time/time.h>
+#include <gtest/gtest.h>
+
+#include "diagnostics/cros_healthd/routines/disk_read/disk_read_job.h"
+
+namespace diagnostics {
+
+namespace {
+
+constexpr uint32_t kBlockSizeBytes = 4096;
+constexpr uint64_t kFileSizeBytes = 256 * kBlockSizeBytes;
+
+DiskReadJobOptions MakeOptions(const base::FilePath& dir,
+                               DiskReadJobOptions::Pattern pattern) {
+  DiskReadJobOptions options;
+  options.file_path = dir.Append("test-file");
+  options.file_size_bytes = kFileSizeBytes;
+  options.pattern = pattern;
+  options.queue_depth = 4;
+  options.block_size_bytes = kBlockSizeBytes;
+  options.duration = base::TimeDelta::FromMilliseconds(200);
+  return options;
+}
+
+}  // namespace
+
+// Test that an empty histogram reports zero for every percentile.
+TEST(LatencyHistogramTest, Empty) {
+  LatencyHistogram histogram;
+  EXPECT_EQ(histogram.count(), 0u);
+  EXPECT_EQ(histogram.Percentile(50), 0u);
+  EXPECT_EQ(histogram.Percentile(100), 0u);
+}
+
+// Test that small values are recorded exactly.
+TEST(LatencyHistogramTest, SmallValuesAreExact) {
+  LatencyHistogram histogram;
+  for (uint64_t i = 1; i <= 10; i++)
+    histogram.Add(i);
+  EXPECT_EQ(histogram.count(), 10u);
+  EXPECT_EQ(histogram.max(), 10u);
+  EXPECT_EQ(histogram.Percentile(50), 5u);
+  EXPECT_EQ(histogram.Percentile(100), 10u);
+}
+
+// Test that percentiles of large values are within the bucket resolution.
+TEST(LatencyHistogramTest, LargeValuesAreApproximate) {
+  LatencyHistogram histogram;
+  for (uint64_t i = 1; i <= 1000; i++)
+    histogram.Add(i * 1000);
+  EXPECT_EQ(histogram.max(), 1000000u);
+
+  const uint64_t p90 = histogram.Percentile(90);
+  EXPECT_LE(p90, 900000u);
+  EXPECT_GE(p90, 900000u - 900000u / 16);
+}
+
+// Test that a sequential job reads back and verifies the whole file, and
+// removes it afterwards.
+TEST(DiskReadJobTest, SequentialRead) {
+  base::ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  const DiskReadJobOptions options = MakeOptions(
+      temp_dir.GetPath(), DiskReadJobOptions::Pattern::kSequential);
+  std::atomic<bool> cancelled{false};
+
+  const DiskReadJobResult result = RunDiskReadJob(options, &cancelled);
+
+  EXPECT_TRUE(result.success) << result.error;
+  EXPECT_GE(result.reads_completed, kFileSizeBytes / kBlockSizeBytes);
+  EXPECT_EQ(result.bytes_read, result.reads_completed * kBlockSizeBytes);
+  EXPECT_EQ(result.verification_failures, 0u);
+  EXPECT_EQ(result.latency_us.count(), result.reads_completed);
+  EXPECT_FALSE(base::PathExists(options.file_path));
+}
+
+// Test that a random job completes without verification failures.
+TEST(DiskReadJobTest, RandomRead) {
+  base::ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  const DiskReadJobOptions options =
+      MakeOptions(temp_dir.GetPath(), DiskReadJobOptions::Pattern::kRandom);
+  std::atomic<bool> cancelled{false};
+
+  const DiskReadJobResult result = RunDiskReadJob(options, &cancelled);
+
+  EXPECT_TRUE(result.success) << result.error;
+  EXPECT_GT(result.reads_completed, 0u);
+  EXPECT_EQ(result.verification_failures, 0u);
+}
+
+// Test that a cancelled job stops early and reports failure.
+TEST(DiskReadJobTest, Cancelled) {
+  base::ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  DiskReadJobOptions options = MakeOptions(
+      temp_dir.GetPath(), DiskReadJobOptions::Pattern::kSequential);
+  options.duration = base::TimeDelta::FromMinutes(10);
+  std::atomic<bool> cancelled{true};
+
+  const DiskReadJobResult result = RunDiskReadJob(options, &cancelled);
+
+  EXPECT_FALSE(result.success);
+  EXPECT_FALSE(base::PathExists(options.file_path));
+}
+
+}  // namespace diagnostics
@@ -0,0 +1,34 @@
+// Copyright 2020 The Chromium OS Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gtest/gtest.h>
+
+#include "diagnostics/cros_healthd/routines/disk_read/disk_read.h"
+
+namespace diagnostics {
+
+// Test that a queue depth of 0 selects the default one.
+TEST(DiskReadRoutineTest, ZeroQueueDepthUsesDefault) {
+  EXPECT_EQ(DiskReadRoutine::ComputeQueueDepth(0),
+            DiskReadRoutine::kDefaultQueueDepth);
+}
+
+// Test that supported queue depths are used as requested.
+TEST(DiskReadRoutineTest, SupportedQueueDepthIsKept) {
+  EXPECT_EQ(DiskReadRoutine::ComputeQueueDepth(1), 1u);
+  EXPECT_EQ(DiskReadRoutine::ComputeQueueDepth(64), 64u);
+  EXPECT_EQ(DiskReadRoutine::ComputeQueueDepth(DiskReadRoutine::kMaxQueueDepth),
+            DiskReadRoutine::kMaxQueueDepth);
+}
+
+// Test that queue depths above the maximum are capped.
+TEST(DiskReadRoutineTest, LargeQueueDepthIsCapped) {
+  EXPECT_EQ(
+      DiskReadRoutine::ComputeQueueDepth(DiskReadRoutine::kMaxQueueDepth + 1),
+      DiskReadRoutine::kMaxQueueDepth);
+  EXPECT_EQ(DiskReadRoutine::ComputeQueueDepth(UINT32_MAX),
+            DiskReadRoutine::kMaxQueueDepth);
+}
+
+}  // namespace diagnostics
@@ -2,18 +2,117 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <sched.h>
 #include <stdlib.h>
+
+#include <algorithm>
 #include <cmath>
 #include <cstdint>
+#include <memory>
+#include <vector>
 
+#include <base/logging.h>
+#include <base/strings/stringprintf.h>
+#include <base/threading/simple_thread.h>
 #include <base/time/time.h>
 #include <brillo/flag_helper.h>
 
 #include "diagnostics/cros_healthd/routines/prime_search/prime_number_search.h"
 
+namespace {
+
+// Searches the segments of [2, max_num] assigned to one worker, pinned to one
+// CPU, until the deadline. Segments are interleaved between workers so that
+// each gets a similar share of the larger, more expensive numbers.
+class PrimeSearchWorker : public base::DelegateSimpleThread::Delegate {
+ public:
+  PrimeSearchWorker(int cpu,
+                    uint64_t worker_index,
+                    uint64_t num_workers,
+                    uint64_t max_num,
+                    base::TimeTicks end_time)
+      : cpu_(cpu),
+        worker_index_(worker_index),
+        num_workers_(num_workers),
+        max_num_(max_num),
+        end_time_(end_time),
+        prime_number_search_(max_num) {}
+  PrimeSearchWorker(const PrimeSearchWorker&) = delete;
+  PrimeSearchWorker& operator=(const PrimeSearchWorker&) = delete;
+
+  // base::DelegateSimpleThread::Delegate overrides:
+  void Run() override {
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(cpu_, &cpu_set);
+    if (sched_setaffinity(0 /* calling thread */, sizeof(cpu_set), &cpu_set))
+      PLOG(WARNING) << "Failed to pin worker to CPU " << cpu_;
+
+    const base::TimeTicks start_time = base::TimeTicks::Now();
+    base::TimeTicks now = start_time;
+    while (now < end_time_) {
+      for (uint64_t begin = 2 + worker_index_ * kSieveSegmentSize;
+           begin <= max_num_ && now < end_time_;
+           begin += num_workers_ * kSieveSegmentSize) {
+        const uint64_t end = std::min(max_num_, begin + kSieveSegmentSize - 1);
+        if (!prime_number_search_.RunRange(begin, end)) {
+          LOG(ERROR) << "Prime number search failed on CPU " << cpu_;
+          failures_++;
+        }
+        numbers_checked_ += end - begin + 1;
+        now = base::TimeTicks::Now();
+      }
+      // Workers with no segment of a small range have nothing to do.
+      if (2 + worker_index_ * kSieveSegmentSize > max_num_)
+        break;
+    }
+    elapsed_ = now - start_time;
+  }
+
+  int cpu() const { return cpu_; }
+  uint64_t numbers_checked() const { return numbers_checked_; }
+  int failures() const { return failures_; }
+
+  // Numbers checked per second of this worker's run.
+  double Throughput() const {
+    const double seconds = elapsed_.InSecondsF();
+    return seconds > 0 ? numbers_checked_ / seconds : 0;
+  }
+
+ private:
+  const int cpu_;
+  const uint64_t worker_index_;
+  const uint64_t num_workers_;
+  const uint64_t max_num_;
+  const base::TimeTicks end_time_;
+  diagnostics::PrimeNumberSearch prime_number_search_;
+  uint64_t numbers_checked_ = 0;
+  int failures_ = 0;
+  base::TimeDelta elapsed_;
+};
+
+// Returns the CPUs this process may run on.
+std::vector<int> GetAvailableCpus() {
+  std::vector<int> cpus;
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  if (sched_getaffinity(0 /* this process */, sizeof(cpu_set), &cpu_set)) {
+    PLOG(ERROR) << "Failed to get CPU affinity";
+    return cpus;
+  }
+  for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+    if (CPU_ISSET(cpu, &cpu_set))
+      cpus.push_back(cpu);
+  }
+  return cpus;
+}
+
+}  // namespace
+
 // 'prime_search' command-line tool:
 //  Calculates prime number between 2 to max_num and verifies the calculation
-//  repeatedly within a duration.
+//  repeatedly within a duration, on every available CPU at once. Throughput
+//  and failures are reported for each CPU.
 int main(int argc, char** argv) {
   DEFINE_uint64(time, 10, "duration in seconds to run routine for.");
   DEFINE_uint64(max_num, diagnostics::kMaxPrimeNumber,
@@ -28,15 +127,36 @@ int main(int argc, char** argv) {
   if (FLAGS_max_num <= diagnostics::kMaxPrimeNumber && FLAGS_max_num >= 2)
     max_num = FLAGS_max_num;
 
-  auto prime_number_search =
-      std::make_unique<diagnostics::PrimeNumberSearch>(max_num);
-  bool result = false;
+  std::vector<int> cpus = GetAvailableCpus();
+  if (cpus.empty())
+    return EXIT_FAILURE;
+
+  std::vector<std::unique_ptr<PrimeSearchWorker>> workers;
+  std::vector<std::unique_ptr<base::DelegateSimpleThread>> threads;
+  for (size_t i = 0; i < cpus.size(); i++) {
+    workers.push_back(std::make_unique<PrimeSearchWorker>(
+        cpus[i], i, cpus.size(), max_num, end_time));
+    threads.push_back(std::make_unique<base::DelegateSimpleThread>(
+        workers.back().get(), base::StringPrintf("prime_search_%d", cpus[i])));
+    threads.back()->Start();
+  }
 
-  while (base::TimeTicks::Now() < end_time) {
-    result = prime_number_search->Run();
-    if (result == false)
-      break;
+  bool result = true;
+  uint64_t total_checked = 0;
+  for (size_t i = 0; i < workers.size(); i++) {
+    threads[i]->Join();
+    const PrimeSearchWorker& worker = *workers[i];
+    LOG(INFO) << base::StringPrintf(
+        "CPU %d: %.0f numbers/s, %d failures", worker.cpu(),
+        worker.Throughput(), worker.failures());
+    if (worker.failures() > 0)
+      result = false;
+    total_checked += worker.numbers_checked();
   }
 
+  // As before, a run that checked nothing is not a pass.
+  if (total_checked == 0)
+    result = false;
+
   return result == true ? EXIT_SUCCESS : EXIT_FAILURE;
 }
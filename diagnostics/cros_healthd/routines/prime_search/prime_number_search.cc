@@ -4,35 +4,76 @@
 
 #include "diagnostics/cros_healthd/routines/prime_search/prime_number_search.h"
 
+#include <algorithm>
 #include <cmath>
 
-#include <base/stl_util.h>
+#include <base/logging.h>
 
 namespace diagnostics {
 
+namespace {
+
+// Returns the largest integer whose square is at most |num|.
+uint64_t IntegerSquareRoot(uint64_t num) {
+  uint64_t root = static_cast<uint64_t>(std::sqrt(static_cast<double>(num)));
+  while (root * root > num)
+    root--;
+  while ((root + 1) * (root + 1) <= num)
+    root++;
+  return root;
+}
+
+}  // namespace
+
 PrimeNumberSearch::PrimeNumberSearch(uint64_t max_num) : max_num_(max_num) {
-  // Create a Sieve of Eratosthenes. This creates a bitfield of prime numbers
-  // from 0 - |max_number|.
-  // https://en.wikipedia.org/wiki/Sieve_of_Eratosthenes
-  for (uint64_t i = 2;
-       i <= static_cast<uint64_t>(std::sqrt(static_cast<double>(max_num_)));
-       i++) {
-    if (prime_sieve_[i]) {
-      for (uint64_t j = (i * i); j <= max_num_; j += i)
-        prime_sieve_[j] = 0;
-    }
+  // Only the primes up to the square root of |max_num_| are kept. Each segment
+  // checked by RunRange() is sieved with them, so memory use does not grow
+  // with |max_num_|.
+  // https://en.wikipedia.org/wiki/Sieve_of_Eratosthenes#Segmented_sieve
+  const uint64_t root = IntegerSquareRoot(max_num_);
+  std::vector<uint8_t> small_sieve(root + 1, 1);
+  for (uint64_t i = 2; i <= root; i++) {
+    if (!small_sieve[i])
+      continue;
+    base_primes_.push_back(i);
+    for (uint64_t j = i * i; j <= root; j += i)
+      small_sieve[j] = 0;
   }
+  segment_.reserve(kSieveSegmentSize);
 }
 
 bool PrimeNumberSearch::Run() {
-  for (uint64_t num = 2; num <= max_num_; num++) {
-    bool sieve_prime = prime_sieve_[num];
-    bool func_prime = IsPrime(num);
+  return RunRange(2, max_num_);
+}
 
-    if (sieve_prime != func_prime) {
-      LOG(ERROR) << "prime number mismatch: " << num
-                 << ". sieve: " << sieve_prime << " IsPrime(): " << func_prime;
-      return false;
+bool PrimeNumberSearch::RunRange(uint64_t begin, uint64_t end) {
+  begin = std::max<uint64_t>(begin, 2);
+  end = std::min(end, max_num_);
+
+  for (uint64_t low = begin; low <= end; low += kSieveSegmentSize) {
+    const uint64_t high = std::min(end, low + kSieveSegmentSize - 1);
+
+    segment_.assign(high - low + 1, 1);
+    for (const uint64_t prime : base_primes_) {
+      if (prime * prime > high)
+        break;
+      // Start from the first multiple of |prime| in the segment, but never
+      // from |prime| itself.
+      uint64_t multiple =
+          std::max(prime * prime, (low + prime - 1) / prime * prime);
+      for (; multiple <= high; multiple += prime)
+        segment_[multiple - low] = 0;
+    }
+
+    for (uint64_t num = low; num <= high; num++) {
+      bool sieve_prime = segment_[num - low];
+      bool func_prime = IsPrime(num);
+
+      if (sieve_prime != func_prime) {
+        LOG(ERROR) << "prime number mismatch: " << num << ". sieve: "
+                   << sieve_prime << " IsPrime(): " << func_prime;
+        return false;
+      }
     }
   }
 
@@ -5,14 +5,18 @@
 #ifndef DIAGNOSTICS_CROS_HEALTHD_ROUTINES_PRIME_SEARCH_PRIME_NUMBER_SEARCH_H_
 #define DIAGNOSTICS_CROS_HEALTHD_ROUTINES_PRIME_SEARCH_PRIME_NUMBER_SEARCH_H_
 
-#include <bitset>
 #include <cstdint>
+#include <vector>
 
 namespace diagnostics {
 
 // Largest number that routine will calculate prime numbers up to.
 constexpr uint64_t kMaxPrimeNumber = 1000000;
 
+// Number of values sieved at a time. One byte per value keeps a segment well
+// inside a core's L1 data cache.
+constexpr uint64_t kSieveSegmentSize = 16 * 1024;
+
 class PrimeNumberSearch {
  public:
   explicit PrimeNumberSearch(uint64_t max_num);
@@ -26,10 +30,18 @@ class PrimeNumberSearch {
   // without any error, false otherwise.
   bool Run();
 
+  // Executes the prime number search task over [|begin|, |end|], clamped to
+  // [2, max_num]. Returns true if searching is completed without any error,
+  // false otherwise.
+  bool RunRange(uint64_t begin, uint64_t end);
+
  private:
   const uint64_t max_num_ = 0;
-  std::bitset<kMaxPrimeNumber + 1> prime_sieve_ =
-      std::bitset<kMaxPrimeNumber + 1>().set();
+  // Primes up to the square root of |max_num_|, used to sieve each segment.
+  std::vector<uint64_t> base_primes_;
+  // Sieve of the segment being checked. Entry i is nonzero if the i-th number
+  // of the segment is prime.
+  std::vector<uint8_t> segment_;
 };
 
 }  // namespace diagnostics
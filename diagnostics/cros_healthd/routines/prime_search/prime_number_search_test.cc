@@ -57,6 +57,27 @@ TEST(PrimeNumbersSearchTest, RunFull) {
   EXPECT_TRUE(prime_search.Run());
 }
 
+// Test that ranges spanning several sieve segments, including ones which do
+// not start on a segment boundary, are verified correctly.
+TEST(PrimeNumberSearchTest, RunRangeAcrossSegments) {
+  PrimeNumberSearch prime_search(kMaxPrimeNumber);
+  EXPECT_TRUE(prime_search.RunRange(kSieveSegmentSize - 10,
+                                    3 * kSieveSegmentSize + 10));
+  EXPECT_TRUE(
+      prime_search.RunRange(kMaxPrimeNumber - 100, kMaxPrimeNumber + 100));
+}
+
+// Test RunRange() only checks numbers within the requested range.
+TEST(PrimeNumberSearchTest, RunRangeChecksOnlyRange) {
+  MockPrimeNumberSearchTest prime_search(100);
+
+  EXPECT_CALL(prime_search, IsPrime(5)).WillOnce(Return(true));
+  EXPECT_CALL(prime_search, IsPrime(6)).WillOnce(Return(false));
+  EXPECT_CALL(prime_search, IsPrime(7)).WillOnce(Return(true));
+
+  EXPECT_TRUE(prime_search.RunRange(5, 7));
+}
+
 // Test Run() returns true when IsPrime() calculates
 // correctly.
 TEST(PrimeNumberSearchTest, RunPass) {
@@ -89,7 +89,8 @@ class CrosHealthdMojoAdapterImpl final : public CrosHealthdMojoAdapter {
   chromeos::cros_healthd::mojom::RunRoutineResponsePtr RunDiskReadRoutine(
       chromeos::cros_healthd::mojom::DiskReadRoutineTypeEnum type,
       base::TimeDelta exec_duration,
-      uint32_t file_size_mb) override;
+      uint32_t file_size_mb,
+      uint32_t queue_depth) override;
 
   // Runs the prime search routine.
   chromeos::cros_healthd::mojom::RunRoutineResponsePtr RunPrimeSearchRoutine(
@@ -430,14 +431,15 @@ chromeos::cros_healthd::mojom::RunRoutineResponsePtr
 CrosHealthdMojoAdapterImpl::RunDiskReadRoutine(
     chromeos::cros_healthd::mojom::DiskReadRoutineTypeEnum type,
     base::TimeDelta exec_duration,
-    uint32_t file_size_mb) {
+    uint32_t file_size_mb,
+    uint32_t queue_depth) {
   if (!cros_healthd_service_factory_.is_bound())
     Connect();
 
   chromeos::cros_healthd::mojom::RunRoutineResponsePtr response;
   base::RunLoop run_loop;
   cros_healthd_diagnostics_service_->RunDiskReadRoutine(
-      type, exec_duration.InSeconds(), file_size_mb,
+      type, exec_duration.InSeconds(), file_size_mb, queue_depth,
       base::Bind(&OnMojoResponseReceived<
                      chromeos::cros_healthd::mojom::RunRoutineResponsePtr>,
                  &response, run_loop.QuitClosure()));
@@ -85,7 +85,8 @@ class CrosHealthdMojoAdapter {
   RunDiskReadRoutine(
       chromeos::cros_healthd::mojom::DiskReadRoutineTypeEnum type,
       base::TimeDelta exec_duration,
-      uint32_t file_size_mb) = 0;
+      uint32_t file_size_mb,
+      uint32_t queue_depth) = 0;
 
   // Runs the prime search routine.
   virtual chromeos::cros_healthd::mojom::RunRoutineResponsePtr
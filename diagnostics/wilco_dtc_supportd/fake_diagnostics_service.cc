@@ -105,6 +105,7 @@ void FakeDiagnosticsService::RunDiskReadRoutine(
     mojo_ipc::DiskReadRoutineTypeEnum type,
     uint32_t length_seconds,
     uint32_t file_size_mb,
+    uint32_t queue_depth,
     RunDiskReadRoutineCallback callback) {
   std::move(callback).Run(run_routine_response_.Clone());
 }
@@ -43,6 +43,14 @@ class MockProbeService : public mojo_ipc::CrosHealthdProbeService {
               (const std::vector<mojo_ipc::ProbeCategoryEnum>&,
                ProbeTelemetryInfoCallback),
               (override));
+  MOCK_METHOD(void,
+              ProbeMultipleProcessInfo,
+              (mojo_ipc::ProcessQueryPtr, ProbeMultipleProcessInfoCallback),
+              (override));
+  MOCK_METHOD(void,
+              ProbeStorageIoHistory,
+              (uint32_t, ProbeStorageIoHistoryCallback),
+              (override));
 };
 
 class MockProbeServiceDelegate : public ProbeService::Delegate {
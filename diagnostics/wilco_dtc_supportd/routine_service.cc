@@ -340,6 +340,7 @@ void RoutineService::RunRoutine(const grpc_api::RunRoutineRequest& request,
           mojo_ipc::DiskReadRoutineTypeEnum::kLinearRead,
           request.disk_linear_read_params().length_seconds(),
           request.disk_linear_read_params().file_size_mb(),
+          /*queue_depth=*/0,
           base::Bind(&RoutineService::ForwardRunRoutineResponse,
                      weak_ptr_factory_.GetWeakPtr(), callback_key));
       break;
@@ -350,6 +351,7 @@ void RoutineService::RunRoutine(const grpc_api::RunRoutineRequest& request,
           mojo_ipc::DiskReadRoutineTypeEnum::kRandomRead,
           request.disk_random_read_params().length_seconds(),
           request.disk_random_read_params().file_size_mb(),
+          /*queue_depth=*/0,
           base::Bind(&RoutineService::ForwardRunRoutineResponse,
                      weak_ptr_factory_.GetWeakPtr(), callback_key));
       break;
@@ -22,6 +22,9 @@ struct ClientData {
   std::set<int32_t> enabled_chn_indices;
   double frequency = -1;    // Hz
   uint32_t timeout = 5000;  // millisecond
+  // See SensorDevice::SetSampleChangeThreshold.
+  double change_fraction = 0.0;
+  int64_t change_min_delta = 0;
   mojo::Remote<cros::mojom::SensorDeviceSamplesObserver> observer;
 };
 
@@ -5,6 +5,7 @@
 #include "iioservice/daemon/samples_handler.h"
 
 #include <algorithm>
+#include <cmath>
 #include <memory>
 #include <string>
 #include <utility>
@@ -593,6 +594,35 @@ void SamplesHandler::SampleTimeout(ClientData* client_data,
                                 cros::mojom::ObserverErrorType::READ_TIMEOUT));
 }
 
+bool SamplesHandler::IsSampleChangeSignificant(
+    const ClientData* client_data,
+    const libmems::IioDevice::IioSample& last_sample,
+    const libmems::IioDevice::IioSample& sample) const {
+  if ((client_data->change_fraction <= 0.0 &&
+       client_data->change_min_delta <= 0) ||
+      last_sample.empty()) {
+    return true;
+  }
+
+  for (const auto& chn : sample) {
+    if (no_batch_chn_indices.find(chn.first) != no_batch_chn_indices.end())
+      continue;
+
+    auto it = last_sample.find(chn.first);
+    if (it == last_sample.end())
+      return true;
+
+    double threshold =
+        std::max(static_cast<double>(client_data->change_min_delta),
+                 std::abs(static_cast<double>(it->second)) *
+                     client_data->change_fraction);
+    if (std::abs(static_cast<double>(chn.second - it->second)) > threshold)
+      return true;
+  }
+
+  return false;
+}
+
 void SamplesHandler::OnSampleAvailableWithoutBlocking() {
   DCHECK(sample_task_runner_->BelongsToCurrentThread());
   DCHECK(num_read_failed_logs_ == 0 || num_read_failed_logs_recovery_ == 0);
@@ -686,10 +716,17 @@ void SamplesHandler::OnSampleAvailableWithoutBlocking() {
       client.second.sample_index = samples_cnt_ + 1;
       client.second.chns.clear();
 
-      ipc_task_runner_->PostTask(
-          FROM_HERE,
-          base::BindOnce(on_sample_updated_callback_, client.first->id,
-                         std::move(client_sample)));
+      // The sample was read, so the timeout is reset even if the sample isn't
+      // sent.
+      if (IsSampleChangeSignificant(client.first,
+                                    client.second.last_sent_sample,
+                                    client_sample)) {
+        client.second.last_sent_sample = client_sample;
+        ipc_task_runner_->PostTask(
+            FROM_HERE,
+            base::BindOnce(on_sample_updated_callback_, client.first->id,
+                           std::move(client_sample)));
+      }
       SetTimeoutTaskOnThread(client.first);
     }
   }
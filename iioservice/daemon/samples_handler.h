@@ -85,6 +85,8 @@ class SamplesHandler {
     uint64_t sample_index = 0;
     // Moving averages of channels except for channels that have no batch mode
     std::map<int32_t, int64_t> chns;
+    // The last sample sent to the client.
+    libmems::IioDevice::IioSample last_sent_sample;
   };
 
   static const uint32_t kNumReadFailedLogsBeforeGivingUp = 100;
@@ -145,6 +147,14 @@ class SamplesHandler {
   void SetTimeoutTaskOnThread(ClientData* client_data);
   void SampleTimeout(ClientData* client_data, uint64_t sample_index);
 
+  // Returns true if |sample| should be sent to the client with |client_data|,
+  // which was last sent |last_sample|, given its sample change threshold.
+  // Channels without batch mode, such as timestamps, are not compared.
+  bool IsSampleChangeSignificant(
+      const ClientData* client_data,
+      const libmems::IioDevice::IioSample& last_sample,
+      const libmems::IioDevice::IioSample& sample) const;
+
   void OnSampleAvailableWithoutBlocking();
   void AddReadFailedLog();
 
@@ -229,6 +229,133 @@ TEST_F(SamplesHandlerTest, BadDeviceWithNoSamples) {
     handler_->RemoveClient(&client_data);
 }
 
+// Reads samples whose accel_x channel has a value set by the test.
+class SamplesHandlerChangeThresholdTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    device_ = std::make_unique<libmems::fakes::FakeIioDevice>(
+        nullptr, fakes::kAccelDeviceName, fakes::kAccelDeviceId);
+    EXPECT_TRUE(
+        device_->WriteStringAttribute(libmems::kSamplingFrequencyAvailable,
+                                      fakes::kFakeSamplingFrequencyAvailable));
+
+    for (int i = 0; i < base::size(libmems::fakes::kFakeAccelChns); ++i) {
+      auto channel = std::make_unique<libmems::fakes::FakeIioChannel>(
+          libmems::fakes::kFakeAccelChns[i], true);
+      channels_.push_back(channel.get());
+      device_->AddChannel(std::move(channel));
+    }
+    SetValue(100);
+
+    EXPECT_TRUE(
+        device_->WriteDoubleAttribute(libmems::kSamplingFrequencyAttr, 0.0));
+
+    handler_ = fakes::FakeSamplesHandler::CreateWithFifo(
+        task_environment_.GetMainThreadTaskRunner(),
+        task_environment_.GetMainThreadTaskRunner(), device_.get(),
+        base::BindRepeating(
+            &SamplesHandlerChangeThresholdTest::OnSampleUpdatedCallback,
+            base::Unretained(this)),
+        base::BindRepeating(
+            &SamplesHandlerChangeThresholdTest::OnErrorOccurredCallback,
+            base::Unretained(this)));
+    EXPECT_TRUE(handler_);
+
+    // Don't read any sample until the test asks for them.
+    device_->SetPauseCallbackAtKthSamples(0, base::BindOnce([]() {}));
+
+    client_data_.id = 0;
+    client_data_.iio_device = device_.get();
+    client_data_.enabled_chn_indices.emplace(0);  // accel_x
+    client_data_.enabled_chn_indices.emplace(3);  // timestamp
+    client_data_.timeout = 0;
+    client_data_.frequency = kFooFrequency;
+  }
+
+  void TearDown() override {
+    handler_->RemoveClient(&client_data_);
+    handler_.reset();
+    base::RunLoop().RunUntilIdle();
+  }
+
+  void OnSampleUpdatedCallback(mojo::ReceiverId id,
+                               libmems::IioDevice::IioSample sample) {
+    EXPECT_EQ(id, client_data_.id);
+    values_.push_back(sample[0]);
+  }
+  void OnErrorOccurredCallback(mojo::ReceiverId id,
+                               cros::mojom::ObserverErrorType type) {
+    ADD_FAILURE() << "Unexpected error " << static_cast<int>(type);
+  }
+
+  // Sets the value of the accel_x channel in the next samples.
+  void SetValue(int64_t value) {
+    EXPECT_TRUE(channels_[0]->WriteNumberAttribute(libmems::kRawAttr, value));
+  }
+
+  // Reads samples until the |k|th one.
+  void ReadSamplesUntil(int k) {
+    base::RunLoop run_loop;
+    device_->SetPauseCallbackAtKthSamples(k, run_loop.QuitClosure());
+    handler_->ResumeReading();
+    run_loop.Run();
+    base::RunLoop().RunUntilIdle();
+  }
+
+  base::test::SingleThreadTaskEnvironment task_environment_{
+      base::test::TaskEnvironment::TimeSource::MOCK_TIME,
+      base::test::TaskEnvironment::MainThreadType::IO};
+
+  std::unique_ptr<libmems::fakes::FakeIioDevice> device_;
+  std::vector<libmems::fakes::FakeIioChannel*> channels_;
+
+  fakes::FakeSamplesHandler::ScopedFakeSamplesHandler handler_ = {
+      nullptr, SamplesHandler::SamplesHandlerDeleter};
+  ClientData client_data_;
+
+  // accel_x values of the samples sent to the client.
+  std::vector<int64_t> values_;
+};
+
+// Without a threshold, every sample is sent even if it doesn't change.
+TEST_F(SamplesHandlerChangeThresholdTest, NoThreshold) {
+  handler_->AddClient(&client_data_);
+  ReadSamplesUntil(10);
+
+  EXPECT_GT(values_.size(), 1u);
+}
+
+// Samples that don't move beyond the threshold aren't sent, even though the
+// timestamp channel changes in each of them.
+TEST_F(SamplesHandlerChangeThresholdTest, UnchangedSamplesAreNotSent) {
+  client_data_.change_fraction = 0.05;
+  client_data_.change_min_delta = 1;
+  handler_->AddClient(&client_data_);
+
+  ReadSamplesUntil(10);
+  ASSERT_EQ(values_.size(), 1u);
+  EXPECT_EQ(values_[0], 100);
+
+  // Within 5% of the last sent value.
+  SetValue(104);
+  ReadSamplesUntil(20);
+  EXPECT_EQ(values_.size(), 1u);
+
+  SetValue(200);
+  ReadSamplesUntil(30);
+  ASSERT_EQ(values_.size(), 2u);
+  EXPECT_EQ(values_[1], 200);
+
+  // Small changes are compared with the last sent value, not the last read
+  // one, so they can't add up unnoticed.
+  SetValue(209);
+  ReadSamplesUntil(40);
+  SetValue(218);
+  ReadSamplesUntil(50);
+  ASSERT_EQ(values_.size(), 3u);
+  EXPECT_EQ(values_[2], 218);
+}
+
 class SamplesHandlerTestWithParam
     : public ::testing::TestWithParam<std::vector<std::pair<double, double>>>,
       public SamplesHandlerTestBase {
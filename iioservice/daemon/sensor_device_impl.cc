@@ -256,6 +256,34 @@ void SensorDeviceImpl::GetChannelsAttributes(
   std::move(callback).Run(std::move(values));
 }
 
+void SensorDeviceImpl::SetSampleChangeThreshold(
+    double fraction,
+    int64_t min_delta,
+    SetSampleChangeThresholdCallback callback) {
+  DCHECK(ipc_task_runner_->RunsTasksInCurrentSequence());
+
+  mojo::ReceiverId id = receiver_set_.current_receiver();
+  ClientData& client = clients_[id];
+
+  // The samples thread reads the threshold while the client is reading.
+  if (client.observer.is_bound()) {
+    LOGF(ERROR) << "Reading already started: " << id;
+    std::move(callback).Run(false);
+    return;
+  }
+
+  if (fraction < 0.0 || min_delta < 0) {
+    LOGF(ERROR) << "Invalid sample change threshold: " << fraction << ", "
+                << min_delta;
+    std::move(callback).Run(false);
+    return;
+  }
+
+  client.change_fraction = fraction;
+  client.change_min_delta = min_delta;
+  std::move(callback).Run(true);
+}
+
 SensorDeviceImpl::SensorDeviceImpl(
     scoped_refptr<base::SequencedTaskRunner> ipc_task_runner,
     libmems::IioContext* context,
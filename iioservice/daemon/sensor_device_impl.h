@@ -59,6 +59,10 @@ class SensorDeviceImpl final : public cros::mojom::SensorDevice {
   void GetChannelsAttributes(const std::vector<int32_t>& iio_chn_indices,
                              const std::string& attr_name,
                              GetChannelsAttributesCallback callback) override;
+  void SetSampleChangeThreshold(
+      double fraction,
+      int64_t min_delta,
+      SetSampleChangeThresholdCallback callback) override;
 
  private:
   SensorDeviceImpl(scoped_refptr<base::SequencedTaskRunner> ipc_task_runner,
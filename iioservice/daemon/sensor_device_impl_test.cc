@@ -93,6 +93,21 @@ TEST_F(SensorDeviceImplTest, SetTimeout) {
   remote_->SetTimeout(0);
 }
 
+TEST_F(SensorDeviceImplTest, SetSampleChangeThreshold) {
+  base::RunLoop loop;
+  remote_->SetSampleChangeThreshold(
+      -1.0, 0, base::BindOnce([](bool success) { EXPECT_FALSE(success); }));
+  remote_->SetSampleChangeThreshold(
+      0.05, 1,
+      base::BindOnce(
+          [](base::Closure closure, bool success) {
+            EXPECT_TRUE(success);
+            closure.Run();
+          },
+          loop.QuitClosure()));
+  loop.Run();
+}
+
 TEST_F(SensorDeviceImplTest, GetAttributes) {
   base::RunLoop loop;
   remote_->GetAttributes(
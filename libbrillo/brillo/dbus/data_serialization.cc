@@ -4,9 +4,12 @@
 
 #include <brillo/dbus/data_serialization.h>
 
+#include <limits>
+
 #include <base/logging.h>
 #include <brillo/any.h>
 #include <brillo/variant_dictionary.h>
+#include <google/protobuf/message_lite.h>
 
 namespace brillo {
 namespace dbus_utils {
@@ -145,6 +148,43 @@ bool PopValueFromReader(dbus::MessageReader* reader, base::ScopedFD* value) {
          reader->PopFileDescriptor(value);
 }
 
+void AppendValueToWriter(dbus::MessageWriter* writer,
+                         const std::vector<uint8_t>& value) {
+  writer->AppendArrayOfBytes(value.data(), value.size());
+}
+
+bool PopArrayOfBytesView(dbus::MessageReader* reader,
+                         const uint8_t** bytes,
+                         size_t* length) {
+  dbus::MessageReader variant_reader(nullptr);
+  return details::DescendIntoVariantIfPresent(&reader, &variant_reader) &&
+         reader->PopArrayOfBytes(bytes, length);
+}
+
+bool PopValueFromReader(dbus::MessageReader* reader,
+                        std::vector<uint8_t>* value) {
+  const uint8_t* bytes = nullptr;
+  size_t length = 0;
+  if (!PopArrayOfBytesView(reader, &bytes, &length))
+    return false;
+  // Reuses |value|'s storage if it's large enough.
+  value->assign(bytes, bytes + length);
+  return true;
+}
+
+bool PopValueFromReader(dbus::MessageReader* reader,
+                        google::protobuf::MessageLite* value) {
+  const uint8_t* bytes = nullptr;
+  size_t length = 0;
+  if (!PopArrayOfBytesView(reader, &bytes, &length))
+    return false;
+  if (length > static_cast<size_t>(std::numeric_limits<int>::max())) {
+    LOG(ERROR) << "Protobuf of " << length << " bytes is too large to parse";
+    return false;
+  }
+  return value->ParseFromArray(bytes, static_cast<int>(length));
+}
+
 namespace {
 
 // Helper methods for PopValueFromReader(dbus::MessageReader*, Any*)
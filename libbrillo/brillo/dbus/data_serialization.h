@@ -461,6 +461,21 @@ struct DBusType<brillo::Any> {
   }
 };
 
+// std::vector<uint8_t> = D-Bus ARRAY of BYTE ----------------------------------
+// Byte arrays are written and read as a single block rather than byte by
+// byte by the generic std::vector overloads below.
+BRILLO_EXPORT void AppendValueToWriter(::dbus::MessageWriter* writer,
+                                       const std::vector<uint8_t>& value);
+BRILLO_EXPORT bool PopValueFromReader(::dbus::MessageReader* reader,
+                                      std::vector<uint8_t>* value);
+
+// Pops an ARRAY of BYTE, optionally wrapped in a VARIANT, without copying it.
+// On success, |bytes| points into the message's memory and is only valid for
+// as long as the message is.
+BRILLO_EXPORT bool PopArrayOfBytesView(::dbus::MessageReader* reader,
+                                       const uint8_t** bytes,
+                                       size_t* length);
+
 // std::vector = D-Bus ARRAY. -------------------------------------------------
 template <typename T, typename ALLOC>
 typename std::enable_if<IsTypeSupported<T>::value>::type AppendValueToWriter(
@@ -810,10 +825,9 @@ inline void AppendValueToWriter(::dbus::MessageWriter* writer,
   writer->AppendProtoAsArrayOfBytes(value);
 }
 
-inline bool PopValueFromReader(::dbus::MessageReader* reader,
-                               google::protobuf::MessageLite* value) {
-  return reader->PopArrayOfBytesAsProto(value);
-}
+// The message is parsed straight from the D-Bus message's memory.
+BRILLO_EXPORT bool PopValueFromReader(::dbus::MessageReader* reader,
+                                      google::protobuf::MessageLite* value);
 
 // is_protobuf_t<T> is a helper type trait to determine if type T derives from
 // google::protobuf::MessageLite.
@@ -7,6 +7,8 @@
 #include <limits>
 #include <tuple>
 
+#include <base/logging.h>
+#include <base/time/time.h>
 #include <brillo/variant_dictionary.h>
 #include <gtest/gtest.h>
 
@@ -414,6 +416,68 @@ TEST(DBusUtils, ArrayOfBytes_Empty) {
   EXPECT_EQ(bytes, bytes_out);
 }
 
+TEST(DBusUtils, ArrayOfBytesView) {
+  std::unique_ptr<Response> message = Response::CreateEmpty();
+  MessageWriter writer(message.get());
+  std::vector<uint8_t> bytes{1, 2, 3};
+  AppendValueToWriter(&writer, bytes);
+  AppendValueToWriterAsVariant(&writer, bytes);
+
+  MessageReader reader(message.get());
+  const uint8_t* data = nullptr;
+  size_t length = 0;
+  EXPECT_TRUE(PopArrayOfBytesView(&reader, &data, &length));
+  EXPECT_EQ(bytes, std::vector<uint8_t>(data, data + length));
+  EXPECT_TRUE(PopArrayOfBytesView(&reader, &data, &length));
+  EXPECT_EQ(bytes, std::vector<uint8_t>(data, data + length));
+  EXPECT_FALSE(reader.HasMoreData());
+}
+
+// Compares writing and reading byte arrays of several sizes as one block
+// with doing it byte by byte, as the generic std::vector overloads would.
+// Only run on request with --gtest_also_run_disabled_tests.
+TEST(DBusUtils, DISABLED_ArrayOfBytesBenchmark) {
+  for (size_t size : {1024, 64 * 1024, 1024 * 1024}) {
+    const std::vector<uint8_t> bytes(size, 0xAB);
+
+    base::TimeTicks start = base::TimeTicks::Now();
+    {
+      std::unique_ptr<Response> message = Response::CreateEmpty();
+      MessageWriter writer(message.get());
+      AppendValueToWriter(&writer, bytes);
+      MessageReader reader(message.get());
+      std::vector<uint8_t> bytes_out;
+      ASSERT_TRUE(PopValueFromReader(&reader, &bytes_out));
+      ASSERT_EQ(bytes, bytes_out);
+    }
+    const base::TimeDelta block_time = base::TimeTicks::Now() - start;
+
+    start = base::TimeTicks::Now();
+    {
+      std::unique_ptr<Response> message = Response::CreateEmpty();
+      MessageWriter writer(message.get());
+      MessageWriter array_writer(nullptr);
+      writer.OpenArray("y", &array_writer);
+      for (uint8_t byte : bytes)
+        array_writer.AppendByte(byte);
+      writer.CloseContainer(&array_writer);
+      MessageReader reader(message.get());
+      MessageReader array_reader(nullptr);
+      ASSERT_TRUE(reader.PopArray(&array_reader));
+      std::vector<uint8_t> bytes_out;
+      uint8_t byte = 0;
+      while (array_reader.PopByte(&byte))
+        bytes_out.push_back(byte);
+      ASSERT_EQ(bytes, bytes_out);
+    }
+    const base::TimeDelta per_byte_time = base::TimeTicks::Now() - start;
+
+    LOG(INFO) << size << " bytes: " << block_time.InMicroseconds()
+              << " us as a block, " << per_byte_time.InMicroseconds()
+              << " us byte by byte";
+  }
+}
+
 TEST(DBusUtils, ArrayOfStrings) {
   std::unique_ptr<Response> message = Response::CreateEmpty();
   MessageWriter writer(message.get());
@@ -824,5 +888,25 @@ TEST(DBusUtils, Protobuf) {
   EXPECT_EQ("abcd", test_message_out.bar());
 }
 
+TEST(DBusUtils, ProtobufAsVariant) {
+  std::unique_ptr<Response> message = Response::CreateEmpty();
+  MessageWriter writer(message.get());
+
+  dbus_utils_test::TestMessage test_message;
+  test_message.set_foo(123);
+  test_message.set_bar("abcd");
+  AppendValueToWriterAsVariant(&writer, test_message);
+
+  EXPECT_EQ("v", message->GetSignature());
+
+  dbus_utils_test::TestMessage test_message_out;
+  MessageReader reader(message.get());
+  EXPECT_TRUE(PopValueFromReader(&reader, &test_message_out));
+  EXPECT_FALSE(reader.HasMoreData());
+
+  EXPECT_EQ(123, test_message_out.foo());
+  EXPECT_EQ("abcd", test_message_out.bar());
+}
+
 }  // namespace dbus_utils
 }  // namespace brillo
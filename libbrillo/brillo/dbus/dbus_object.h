@@ -616,6 +616,12 @@ class BRILLO_EXPORT DBusObject {
   // Sends a signal from the exported D-Bus object.
   bool SendSignal(::dbus::Signal* signal);
 
+  // Batches the PropertiesChanged signals sent for this object's properties.
+  // See ExportedPropertySet::EnableSignalCoalescing().
+  void EnablePropertiesChangedCoalescing(base::TimeDelta window) {
+    property_set_.EnableSignalCoalescing(window);
+  }
+
   // Returns the reference to dbus::Bus this object is associated with.
   scoped_refptr<::dbus::Bus> GetBus() { return bus_; }
 
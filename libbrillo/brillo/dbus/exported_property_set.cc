@@ -7,6 +7,8 @@
 #include <utility>
 
 #include <base/bind.h>
+#include <base/location.h>
+#include <base/threading/thread_task_runner_handle.h>
 #include <dbus/bus.h>
 #include <dbus/property.h>  // For kPropertyInterface
 
@@ -60,6 +62,41 @@ void ExportedPropertySet::UnregisterProperty(const std::string& interface_name,
   prop_map.erase(prop_iter);
 }
 
+void ExportedPropertySet::EnableSignalCoalescing(base::TimeDelta window) {
+  bus_->AssertOnOriginThread();
+  coalesce_signals_ = true;
+  coalescing_window_ = window;
+}
+
+void ExportedPropertySet::FlushPendingSignals() {
+  bus_->AssertOnOriginThread();
+  flush_weak_ptr_factory_.InvalidateWeakPtrs();
+  std::map<std::string, std::set<std::string>> pending_changes;
+  pending_changes.swap(pending_changes_);
+
+  auto signal = signal_properties_changed_.lock();
+  if (!signal)
+    return;
+  for (const auto& pending : pending_changes) {
+    auto property_map_itr = properties_.find(pending.first);
+    if (property_map_itr == properties_.end())
+      continue;
+    // Properties unregistered since they were updated are skipped.
+    VariantDictionary changed_properties;
+    for (const std::string& property_name : pending.second) {
+      auto property_itr = property_map_itr->second.find(property_name);
+      if (property_itr != property_map_itr->second.end()) {
+        changed_properties.emplace(property_name,
+                                   property_itr->second->GetValue());
+      }
+    }
+    if (changed_properties.empty())
+      continue;
+    std::vector<std::string> invalidated_properties;  // empty.
+    signal->Send(pending.first, changed_properties, invalidated_properties);
+  }
+}
+
 VariantDictionary ExportedPropertySet::HandleGetAll(
     const std::string& interface_name) {
   bus_->AssertOnOriginThread();
@@ -141,6 +178,18 @@ void ExportedPropertySet::HandlePropertyUpdated(
   auto signal = signal_properties_changed_.lock();
   if (!signal)
     return;
+  if (coalesce_signals_) {
+    // The value is read when the signal is sent, so only the name is kept.
+    if (pending_changes_.empty()) {
+      base::ThreadTaskRunnerHandle::Get()->PostDelayedTask(
+          FROM_HERE,
+          base::BindOnce(&ExportedPropertySet::FlushPendingSignals,
+                         flush_weak_ptr_factory_.GetWeakPtr()),
+          coalescing_window_);
+    }
+    pending_changes_[interface_name].insert(property_name);
+    return;
+  }
   VariantDictionary changed_properties{
       {property_name, exported_property->GetValue()}};
   // The interface specification tells us to include this list of properties
@@ -9,10 +9,12 @@
 
 #include <map>
 #include <memory>
+#include <set>
 #include <string>
 #include <vector>
 
 #include <base/memory/weak_ptr.h>
+#include <base/time/time.h>
 #include <brillo/any.h>
 #include <brillo/brillo_export.h>
 #include <brillo/dbus/dbus_signal.h>
@@ -118,6 +120,18 @@ class BRILLO_EXPORT ExportedPropertySet {
   void UnregisterProperty(const std::string& interface_name,
                           const std::string& property_name);
 
+  // Batches property updates instead of sending a PropertiesChanged signal
+  // for each of them. Updates are collected per interface for |window| after
+  // the first one, or until the end of the current task if |window| is zero,
+  // and then sent as one signal per interface carrying the latest values of
+  // all the properties that changed. Note that this may reorder
+  // PropertiesChanged relative to other signals sent by the object.
+  void EnableSignalCoalescing(base::TimeDelta window);
+
+  // Sends the signals for any updates batched by EnableSignalCoalescing()
+  // right away.
+  void FlushPendingSignals();
+
   // D-Bus methods for org.freedesktop.DBus.Properties interface.
   VariantDictionary HandleGetAll(const std::string& interface_name);
   bool HandleGet(brillo::ErrorPtr* error,
@@ -153,8 +167,18 @@ class BRILLO_EXPORT ExportedPropertySet {
   std::map<std::string, std::map<std::string, ExportedPropertyBase*>>
       properties_;
 
+  // Set by EnableSignalCoalescing().
+  bool coalesce_signals_{false};
+  base::TimeDelta coalescing_window_;
+  // Properties updated since the last PropertiesChanged signals were sent
+  // when coalescing, by interface name.
+  std::map<std::string, std::set<std::string>> pending_changes_;
+
   // D-Bus callbacks may last longer the property set exporting those methods.
   base::WeakPtrFactory<ExportedPropertySet> weak_ptr_factory_;
+  // Used for the pending FlushPendingSignals() task, which is canceled if the
+  // signals are flushed earlier.
+  base::WeakPtrFactory<ExportedPropertySet> flush_weak_ptr_factory_{this};
 
   using SignalPropertiesChanged =
       DBusSignal<std::string, VariantDictionary, std::vector<std::string>>;
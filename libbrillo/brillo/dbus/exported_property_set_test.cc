@@ -8,10 +8,14 @@
 #include <vector>
 
 #include <base/bind.h>
+#include <base/logging.h>
 #include <base/macros.h>
+#include <base/run_loop.h>
+#include <base/task/single_thread_task_executor.h>
 #include <brillo/dbus/dbus_object.h>
 #include <brillo/dbus/dbus_object_test_helpers.h>
 #include <brillo/errors/error_codes.h>
+#include <dbus/dbus.h>
 #include <dbus/message.h>
 #include <dbus/property.h>
 #include <dbus/object_path.h>
@@ -163,6 +167,7 @@ class ExportedPropertySetTest : public ::testing::Test {
     return testing::CallMethod(p_->dbus_object_, &method_call);
   }
 
+  base::SingleThreadTaskExecutor task_executor_;
   std::unique_ptr<dbus::Response> last_response_;
   scoped_refptr<dbus::MockBus> bus_;
   scoped_refptr<dbus::MockExportedObject> mock_exported_object_;
@@ -599,6 +604,79 @@ TEST_F(ExportedPropertySetTest, SignalsAreParsable) {
   p_->uint8_prop_.SetValue(57);
 }
 
+TEST_F(ExportedPropertySetTest, CoalescedSignalHasLatestValue) {
+  p_->dbus_object_.EnablePropertiesChangedCoalescing(base::TimeDelta());
+  EXPECT_CALL(*mock_exported_object_, SendSignal(_))
+      .Times(1)
+      .WillOnce(Invoke(&VerifySignal));
+  p_->uint8_prop_.SetValue(1);
+  p_->uint8_prop_.SetValue(57);
+  base::RunLoop().RunUntilIdle();
+}
+
+namespace {
+
+// Returns the size of |signal| as sent over the bus.
+int GetMarshaledSize(dbus::Signal* signal) {
+  char* data = nullptr;
+  int size = 0;
+  if (!dbus_message_marshal(signal->raw_message(), &data, &size))
+    return 0;
+  dbus_free(data);
+  return size;
+}
+
+}  // namespace
+
+// Updates every property once per round, as a daemon refreshing its state
+// would, and compares the signals sent with and without coalescing.
+TEST_F(ExportedPropertySetTest, CoalescedPropertyStorm) {
+  constexpr int kRounds = 10;
+  int num_signals = 0;
+  int num_bytes = 0;
+  EXPECT_CALL(*mock_exported_object_, SendSignal(_))
+      .WillRepeatedly(Invoke([&](dbus::Signal* signal) {
+        ++num_signals;
+        num_bytes += GetMarshaledSize(signal);
+      }));
+  auto run_storm = [&](int first_round) {
+    num_signals = 0;
+    num_bytes = 0;
+    for (int i = first_round; i < first_round + kRounds; ++i) {
+      const dbus::ObjectPath path("/path_" + std::to_string(i));
+      p_->bool_prop_.SetValue(i % 2 == 1);
+      p_->uint8_prop_.SetValue(i);
+      p_->int16_prop_.SetValue(i);
+      p_->uint16_prop_.SetValue(i);
+      p_->int32_prop_.SetValue(i);
+      p_->uint32_prop_.SetValue(i);
+      p_->int64_prop_.SetValue(i);
+      p_->uint64_prop_.SetValue(i);
+      p_->double_prop_.SetValue(i);
+      p_->string_prop_.SetValue(kTestString + std::to_string(i));
+      p_->path_prop_.SetValue(path);
+      p_->stringlist_prop_.SetValue({kTestString, std::to_string(i)});
+      p_->pathlist_prop_.SetValue({path});
+      p_->uint8list_prop_.SetValue({static_cast<uint8_t>(i)});
+      base::RunLoop().RunUntilIdle();
+    }
+  };
+
+  run_storm(1);
+  EXPECT_EQ(14 * kRounds, num_signals);
+  const int uncoalesced_signals = num_signals;
+  const int uncoalesced_bytes = num_bytes;
+
+  p_->dbus_object_.EnablePropertiesChangedCoalescing(base::TimeDelta());
+  run_storm(1 + kRounds);
+  // One signal per interface and round.
+  EXPECT_EQ(3 * kRounds, num_signals);
+  EXPECT_LT(num_bytes, uncoalesced_bytes);
+  LOG(INFO) << "Uncoalesced: " << uncoalesced_signals << " signals, "
+            << uncoalesced_bytes << " bytes; coalesced: " << num_signals
+            << " signals, " << num_bytes << " bytes";
+}
+
 }  // namespace dbus_utils
 
 }  // namespace brillo
@@ -4,13 +4,22 @@
 
 #include "brillo/file_utils.h"
 
+#include <dirent.h>
 #include <fcntl.h>
+#include <linux/fs.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/quota.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <limits>
 #include <utility>
 #include <vector>
 
+#include <base/containers/circular_deque.h>
 #include <base/files/file_enumerator.h>
 #include <base/files/file_path.h>
 #include <base/files/file_util.h>
@@ -19,7 +28,12 @@
 #include <base/rand_util.h>
 #include <base/stl_util.h>
 #include <base/strings/string_number_conversions.h>
+#include <base/strings/string_split.h>
 #include <base/strings/stringprintf.h>
+#include <base/synchronization/condition_variable.h>
+#include <base/synchronization/lock.h>
+#include <base/system/sys_info.h>
+#include <base/threading/simple_thread.h>
 #include <base/time/time.h>
 
 namespace brillo {
@@ -231,6 +245,176 @@ base::ScopedFD OpenSafelyInternal(int parent_fd,
   return OpenPathComponentInternal(parent_fd, *itr, flags, mode);
 }
 
+// Upper bound on the number of threads used by ComputeDirectoryDiskUsage() when
+// the caller doesn't pick one. Walks are mostly bound by inode lookups, which
+// stop scaling well before this on the storage in use.
+constexpr int kMaxDiskUsageThreads = 8;
+
+// Walks a directory tree on any number of threads, summing the blocks used by
+// everything below the root. Directories are handed out one at a time from a
+// shared queue; the thread that lists a directory queues its subdirectories
+// for whichever thread is idle next. Only paths are queued so that the number
+// of open directories is bounded by the number of threads rather than by the
+// width of the tree.
+class DiskUsageWalker : public base::DelegateSimpleThread::Delegate {
+ public:
+  explicit DiskUsageWalker(const base::FilePath& root)
+      : root_(root), cond_(&lock_), pending_dirs_({root}), num_pending_(1) {}
+  ~DiskUsageWalker() override = default;
+
+  // Returns the number of S_BLKSIZE blocks counted by all calls to Run().
+  int64_t blocks() const {
+    base::AutoLock lock(lock_);
+    return blocks_;
+  }
+
+  // base::DelegateSimpleThread::Delegate:
+  // Lists queued directories until the whole tree has been walked.
+  void Run() override {
+    int64_t blocks = 0;
+    std::vector<base::FilePath> subdirs;
+    base::AutoLock lock(lock_);
+    while (true) {
+      while (pending_dirs_.empty() && num_pending_ > 0)
+        cond_.Wait();
+      if (pending_dirs_.empty())
+        break;
+
+      base::FilePath dir = std::move(pending_dirs_.back());
+      pending_dirs_.pop_back();
+      {
+        base::AutoUnlock unlock(lock_);
+        subdirs.clear();
+        blocks += ListDirectory(dir, &subdirs);
+      }
+      for (base::FilePath& subdir : subdirs)
+        pending_dirs_.push_back(std::move(subdir));
+      num_pending_ += subdirs.size();
+      // The directory that was just listed is no longer outstanding.
+      if (--num_pending_ == 0 || !subdirs.empty())
+        cond_.Broadcast();
+    }
+    blocks_ += blocks;
+  }
+
+ private:
+  // Returns the blocks used by the entries of |dir|, adding the paths of its
+  // subdirectories to |subdirs|. Symbolic links below the root are not
+  // followed, but the root itself may be one.
+  int64_t ListDirectory(const base::FilePath& dir,
+                        std::vector<base::FilePath>* subdirs) const {
+    const int nofollow = dir == root_ ? 0 : O_NOFOLLOW;
+    base::ScopedFD fd(HANDLE_EINTR(open(
+        dir.value().c_str(), O_RDONLY | O_DIRECTORY | nofollow | O_CLOEXEC)));
+    if (!fd.is_valid()) {
+      // The root may not exist, and entries may be removed during the walk.
+      if (errno != ENOENT)
+        PLOG(ERROR) << "Failed to open " << dir.value();
+      return 0;
+    }
+    // The DIR takes ownership of the descriptor.
+    DIR* dirp = fdopendir(fd.get());
+    if (!dirp) {
+      PLOG(ERROR) << "Failed to list " << dir.value();
+      return 0;
+    }
+    const int dir_fd = fd.release();
+
+    int64_t blocks = 0;
+    while (struct dirent* entry = readdir(dirp)) {
+      if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+        continue;
+      struct stat st;
+      if (fstatat(dir_fd, entry->d_name, &st, AT_SYMLINK_NOFOLLOW) != 0)
+        continue;
+      // st_blocks in struct stat is the number of S_BLKSIZE (512) bytes sized
+      // blocks occupied by this file.
+      blocks += st.st_blocks;
+      if (S_ISDIR(st.st_mode))
+        subdirs->push_back(dir.Append(entry->d_name));
+    }
+    closedir(dirp);
+    return blocks;
+  }
+
+  const base::FilePath root_;
+
+  mutable base::Lock lock_;
+  // Signalled when directories are queued or the walk finishes.
+  base::ConditionVariable cond_;
+
+  // Directories waiting to be listed. Taken from the back so that the walk is
+  // roughly depth-first, which keeps the queue short on wide trees.
+  std::vector<base::FilePath> pending_dirs_;
+
+  // Number of directories that are queued or being listed. The walk is done
+  // once this drops to zero.
+  size_t num_pending_;
+
+  // Blocks counted by threads that have finished.
+  int64_t blocks_ = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(DiskUsageWalker);
+};
+
+// Returns the path of the block device backing the filesystem with device
+// number |dev|, or an empty path if it isn't mounted.
+base::FilePath GetBlockDeviceForDev(dev_t dev) {
+  std::string mountinfo;
+  if (!base::ReadFileToString(base::FilePath("/proc/self/mountinfo"),
+                              &mountinfo)) {
+    return base::FilePath();
+  }
+  const std::string dev_str =
+      base::StringPrintf("%u:%u", major(dev), minor(dev));
+  for (const auto& line : base::SplitStringPiece(
+           mountinfo, "\n", base::TRIM_WHITESPACE, base::SPLIT_WANT_NONEMPTY)) {
+    // See proc(5): the optional fields are terminated by a lone "-", which is
+    // followed by the filesystem type and the mount source.
+    std::vector<base::StringPiece> fields = base::SplitStringPiece(
+        line, " ", base::TRIM_WHITESPACE, base::SPLIT_WANT_NONEMPTY);
+    if (fields.size() < 3 || fields[2] != dev_str)
+      continue;
+    auto separator = std::find(fields.begin(), fields.end(), "-");
+    if (std::distance(separator, fields.end()) < 3)
+      continue;
+    return base::FilePath(*(separator + 2));
+  }
+  return base::FilePath();
+}
+
+// Returns the space charged to the project quota of |root_path|, or -1 if
+// |root_path| doesn't have a project ID inherited by its descendants or the
+// quota can't be read.
+int64_t GetProjectQuotaUsage(const base::FilePath& root_path) {
+  base::ScopedFD fd(HANDLE_EINTR(open(root_path.value().c_str(),
+                                      O_RDONLY | O_DIRECTORY | O_CLOEXEC)));
+  if (!fd.is_valid())
+    return -1;
+
+  struct fsxattr fsx = {};
+  if (ioctl(fd.get(), FS_IOC_FSGETXATTR, &fsx) != 0 || fsx.fsx_projid == 0 ||
+      !(fsx.fsx_xflags & FS_XFLAG_PROJINHERIT)) {
+    return -1;
+  }
+
+  struct stat st;
+  if (fstat(fd.get(), &st) != 0)
+    return -1;
+  const base::FilePath device = GetBlockDeviceForDev(st.st_dev);
+  if (device.empty())
+    return -1;
+
+  struct dqblk dq = {};
+  if (quotactl(QCMD(Q_GETQUOTA, PRJQUOTA), device.value().c_str(),
+               fsx.fsx_projid, reinterpret_cast<char*>(&dq)) != 0) {
+    PLOG(WARNING) << "Failed to read project quota " << fsx.fsx_projid
+                  << " on " << device.value();
+    return -1;
+  }
+  return dq.dqb_curspace;
+}
+
 }  // namespace
 
 bool TouchFile(const base::FilePath& path,
@@ -508,18 +692,34 @@ bool WriteToFileAtomic(const base::FilePath& path,
 }
 
 int64_t ComputeDirectoryDiskUsage(const base::FilePath& root_path) {
-  int64_t running_blocks = 0;
-  base::FileEnumerator file_iter(root_path, true,
-                                 base::FileEnumerator::FILES |
-                                     base::FileEnumerator::DIRECTORIES |
-                                     base::FileEnumerator::SHOW_SYM_LINKS);
-  while (!file_iter.Next().empty()) {
-    // st_blocks in struct stat is the number of S_BLKSIZE (512) bytes sized
-    // blocks occupied by this file.
-    running_blocks += file_iter.GetInfo().stat().st_blocks;
+  return ComputeDirectoryDiskUsage(root_path, DiskUsageOptions());
+}
+
+int64_t ComputeDirectoryDiskUsage(const base::FilePath& root_path,
+                                  const DiskUsageOptions& options) {
+  if (options.use_project_quota) {
+    const int64_t usage = GetProjectQuotaUsage(root_path);
+    if (usage >= 0)
+      return usage;
+  }
+
+  int num_threads = options.num_threads;
+  if (num_threads <= 0) {
+    num_threads =
+        std::min(base::SysInfo::NumberOfProcessors(), kMaxDiskUsageThreads);
+  }
+  DiskUsageWalker walker(root_path);
+  if (num_threads > 1) {
+    base::DelegateSimpleThreadPool pool("DiskUsage", num_threads - 1);
+    pool.AddWork(&walker, num_threads - 1);
+    pool.Start();
+    walker.Run();
+    pool.JoinAll();
+  } else {
+    walker.Run();
   }
   // Each block is S_BLKSIZE (512) bytes so *S_BLKSIZE.
-  return running_blocks * S_BLKSIZE;
+  return walker.blocks() * S_BLKSIZE;
 }
 
 }  // namespace brillo
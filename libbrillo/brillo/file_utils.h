@@ -156,7 +156,8 @@ BRILLO_EXPORT bool WriteBlobToFileAtomic(const base::FilePath& path,
 // - This function recursively processes directory down the tree, so disk space
 // used by files in all the subdirectories are counted.
 // - Symbolic links will not be followed (the size of link itself is counted,
-// the target is not)
+// the target is not), except that |root_path| itself may be a symbolic link to
+// a directory.
 // - Hidden files are counted as well.
 // The following behaviours are not guaranteed, and it is recommended to avoid
 // them in the field. Their current behaviour is provided for reference only:
@@ -181,11 +182,36 @@ BRILLO_EXPORT bool WriteBlobToFileAtomic(const base::FilePath& path,
 // - Non-POSIX system is not supported.
 // - Disk space used by directory (and its subdirectories) itself is counted.
 //
+// The tree is walked by several threads at once (see DiskUsageOptions), each
+// listing one directory at a time through an open descriptor and stat'ing its
+// entries relative to it with fstatat().
+//
 // Parameters
 //   root_path - The directory to compute the size for
 BRILLO_EXPORT int64_t
 ComputeDirectoryDiskUsage(const base::FilePath& root_path);
 
+// Options for ComputeDirectoryDiskUsage().
+struct BRILLO_EXPORT DiskUsageOptions {
+  // Number of threads (including the calling thread) used to walk the tree. 0
+  // picks a number based on the number of CPUs, and 1 walks the tree on the
+  // calling thread only.
+  int num_threads = 0;
+
+  // If true and |root_path| has an ext4 project ID that its descendants inherit
+  // (FS_XFLAG_PROJINHERIT), the current space charged to that project is read
+  // with quotactl() instead of walking the tree. This is only correct if no
+  // files outside |root_path| share the project ID. Unlike the walk, the
+  // result includes the blocks used by |root_path| itself. Falls back to
+  // walking the tree if the project ID or quota can't be read.
+  bool use_project_quota = false;
+};
+
+// Same as above, with control over how the usage is computed.
+BRILLO_EXPORT int64_t
+ComputeDirectoryDiskUsage(const base::FilePath& root_path,
+                          const DiskUsageOptions& options);
+
 }  // namespace brillo
 
 #endif  // LIBBRILLO_BRILLO_FILE_UTILS_H_
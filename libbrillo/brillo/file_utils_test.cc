@@ -12,9 +12,11 @@
 
 #include <base/files/file_util.h>
 #include <base/files/scoped_temp_dir.h>
+#include <base/logging.h>
 #include <base/rand_util.h>
 #include <base/stl_util.h>
 #include <base/strings/string_number_conversions.h>
+#include <base/time/time.h>
 #include <gtest/gtest.h>
 
 namespace brillo {
@@ -38,6 +40,19 @@ bool IsNonBlockingFD(int fd) {
   return fcntl(fd, F_GETFL) & O_NONBLOCK;
 }
 
+// Computes the disk usage of |path| with |num_threads| threads, logging how
+// long it took.
+int64_t TimeDiskUsage(const base::FilePath& path, int num_threads) {
+  DiskUsageOptions options;
+  options.num_threads = num_threads;
+  const base::TimeTicks start = base::TimeTicks::Now();
+  const int64_t usage = ComputeDirectoryDiskUsage(path, options);
+  LOG(INFO) << "Computed usage of " << path.value() << " with " << num_threads
+            << " thread(s) in "
+            << (base::TimeTicks::Now() - start).InMicroseconds() << " us";
+  return usage;
+}
+
 }  // namespace
 
 class FileUtilsTest : public testing::Test {
@@ -505,4 +520,96 @@ TEST_F(FileUtilsTest, ComputeDirectoryDiskUsageSymlinkDir) {
   EXPECT_LT(result_usage, kFileSize / 10 * 11);
 }
 
+TEST_F(FileUtilsTest, ComputeDirectoryDiskUsageSymlinkRoot) {
+  // 2MB test file.
+  constexpr size_t kFileSize = 2 * 1024 * 1024;
+
+  const base::FilePath parentname(GetTempName());
+  EXPECT_TRUE(base::CreateDirectory(parentname));
+  const base::FilePath dirname = parentname.Append("target.dir");
+  EXPECT_TRUE(base::CreateDirectory(dirname));
+  const base::FilePath linkname = parentname.Append("link.dir");
+
+  const base::FilePath filename = dirname.Append("test.temp");
+
+  std::string file_content = base::RandBytesAsString(kFileSize);
+  EXPECT_TRUE(WriteStringToFile(filename, file_content));
+
+  // Create a symlink.
+  EXPECT_TRUE(base::CreateSymbolicLink(dirname, linkname));
+
+  // A symlink passed as the root is followed, like base::FileEnumerator does.
+  int64_t result_usage = ComputeDirectoryDiskUsage(linkname);
+
+  // result_usage (what we are testing here) should be within +/-10% of ground
+  // truth. The variation is to account for filesystem overhead variations.
+  EXPECT_GT(result_usage, kFileSize / 10 * 9);
+  EXPECT_LT(result_usage, kFileSize / 10 * 11);
+  EXPECT_EQ(ComputeDirectoryDiskUsage(dirname), result_usage);
+}
+
+TEST_F(FileUtilsTest, ComputeDirectoryDiskUsageWideTree) {
+  constexpr int kNumDirs = 64;
+  constexpr int kFilesPerDir = 32;
+  constexpr size_t kFileSize = 4096;
+
+  const base::FilePath dirname(GetTempName());
+  ASSERT_TRUE(base::CreateDirectory(dirname));
+  const std::string file_content = base::RandBytesAsString(kFileSize);
+  for (int i = 0; i < kNumDirs; i++) {
+    const base::FilePath subdir = dirname.Append(base::NumberToString(i));
+    ASSERT_TRUE(base::CreateDirectory(subdir));
+    for (int j = 0; j < kFilesPerDir; j++) {
+      ASSERT_TRUE(WriteStringToFile(subdir.Append(base::NumberToString(j)),
+                                    file_content));
+    }
+  }
+
+  // Every file should be counted exactly once however many threads are used.
+  const int64_t serial_usage = TimeDiskUsage(dirname, 1);
+  EXPECT_GE(serial_usage, kNumDirs * kFilesPerDir * kFileSize);
+  EXPECT_EQ(serial_usage, TimeDiskUsage(dirname, 4));
+  EXPECT_EQ(serial_usage, TimeDiskUsage(dirname, 0));
+}
+
+TEST_F(FileUtilsTest, ComputeDirectoryDiskUsageDeepTree) {
+  constexpr int kDepth = 200;
+  constexpr size_t kFileSize = 4096;
+
+  const base::FilePath dirname(GetTempName());
+  ASSERT_TRUE(base::CreateDirectory(dirname));
+  const std::string file_content = base::RandBytesAsString(kFileSize);
+  base::FilePath currentlevel = dirname;
+  for (int i = 0; i < kDepth; i++) {
+    ASSERT_TRUE(WriteStringToFile(currentlevel.Append("test.temp"),
+                                  file_content));
+    currentlevel = currentlevel.Append("d");
+    ASSERT_TRUE(base::CreateDirectory(currentlevel));
+  }
+
+  const int64_t serial_usage = TimeDiskUsage(dirname, 1);
+  EXPECT_GE(serial_usage, kDepth * kFileSize);
+  EXPECT_EQ(serial_usage, TimeDiskUsage(dirname, 4));
+  EXPECT_EQ(serial_usage, TimeDiskUsage(dirname, 0));
+}
+
+TEST_F(FileUtilsTest, ComputeDirectoryDiskUsageNonExistent) {
+  EXPECT_EQ(0, ComputeDirectoryDiskUsage(GetTempName()));
+}
+
+TEST_F(FileUtilsTest, ComputeDirectoryDiskUsageProjectQuotaFallback) {
+  constexpr size_t kFileSize = 2 * 1024 * 1024;
+
+  const base::FilePath dirname(GetTempName());
+  EXPECT_TRUE(base::CreateDirectory(dirname));
+  EXPECT_TRUE(WriteStringToFile(dirname.Append("test.temp"),
+                                base::RandBytesAsString(kFileSize)));
+
+  // The temporary directory has no project ID, so the tree should be walked.
+  DiskUsageOptions options;
+  options.use_project_quota = true;
+  EXPECT_EQ(ComputeDirectoryDiskUsage(dirname),
+            ComputeDirectoryDiskUsage(dirname, options));
+}
+
 }  // namespace brillo
@@ -39,6 +39,10 @@ void CurlApi::EasyCleanup(CURL* curl) {
   curl_easy_cleanup(curl);
 }
 
+void CurlApi::EasyReset(CURL* curl) {
+  curl_easy_reset(curl);
+}
+
 CURLcode CurlApi::EasySetOptInt(CURL* curl, CURLoption option, int value) {
   CHECK(VerifyOptionType(option, CURLOPTTYPE_LONG))
       << "Only options that expect a LONG data type must be specified here";
@@ -192,5 +196,23 @@ CURLMcode CurlApi::MultiWait(CURLM* multi_handle,
                          numfds);
 }
 
+CURLSH* CurlApi::ShareInit() {
+  return curl_share_init();
+}
+
+CURLSHcode CurlApi::ShareCleanup(CURLSH* share_handle) {
+  return curl_share_cleanup(share_handle);
+}
+
+CURLSHcode CurlApi::ShareSetOptInt(CURLSH* share_handle,
+                                   CURLSHoption option,
+                                   int value) {
+  return curl_share_setopt(share_handle, option, value);
+}
+
+std::string CurlApi::ShareStrError(CURLSHcode code) const {
+  return curl_share_strerror(code);
+}
+
 }  // namespace http
 }  // namespace brillo
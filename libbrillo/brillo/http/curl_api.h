@@ -27,6 +27,9 @@ class CurlInterface {
   // Wrapper around curl_easy_cleanup().
   virtual void EasyCleanup(CURL* curl) = 0;
 
+  // Wrapper around curl_easy_reset().
+  virtual void EasyReset(CURL* curl) = 0;
+
   // Wrappers around curl_easy_setopt().
   virtual CURLcode EasySetOptInt(CURL* curl, CURLoption option, int value) = 0;
   virtual CURLcode EasySetOptStr(CURL* curl,
@@ -122,6 +125,21 @@ class CurlInterface {
                               int timeout_ms,
                               int* numfds) = 0;
 
+  // Wrapper around curl_share_init().
+  virtual CURLSH* ShareInit() = 0;
+
+  // Wrapper around curl_share_cleanup().
+  virtual CURLSHcode ShareCleanup(CURLSH* share_handle) = 0;
+
+  // Wrapper around curl_share_setopt() for options taking an integer, such
+  // as CURLSHOPT_SHARE.
+  virtual CURLSHcode ShareSetOptInt(CURLSH* share_handle,
+                                    CURLSHoption option,
+                                    int value) = 0;
+
+  // Wrapper around curl_share_strerror().
+  virtual std::string ShareStrError(CURLSHcode code) const = 0;
+
  private:
   DISALLOW_COPY_AND_ASSIGN(CurlInterface);
 };
@@ -137,6 +155,9 @@ class BRILLO_EXPORT CurlApi : public CurlInterface {
   // Wrapper around curl_easy_cleanup().
   void EasyCleanup(CURL* curl) override;
 
+  // Wrapper around curl_easy_reset().
+  void EasyReset(CURL* curl) override;
+
   // Wrappers around curl_easy_setopt().
   CURLcode EasySetOptInt(CURL* curl, CURLoption option, int value) override;
   CURLcode EasySetOptStr(CURL* curl,
@@ -217,6 +238,20 @@ class BRILLO_EXPORT CurlApi : public CurlInterface {
                       int timeout_ms,
                       int* numfds) override;
 
+  // Wrapper around curl_share_init().
+  CURLSH* ShareInit() override;
+
+  // Wrapper around curl_share_cleanup().
+  CURLSHcode ShareCleanup(CURLSH* share_handle) override;
+
+  // Wrapper around curl_share_setopt().
+  CURLSHcode ShareSetOptInt(CURLSH* share_handle,
+                            CURLSHoption option,
+                            int value) override;
+
+  // Wrapper around curl_share_strerror().
+  std::string ShareStrError(CURLSHcode code) const override;
+
  private:
   DISALLOW_COPY_AND_ASSIGN(CurlApi);
 };
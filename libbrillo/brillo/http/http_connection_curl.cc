@@ -69,7 +69,10 @@ Connection::Connection(CURL* curl_handle,
 Connection::~Connection() {
   if (header_list_)
     curl_slist_free_all(header_list_);
-  curl_interface_->EasyCleanup(curl_handle_);
+  if (release_handle_callback_)
+    std::move(release_handle_callback_).Run(curl_handle_);
+  else
+    curl_interface_->EasyCleanup(curl_handle_);
   VLOG(2) << "curl::Connection destroyed";
 }
 
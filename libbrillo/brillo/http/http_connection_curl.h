@@ -10,6 +10,7 @@
 #include <string>
 #include <vector>
 
+#include <base/callback.h>
 #include <base/macros.h>
 #include <brillo/brillo_export.h>
 #include <brillo/http/http_connection.h>
@@ -92,6 +93,10 @@ class BRILLO_EXPORT Connection : public http::Connection {
   std::shared_ptr<CurlInterface> curl_interface_;
 
  private:
+  // If set, |curl_handle_| is handed back to the transport through this
+  // callback for reuse instead of being cleaned up.
+  base::OnceCallback<void(CURL*)> release_handle_callback_;
+
   friend class http::curl::Transport;
   DISALLOW_COPY_AND_ASSIGN(Connection);
 };
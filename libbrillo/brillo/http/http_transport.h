@@ -125,6 +125,12 @@ class BRILLO_EXPORT Transport : public std::enable_shared_from_this<Transport> {
                                uint16_t port,
                                const std::string& ip_address) {}
 
+  // Keeps connections, DNS lookups and TLS sessions alive between requests
+  // made through this transport, so that repeated requests to the same server
+  // skip the TCP and TLS handshakes. Only affects connections created after
+  // the call.
+  virtual void EnableConnectionReuse() {}
+
   // Creates a default http::Transport (currently, using http::curl::Transport).
   static std::shared_ptr<Transport> CreateDefault();
 
@@ -113,6 +113,12 @@ Transport::Transport(const std::shared_ptr<CurlInterface>& curl_interface,
 Transport::~Transport() {
   ClearHost();
   ShutDownAsyncCurl();
+  // Connections keep the transport alive, so none can still be using the
+  // share-handle at this point.
+  for (CURL* curl_handle : idle_curl_handles_)
+    curl_interface_->EasyCleanup(curl_handle);
+  if (curl_share_handle_)
+    curl_interface_->ShareCleanup(curl_share_handle_);
   VLOG(2) << "curl::Transport destroyed";
 }
 
@@ -124,7 +130,7 @@ std::shared_ptr<http::Connection> Transport::CreateConnection(
     const std::string& referer,
     brillo::ErrorPtr* error) {
   std::shared_ptr<http::Connection> connection;
-  CURL* curl_handle = curl_interface_->EasyInit();
+  CURL* curl_handle = AcquireCurlHandle();
   if (!curl_handle) {
     LOG(ERROR) << "Failed to initialize CURL";
     brillo::Error::AddTo(error, FROM_HERE, http::kErrorDomain,
@@ -180,6 +186,10 @@ std::shared_ptr<http::Connection> Transport::CreateConnection(
     code = curl_interface_->EasySetOptPtr(curl_handle, CURLOPT_RESOLVE,
                                           host_list_);
   }
+  if (code == CURLE_OK && curl_share_handle_) {
+    code = curl_interface_->EasySetOptPtr(curl_handle, CURLOPT_SHARE,
+                                          curl_share_handle_);
+  }
 
   // Setup HTTP request method and optional request body.
   if (code == CURLE_OK) {
@@ -209,8 +219,15 @@ std::shared_ptr<http::Connection> Transport::CreateConnection(
     return connection;
   }
 
-  connection = std::make_shared<http::curl::Connection>(
+  auto curl_connection = std::make_shared<http::curl::Connection>(
       curl_handle, method, curl_interface_, shared_from_this());
+  if (curl_share_handle_) {
+    // The connection holds a reference to this transport, so the transport
+    // outlives the callback.
+    curl_connection->release_handle_callback_ = base::BindOnce(
+        &Transport::ReleaseCurlHandle, base::Unretained(this));
+  }
+  connection = curl_connection;
   if (!connection->SendHeaders(headers, error)) {
     connection.reset();
   }
@@ -302,6 +319,50 @@ void Transport::ResolveHostToIp(const std::string& host,
           .c_str());
 }
 
+void Transport::EnableConnectionReuse() {
+  if (curl_share_handle_)
+    return;
+
+  CURLSH* share_handle = curl_interface_->ShareInit();
+  if (!share_handle) {
+    LOG(ERROR) << "Failed to initialize CURL share-handle";
+    return;
+  }
+  for (curl_lock_data data : {CURL_LOCK_DATA_DNS, CURL_LOCK_DATA_SSL_SESSION,
+                              CURL_LOCK_DATA_CONNECT}) {
+    // All connections run on the transport's thread, so no lock callbacks
+    // are needed. Sharing connections needs libcurl 7.57, but the other
+    // caches are still worth sharing without it.
+    CURLSHcode code =
+        curl_interface_->ShareSetOptInt(share_handle, CURLSHOPT_SHARE, data);
+    if (code != CURLSHE_OK) {
+      LOG(WARNING) << "Failed to share CURL data " << data << ": "
+                   << curl_interface_->ShareStrError(code);
+    }
+  }
+  curl_share_handle_ = share_handle;
+}
+
+CURL* Transport::AcquireCurlHandle() {
+  if (idle_curl_handles_.empty())
+    return curl_interface_->EasyInit();
+
+  CURL* curl_handle = idle_curl_handles_.back();
+  idle_curl_handles_.pop_back();
+  return curl_handle;
+}
+
+void Transport::ReleaseCurlHandle(CURL* curl_handle) {
+  if (idle_curl_handles_.size() >= kMaxIdleCurlHandles) {
+    curl_interface_->EasyCleanup(curl_handle);
+    return;
+  }
+  // Clears the options set for the finished request. The handle keeps its
+  // live connections and caches.
+  curl_interface_->EasyReset(curl_handle);
+  idle_curl_handles_.push_back(curl_handle);
+}
+
 void Transport::ClearHost() {
   curl_slist_free_all(host_list_);
   host_list_ = nullptr;
@@ -9,6 +9,7 @@
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include <base/location.h>
 #include <base/memory/weak_ptr.h>
@@ -71,6 +72,11 @@ class BRILLO_EXPORT Transport : public http::Transport {
                        uint16_t port,
                        const std::string& ip_address) override;
 
+  // Shares the DNS cache, TLS session cache and connection pool of all
+  // connections through a CURL "share"-handle, and keeps up to
+  // |kMaxIdleCurlHandles| easy handles of finished connections for reuse.
+  void EnableConnectionReuse() override;
+
   // Helper methods to convert CURL error codes (CURLcode and CURLMcode)
   // into brillo::Error object.
   static void AddEasyCurlError(brillo::ErrorPtr* error,
@@ -91,6 +97,16 @@ class BRILLO_EXPORT Transport : public http::Transport {
   struct AsyncRequestData;
   class SocketPollData;
 
+  // Maximum number of idle CURL easy handles kept for reuse.
+  static constexpr size_t kMaxIdleCurlHandles = 4;
+
+  // Returns an idle CURL easy handle if there is one, or a new one.
+  CURL* AcquireCurlHandle();
+
+  // Called by a connection when it no longer needs |curl_handle|. Resets the
+  // handle and keeps it for reuse, or cleans it up if enough are kept.
+  void ReleaseCurlHandle(CURL* curl_handle);
+
   // Initializes CURL for async operation.
   bool SetupAsyncCurl(brillo::ErrorPtr* error);
 
@@ -126,6 +142,11 @@ class BRILLO_EXPORT Transport : public http::Transport {
   std::string proxy_;
   // CURL "multi"-handle for processing requests on multiple connections.
   CURLM* curl_multi_handle_{nullptr};
+  // CURL "share"-handle set on all connections once connection reuse is
+  // enabled.
+  CURLSH* curl_share_handle_{nullptr};
+  // Easy handles of finished connections, reset and ready for reuse.
+  std::vector<CURL*> idle_curl_handles_;
   // A map to find a corresponding Connection* using a request ID.
   std::map<RequestID, Connection*> request_id_map_;
   // Stores the connection-specific asynchronous data (such as the success
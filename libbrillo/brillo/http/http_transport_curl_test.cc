@@ -4,16 +4,40 @@
 
 #include <brillo/http/http_transport_curl.h>
 
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
 #include <base/at_exit.h>
 #include <base/bind.h>
+#include <base/files/file_util.h>
+#include <base/files/scoped_file.h>
+#include <base/files/scoped_temp_dir.h>
+#include <base/logging.h>
+#include <base/posix/eintr_wrapper.h>
 #include <base/run_loop.h>
+#include <base/strings/stringprintf.h>
 #include <base/task/single_thread_task_executor.h>
+#include <base/threading/simple_thread.h>
 #include <base/threading/thread_task_runner_handle.h>
+#include <base/timer/elapsed_timer.h>
+#include <brillo/http/curl_api.h>
 #include <brillo/http/http_connection_curl.h>
 #include <brillo/http/http_request.h>
+#include <brillo/http/http_utils.h>
 #include <brillo/http/mock_curl_api.h>
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/ssl.h>
+#include <openssl/x509v3.h>
 
 using testing::_;
 using testing::DoAll;
@@ -349,6 +373,270 @@ TEST_F(HttpCurlTransportTest, RequestGetResolveHost) {
   connection.reset();
 }
 
+namespace {
+
+// A minimal HTTPS server on 127.0.0.1, with a self-signed certificate for
+// "localhost", that answers every request with "OK". Each connection is
+// served on its own thread.
+class LocalHttpsServer : public base::DelegateSimpleThread::Delegate {
+ public:
+  LocalHttpsServer() = default;
+  ~LocalHttpsServer() override {
+    Stop();
+    SSL_CTX_free(ssl_ctx_);
+  }
+
+  // Writes the certificate of the server to |cert_path| and starts listening.
+  bool Start(const base::FilePath& cert_path) {
+    if (!CreateSslContext(cert_path))
+      return false;
+
+    listen_fd_.reset(socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0));
+    if (!listen_fd_.is_valid())
+      return false;
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addr_len = sizeof(addr);
+    if (bind(listen_fd_.get(), reinterpret_cast<struct sockaddr*>(&addr),
+             addr_len) != 0 ||
+        getsockname(listen_fd_.get(), reinterpret_cast<struct sockaddr*>(&addr),
+                    &addr_len) != 0 ||
+        listen(listen_fd_.get(), SOMAXCONN) != 0) {
+      return false;
+    }
+    port_ = ntohs(addr.sin_port);
+
+    accept_thread_ =
+        std::make_unique<base::DelegateSimpleThread>(this, "https_accept");
+    accept_thread_->Start();
+    return true;
+  }
+
+  void Stop() {
+    if (!accept_thread_)
+      return;
+    shutdown(listen_fd_.get(), SHUT_RDWR);
+    accept_thread_->Join();
+    accept_thread_.reset();
+    for (auto& handler : handlers_)
+      handler->Join();
+    handlers_.clear();
+  }
+
+  uint16_t port() const { return port_; }
+
+  // Number of connections accepted, each of which needed a TLS handshake.
+  int connections() const { return connections_.load(); }
+
+ private:
+  class ConnectionHandler : public base::DelegateSimpleThread::Delegate {
+   public:
+    ConnectionHandler(SSL_CTX* ssl_ctx, base::ScopedFD fd)
+        : ssl_ctx_(ssl_ctx), fd_(std::move(fd)), thread_(this, "https_conn") {
+      thread_.Start();
+    }
+
+    // Disconnects the client if it is still connected, and waits for the
+    // thread to finish.
+    void Join() {
+      shutdown(fd_.get(), SHUT_RDWR);
+      thread_.Join();
+    }
+
+   private:
+    // base::DelegateSimpleThread::Delegate:
+    void Run() override {
+      SSL* ssl = SSL_new(ssl_ctx_);
+      SSL_set_fd(ssl, fd_.get());
+      if (SSL_accept(ssl) == 1) {
+        // The client only sends requests without a body, so each request
+        // ends with an empty line.
+        static const char kResponse[] =
+            "HTTP/1.1 200 OK\r\n"
+            "Content-Type: text/plain\r\n"
+            "Content-Length: 2\r\n"
+            "\r\n"
+            "OK";
+        std::string request;
+        char buffer[4096];
+        int bytes_read;
+        while ((bytes_read = SSL_read(ssl, buffer, sizeof(buffer))) > 0) {
+          request.append(buffer, bytes_read);
+          size_t end;
+          while ((end = request.find("\r\n\r\n")) != std::string::npos) {
+            request.erase(0, end + 4);
+            SSL_write(ssl, kResponse, sizeof(kResponse) - 1);
+          }
+        }
+      }
+      SSL_free(ssl);
+    }
+
+    SSL_CTX* ssl_ctx_;
+    base::ScopedFD fd_;
+    base::DelegateSimpleThread thread_;
+
+    DISALLOW_COPY_AND_ASSIGN(ConnectionHandler);
+  };
+
+  bool CreateSslContext(const base::FilePath& cert_path) {
+    EVP_PKEY* key = nullptr;
+    EVP_PKEY_CTX* key_ctx = EVP_PKEY_CTX_new_id(EVP_PKEY_EC, nullptr);
+    bool success =
+        key_ctx && EVP_PKEY_keygen_init(key_ctx) == 1 &&
+        EVP_PKEY_CTX_set_ec_paramgen_curve_nid(key_ctx,
+                                               NID_X9_62_prime256v1) == 1 &&
+        EVP_PKEY_keygen(key_ctx, &key) == 1;
+    EVP_PKEY_CTX_free(key_ctx);
+
+    X509* cert = X509_new();
+    if (success) {
+      X509_set_version(cert, 2);
+      ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+      X509_gmtime_adj(X509_getm_notBefore(cert), -3600);
+      X509_gmtime_adj(X509_getm_notAfter(cert), 3600);
+      X509_set_pubkey(cert, key);
+      X509_NAME* name = X509_get_subject_name(cert);
+      X509_NAME_add_entry_by_txt(
+          name, "CN", MBSTRING_ASC,
+          reinterpret_cast<const unsigned char*>("localhost"), -1, -1, 0);
+      X509_set_issuer_name(cert, name);
+
+      X509V3_CTX ext_ctx;
+      X509V3_set_ctx_nodb(&ext_ctx);
+      X509V3_set_ctx(&ext_ctx, cert, cert, nullptr, nullptr, 0);
+      X509_EXTENSION* ext = X509V3_EXT_conf_nid(
+          nullptr, &ext_ctx, NID_subject_alt_name, "DNS:localhost");
+      success = ext && X509_add_ext(cert, ext, -1) == 1 &&
+                X509_sign(cert, key, EVP_sha256()) > 0;
+      X509_EXTENSION_free(ext);
+    }
+
+    if (success) {
+      BIO* bio = BIO_new(BIO_s_mem());
+      char* pem = nullptr;
+      success = PEM_write_bio_X509(bio, cert) == 1;
+      long pem_size = BIO_get_mem_data(bio, &pem);  // NOLINT(runtime/int)
+      success = success && base::WriteFile(cert_path, pem, pem_size) ==
+                               static_cast<int>(pem_size);
+      BIO_free(bio);
+    }
+
+    if (success) {
+      ssl_ctx_ = SSL_CTX_new(TLS_server_method());
+      success = ssl_ctx_ && SSL_CTX_use_certificate(ssl_ctx_, cert) == 1 &&
+                SSL_CTX_use_PrivateKey(ssl_ctx_, key) == 1;
+    }
+    X509_free(cert);
+    EVP_PKEY_free(key);
+    return success;
+  }
+
+  // base::DelegateSimpleThread::Delegate:
+  void Run() override {
+    // Stop() shuts the socket down, which makes accept() fail.
+    while (true) {
+      base::ScopedFD fd(
+          HANDLE_EINTR(accept4(listen_fd_.get(), nullptr, nullptr,
+                               SOCK_CLOEXEC)));
+      if (!fd.is_valid())
+        return;
+      connections_++;
+      handlers_.push_back(
+          std::make_unique<ConnectionHandler>(ssl_ctx_, std::move(fd)));
+    }
+  }
+
+  SSL_CTX* ssl_ctx_{nullptr};
+  base::ScopedFD listen_fd_;
+  uint16_t port_{0};
+  std::atomic<int> connections_{0};
+  std::unique_ptr<base::DelegateSimpleThread> accept_thread_;
+  // Only used by the accept thread while it runs.
+  std::vector<std::unique_ptr<ConnectionHandler>> handlers_;
+
+  DISALLOW_COPY_AND_ASSIGN(LocalHttpsServer);
+};
+
+// The real CURL API, except that the server certificate is verified against
+// the certificate of a LocalHttpsServer.
+class LocalCertificateCurlApi : public CurlApi {
+ public:
+  explicit LocalCertificateCurlApi(const base::FilePath& cert_path)
+      : cert_path_(cert_path) {}
+
+  CURLcode EasySetOptPtr(CURL* curl, CURLoption option, void* value) override {
+    if (option == CURLOPT_CAINFO)
+      return EasySetOptStr(curl, option, cert_path_.value());
+    return CurlApi::EasySetOptPtr(curl, option, value);
+  }
+
+ private:
+  const base::FilePath cert_path_;
+
+  DISALLOW_COPY_AND_ASSIGN(LocalCertificateCurlApi);
+};
+
+}  // namespace
+
+class HttpCurlTransportLocalServerTest : public testing::Test {
+ public:
+  void SetUp() override {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    cert_path_ = temp_dir_.GetPath().Append("cert.pem");
+    ASSERT_TRUE(server_.Start(cert_path_));
+  }
+
+ protected:
+  std::shared_ptr<Transport> CreateTransport() {
+    auto transport = std::make_shared<Transport>(
+        std::make_shared<LocalCertificateCurlApi>(cert_path_));
+    transport->ResolveHostToIp("localhost", server_.port(), "127.0.0.1");
+    return transport;
+  }
+
+  // Makes |count| GET requests one after the other through |transport|, and
+  // returns the mean time a request took.
+  base::TimeDelta GetRepeatedly(std::shared_ptr<Transport> transport,
+                                int count) {
+    const std::string url =
+        base::StringPrintf("https://localhost:%u/", server_.port());
+    base::ElapsedTimer timer;
+    for (int i = 0; i < count; i++) {
+      brillo::ErrorPtr error;
+      auto response = http::GetAndBlock(url, {}, transport, &error);
+      EXPECT_NE(nullptr, response) << (error ? error->GetMessage() : "");
+      if (response)
+        EXPECT_EQ("OK", response->ExtractDataAsString());
+    }
+    return timer.Elapsed() / count;
+  }
+
+  base::ScopedTempDir temp_dir_;
+  base::FilePath cert_path_;
+  LocalHttpsServer server_;
+};
+
+TEST_F(HttpCurlTransportLocalServerTest, RepeatedRequestsReuseConnection) {
+  constexpr int kRequests = 20;
+
+  base::TimeDelta without_reuse = GetRepeatedly(CreateTransport(), kRequests);
+  // Each request connected and made a TLS handshake.
+  EXPECT_EQ(kRequests, server_.connections());
+
+  auto transport = CreateTransport();
+  transport->EnableConnectionReuse();
+  base::TimeDelta with_reuse = GetRepeatedly(transport, kRequests);
+  // Only the first request connected, the others reused its connection.
+  EXPECT_EQ(kRequests + 1, server_.connections());
+
+  LOG(INFO) << "Mean request latency: " << without_reuse.InMicroseconds()
+            << "us without connection reuse, " << with_reuse.InMicroseconds()
+            << "us with connection reuse";
+  EXPECT_LT(with_reuse, without_reuse);
+}
+
 }  // namespace curl
 }  // namespace http
 }  // namespace brillo
@@ -22,6 +22,7 @@ class MockCurlInterface : public CurlInterface {
 
   MOCK_METHOD(CURL*, EasyInit, (), (override));
   MOCK_METHOD(void, EasyCleanup, (CURL*), (override));
+  MOCK_METHOD(void, EasyReset, (CURL*), (override));
   MOCK_METHOD(CURLcode, EasySetOptInt, (CURL*, CURLoption, int), (override));
   MOCK_METHOD(CURLcode,
               EasySetOptStr,
@@ -81,6 +82,13 @@ class MockCurlInterface : public CurlInterface {
               MultiWait,
               (CURLM*, curl_waitfd[], unsigned int, int, int*),
               (override));
+  MOCK_METHOD(CURLSH*, ShareInit, (), (override));
+  MOCK_METHOD(CURLSHcode, ShareCleanup, (CURLSH*), (override));
+  MOCK_METHOD(CURLSHcode,
+              ShareSetOptInt,
+              (CURLSH*, CURLSHoption, int),
+              (override));
+  MOCK_METHOD(std::string, ShareStrError, (CURLSHcode), (const, override));
 
  private:
   DISALLOW_COPY_AND_ASSIGN(MockCurlInterface);
@@ -153,6 +153,8 @@ class FileDescriptor : public FileStream::FileDescriptorInterface {
     write_watcher_ = nullptr;
   }
 
+  int GetFd() const override { return fd_; }
+
   // Called from the brillo::MessageLoop when the file descriptor is available
   // for reading.
   void OnReadable() {
@@ -531,4 +533,8 @@ void FileStream::CancelPendingAsyncOperations() {
   Stream::CancelPendingAsyncOperations();
 }
 
+int FileStream::GetFileDescriptor() const {
+  return IsOpen() ? fd_interface_->GetFd() : -1;
+}
+
 }  // namespace brillo
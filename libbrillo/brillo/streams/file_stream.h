@@ -54,6 +54,7 @@ class BRILLO_EXPORT FileStream : public Stream {
                                     base::TimeDelta timeout,
                                     AccessMode* out_mode) = 0;
     virtual void CancelPendingAsyncOperations() = 0;
+    virtual int GetFd() const = 0;
   };
 
   // == Construction ==========================================================
@@ -148,6 +149,8 @@ class BRILLO_EXPORT FileStream : public Stream {
   // Cancels pending asynchronous read/write operations.
   void CancelPendingAsyncOperations() override;
 
+  int GetFileDescriptor() const override;
+
  private:
   friend class FileStreamTest;
 
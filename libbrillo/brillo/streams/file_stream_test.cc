@@ -149,6 +149,7 @@ class MockFileDescriptor : public FileStream::FileDescriptorInterface {
               (Stream::AccessMode, base::TimeDelta, Stream::AccessMode*),
               (override));
   MOCK_METHOD(void, CancelPendingAsyncOperations, (), (override));
+  MOCK_METHOD(int, GetFd, (), (const, override));
 };
 
 class FileStreamTest : public testing::Test {
@@ -390,6 +390,11 @@ class BRILLO_EXPORT Stream {
   // Cancels pending asynchronous read/write operations.
   virtual void CancelPendingAsyncOperations();
 
+  // Returns the file descriptor the stream reads from and writes to directly,
+  // or -1 if there is none. The stream keeps ownership of the descriptor.
+  // This lets stream_utils::CopyData() copy between descriptors in the kernel.
+  virtual int GetFileDescriptor() const { return -1; }
+
  protected:
   Stream() = default;
 
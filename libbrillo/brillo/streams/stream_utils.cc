@@ -4,6 +4,12 @@
 
 #include <brillo/streams/stream_utils.h>
 
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include <algorithm>
 #include <limits>
 #include <memory>
@@ -11,6 +17,10 @@
 #include <vector>
 
 #include <base/bind.h>
+#include <base/logging.h>
+#include <base/posix/eintr_wrapper.h>
+#include <base/stl_util.h>
+#include <brillo/errors/error_codes.h>
 #include <brillo/message_loops/message_loop.h>
 #include <brillo/streams/stream_errors.h>
 
@@ -19,69 +29,299 @@ namespace stream_utils {
 
 namespace {
 
+// Buffer size used by the CopyData() overload that doesn't take one.
+constexpr size_t kDefaultCopyBufferSize = 64 * 1024;
+
+// Maximum amount of data moved by a single splice(), sendfile() or
+// copy_file_range() call. The copy yields to the message loop between chunks
+// so a large transfer doesn't starve other tasks.
+constexpr size_t kKernelCopyChunkSize = 1024 * 1024;
+
+// System call used to copy data between two file descriptors without bringing
+// it to user space.
+enum class KernelCopyMethod {
+  kNone,
+  kSplice,
+  kSendFile,
+  kCopyFileRange,
+};
+
 // Status of asynchronous CopyData operation.
 struct CopyDataState {
   brillo::StreamPtr in_stream;
   brillo::StreamPtr out_stream;
-  std::vector<uint8_t> buffer;
+  KernelCopyMethod kernel_copy_method{KernelCopyMethod::kNone};
+  size_t buffer_size;
+  // Data is read into one buffer while the other one is being written, and
+  // the roles swap once both operations finished. |read_index| and
+  // |write_index| are the buffers the next read and write use, and
+  // |buffer_fill| is the amount of data each buffer holds.
+  std::vector<uint8_t> buffers[2];
+  size_t buffer_fill[2]{0, 0};
+  size_t read_index{0};
+  size_t write_index{0};
+  bool reading{false};
+  bool writing{false};
+  bool end_of_stream{false};
+  // Set once either callback has been invoked. Completions of operations that
+  // were still pending at that point are ignored.
+  bool done{false};
   uint64_t remaining_to_copy;
   uint64_t size_copied;
   CopyDataSuccessCallback success_callback;
   CopyDataErrorCallback error_callback;
 };
 
+// Invokes the success callback of CopyData.
+void OnCopyDataSuccess(const std::shared_ptr<CopyDataState>& state) {
+  if (state->done)
+    return;
+  state->done = true;
+  state->success_callback.Run(std::move(state->in_stream),
+                              std::move(state->out_stream),
+                              state->size_copied);
+}
+
 // Async CopyData I/O error callback.
 void OnCopyDataError(const std::shared_ptr<CopyDataState>& state,
                      const brillo::Error* error) {
+  if (state->done)
+    return;
+  state->done = true;
+  // A read may still be pending while a write failed, or the other way around.
+  state->in_stream->CancelPendingAsyncOperations();
+  state->out_stream->CancelPendingAsyncOperations();
   state->error_callback.Run(std::move(state->in_stream),
                             std::move(state->out_stream), error);
 }
 
 // Forward declaration.
-void PerformRead(const std::shared_ptr<CopyDataState>& state);
+void PumpBufferedCopy(const std::shared_ptr<CopyDataState>& state);
 
-// Callback from read operation for CopyData. Writes the read data to the output
-// stream and invokes PerformRead when done to restart the copy cycle.
-void PerformWrite(const std::shared_ptr<CopyDataState>& state, size_t size) {
+// Called when a read issued by PumpBufferedCopy() completes.
+void OnBufferRead(const std::shared_ptr<CopyDataState>& state, size_t size) {
+  if (state->done)
+    return;
+  state->reading = false;
   if (size == 0) {
-    state->success_callback.Run(std::move(state->in_stream),
-                                std::move(state->out_stream),
-                                state->size_copied);
+    state->end_of_stream = true;
+  } else {
+    CHECK_GE(state->remaining_to_copy, size);
+    state->remaining_to_copy -= size;
+    state->buffer_fill[state->read_index] = size;
+    state->read_index ^= 1;
+  }
+  PumpBufferedCopy(state);
+}
+
+// Called when a write issued by PumpBufferedCopy() completes.
+void OnBufferWritten(const std::shared_ptr<CopyDataState>& state) {
+  if (state->done)
     return;
+  state->writing = false;
+  state->size_copied += state->buffer_fill[state->write_index];
+  state->buffer_fill[state->write_index] = 0;
+  state->write_index ^= 1;
+  PumpBufferedCopy(state);
+}
+
+// Drives the buffered part of CopyData. Starts writing a filled buffer and
+// reading into an empty one, whichever of those is possible and not already
+// in progress, so that reading the next block overlaps with writing the
+// previous one. Finishes the operation once all the data has been written.
+void PumpBufferedCopy(const std::shared_ptr<CopyDataState>& state) {
+  const size_t write_index = state->write_index;
+  if (!state->writing && state->buffer_fill[write_index] > 0) {
+    state->writing = true;
+    brillo::ErrorPtr error;
+    bool success = state->out_stream->WriteAllAsync(
+        state->buffers[write_index].data(), state->buffer_fill[write_index],
+        base::Bind(&OnBufferWritten, state),
+        base::Bind(&OnCopyDataError, state), &error);
+    if (!success)
+      return OnCopyDataError(state, error.get());
   }
-  state->size_copied += size;
-  CHECK_GE(state->remaining_to_copy, size);
-  state->remaining_to_copy -= size;
 
-  brillo::ErrorPtr error;
-  bool success = state->out_stream->WriteAllAsync(
-      state->buffer.data(), size, base::Bind(&PerformRead, state),
-      base::Bind(&OnCopyDataError, state), &error);
+  const size_t read_index = state->read_index;
+  if (!state->done && !state->reading && !state->end_of_stream &&
+      state->remaining_to_copy > 0 && state->buffer_fill[read_index] == 0) {
+    // |buffer_size| is a size_t, so |size_to_read| fits in one too.
+    size_t size_to_read = static_cast<size_t>(
+        std::min<uint64_t>(state->buffer_size, state->remaining_to_copy));
+    state->reading = true;
+    brillo::ErrorPtr error;
+    bool success = state->in_stream->ReadAsync(
+        state->buffers[read_index].data(), size_to_read,
+        base::Bind(&OnBufferRead, state), base::Bind(&OnCopyDataError, state),
+        &error);
+    if (!success)
+      return OnCopyDataError(state, error.get());
+  }
 
-  if (!success)
-    OnCopyDataError(state, error.get());
+  if (!state->reading && !state->writing && state->buffer_fill[0] == 0 &&
+      state->buffer_fill[1] == 0 &&
+      (state->end_of_stream || state->remaining_to_copy == 0)) {
+    OnCopyDataSuccess(state);
+  }
+}
+
+// Copies data through user space buffers, using the streams' asynchronous
+// read and write operations.
+void StartBufferedCopy(const std::shared_ptr<CopyDataState>& state) {
+  state->kernel_copy_method = KernelCopyMethod::kNone;
+  state->buffers[0].resize(state->buffer_size);
+  state->buffers[1].resize(state->buffer_size);
+  PumpBufferedCopy(state);
 }
 
-// Performs the read part of asynchronous CopyData operation. Reads the data
-// from input stream and invokes PerformWrite when done to write the data to
-// the output stream.
-void PerformRead(const std::shared_ptr<CopyDataState>& state) {
+// Picks the system call able to copy data from |in_fd| to |out_fd|, if any.
+KernelCopyMethod GetKernelCopyMethod(int in_fd, int out_fd) {
+  struct stat in_stat;
+  struct stat out_stat;
+  if (fstat(in_fd, &in_stat) < 0 || fstat(out_fd, &out_stat) < 0)
+    return KernelCopyMethod::kNone;
+  // None of the system calls write to a descriptor opened with O_APPEND.
+  int out_flags = fcntl(out_fd, F_GETFL);
+  if (out_flags < 0 || (out_flags & O_APPEND))
+    return KernelCopyMethod::kNone;
+  if (S_ISFIFO(in_stat.st_mode) || S_ISFIFO(out_stat.st_mode))
+    return KernelCopyMethod::kSplice;
+  // Files in pseudo file systems such as procfs and sysfs report a size of 0
+  // and can't be read with sendfile() or copy_file_range() reliably.
+  if (!S_ISREG(in_stat.st_mode) || in_stat.st_size == 0)
+    return KernelCopyMethod::kNone;
+  if (S_ISREG(out_stat.st_mode))
+    return KernelCopyMethod::kCopyFileRange;
+  return KernelCopyMethod::kSendFile;
+}
+
+// Copies up to |size| bytes from |in_fd| to |out_fd| at their current
+// positions. Returns the number of bytes copied, 0 at the end of the input,
+// or -1 with errno set.
+ssize_t KernelCopy(KernelCopyMethod method,
+                   int in_fd,
+                   int out_fd,
+                   size_t size) {
+  switch (method) {
+    case KernelCopyMethod::kSplice:
+      return HANDLE_EINTR(splice(in_fd, nullptr, out_fd, nullptr, size,
+                                 SPLICE_F_MOVE | SPLICE_F_NONBLOCK));
+    case KernelCopyMethod::kSendFile:
+      return HANDLE_EINTR(sendfile(out_fd, in_fd, nullptr, size));
+    case KernelCopyMethod::kCopyFileRange:
+      return HANDLE_EINTR(
+          copy_file_range(in_fd, nullptr, out_fd, nullptr, size, 0));
+    case KernelCopyMethod::kNone:
+      break;
+  }
+  NOTREACHED();
+  errno = EINVAL;
+  return -1;
+}
+
+// Forward declarations.
+void PerformKernelCopy(const std::shared_ptr<CopyDataState>& state);
+void WaitForKernelCopy(const std::shared_ptr<CopyDataState>& state);
+
+// Called by Stream::WaitForData() once the stream that blocked the kernel
+// copy is ready again.
+void OnKernelCopyReady(const std::shared_ptr<CopyDataState>& state,
+                       Stream::AccessMode /* mode */) {
+  PerformKernelCopy(state);
+}
+
+// Copies the next chunk of data in the kernel. Falls back to the buffered copy
+// if the kernel refuses to copy between these two descriptors.
+void PerformKernelCopy(const std::shared_ptr<CopyDataState>& state) {
+  if (state->remaining_to_copy == 0)
+    return OnCopyDataSuccess(state);
+
+  size_t size_to_copy = static_cast<size_t>(
+      std::min<uint64_t>(kKernelCopyChunkSize, state->remaining_to_copy));
+  ssize_t copied = KernelCopy(
+      state->kernel_copy_method, state->in_stream->GetFileDescriptor(),
+      state->out_stream->GetFileDescriptor(), size_to_copy);
+  if (copied > 0) {
+    state->size_copied += copied;
+    state->remaining_to_copy -= copied;
+    brillo::MessageLoop::current()->PostTask(
+        FROM_HERE, base::BindOnce(&PerformKernelCopy, state));
+    return;
+  }
+  if (copied == 0)
+    return OnCopyDataSuccess(state);
+
+  switch (errno) {
+    case EAGAIN:
+      return WaitForKernelCopy(state);
+    case EBADF:
+      // copy_file_range() also returns EBADF for a descriptor it refuses to
+      // write to, such as one opened with O_APPEND.
+      if (state->kernel_copy_method != KernelCopyMethod::kCopyFileRange)
+        break;
+      return StartBufferedCopy(state);
+    case EINVAL:
+    case ENOSYS:
+    case EOPNOTSUPP:
+    case EXDEV:
+      // Each method keeps the descriptors' positions up to date, so the copy
+      // can continue with another method wherever this one stopped.
+      if (state->kernel_copy_method == KernelCopyMethod::kCopyFileRange) {
+        state->kernel_copy_method = KernelCopyMethod::kSendFile;
+        return PerformKernelCopy(state);
+      }
+      return StartBufferedCopy(state);
+  }
   brillo::ErrorPtr error;
-  const uint64_t buffer_size = state->buffer.size();
-  // |buffer_size| is guaranteed to fit in size_t, so |size_to_read| value will
-  // also not overflow size_t, so the static_cast below is safe.
-  size_t size_to_read =
-      static_cast<size_t>(std::min(buffer_size, state->remaining_to_copy));
-  if (size_to_read == 0)
-    return PerformWrite(state, 0);  // Nothing more to read. Finish operation.
-  bool success = state->in_stream->ReadAsync(
-      state->buffer.data(), size_to_read, base::Bind(PerformWrite, state),
-      base::Bind(OnCopyDataError, state), &error);
+  errors::system::AddSystemError(&error, FROM_HERE, errno);
+  OnCopyDataError(state, error.get());
+}
 
+// Waits for whichever of the streams made the kernel copy return EAGAIN.
+void WaitForKernelCopy(const std::shared_ptr<CopyDataState>& state) {
+  struct pollfd fds[2] = {
+      {state->in_stream->GetFileDescriptor(), POLLIN, 0},
+      {state->out_stream->GetFileDescriptor(), POLLOUT, 0},
+  };
+  if (HANDLE_EINTR(poll(fds, base::size(fds), 0)) < 0) {
+    brillo::ErrorPtr error;
+    errors::system::AddSystemError(&error, FROM_HERE, errno);
+    return OnCopyDataError(state, error.get());
+  }
+
+  brillo::ErrorPtr error;
+  bool success = true;
+  if (fds[0].revents == 0) {
+    success = state->in_stream->WaitForData(
+        Stream::AccessMode::READ, base::Bind(&OnKernelCopyReady, state),
+        &error);
+  } else if (fds[1].revents == 0) {
+    success = state->out_stream->WaitForData(
+        Stream::AccessMode::WRITE, base::Bind(&OnKernelCopyReady, state),
+        &error);
+  } else {
+    // Both ends look ready, so whatever blocked the copy has gone away.
+    brillo::MessageLoop::current()->PostTask(
+        FROM_HERE, base::BindOnce(&PerformKernelCopy, state));
+  }
   if (!success)
     OnCopyDataError(state, error.get());
 }
 
+// Starts the CopyData operation, in the kernel if both streams are backed by
+// file descriptors that allow it.
+void StartCopy(const std::shared_ptr<CopyDataState>& state) {
+  const int in_fd = state->in_stream->GetFileDescriptor();
+  const int out_fd = state->out_stream->GetFileDescriptor();
+  if (in_fd >= 0 && out_fd >= 0 && state->in_stream->CanRead() &&
+      state->out_stream->CanWrite()) {
+    state->kernel_copy_method = GetKernelCopyMethod(in_fd, out_fd);
+  }
+  if (state->kernel_copy_method == KernelCopyMethod::kNone)
+    return StartBufferedCopy(state);
+  PerformKernelCopy(state);
+}
+
 }  // anonymous namespace
 
 bool ErrorStreamClosed(const base::Location& location, ErrorPtr* error) {
@@ -176,8 +416,8 @@ void CopyData(StreamPtr in_stream,
               const CopyDataSuccessCallback& success_callback,
               const CopyDataErrorCallback& error_callback) {
   CopyData(std::move(in_stream), std::move(out_stream),
-           std::numeric_limits<uint64_t>::max(), 4096, success_callback,
-           error_callback);
+           std::numeric_limits<uint64_t>::max(), kDefaultCopyBufferSize,
+           success_callback, error_callback);
 }
 
 void CopyData(StreamPtr in_stream,
@@ -189,13 +429,13 @@ void CopyData(StreamPtr in_stream,
   auto state = std::make_shared<CopyDataState>();
   state->in_stream = std::move(in_stream);
   state->out_stream = std::move(out_stream);
-  state->buffer.resize(buffer_size);
+  state->buffer_size = buffer_size;
   state->remaining_to_copy = max_size_to_copy;
   state->size_copied = 0;
   state->success_callback = success_callback;
   state->error_callback = error_callback;
   brillo::MessageLoop::current()->PostTask(FROM_HERE,
-                                           base::BindOnce(&PerformRead, state));
+                                           base::BindOnce(&StartCopy, state));
 }
 
 }  // namespace stream_utils
@@ -86,7 +86,7 @@ using CopyDataErrorCallback =
 // streams for the duration of the operation and then gives them back when
 // either the |success_callback| or |error_callback| is called.
 // |success_callback| also provides the number of bytes actually copied.
-// This variant of CopyData uses internal buffer of 4 KiB for the operation.
+// This variant of CopyData uses internal buffers of 64 KiB for the operation.
 BRILLO_EXPORT void CopyData(StreamPtr in_stream,
                             StreamPtr out_stream,
                             const CopyDataSuccessCallback& success_callback,
@@ -99,6 +99,14 @@ BRILLO_EXPORT void CopyData(StreamPtr in_stream,
 // either the |success_callback| or |error_callback| is called.
 // |success_callback| also provides the number of bytes actually copied.
 // |buffer_size| specifies the size of the read buffer to use for the operation.
+// Two such buffers are used, so that the next block of data is read while the
+// previous one is being written.
+//
+// If both streams are backed by file descriptors (see
+// Stream::GetFileDescriptor()), the data is copied in the kernel instead with
+// splice() when either end is a pipe, or with copy_file_range() or sendfile()
+// when the input is a regular file. The buffers are only used if the kernel
+// can't copy between the two descriptors.
 BRILLO_EXPORT void CopyData(StreamPtr in_stream,
                             StreamPtr out_stream,
                             uint64_t max_size_to_copy,
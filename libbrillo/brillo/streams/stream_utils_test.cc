@@ -4,14 +4,28 @@
 
 #include <brillo/streams/stream_utils.h>
 
+#include <fcntl.h>
+#include <unistd.h>
+
 #include <limits>
 #include <memory>
 #include <string>
 #include <utility>
 
 #include <base/bind.h>
+#include <base/files/file_util.h>
+#include <base/files/scoped_temp_dir.h>
+#include <base/logging.h>
+#include <base/rand_util.h>
+#include <base/task/single_thread_task_executor.h>
+#include <base/threading/thread.h>
+#include <base/time/time.h>
+#include <brillo/message_loops/base_message_loop.h>
 #include <brillo/message_loops/fake_message_loop.h>
 #include <brillo/message_loops/message_loop.h>
+#include <brillo/message_loops/message_loop_utils.h>
+#include <brillo/streams/file_stream.h>
+#include <brillo/streams/memory_stream.h>
 #include <brillo/streams/mock_stream.h>
 #include <brillo/streams/stream_errors.h>
 #include <gmock/gmock.h>
@@ -289,6 +303,9 @@ TEST_F(CopyStreamDataTest, ErrorWrite) {
         .WillOnce(InvokeAsyncCallback<2>(60));
     EXPECT_CALL(*out_stream_, WriteAllAsync(_, 60, _, _, _))
         .WillOnce(InvokeAsyncErrorCallback<3>("write"));
+    // The next block is read while the first one is being written.
+    EXPECT_CALL(*in_stream_, ReadAsync(_, 40, _, _, _))
+        .WillOnce(InvokeAsyncCallback<2>(40));
   }
   stream_utils::CopyData(
       std::move(in_stream_), std::move(out_stream_), 100, 60,
@@ -299,4 +316,158 @@ TEST_F(CopyStreamDataTest, ErrorWrite) {
   ExpectFailure();
 }
 
+// Copies between real streams, through the kernel where possible.
+class CopyStreamDataIoTest : public testing::Test {
+ public:
+  void SetUp() override {
+    brillo_loop_.SetAsCurrent();
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+  }
+
+  // Writes |data| to a new file and opens it for reading.
+  StreamPtr OpenInputFile(const std::string& data) {
+    base::FilePath path = temp_dir_.GetPath().Append("in");
+    EXPECT_EQ(static_cast<int>(data.size()),
+              base::WriteFile(path, data.data(), data.size()));
+    return FileStream::Open(path, Stream::AccessMode::READ,
+                            FileStream::Disposition::OPEN_EXISTING, nullptr);
+  }
+
+  StreamPtr OpenOutputFile() {
+    return FileStream::Open(output_path(), Stream::AccessMode::WRITE,
+                            FileStream::Disposition::CREATE_ALWAYS, nullptr);
+  }
+
+  // Creates a pipe whose read end is returned as a stream. |data| is written
+  // to the other end from a separate thread, which then closes it.
+  StreamPtr OpenInputPipe(const std::string& data) {
+    int fds[2];
+    EXPECT_EQ(0, pipe(fds));
+    if (!writer_thread_.IsRunning())
+      EXPECT_TRUE(writer_thread_.Start());
+    writer_thread_.task_runner()->PostTask(
+        FROM_HERE, base::BindOnce(
+                       [](int fd, const std::string& data) {
+                         EXPECT_TRUE(base::WriteFileDescriptor(
+                             fd, data.data(), data.size()));
+                         close(fd);
+                       },
+                       fds[1], data));
+    return FileStream::FromFileDescriptor(fds[0], true, nullptr);
+  }
+
+  // Runs CopyData() to completion. Returns the number of bytes copied, or -1
+  // if the copy failed.
+  int64_t Copy(StreamPtr in_stream, StreamPtr out_stream, size_t buffer_size) {
+    int64_t result = -1;
+    bool finished = false;
+    stream_utils::CopyData(
+        std::move(in_stream), std::move(out_stream),
+        std::numeric_limits<uint64_t>::max(), buffer_size,
+        base::Bind(
+            [](int64_t* result, bool* finished, StreamPtr, StreamPtr,
+               uint64_t copied) {
+              *result = copied;
+              *finished = true;
+            },
+            &result, &finished),
+        base::Bind([](bool* finished, StreamPtr, StreamPtr,
+                      const Error*) { *finished = true; },
+                   &finished));
+    MessageLoopRunUntil(&brillo_loop_, base::TimeDelta::FromSeconds(30),
+                        base::Bind([](bool* finished) { return *finished; },
+                                   &finished));
+    EXPECT_TRUE(finished);
+    return result;
+  }
+
+  std::string ReadOutputFile() {
+    std::string data;
+    EXPECT_TRUE(base::ReadFileToString(output_path(), &data));
+    return data;
+  }
+
+  base::FilePath output_path() const {
+    return temp_dir_.GetPath().Append("out");
+  }
+
+  base::SingleThreadTaskExecutor task_executor_{base::MessagePumpType::IO};
+  BaseMessageLoop brillo_loop_{task_executor_.task_runner()};
+  base::ScopedTempDir temp_dir_;
+  base::Thread writer_thread_{"pipe writer"};
+};
+
+TEST_F(CopyStreamDataIoTest, FileToFile) {
+  // Larger than a single kernel copy.
+  const std::string data = base::RandBytesAsString(3 * 1024 * 1024 + 5);
+  EXPECT_EQ(static_cast<int64_t>(data.size()),
+            Copy(OpenInputFile(data), OpenOutputFile(), 4096));
+  EXPECT_EQ(data, ReadOutputFile());
+}
+
+// The kernel won't copy to a file opened with O_APPEND, so the data has to go
+// through the buffered copy.
+TEST_F(CopyStreamDataIoTest, FileToAppendedFile) {
+  const std::string prefix = "existing data";
+  ASSERT_EQ(static_cast<int>(prefix.size()),
+            base::WriteFile(output_path(), prefix.data(), prefix.size()));
+  int fd = open(output_path().value().c_str(), O_WRONLY | O_APPEND);
+  ASSERT_GE(fd, 0);
+  StreamPtr out_stream = FileStream::FromFileDescriptor(fd, true, nullptr);
+  ASSERT_TRUE(out_stream);
+
+  const std::string data = base::RandBytesAsString(1024 * 1024 + 5);
+  EXPECT_EQ(static_cast<int64_t>(data.size()),
+            Copy(OpenInputFile(data), std::move(out_stream), 4096));
+  EXPECT_EQ(prefix + data, ReadOutputFile());
+}
+
+TEST_F(CopyStreamDataIoTest, PipeToFile) {
+  const std::string data = base::RandBytesAsString(1024 * 1024);
+  EXPECT_EQ(static_cast<int64_t>(data.size()),
+            Copy(OpenInputPipe(data), OpenOutputFile(), 4096));
+  EXPECT_EQ(data, ReadOutputFile());
+}
+
+TEST_F(CopyStreamDataIoTest, MemoryToFile) {
+  const std::string data = base::RandBytesAsString(100 * 1024 + 5);
+  EXPECT_EQ(static_cast<int64_t>(data.size()),
+            Copy(MemoryStream::OpenRef(data, nullptr), OpenOutputFile(), 4096));
+  EXPECT_EQ(data, ReadOutputFile());
+}
+
+// Logs the throughput of CopyData() between the various kinds of streams.
+// Run with --gtest_also_run_disabled_tests.
+TEST_F(CopyStreamDataIoTest, DISABLED_Benchmark) {
+  const std::string data = base::RandBytesAsString(64 * 1024 * 1024);
+  auto log_throughput = [&data](const char* name, base::TimeTicks start) {
+    base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+    LOG(INFO) << name << ": " << data.size() / elapsed.InSecondsF() / 1e6
+              << " MB/s";
+  };
+
+  for (size_t buffer_size : {4096, 64 * 1024}) {
+    LOG(INFO) << "Buffer size " << buffer_size;
+
+    StreamPtr in_stream = OpenInputFile(data);
+    base::TimeTicks start = base::TimeTicks::Now();
+    ASSERT_EQ(static_cast<int64_t>(data.size()),
+              Copy(std::move(in_stream), OpenOutputFile(), buffer_size));
+    log_throughput("file to file", start);
+
+    in_stream = OpenInputPipe(data);
+    start = base::TimeTicks::Now();
+    ASSERT_EQ(static_cast<int64_t>(data.size()),
+              Copy(std::move(in_stream), OpenOutputFile(), buffer_size));
+    log_throughput("pipe to file", start);
+
+    in_stream = MemoryStream::OpenRef(data, nullptr);
+    start = base::TimeTicks::Now();
+    ASSERT_EQ(static_cast<int64_t>(data.size()),
+              Copy(std::move(in_stream), MemoryStream::Create(nullptr),
+                   buffer_size));
+    log_throughput("memory to memory", start);
+  }
+}
+
 }  // namespace brillo
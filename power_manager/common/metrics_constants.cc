@@ -70,6 +70,15 @@ const char kNumberOfAlsAdjustmentsPerSessionName[] =
 const int kNumberOfAlsAdjustmentsPerSessionMin = 1;
 const int kNumberOfAlsAdjustmentsPerSessionMax = 10000;
 
+const char kAmbientLightSensorWakeupsPerMinuteName[] =
+    "Power.AmbientLightSensorWakeupsPerMinute";
+const char kAmbientLightSensorLidSuffix[] = "Lid";
+const char kAmbientLightSensorBaseSuffix[] = "Base";
+const char kAmbientLightSensorUnknownLocationSuffix[] = "UnknownLocation";
+const int kAmbientLightSensorWakeupsPerMinuteMin = 1;
+const int kAmbientLightSensorWakeupsPerMinuteMax = 1000;
+const int kAmbientLightSensorWakeupsIntervalSec = 10 * 60;
+
 const char kUserBrightnessAdjustmentsPerSessionName[] =
     "Power.UserBrightnessAdjustmentsPerSession";
 const int kUserBrightnessAdjustmentsPerSessionMin = 1;
@@ -102,6 +111,15 @@ const int kPowerSupplyMaxPowerMax = 101;
 
 const char kPowerSupplyTypeName[] = "Power.PowerSupplyType";
 
+const char kPowerSupplyUpdateSyscallsName[] = "Power.PowerSupplyUpdateSyscalls";
+const int kPowerSupplyUpdateSyscallsMin = 1;
+const int kPowerSupplyUpdateSyscallsMax = 1000;
+
+const char kPowerSupplyUpdateDurationUsName[] =
+    "Power.PowerSupplyUpdateDurationUs";
+const int kPowerSupplyUpdateDurationUsMin = 1;
+const int kPowerSupplyUpdateDurationUsMax = 100000;
+
 const char kConnectedChargingPortsName[] = "Power.ConnectedChargingPorts";
 
 const char kExternalBrightnessRequestResultName[] =
@@ -70,6 +70,16 @@ extern const char kNumberOfAlsAdjustmentsPerSessionName[];
 extern const int kNumberOfAlsAdjustmentsPerSessionMin;
 extern const int kNumberOfAlsAdjustmentsPerSessionMax;
 
+// Reported separately for each sensor, with one of the location suffixes
+// below appended to the name.
+extern const char kAmbientLightSensorWakeupsPerMinuteName[];
+extern const char kAmbientLightSensorLidSuffix[];
+extern const char kAmbientLightSensorBaseSuffix[];
+extern const char kAmbientLightSensorUnknownLocationSuffix[];
+extern const int kAmbientLightSensorWakeupsPerMinuteMin;
+extern const int kAmbientLightSensorWakeupsPerMinuteMax;
+extern const int kAmbientLightSensorWakeupsIntervalSec;
+
 extern const char kUserBrightnessAdjustmentsPerSessionName[];
 extern const int kUserBrightnessAdjustmentsPerSessionMin;
 extern const int kUserBrightnessAdjustmentsPerSessionMax;
@@ -100,6 +110,14 @@ extern const int kPowerSupplyMaxPowerMax;
 
 extern const char kPowerSupplyTypeName[];
 
+extern const char kPowerSupplyUpdateSyscallsName[];
+extern const int kPowerSupplyUpdateSyscallsMin;
+extern const int kPowerSupplyUpdateSyscallsMax;
+
+extern const char kPowerSupplyUpdateDurationUsName[];
+extern const int kPowerSupplyUpdateDurationUsMin;
+extern const int kPowerSupplyUpdateDurationUsMax;
+
 extern const char kConnectedChargingPortsName[];
 
 extern const char kExternalBrightnessRequestResultName[];
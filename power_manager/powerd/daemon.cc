@@ -337,7 +337,8 @@ void Daemon::Init() {
   // Ignore the ALS and backlights in factory mode.
   if (!factory_mode_) {
     light_sensor_manager_ =
-        delegate_->CreateAmbientLightSensorManager(prefs_.get());
+        delegate_->CreateAmbientLightSensorManager(prefs_.get(),
+                                                   dbus_wrapper_.get());
 
     if (BoolPrefIsTrue(kExternalDisplayOnlyPref)) {
       display_backlight_controller_ =
@@ -64,7 +64,8 @@ class DaemonDelegate {
   virtual std::unique_ptr<system::UdevInterface> CreateUdev() = 0;
 
   virtual std::unique_ptr<system::AmbientLightSensorManagerInterface>
-  CreateAmbientLightSensorManager(PrefsInterface* prefs) = 0;
+  CreateAmbientLightSensorManager(
+      PrefsInterface* prefs, system::DBusWrapperInterface* dbus_wrapper) = 0;
 
   virtual std::unique_ptr<system::DisplayWatcherInterface> CreateDisplayWatcher(
       system::UdevInterface* udev) = 0;
@@ -153,7 +153,10 @@ class DaemonTest : public ::testing::Test, public DaemonDelegate {
     return std::move(passed_udev_);
   }
   std::unique_ptr<system::AmbientLightSensorManagerInterface>
-  CreateAmbientLightSensorManager(PrefsInterface* prefs) override {
+  CreateAmbientLightSensorManager(
+      PrefsInterface* prefs,
+      system::DBusWrapperInterface* dbus_wrapper) override {
+    EXPECT_EQ(dbus_wrapper_, dbus_wrapper);
     return std::move(passed_ambient_light_sensor_manager_);
   }
   std::unique_ptr<system::DisplayWatcherInterface> CreateDisplayWatcher(
@@ -12,6 +12,7 @@
 #include <unistd.h>
 
 #include <base/at_exit.h>
+#include <base/bind.h>
 #include <base/command_line.h>
 #include <base/files/file_descriptor_watcher_posix.h>
 #include <base/files/file_path.h>
@@ -28,6 +29,11 @@
 #include <brillo/flag_helper.h>
 #include <metrics/metrics_library.h>
 
+#if USE_IIOSERVICE
+#include <mojo/core/embedder/embedder.h>
+#include <mojo/core/embedder/scoped_ipc_support.h>
+#endif  // USE_IIOSERVICE
+
 #include "power_manager/common/metrics_sender.h"
 #include "power_manager/common/prefs.h"
 #include "power_manager/common/util.h"
@@ -54,6 +60,9 @@
 #include "power_manager/powerd/system/pluggable_internal_backlight.h"
 #include "power_manager/powerd/system/power_supply.h"
 #include "power_manager/powerd/system/sar_watcher.h"
+#if USE_IIOSERVICE
+#include "power_manager/powerd/system/sensor_service_handler.h"
+#endif  // USE_IIOSERVICE
 #include "power_manager/powerd/system/suspend_configurator.h"
 #include "power_manager/powerd/system/thermal/thermal_device.h"
 #include "power_manager/powerd/system/thermal/thermal_device_factory.h"
@@ -91,10 +100,21 @@ class DaemonDelegateImpl : public DaemonDelegate {
   }
 
   std::unique_ptr<system::AmbientLightSensorManagerInterface>
-  CreateAmbientLightSensorManager(PrefsInterface* prefs) override {
+  CreateAmbientLightSensorManager(
+      PrefsInterface* prefs,
+      system::DBusWrapperInterface* dbus_wrapper) override {
     auto light_sensor_manager =
         std::make_unique<system::AmbientLightSensorManager>();
     light_sensor_manager->Init(prefs);
+#if USE_IIOSERVICE
+    // Read samples pushed by iioservice, which shares the sensors' buffers
+    // with its other clients, instead of polling sysfs.
+    sensor_service_handler_ = std::make_unique<system::SensorServiceHandler>();
+    sensor_service_handler_->Init(dbus_wrapper->GetBus());
+    light_sensor_manager->set_create_sample_reader_func(base::BindRepeating(
+        &system::SensorServiceHandler::CreateLightSampleReader,
+        base::Unretained(sensor_service_handler_.get())));
+#endif  // USE_IIOSERVICE
     light_sensor_manager->Run(false /* read_immediately */);
     return light_sensor_manager;
   }
@@ -298,6 +318,10 @@ class DaemonDelegateImpl : public DaemonDelegate {
   base::FilePath read_write_prefs_dir_;
   base::FilePath read_only_prefs_dir_;
 
+#if USE_IIOSERVICE
+  std::unique_ptr<system::SensorServiceHandler> sensor_service_handler_;
+#endif  // USE_IIOSERVICE
+
   DISALLOW_COPY_AND_ASSIGN(DaemonDelegateImpl);
 };
 
@@ -349,6 +373,12 @@ int main(int argc, char* argv[]) {
   base::SingleThreadTaskExecutor task_executor(base::MessagePumpType::IO);
   // This is used in AlarmTimer.
   base::FileDescriptorWatcher watcher{task_executor.task_runner()};
+#if USE_IIOSERVICE
+  mojo::core::Init();
+  mojo::core::ScopedIPCSupport ipc_support(
+      task_executor.task_runner(),
+      mojo::core::ScopedIPCSupport::ShutdownPolicy::FAST);
+#endif  // USE_IIOSERVICE
   power_manager::DaemonDelegateImpl delegate;
   // Extra parens to avoid http://en.wikipedia.org/wiki/Most_vexing_parse.
   power_manager::Daemon daemon(&delegate, (base::FilePath(FLAGS_run_dir)));
@@ -15,6 +15,7 @@
 
 #include "power_manager/common/util.h"
 #include "power_manager/powerd/policy/suspend_delay_observer.h"
+#include "power_manager/powerd/policy/suspend_tracer.h"
 #include "power_manager/proto_bindings/suspend.pb.h"
 
 namespace power_manager {
@@ -119,6 +120,7 @@ void SuspendDelayController::HandleSuspendReadiness(
                  << ", which we weren't waiting for";
     return;
   }
+  EndDelaySpan(delay_id, "ready");
   RemoveDelayFromWaitList(delay_id);
 }
 
@@ -145,10 +147,14 @@ void SuspendDelayController::PrepareForSuspend(int suspend_id,
   current_suspend_id_ = suspend_id;
 
   size_t old_count = delay_ids_being_waited_on_.size();
+  for (int delay_id : delay_ids_being_waited_on_)
+    EndDelaySpan(delay_id, "superseded");
   delay_ids_being_waited_on_.clear();
   for (DelayInfoMap::const_iterator it = registered_delays_.begin();
-       it != registered_delays_.end(); ++it)
+       it != registered_delays_.end(); ++it) {
     delay_ids_being_waited_on_.insert(it->first);
+    BeginDelaySpan(it->first);
+  }
 
   LOG(INFO) << "Announcing " << GetLogDescription() << " request "
             << current_suspend_id_ << " with "
@@ -184,6 +190,8 @@ void SuspendDelayController::FinishSuspend(int suspend_id) {
 
   max_delay_expiration_timer_.Stop();
   min_delay_expiration_timer_.Stop();
+  for (int delay_id : delay_ids_being_waited_on_)
+    EndDelaySpan(delay_id, "aborted");
   delay_ids_being_waited_on_.clear();
 }
 
@@ -197,12 +205,38 @@ std::string SuspendDelayController::GetDelayDescription(int delay_id) const {
   return it != registered_delays_.end() ? it->second.description : "unknown";
 }
 
+void SuspendDelayController::BeginDelaySpan(int delay_id) {
+  if (!tracer_)
+    return;
+
+  const DelayInfo& delay = registered_delays_[delay_id];
+  const std::string track = GetLogDescription() + " delay " +
+                            base::NumberToString(delay_id) + " (" +
+                            delay.dbus_client + ": " + delay.description + ")";
+  delay_span_ids_[delay_id] = tracer_->BeginSpan(
+      track, "WaitForReadiness",
+      {{"suspend_id", base::NumberToString(current_suspend_id_)},
+       {"timeout_ms", base::NumberToString(delay.timeout.InMilliseconds())}});
+}
+
+void SuspendDelayController::EndDelaySpan(int delay_id,
+                                          const std::string& result) {
+  auto it = delay_span_ids_.find(delay_id);
+  if (it == delay_span_ids_.end())
+    return;
+
+  if (tracer_)
+    tracer_->EndSpan(it->second, {{"result", result}});
+  delay_span_ids_.erase(it);
+}
+
 void SuspendDelayController::UnregisterDelayInternal(int delay_id) {
   if (!registered_delays_.count(delay_id)) {
     LOG(WARNING) << "Ignoring request to remove unknown " << GetLogDescription()
                  << " delay " << delay_id;
     return;
   }
+  EndDelaySpan(delay_id, "unregistered");
   RemoveDelayFromWaitList(delay_id);
   registered_delays_.erase(delay_id);
 }
@@ -235,6 +269,8 @@ void SuspendDelayController::OnMaxDelayExpiration() {
                << delay_ids_being_waited_on_.size()
                << " delay(s): " << tardy_delays;
 
+  for (int delay_id : delay_ids_being_waited_on_)
+    EndDelaySpan(delay_id, "timed_out");
   delay_ids_being_waited_on_.clear();
   PostNotifyObserversTask(current_suspend_id_);
 }
@@ -24,6 +24,7 @@ class UnregisterSuspendDelayRequest;
 namespace policy {
 
 class SuspendDelayObserver;
+class SuspendTracer;
 
 // Handles D-Bus requests to delay suspending until other processes have had
 // time to do last-minute cleanup.
@@ -45,6 +46,10 @@ class SuspendDelayController {
     dark_resume_min_delay_ = min_delay;
   }
 
+  // Records how long each delay takes to report readiness to |tracer|, which
+  // may be null.
+  void set_tracer(SuspendTracer* tracer) { tracer_ = tracer; }
+
   // Adds or removes an observer that will be notified when it's safe to
   // suspend.
   void AddObserver(SuspendDelayObserver* observer);
@@ -108,6 +113,14 @@ class SuspendDelayController {
   // Returns the human-readable description of |delay_id|.
   std::string GetDelayDescription(int delay_id) const;
 
+  // Starts a |tracer_| span covering the wait for |delay_id| to report
+  // readiness for the current suspend request.
+  void BeginDelaySpan(int delay_id);
+
+  // Ends the span started by BeginDelaySpan() for |delay_id|, if any, noting
+  // |result| (e.g. "ready" or "timed_out").
+  void EndDelaySpan(int delay_id, const std::string& result);
+
   // Removes |delay_id| from |registered_delays_| and calls
   // RemoveDelayFromWaitList().
   void UnregisterDelayInternal(int delay_id);
@@ -175,6 +188,12 @@ class SuspendDelayController {
 
   base::ObserverList<SuspendDelayObserver> observers_;
 
+  SuspendTracer* tracer_ = nullptr;  // weak
+
+  // Map from delay ID to the ID of the |tracer_| span covering the current
+  // wait for it.
+  std::map<int, int> delay_span_ids_;
+
   DISALLOW_COPY_AND_ASSIGN(SuspendDelayController);
 };
 
@@ -0,0 +1,184 @@
+// Copyright 2020 The Chromium OS Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "power_manager/powerd/policy/suspend_tracer.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <utility>
+
+#include <base/json/json_writer.h>
+#include <base/logging.h>
+#include <base/values.h>
+
+#include "power_manager/common/clock.h"
+
+namespace power_manager {
+namespace policy {
+
+namespace {
+
+// Category attached to all events.
+const char kCategory[] = "power";
+
+// Returns |time| as microseconds in the trace's timebase. Doubles are used
+// since base::Value's integers are only 32 bits wide.
+double ToTraceMicroseconds(base::TimeTicks time) {
+  return static_cast<double>((time - base::TimeTicks()).InMicroseconds());
+}
+
+// Returns a dictionary describing |args|.
+base::Value ArgsToValue(const SuspendTracer::Args& args) {
+  base::Value value(base::Value::Type::DICTIONARY);
+  for (const auto& arg : args)
+    value.SetStringKey(arg.first, arg.second);
+  return value;
+}
+
+}  // namespace
+
+SuspendTracer::ScopedSpan::ScopedSpan(SuspendTracer* tracer,
+                                      const std::string& track,
+                                      const std::string& name,
+                                      const Args& args)
+    : tracer_(tracer), id_(tracer->BeginSpan(track, name, args)) {}
+
+SuspendTracer::ScopedSpan::~ScopedSpan() {
+  tracer_->EndSpan(id_, end_args_);
+}
+
+void SuspendTracer::ScopedSpan::AddArg(const std::string& key,
+                                       const std::string& value) {
+  end_args_.emplace_back(key, value);
+}
+
+// static
+constexpr size_t SuspendTracer::kDefaultMaxEvents;
+
+SuspendTracer::SuspendTracer(Clock* clock, size_t max_events)
+    : clock_(clock), max_events_(max_events) {
+  DCHECK(clock_);
+  DCHECK_GT(max_events_, 0);
+}
+
+SuspendTracer::~SuspendTracer() = default;
+
+int SuspendTracer::BeginSpan(const std::string& track,
+                             const std::string& name,
+                             const Args& args) {
+  // Spans that are never ended shouldn't grow without bound either.
+  if (open_spans_.size() >= max_events_)
+    open_spans_.erase(open_spans_.begin());
+
+  Event event;
+  event.track = track;
+  event.name = name;
+  event.start = clock_->GetCurrentBootTime();
+  event.args = args;
+
+  const int id = next_span_id_++;
+  open_spans_.emplace(id, std::move(event));
+  return id;
+}
+
+void SuspendTracer::EndSpan(int id, const Args& args) {
+  auto it = open_spans_.find(id);
+  if (it == open_spans_.end())
+    return;
+
+  Event event = std::move(it->second);
+  open_spans_.erase(it);
+  event.duration = std::max(base::TimeDelta(),
+                            clock_->GetCurrentBootTime() - event.start);
+  event.args.insert(event.args.end(), args.begin(), args.end());
+  AddEvent(std::move(event));
+}
+
+void SuspendTracer::AddInstant(const std::string& track,
+                               const std::string& name,
+                               const Args& args) {
+  Event event;
+  event.track = track;
+  event.name = name;
+  event.start = clock_->GetCurrentBootTime();
+  event.instant = true;
+  event.args = args;
+  AddEvent(std::move(event));
+}
+
+std::string SuspendTracer::GetTraceJson() const {
+  const int pid = getpid();
+  base::Value trace_events(base::Value::Type::LIST);
+
+  base::Value process_name(base::Value::Type::DICTIONARY);
+  process_name.SetStringKey("ph", "M");
+  process_name.SetStringKey("name", "process_name");
+  process_name.SetIntKey("pid", pid);
+  process_name.SetIntKey("tid", 0);
+  process_name.SetKey("args", ArgsToValue({{"name", "powerd"}}));
+  trace_events.Append(std::move(process_name));
+
+  // Tracks are mapped to thread IDs in the order in which they're first seen,
+  // with a thread_name metadata event naming each one.
+  std::map<std::string, int> track_ids;
+  auto get_track_id = [&](const std::string& track) {
+    auto it = track_ids.find(track);
+    if (it != track_ids.end())
+      return it->second;
+
+    const int tid = static_cast<int>(track_ids.size()) + 1;
+    track_ids.emplace(track, tid);
+    base::Value thread_name(base::Value::Type::DICTIONARY);
+    thread_name.SetStringKey("ph", "M");
+    thread_name.SetStringKey("name", "thread_name");
+    thread_name.SetIntKey("pid", pid);
+    thread_name.SetIntKey("tid", tid);
+    thread_name.SetKey("args", ArgsToValue({{"name", track}}));
+    trace_events.Append(std::move(thread_name));
+    return tid;
+  };
+
+  auto append_event = [&](const Event& event, const char* phase) {
+    const int tid = get_track_id(event.track);
+    base::Value value(base::Value::Type::DICTIONARY);
+    value.SetStringKey("ph", phase);
+    value.SetStringKey("name", event.name);
+    value.SetStringKey("cat", kCategory);
+    value.SetIntKey("pid", pid);
+    value.SetIntKey("tid", tid);
+    value.SetDoubleKey("ts", ToTraceMicroseconds(event.start));
+    if (event.instant)
+      value.SetStringKey("s", "t");
+    else if (std::string(phase) == "X")
+      value.SetDoubleKey("dur", event.duration.InMicrosecondsF());
+    value.SetKey("args", ArgsToValue(event.args));
+    trace_events.Append(std::move(value));
+  };
+
+  for (const Event& event : events_)
+    append_event(event, event.instant ? "i" : "X");
+  // Unfinished spans are written as begin events without matching ends, which
+  // trace viewers draw as extending to the end of the trace.
+  for (const auto& it : open_spans_)
+    append_event(it.second, "B");
+
+  base::Value trace(base::Value::Type::DICTIONARY);
+  trace.SetKey("traceEvents", std::move(trace_events));
+  trace.SetStringKey("displayTimeUnit", "ms");
+
+  std::string json;
+  if (!base::JSONWriter::Write(trace, &json))
+    LOG(ERROR) << "Failed to serialize suspend trace";
+  return json;
+}
+
+void SuspendTracer::AddEvent(Event event) {
+  if (events_.size() >= max_events_)
+    events_.pop_front();
+  events_.push_back(std::move(event));
+}
+
+}  // namespace policy
+}  // namespace power_manager
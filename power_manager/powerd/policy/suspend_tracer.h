@@ -0,0 +1,119 @@
+// Copyright 2020 The Chromium OS Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef POWER_MANAGER_POWERD_POLICY_SUSPEND_TRACER_H_
+#define POWER_MANAGER_POWERD_POLICY_SUSPEND_TRACER_H_
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <base/containers/circular_deque.h>
+#include <base/macros.h>
+#include <base/time/time.h>
+
+namespace power_manager {
+
+class Clock;
+
+namespace policy {
+
+// SuspendTracer records timestamped phases of suspend requests (waiting for
+// each registered suspend delay, running powerd_suspend, identifying the wakeup
+// source, etc.) so that slow suspends and resumes can be attributed to a
+// specific client or step after the fact.
+//
+// Events are kept in a ring of bounded size and are serialized in the Chrome
+// JSON trace event format, which Perfetto's UI and trace_processor load
+// directly. Each "track" is shown as a separate row; spans on the same track
+// are expected to nest.
+class SuspendTracer {
+ public:
+  // Key-value pairs attached to an event.
+  using Args = std::vector<std::pair<std::string, std::string>>;
+
+  // Ends a span when it goes out of scope.
+  class ScopedSpan {
+   public:
+    ScopedSpan(SuspendTracer* tracer,
+               const std::string& track,
+               const std::string& name,
+               const Args& args);
+    ~ScopedSpan();
+
+    // Adds an argument that will be recorded when the span ends.
+    void AddArg(const std::string& key, const std::string& value);
+
+   private:
+    SuspendTracer* tracer_;  // weak
+    int id_;
+    Args end_args_;
+
+    DISALLOW_COPY_AND_ASSIGN(ScopedSpan);
+  };
+
+  // Default maximum number of events held in the ring.
+  static constexpr size_t kDefaultMaxEvents = 1000;
+
+  // Events are timestamped using |clock|'s boot time, which keeps advancing
+  // while the system is suspended.
+  SuspendTracer(Clock* clock, size_t max_events);
+  ~SuspendTracer();
+
+  size_t num_events() const { return events_.size(); }
+
+  // Starts a span named |name| on |track| and returns an ID that must be
+  // passed to EndSpan().
+  int BeginSpan(const std::string& track,
+                const std::string& name,
+                const Args& args);
+
+  // Ends the span identified by |id|, adding |args| to the ones passed to
+  // BeginSpan(). Unknown IDs (e.g. spans that were already ended) are ignored.
+  void EndSpan(int id, const Args& args);
+
+  // Records an instantaneous event.
+  void AddInstant(const std::string& track,
+                  const std::string& name,
+                  const Args& args);
+
+  // Returns the recorded events, followed by any spans that haven't ended yet,
+  // as a JSON trace.
+  std::string GetTraceJson() const;
+
+ private:
+  struct Event {
+    std::string track;
+    std::string name;
+    base::TimeTicks start;
+    base::TimeDelta duration;
+    // True for events added via AddInstant().
+    bool instant = false;
+    Args args;
+  };
+
+  // Appends |event| to |events_|, dropping the oldest event if full.
+  void AddEvent(Event event);
+
+  Clock* clock_;  // weak
+
+  // Maximum size of |events_|.
+  const size_t max_events_;
+
+  // Completed spans and instants, oldest first.
+  base::circular_deque<Event> events_;
+
+  // Spans that have been started but not yet ended, keyed by ID.
+  std::map<int, Event> open_spans_;
+
+  int next_span_id_ = 1;
+
+  DISALLOW_COPY_AND_ASSIGN(SuspendTracer);
+};
+
+}  // namespace policy
+}  // namespace power_manager
+
+#endif  // POWER_MANAGER_POWERD_POLICY_SUSPEND_TRACER_H_
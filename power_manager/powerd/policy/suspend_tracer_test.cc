@@ -0,0 +1,114 @@
+// Copyright 2020 The Chromium OS Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "power_manager/powerd/policy/suspend_tracer.h"
+
+#include <string>
+#include <vector>
+
+#include <base/json/json_reader.h>
+#include <base/macros.h>
+#include <base/values.h>
+#include <gtest/gtest.h>
+
+#include "power_manager/common/clock.h"
+
+namespace power_manager {
+namespace policy {
+
+class SuspendTracerTest : public testing::Test {
+ public:
+  SuspendTracerTest() : tracer_(&clock_, kMaxEvents) {
+    clock_.set_current_boot_time_for_testing(base::TimeTicks() +
+                                             base::TimeDelta::FromHours(1));
+  }
+  ~SuspendTracerTest() override {}
+
+ protected:
+  static constexpr size_t kMaxEvents = 3;
+
+  // Parses |tracer_|'s trace and returns its non-metadata events.
+  std::vector<base::Value> GetEvents() {
+    base::Optional<base::Value> trace =
+        base::JSONReader::Read(tracer_.GetTraceJson());
+    EXPECT_TRUE(trace);
+    std::vector<base::Value> events;
+    if (!trace)
+      return events;
+    const base::Value* list = trace->FindListKey("traceEvents");
+    EXPECT_TRUE(list);
+    if (!list)
+      return events;
+    for (const base::Value& event : list->GetList()) {
+      if (*event.FindStringKey("ph") != "M")
+        events.push_back(event.Clone());
+    }
+    return events;
+  }
+
+  Clock clock_;
+  SuspendTracer tracer_;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(SuspendTracerTest);
+};
+
+constexpr size_t SuspendTracerTest::kMaxEvents;
+
+TEST_F(SuspendTracerTest, Spans) {
+  const int id = tracer_.BeginSpan("track", "Span", {{"a", "1"}});
+  clock_.advance_current_boot_time_for_testing(
+      base::TimeDelta::FromMilliseconds(250));
+  {
+    SuspendTracer::ScopedSpan scoped(&tracer_, "other", "Scoped", {});
+    scoped.AddArg("b", "2");
+    clock_.advance_current_boot_time_for_testing(
+        base::TimeDelta::FromMilliseconds(50));
+  }
+  tracer_.AddInstant("other", "Instant", {});
+
+  // The unfinished span should be reported as a begin event after the
+  // completed ones.
+  std::vector<base::Value> events = GetEvents();
+  ASSERT_EQ(3u, events.size());
+  EXPECT_EQ("Scoped", *events[0].FindStringKey("name"));
+  EXPECT_EQ("X", *events[0].FindStringKey("ph"));
+  EXPECT_DOUBLE_EQ(50000.0, *events[0].FindDoubleKey("dur"));
+  EXPECT_EQ("2", *events[0].FindKey("args")->FindStringKey("b"));
+  EXPECT_EQ("Instant", *events[1].FindStringKey("name"));
+  EXPECT_EQ("i", *events[1].FindStringKey("ph"));
+  EXPECT_EQ("Span", *events[2].FindStringKey("name"));
+  EXPECT_EQ("B", *events[2].FindStringKey("ph"));
+
+  // Events on different tracks should be on different threads.
+  EXPECT_NE(*events[0].FindIntKey("tid"), *events[2].FindIntKey("tid"));
+  EXPECT_EQ(*events[0].FindIntKey("tid"), *events[1].FindIntKey("tid"));
+
+  tracer_.EndSpan(id, {{"c", "3"}});
+  events = GetEvents();
+  ASSERT_EQ(3u, events.size());
+  EXPECT_EQ("Span", *events[2].FindStringKey("name"));
+  EXPECT_EQ("X", *events[2].FindStringKey("ph"));
+  EXPECT_DOUBLE_EQ(300000.0, *events[2].FindDoubleKey("dur"));
+  EXPECT_EQ("1", *events[2].FindKey("args")->FindStringKey("a"));
+  EXPECT_EQ("3", *events[2].FindKey("args")->FindStringKey("c"));
+
+  // Ending the span again should be a no-op.
+  tracer_.EndSpan(id, {});
+  EXPECT_EQ(3u, tracer_.num_events());
+}
+
+TEST_F(SuspendTracerTest, DropOldestEvents) {
+  for (int i = 0; i < 5; ++i)
+    tracer_.AddInstant("track", "Instant" + std::to_string(i), {});
+  EXPECT_EQ(kMaxEvents, tracer_.num_events());
+
+  std::vector<base::Value> events = GetEvents();
+  ASSERT_EQ(kMaxEvents, events.size());
+  EXPECT_EQ("Instant2", *events[0].FindStringKey("name"));
+  EXPECT_EQ("Instant4", *events[2].FindStringKey("name"));
+}
+
+}  // namespace policy
+}  // namespace power_manager
@@ -9,6 +9,7 @@
 
 #include <base/files/file_util.h>
 #include <base/logging.h>
+#include <base/strings/string_number_conversions.h>
 #include <chromeos/dbus/service_constants.h>
 
 #include "power_manager/common/clock.h"
@@ -17,6 +18,7 @@
 #include "power_manager/common/util.h"
 #include "power_manager/powerd/policy/shutdown_from_suspend_interface.h"
 #include "power_manager/powerd/policy/suspend_delay_controller.h"
+#include "power_manager/powerd/policy/suspend_tracer.h"
 #include "power_manager/powerd/system/dark_resume_interface.h"
 #include "power_manager/powerd/system/dbus_wrapper.h"
 #include "power_manager/powerd/system/display/display_watcher.h"
@@ -28,11 +30,35 @@ namespace {
 // Default wake reason powerd uses to report wake-reason-specific wake duration
 // metrics.
 const char kDefaultWakeReason[] = "Other";
+
+// Track used for Suspender's own events in |tracer_|.
+const char kSuspenderTrack[] = "Suspender";
 }  // namespace
 
 namespace power_manager {
 namespace policy {
 
+namespace {
+
+// Returns a string describing |result| for traces.
+std::string SuspendResultToString(Suspender::Delegate::SuspendResult result) {
+  switch (result) {
+    case Suspender::Delegate::SuspendResult::SUCCESS:
+      return "success";
+    case Suspender::Delegate::SuspendResult::FAILURE:
+      return "failure";
+    case Suspender::Delegate::SuspendResult::CANCELED:
+      return "canceled";
+  }
+  return "unknown";
+}
+
+const char* BoolToString(bool value) {
+  return value ? "true" : "false";
+}
+
+}  // namespace
+
 Suspender::TestApi::TestApi(Suspender* suspender) : suspender_(suspender) {}
 
 bool Suspender::TestApi::TriggerResuspendTimeout() {
@@ -50,6 +76,8 @@ std::string Suspender::TestApi::GetDefaultWakeReason() const {
 
 Suspender::Suspender()
     : clock_(std::make_unique<Clock>()),
+      tracer_(std::make_unique<SuspendTracer>(
+          clock_.get(), SuspendTracer::kDefaultMaxEvents)),
       last_dark_resume_wake_reason_(kDefaultWakeReason),
       weak_ptr_factory_(this) {}
 
@@ -74,6 +102,7 @@ void Suspender::Init(
   suspend_delay_controller_.reset(new SuspendDelayController(
       initial_id, "", SuspendDelayController::kDefaultMaxSuspendDelayTimeout));
   suspend_delay_controller_->AddObserver(this);
+  suspend_delay_controller_->set_tracer(tracer_.get());
 
   // Default dark suspend delay same as regular suspend timeout if the pref
   // isn't provided.
@@ -92,6 +121,7 @@ void Suspender::Init(
   dark_suspend_delay_controller_.reset(new SuspendDelayController(
       initial_dark_id, "dark", max_dark_suspend_delay_timeout));
   dark_suspend_delay_controller_->AddObserver(this);
+  dark_suspend_delay_controller_->set_tracer(tracer_.get());
 
   display_watcher->AddObserver(this);
   int64_t retry_delay_ms = 0;
@@ -251,6 +281,10 @@ void Suspender::ExportDBusMethods() {
   dbus_wrapper_->ExportMethod(kRecordDarkResumeWakeReasonMethod,
                               base::Bind(&Suspender::RecordDarkResumeWakeReason,
                                          weak_ptr_factory_.GetWeakPtr()));
+
+  dbus_wrapper_->ExportMethod(kGetSuspendTraceMethod,
+                              base::Bind(&Suspender::GetSuspendTrace,
+                                         weak_ptr_factory_.GetWeakPtr()));
 }
 
 void Suspender::RegisterSuspendDelay(
@@ -362,6 +396,16 @@ void Suspender::RecordDarkResumeWakeReason(
   std::move(response_sender).Run(dbus::Response::FromMethodCall(method_call));
 }
 
+void Suspender::GetSuspendTrace(
+    dbus::MethodCall* method_call,
+    dbus::ExportedObject::ResponseSender response_sender) {
+  std::unique_ptr<dbus::Response> response =
+      dbus::Response::FromMethodCall(method_call);
+  dbus::MessageWriter writer(response.get());
+  writer.AppendString(tracer_->GetTraceJson());
+  std::move(response_sender).Run(std::move(response));
+}
+
 void Suspender::HandleEvent(Event event) {
   // If a new event is received while handling an event, save it for later. This
   // can happen when e.g. |delegate_|'s UndoPrepareToSuspend() method attempts
@@ -480,6 +524,8 @@ Suspender::State Suspender::HandleWakeEventInSuspend(Event event) {
     return state_;
 
   LOG(INFO) << "Aborting request in response to event " << EventToString(event);
+  tracer_->AddInstant(kSuspenderTrack, "Abort",
+                      {{"event", EventToString(event)}});
   FinishRequest(false, SuspendDone_WakeupType_NOT_APPLICABLE);
   return State::IDLE;
 }
@@ -489,6 +535,11 @@ void Suspender::StartRequest() {
 
   suspend_request_id_++;
   LOG(INFO) << "Starting request " << suspend_request_id_;
+  request_span_id_ = tracer_->BeginSpan(
+      kSuspenderTrack, "SuspendRequest",
+      {{"suspend_id", base::NumberToString(suspend_request_id_)},
+       {"reason",
+        base::NumberToString(static_cast<int>(suspend_request_reason_))}});
 
   if (suspend_request_supplied_wakeup_count_) {
     wakeup_count_ = suspend_request_wakeup_count_;
@@ -507,7 +558,14 @@ void Suspender::StartRequest() {
   // Call PrepareToSuspend() before emitting SuspendImminent -- powerd needs to
   // set the backlight level to 0 before Chrome turns the display on in response
   // to the signal.
-  delegate_->PrepareToSuspend();
+  {
+    SuspendTracer::ScopedSpan span(tracer_.get(), kSuspenderTrack,
+                                   "PrepareToSuspend", {});
+    delegate_->PrepareToSuspend();
+  }
+  suspend_delays_span_id_ = tracer_->BeginSpan(
+      kSuspenderTrack, "WaitForSuspendDelays",
+      {{"suspend_id", base::NumberToString(suspend_request_id_)}});
   suspend_delay_controller_->PrepareForSuspend(suspend_request_id_, false);
   wakeup_source_identifier_->PrepareForSuspendRequest();
   delegate_->SetSuspendAnnounced(true);
@@ -533,15 +591,25 @@ void Suspender::FinishRequest(bool success,
             << util::TimeDeltaToString(suspend_duration);
 
   resuspend_timer_.Stop();
+  tracer_->EndSpan(suspend_delays_span_id_, {{"result", "aborted"}});
   suspend_delay_controller_->FinishSuspend(suspend_request_id_);
   dark_suspend_delay_controller_->FinishSuspend(dark_suspend_id_);
   shutdown_from_suspend_->HandleFullResume();
   EmitSuspendDoneSignal(suspend_request_id_, suspend_duration, wakeup_type);
   delegate_->SetSuspendAnnounced(false);
   dark_resume_->ExitDarkResume();
-  delegate_->UndoPrepareToSuspend(success, initial_num_attempts_
-                                               ? initial_num_attempts_
-                                               : current_num_attempts_);
+  const int num_attempts =
+      initial_num_attempts_ ? initial_num_attempts_ : current_num_attempts_;
+  {
+    SuspendTracer::ScopedSpan span(tracer_.get(), kSuspenderTrack,
+                                   "UndoPrepareToSuspend", {});
+    delegate_->UndoPrepareToSuspend(success, num_attempts);
+  }
+  tracer_->EndSpan(request_span_id_,
+                   {{"success", BoolToString(success)},
+                    {"num_attempts", base::NumberToString(num_attempts)},
+                    {"wakeup_type",
+                     base::NumberToString(static_cast<int>(wakeup_type))}});
 
   // Only report dark resume metrics if it is actually enabled to prevent a
   // bunch of noise in the data.
@@ -552,12 +620,24 @@ void Suspender::FinishRequest(bool success,
 }
 
 Suspender::State Suspender::Suspend() {
-  policy::ShutdownFromSuspendInterface::Action action =
-      shutdown_from_suspend_->PrepareForSuspendAttempt();
+  tracer_->EndSpan(suspend_delays_span_id_, {{"result", "ready"}});
+
+  policy::ShutdownFromSuspendInterface::Action action;
+  {
+    SuspendTracer::ScopedSpan span(tracer_.get(), kSuspenderTrack,
+                                   "ShutdownFromSuspendCheck", {});
+    action = shutdown_from_suspend_->PrepareForSuspendAttempt();
+    span.AddArg(
+        "shut_down",
+        BoolToString(
+            action ==
+            policy::ShutdownFromSuspendInterface::Action::SHUT_DOWN));
+  }
 
   switch (action) {
     case policy::ShutdownFromSuspendInterface::Action::SHUT_DOWN:
       LOG(INFO) << "Shutting down from suspend";
+      tracer_->EndSpan(request_span_id_, {{"result", "shut_down"}});
       // Don't call FinishRequest(); we want the backlight to stay off.
       delegate_->ShutDownFromSuspend();
       return State::SHUTTING_DOWN;
@@ -581,10 +661,28 @@ Suspender::State Suspender::Suspend() {
   }
 
   current_num_attempts_++;
-  Delegate::SuspendResult result = delegate_->DoSuspend(
-      wakeup_count_, wakeup_count_valid_, suspend_duration_);
+  Delegate::SuspendResult result;
+  {
+    // powerd_suspend writes to /sys/power/state and returns after resume, so
+    // this span also covers the time spent suspended.
+    SuspendTracer::ScopedSpan span(
+        tracer_.get(), kSuspenderTrack, "DoSuspend",
+        {{"attempt", base::NumberToString(current_num_attempts_)},
+         {"from_dark_resume", BoolToString(dark_resume_->InDarkResume())},
+         {"wakeup_count_valid", BoolToString(wakeup_count_valid_)}});
+    result = delegate_->DoSuspend(wakeup_count_, wakeup_count_valid_,
+                                  suspend_duration_);
+    span.AddArg("result", SuspendResultToString(result));
+  }
 
-  wakeup_source_identifier_->HandleResume();
+  {
+    SuspendTracer::ScopedSpan span(tracer_.get(), kSuspenderTrack,
+                                   "IdentifyWakeupSource", {});
+    wakeup_source_identifier_->HandleResume();
+    span.AddArg(
+        "input_device_caused_wake",
+        BoolToString(wakeup_source_identifier_->InputDeviceCausedLastWake()));
+  }
 
   //  If we saw a wakeup event and it if it is from any input devices, treat
   //  previous resume as successful as a wake event from input device implies a
@@ -641,6 +739,10 @@ Suspender::State Suspender::HandleDarkResume(Delegate::SuspendResult result) {
     initial_num_attempts_ = current_num_attempts_;
 
   dark_suspend_id_++;
+  tracer_->AddInstant(
+      kSuspenderTrack, "DarkResume",
+      {{"dark_suspend_id", base::NumberToString(dark_suspend_id_)},
+       {"result", SuspendResultToString(result)}});
 
   shutdown_from_suspend_->HandleDarkResume();
 
@@ -659,6 +761,9 @@ Suspender::State Suspender::HandleDarkResume(Delegate::SuspendResult result) {
 
   LOG(INFO) << "Notifying registered dark suspend delays about "
             << dark_suspend_id_;
+  suspend_delays_span_id_ = tracer_->BeginSpan(
+      kSuspenderTrack, "WaitForDarkSuspendDelays",
+      {{"dark_suspend_id", base::NumberToString(dark_suspend_id_)}});
   dark_suspend_delay_controller_->PrepareForSuspend(dark_suspend_id_, true);
   EmitDarkSuspendImminentSignal();
 
@@ -672,6 +777,7 @@ Suspender::State Suspender::HandleUnsuccessfulSuspend(
   if (current_num_attempts_ > max_retries_) {
     LOG(ERROR) << "Unsuccessfully attempted to suspend "
                << current_num_attempts_ << " times; shutting down";
+    tracer_->EndSpan(request_span_id_, {{"result", "shut_down"}});
     // Don't call FinishRequest(); we want the backlight to stay off.
     delegate_->ShutDownForFailedSuspend();
     return State::SHUTTING_DOWN;
@@ -43,6 +43,7 @@ namespace policy {
 
 class ShutdownFromSuspendInterface;
 class SuspendDelayController;
+class SuspendTracer;
 
 // Suspender is responsible for suspending the system.
 //
@@ -183,6 +184,7 @@ class Suspender : public SuspendDelayObserver,
     SuspendDelayController* dark_suspend_delay_controller() const {
       return suspender_->dark_suspend_delay_controller_.get();
     }
+    SuspendTracer* tracer() const { return suspender_->tracer_.get(); }
 
     // Runs Suspender::HandleEvent(EVENT_READY_TO_RESUSPEND) if
     // |resuspend_timer_| is running. Returns false otherwise.
@@ -312,6 +314,8 @@ class Suspender : public SuspendDelayObserver,
   void RecordDarkResumeWakeReason(
       dbus::MethodCall* method_call,
       dbus::ExportedObject::ResponseSender response_sender);
+  void GetSuspendTrace(dbus::MethodCall* method_call,
+                       dbus::ExportedObject::ResponseSender response_sender);
 
   // Performs actions and updates |state_| in response to |event|.
   void HandleEvent(Event event);
@@ -369,6 +373,16 @@ class Suspender : public SuspendDelayObserver,
       nullptr;  // weak
 
   std::unique_ptr<Clock> clock_;
+
+  // Records the phases of suspend requests. Exported via the GetSuspendTrace
+  // D-Bus method.
+  std::unique_ptr<SuspendTracer> tracer_;
+
+  // IDs of |tracer_| spans covering the current suspend request and the
+  // current wait for (normal or dark) suspend delays.
+  int request_span_id_ = 0;
+  int suspend_delays_span_id_ = 0;
+
   std::unique_ptr<SuspendDelayController> suspend_delay_controller_;
   std::unique_ptr<SuspendDelayController> dark_suspend_delay_controller_;
 
@@ -10,6 +10,7 @@
 #include <base/logging.h>
 #include <base/strings/stringprintf.h>
 #include <chromeos/dbus/service_constants.h>
+#include <dbus/message.h>
 #include <gtest/gtest.h>
 
 #include "power_manager/common/action_recorder.h"
@@ -17,6 +18,7 @@
 #include "power_manager/common/fake_prefs.h"
 #include "power_manager/common/power_constants.h"
 #include "power_manager/powerd/policy/shutdown_from_suspend_stub.h"
+#include "power_manager/powerd/policy/suspend_delay_controller.h"
 #include "power_manager/powerd/system/dark_resume_stub.h"
 #include "power_manager/powerd/system/dbus_wrapper_stub.h"
 #include "power_manager/powerd/system/display/display_watcher_stub.h"
@@ -1238,5 +1240,47 @@ TEST_F(SuspenderTest, SuspendWakeupTimoutRetryOnFailure) {
   EXPECT_EQ(base::TimeDelta(), delegate_.suspend_duration());
 }
 
+// Tests that the phases of a suspend request, including the wait for each
+// registered suspend delay, are traced and exported over D-Bus.
+TEST_F(SuspenderTest, SuspendTrace) {
+  Init();
+  SuspendDelayController* controller = test_api_.suspend_delay_controller();
+  RegisterSuspendDelayRequest request;
+  request.set_timeout(base::TimeDelta::FromSeconds(5).ToInternalValue());
+  request.set_description("slow-client");
+  RegisterSuspendDelayReply reply;
+  controller->RegisterSuspendDelay(request, ":1.23", &reply);
+
+  suspender_.RequestSuspend(SuspendImminent_Reason_IDLE, base::TimeDelta());
+  const int suspend_id = test_api_.suspend_id();
+  test_api_.clock()->advance_current_boot_time_for_testing(
+      base::TimeDelta::FromMilliseconds(300));
+  SuspendReadinessInfo info;
+  info.set_delay_id(reply.delay_id());
+  info.set_suspend_id(suspend_id);
+  controller->HandleSuspendReadiness(info, ":1.23");
+  AnnounceReadyForSuspend(suspend_id);
+  EXPECT_EQ(JoinActions(kPrepare, kSuspend, kUnprepare, nullptr),
+            delegate_.GetActions());
+
+  dbus::MethodCall method_call(kPowerManagerInterface, kGetSuspendTraceMethod);
+  std::unique_ptr<dbus::Response> response =
+      dbus_wrapper_.CallExportedMethodSync(&method_call);
+  ASSERT_TRUE(response);
+  std::string json;
+  ASSERT_TRUE(dbus::MessageReader(response.get()).PopString(&json));
+
+  for (const char* name :
+       {"SuspendRequest", "PrepareToSuspend", "WaitForSuspendDelays",
+        "WaitForReadiness", "ShutdownFromSuspendCheck", "DoSuspend",
+        "IdentifyWakeupSource", "UndoPrepareToSuspend"}) {
+    EXPECT_NE(std::string::npos,
+              json.find(base::StringPrintf("\"name\":\"%s\"", name)))
+        << name << " missing from " << json;
+  }
+  EXPECT_NE(std::string::npos, json.find("slow-client")) << json;
+  EXPECT_NE(std::string::npos, json.find("\"result\":\"ready\"")) << json;
+}
+
 }  // namespace policy
 }  // namespace power_manager
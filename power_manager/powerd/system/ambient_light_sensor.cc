@@ -4,11 +4,9 @@
 
 #include "power_manager/powerd/system/ambient_light_sensor.h"
 
-#include <fcntl.h>
-
 #include <algorithm>
-#include <cerrno>
 #include <cmath>
+#include <cstdlib>
 #include <cstring>
 #include <map>
 #include <utility>
@@ -23,6 +21,8 @@
 #include <base/strings/string_util.h>
 #include <base/strings/stringprintf.h>
 
+#include "power_manager/common/metrics_constants.h"
+#include "power_manager/common/metrics_sender.h"
 #include "power_manager/common/util.h"
 
 namespace power_manager {
@@ -36,6 +36,9 @@ const char kDefaultDeviceListPath[] = "/sys/bus/iio/devices";
 // Default interval for polling the ambient light sensor.
 const int kDefaultPollIntervalMs = 1000;
 
+// Prefix of the names of IIO device directories, followed by the device ID.
+const char kIioDevicePrefix[] = "iio:device";
+
 enum class ChannelType {
   X,
   Y,
@@ -50,6 +53,18 @@ SensorLocation StringToSensorLocation(const std::string& location) {
   return SensorLocation::UNKNOWN;
 }
 
+// Returns the suffix of the wakeup metric of a sensor at |location|.
+const char* GetWakeupMetricSuffix(SensorLocation location) {
+  switch (location) {
+    case SensorLocation::UNKNOWN:
+      return metrics::kAmbientLightSensorUnknownLocationSuffix;
+    case SensorLocation::BASE:
+      return metrics::kAmbientLightSensorBaseSuffix;
+    case SensorLocation::LID:
+      return metrics::kAmbientLightSensorLidSuffix;
+  }
+}
+
 std::string SensorLocationToString(SensorLocation location) {
   switch (location) {
     case SensorLocation::UNKNOWN:
@@ -89,6 +104,9 @@ const struct ColorChannelInfo {
 
 const int AmbientLightSensor::kNumInitAttemptsBeforeLogging = 5;
 const int AmbientLightSensor::kNumInitAttemptsBeforeGivingUp = 20;
+const int AmbientLightSensor::kNumSampleReaderFailuresBeforeGivingUp = 3;
+const double AmbientLightSensor::kPushedLuxChangeFraction = 0.05;
+const int AmbientLightSensor::kNumStableReadingsToSettle = 5;
 
 AmbientLightSensor::AmbientLightSensor()
     : AmbientLightSensor(SensorLocation::UNKNOWN, false) {}
@@ -109,9 +127,14 @@ AmbientLightSensor::AmbientLightSensor(SensorLocation expected_sensor_location,
       num_init_attempts_(0),
       expected_sensor_location_(expected_sensor_location) {}
 
-AmbientLightSensor::~AmbientLightSensor() {}
+AmbientLightSensor::~AmbientLightSensor() = default;
 
 void AmbientLightSensor::Init(bool read_immediately) {
+  wakeup_metric_timer_.Start(
+      FROM_HERE,
+      base::TimeDelta::FromSeconds(
+          metrics::kAmbientLightSensorWakeupsIntervalSec),
+      this, &AmbientLightSensor::ReportWakeupMetric);
   if (read_immediately)
     ReadAls();
   StartTimer();
@@ -163,12 +186,17 @@ int AmbientLightSensor::GetColorTemperature() {
 }
 
 void AmbientLightSensor::StartTimer() {
+  if (sample_reader_ || InitSampleReader())
+    return;
+
   poll_timer_.Start(FROM_HERE,
                     base::TimeDelta::FromMilliseconds(poll_interval_ms_), this,
                     &AmbientLightSensor::ReadAls);
 }
 
 void AmbientLightSensor::ReadAls() {
+  RecordWakeup();
+
   // We really want to read the ambient light level.
   // Complete the deferred lux file open if necessary.
   if (!als_file_.HasOpenedFile() && !InitAlsFile()) {
@@ -202,8 +230,7 @@ void AmbientLightSensor::ReadCallback(const std::string& data) {
   int value = 0;
   if (ParseLuxData(data, &value)) {
     lux_value_ = value;
-    for (AmbientLightObserver& observer : observers_)
-      observer.OnAmbientLightUpdated(this);
+    NotifyObservers();
   }
   StartTimer();
 }
@@ -270,8 +297,7 @@ void AmbientLightSensor::CollectChannelReadings() {
     }
   }
 
-  for (AmbientLightObserver& observer : observers_)
-    observer.OnAmbientLightUpdated(this);
+  NotifyObservers();
   StartTimer();
 }
 
@@ -327,6 +353,7 @@ bool AmbientLightSensor::InitAlsFile() {
         continue;
       if (!als_file_.Init(als_path))
         continue;
+      als_device_dir_ = check_path;
       if (enable_color_support_)
         InitColorAlsFiles(check_path);
       LOG(INFO) << "Using lux file " << GetIlluminancePath().value() << " for "
@@ -342,5 +369,115 @@ bool AmbientLightSensor::InitAlsFile() {
   return false;
 }
 
+bool AmbientLightSensor::InitSampleReader() {
+  if (create_sample_reader_func_.is_null() || !als_file_.HasOpenedFile() ||
+      IsColorSensor() ||
+      num_sample_reader_failures_ >= kNumSampleReaderFailuresBeforeGivingUp) {
+    return false;
+  }
+
+  // Pushed samples hold raw values, so only use them for sensors whose polled
+  // value is raw too.
+  const std::string file_name = als_file_.path().BaseName().value();
+  if (!base::StartsWith(file_name, "in_illuminance",
+                        base::CompareCase::SENSITIVE) ||
+      !base::EndsWith(file_name, "_raw", base::CompareCase::SENSITIVE)) {
+    return false;
+  }
+
+  const std::string device_name = als_device_dir_.BaseName().value();
+  int iio_device_id = -1;
+  if (!base::StartsWith(device_name, kIioDevicePrefix,
+                        base::CompareCase::SENSITIVE) ||
+      !base::StringToInt(device_name.substr(strlen(kIioDevicePrefix)),
+                         &iio_device_id)) {
+    return false;
+  }
+
+  sample_reader_ = create_sample_reader_func_.Run(
+      iio_device_id, base::TimeDelta::FromMilliseconds(poll_interval_ms_),
+      base::BindRepeating(&AmbientLightSensor::OnSample,
+                          base::Unretained(this)),
+      base::BindOnce(&AmbientLightSensor::OnSampleReaderError,
+                     base::Unretained(this)));
+  if (!sample_reader_)
+    return false;
+
+  poll_timer_.Stop();
+  LOG(INFO) << "Reading pushed samples of " << als_device_dir_.value();
+  return true;
+}
+
+void AmbientLightSensor::OnSample(int lux) {
+  RecordWakeup();
+  if (lux < 0) {
+    LOG(ERROR) << "Discarding negative lux value " << lux;
+    return;
+  }
+  lux_value_ = lux;
+  VLOG(1) << "Read pushed lux value " << lux_value_;
+
+  // While settling, the timer reports the latest value.
+  if (settle_timer_.IsRunning() || !IsSignificantLuxChange(lux_value_))
+    return;
+
+  NotifyObservers();
+  num_stable_readings_ = 0;
+  settle_timer_.Start(FROM_HERE,
+                      base::TimeDelta::FromMilliseconds(poll_interval_ms_),
+                      this, &AmbientLightSensor::OnSettleTimeout);
+}
+
+void AmbientLightSensor::OnSampleReaderError() {
+  num_sample_reader_failures_++;
+  LOG(WARNING) << "Lost pushed samples of " << als_device_dir_.value()
+               << "; polling instead";
+  sample_reader_.reset();
+  settle_timer_.Stop();
+  poll_timer_.Start(FROM_HERE,
+                    base::TimeDelta::FromMilliseconds(poll_interval_ms_), this,
+                    &AmbientLightSensor::ReadAls);
+}
+
+void AmbientLightSensor::OnSettleTimeout() {
+  RecordWakeup();
+  if (IsSignificantLuxChange(lux_value_))
+    num_stable_readings_ = 0;
+  else
+    num_stable_readings_++;
+  NotifyObservers();
+  if (num_stable_readings_ >= kNumStableReadingsToSettle)
+    settle_timer_.Stop();
+}
+
+bool AmbientLightSensor::IsSignificantLuxChange(int lux) const {
+  if (last_notified_lux_ < 0)
+    return true;
+  const double threshold =
+      std::max(1.0, last_notified_lux_ * kPushedLuxChangeFraction);
+  return std::abs(lux - last_notified_lux_) > threshold;
+}
+
+void AmbientLightSensor::NotifyObservers() {
+  last_notified_lux_ = lux_value_;
+  for (AmbientLightObserver& observer : observers_)
+    observer.OnAmbientLightUpdated(this);
+}
+
+void AmbientLightSensor::RecordWakeup() {
+  num_wakeups_++;
+}
+
+void AmbientLightSensor::ReportWakeupMetric() {
+  const int minutes = metrics::kAmbientLightSensorWakeupsIntervalSec / 60;
+  SendMetric(std::string(metrics::kAmbientLightSensorWakeupsPerMinuteName) +
+                 GetWakeupMetricSuffix(expected_sensor_location_),
+             num_wakeups_ / minutes,
+             metrics::kAmbientLightSensorWakeupsPerMinuteMin,
+             metrics::kAmbientLightSensorWakeupsPerMinuteMax,
+             metrics::kDefaultBuckets);
+  num_wakeups_ = 0;
+}
+
 }  // namespace system
 }  // namespace power_manager
@@ -7,12 +7,15 @@
 
 #include <list>
 #include <map>
+#include <memory>
 #include <string>
 
+#include <base/callback.h>
 #include <base/compiler_specific.h>
 #include <base/files/file_path.h>
 #include <base/macros.h>
 #include <base/observer_list.h>
+#include <base/time/time.h>
 #include <base/timer/timer.h>
 
 #include "power_manager/common/power_constants.h"
@@ -38,6 +41,46 @@ class AmbientLightSensor : public AmbientLightSensorInterface {
   static const int kNumInitAttemptsBeforeLogging;
   static const int kNumInitAttemptsBeforeGivingUp;
 
+  // Number of times a sample reader may fail before AmbientLightSensor stops
+  // trying to create one and keeps polling.
+  static const int kNumSampleReaderFailuresBeforeGivingUp;
+
+  // When samples are pushed by a SampleReader, observers are notified when the
+  // lux value moves by more than this fraction of the last reported value (and
+  // at least one lux).
+  static const double kPushedLuxChangeFraction;
+  // When samples are pushed, after a change is reported, the latest value is
+  // re-reported every poll interval until it has stayed within the threshold
+  // for this many consecutive readings. This gives observers' smoothing and
+  // hysteresis the stream of readings they expect.
+  static const int kNumStableReadingsToSettle;
+
+  // Delivers illuminance samples of one IIO device as they are produced, so
+  // that the sensor doesn't need to be polled. Samples stop when the reader is
+  // destroyed.
+  class SampleReader {
+   public:
+    virtual ~SampleReader() = default;
+  };
+
+  // Runs with each illuminance sample.
+  using SampleCallback = base::RepeatingCallback<void(int lux)>;
+
+  // Creates a SampleReader for the IIO device with ID |iio_device_id| (N in
+  // "iio:deviceN") that reads the sensor about every |period|, and only runs
+  // |sample_callback| with samples that moved by more than
+  // kPushedLuxChangeFraction (and at least one lux) from the last one it ran
+  // with, so that unchanged readings don't wake powerd up.
+  // |error_callback| runs, possibly destroying the reader, if samples can no
+  // longer be delivered. Returns null if samples can't be read this way right
+  // now.
+  using CreateSampleReaderFunc =
+      base::RepeatingCallback<std::unique_ptr<SampleReader>(
+          int iio_device_id,
+          base::TimeDelta period,
+          SampleCallback sample_callback,
+          base::OnceClosure error_callback)>;
+
   AmbientLightSensor();
   explicit AmbientLightSensor(SensorLocation expected_sensor_location);
   explicit AmbientLightSensor(bool allow_ambient_eq);
@@ -52,11 +95,30 @@ class AmbientLightSensor : public AmbientLightSensorInterface {
     poll_interval_ms_ = interval_ms;
   }
 
+  // Makes the sensor read pushed samples through readers created by |func|
+  // instead of polling, when possible. Must be called before Init().
+  void set_create_sample_reader_func(CreateSampleReaderFunc func) {
+    create_sample_reader_func_ = func;
+  }
+
   // Starts polling. If |read_immediately| is true, ReadAls() will also
   // immediately be called synchronously. This is separate from c'tor so that
   // tests can call set_*_for_testing() first.
+  //
+  // Once the sensor has been found and read, polling stops if a SampleReader
+  // can be created for it.
   void Init(bool read_immediately);
 
+  // Returns true if samples are being pushed by a SampleReader rather than
+  // polled from sysfs.
+  bool IsReadingPushedSamplesForTesting() const {
+    return sample_reader_ != nullptr;
+  }
+
+  // Returns the number of wakeups counted since the wakeup metric was last
+  // reported.
+  int num_wakeups_for_testing() const { return num_wakeups_; }
+
   // If |poll_timer_| is running, calls ReadAls() and returns true. Otherwise,
   // returns false.
   bool TriggerPollTimerForTesting();
@@ -70,7 +132,9 @@ class AmbientLightSensor : public AmbientLightSensorInterface {
   base::FilePath GetIlluminancePath() const override;
 
  private:
-  // Starts |poll_timer_|.
+  // Starts |poll_timer_|, unless samples are being pushed by
+  // |sample_reader_|. Tries to create |sample_reader_| first if the sensor has
+  // been found.
   void StartTimer();
 
   // Handler for a periodic event that reads the ambient light sensor.
@@ -94,6 +158,31 @@ class AmbientLightSensor : public AmbientLightSensorInterface {
   // Initializes |color_als_files_|.
   void InitColorAlsFiles(const base::FilePath& device_dir);
 
+  // Tries to create |sample_reader_| for the sensor in |als_device_dir_|.
+  // Returns true on success.
+  bool InitSampleReader();
+
+  // Handles a sample or an error from |sample_reader_|, respectively.
+  void OnSample(int lux);
+  void OnSampleReaderError();
+
+  // Runs while pushed values are settling; see
+  // kNumStableReadingsToSettle.
+  void OnSettleTimeout();
+
+  // Returns true if |lux| differs enough from |last_notified_lux_| to be
+  // reported when samples are pushed.
+  bool IsSignificantLuxChange(int lux) const;
+
+  // Notifies observers of the current readings.
+  void NotifyObservers();
+
+  // Counts a wakeup for the wakeups-per-minute metric.
+  void RecordWakeup();
+
+  // Reports the number of wakeups per minute since the previous report.
+  void ReportWakeupMetric();
+
   // Path containing backlight devices.  Typically under /sys, but can be
   // overridden by tests.
   base::FilePath device_list_path_;
@@ -101,6 +190,33 @@ class AmbientLightSensor : public AmbientLightSensorInterface {
   // Runs ReadAls().
   base::RepeatingTimer poll_timer_;
 
+  // Directory of the IIO device holding |als_file_|.
+  base::FilePath als_device_dir_;
+
+  // Creates |sample_reader_|. May be null.
+  CreateSampleReaderFunc create_sample_reader_func_;
+
+  // Pushes samples of the sensor when polling isn't needed.
+  std::unique_ptr<SampleReader> sample_reader_;
+
+  // Number of times |sample_reader_| has reported an error.
+  int num_sample_reader_failures_ = 0;
+
+  // Runs OnSettleTimeout().
+  base::RepeatingTimer settle_timer_;
+
+  // Number of consecutive settle readings within the change threshold.
+  int num_stable_readings_ = 0;
+
+  // Lux value last reported to observers, or -1 if none has been.
+  int last_notified_lux_ = -1;
+
+  // Wakeups since the wakeup metric was last reported.
+  int num_wakeups_ = 0;
+
+  // Runs ReportWakeupMetric().
+  base::RepeatingTimer wakeup_metric_timer_;
+
   // Time between polls of the sensor file, in milliseconds.
   int poll_interval_ms_;
 
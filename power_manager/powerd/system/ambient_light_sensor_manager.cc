@@ -30,6 +30,12 @@ void AmbientLightSensorManager::set_poll_interval_ms_for_testing(
     sensor->set_poll_interval_ms_for_testing(interval_ms);
 }
 
+void AmbientLightSensorManager::set_create_sample_reader_func(
+    AmbientLightSensor::CreateSampleReaderFunc func) {
+  for (const auto& sensor : sensors_)
+    sensor->set_create_sample_reader_func(func);
+}
+
 void AmbientLightSensorManager::Init(PrefsInterface* prefs) {
   prefs_ = prefs;
   int64_t num_sensors = 0;
@@ -26,6 +26,11 @@ class AmbientLightSensorManager : public AmbientLightSensorManagerInterface {
   void set_device_list_path_for_testing(const base::FilePath& path);
   void set_poll_interval_ms_for_testing(int interval_ms);
 
+  // Passes |func| to each sensor's set_create_sample_reader_func(). Must be
+  // called between Init() and Run().
+  void set_create_sample_reader_func(
+      AmbientLightSensor::CreateSampleReaderFunc func);
+
   void Init(PrefsInterface* prefs);
   void Run(bool read_immediately);
 
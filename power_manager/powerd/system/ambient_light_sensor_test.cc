@@ -5,12 +5,17 @@
 #include "power_manager/powerd/system/ambient_light_sensor.h"
 
 #include <memory>
+#include <string>
+#include <utility>
 
+#include <base/bind.h>
 #include <base/compiler_specific.h>
 #include <base/files/file_path.h>
 #include <base/files/file_util.h>
 #include <base/files/scoped_temp_dir.h>
+#include <base/run_loop.h>
 #include <base/strings/string_number_conversions.h>
+#include <base/threading/thread_task_runner_handle.h>
 #include <brillo/file_utils.h>
 #include <gtest/gtest.h>
 
@@ -42,17 +47,95 @@ class TestObserver : public AmbientLightObserver {
         base::TimeDelta::FromMilliseconds(kUpdateTimeoutMs));
   }
 
+  int num_updates() const { return num_updates_; }
+
   // AmbientLightObserver implementation:
   void OnAmbientLightUpdated(AmbientLightSensorInterface* sensor) override {
-    loop_runner_.StopLoop();
+    num_updates_++;
+    if (loop_runner_.LoopIsRunning())
+      loop_runner_.StopLoop();
   }
 
  private:
   TestMainLoopRunner loop_runner_;
+  int num_updates_ = 0;
 
   DISALLOW_COPY_AND_ASSIGN(TestObserver);
 };
 
+// Runs the event loop for |delay|.
+void RunLoopFor(base::TimeDelta delay) {
+  base::RunLoop run_loop;
+  base::ThreadTaskRunnerHandle::Get()->PostDelayedTask(
+      FROM_HERE, run_loop.QuitClosure(), delay);
+  run_loop.Run();
+}
+
+// Stands in for iioservice, letting tests push samples to a sensor.
+class FakeSampleReaderFactory {
+ public:
+  // Destroying a reader tells the factory that samples have stopped.
+  class Reader : public AmbientLightSensor::SampleReader {
+   public:
+    explicit Reader(FakeSampleReaderFactory* factory) : factory_(factory) {}
+    ~Reader() override { factory_->reader_ = nullptr; }
+
+   private:
+    FakeSampleReaderFactory* factory_;  // Not owned.
+
+    DISALLOW_COPY_AND_ASSIGN(Reader);
+  };
+
+  FakeSampleReaderFactory() = default;
+  ~FakeSampleReaderFactory() = default;
+
+  void set_available(bool available) { available_ = available; }
+  int iio_device_id() const { return iio_device_id_; }
+  bool has_reader() const { return reader_ != nullptr; }
+
+  AmbientLightSensor::CreateSampleReaderFunc GetFunc() {
+    return base::BindRepeating(&FakeSampleReaderFactory::Create,
+                               base::Unretained(this));
+  }
+
+  // Pushes |lux| to the current reader's sensor.
+  void PushSample(int lux) {
+    CHECK(reader_);
+    sample_callback_.Run(lux);
+  }
+
+  // Reports an error from the current reader.
+  void ReportError() {
+    CHECK(reader_);
+    std::move(error_callback_).Run();
+  }
+
+ private:
+  std::unique_ptr<AmbientLightSensor::SampleReader> Create(
+      int iio_device_id,
+      base::TimeDelta period,
+      AmbientLightSensor::SampleCallback sample_callback,
+      base::OnceClosure error_callback) {
+    if (!available_)
+      return nullptr;
+    CHECK(!reader_);
+    iio_device_id_ = iio_device_id;
+    sample_callback_ = sample_callback;
+    error_callback_ = std::move(error_callback);
+    auto reader = std::make_unique<Reader>(this);
+    reader_ = reader.get();
+    return reader;
+  }
+
+  bool available_ = true;
+  int iio_device_id_ = -1;
+  AmbientLightSensor::SampleCallback sample_callback_;
+  base::OnceClosure error_callback_;
+  Reader* reader_ = nullptr;  // Owned by the sensor.
+
+  DISALLOW_COPY_AND_ASSIGN(FakeSampleReaderFactory);
+};
+
 }  // namespace
 
 class AmbientLightSensorTest : public ::testing::Test {
@@ -72,7 +155,10 @@ class AmbientLightSensorTest : public ::testing::Test {
     sensor_->Init(false /* read_immediately */);
   }
 
-  void TearDown() override { sensor_->RemoveObserver(&observer_); }
+  void TearDown() override {
+    if (sensor_)
+      sensor_->RemoveObserver(&observer_);
+  }
 
  protected:
   // Writes |lux| to |data_file_| to simulate the ambient light sensor reporting
@@ -202,5 +288,103 @@ TEST_F(AmbientLightSensorTest, IsColorSensor) {
   EXPECT_TRUE(sensor_->IsColorSensor());
 }
 
+TEST_F(AmbientLightSensorTest, PushedSamples) {
+  // Set up a sensor whose raw illuminance can be pushed by iioservice.
+  const base::FilePath iio_dir = temp_dir_.GetPath().Append("iio:device1");
+  CHECK(base::CreateDirectory(iio_dir));
+  CHECK(brillo::WriteStringToFile(iio_dir.Append("in_illuminance_raw"), "50"));
+
+  FakeSampleReaderFactory factory;
+  sensor_.reset(new AmbientLightSensor);
+  sensor_->set_device_list_path_for_testing(temp_dir_.GetPath());
+  sensor_->set_poll_interval_ms_for_testing(kPollIntervalMs);
+  sensor_->set_create_sample_reader_func(factory.GetFunc());
+  sensor_->AddObserver(&observer_);
+  sensor_->Init(false /* read_immediately */);
+
+  // The first reading is polled, after which polling stops.
+  ASSERT_TRUE(observer_.RunUntilAmbientLightUpdated());
+  EXPECT_EQ(50, sensor_->GetAmbientLightLux());
+  EXPECT_TRUE(sensor_->IsReadingPushedSamplesForTesting());
+  EXPECT_EQ(1, factory.iio_device_id());
+  EXPECT_FALSE(sensor_->TriggerPollTimerForTesting());
+
+  // A significant change is reported immediately.
+  factory.PushSample(200);
+  EXPECT_EQ(200, sensor_->GetAmbientLightLux());
+  const int num_updates = observer_.num_updates();
+  EXPECT_EQ(2, num_updates);
+
+  // The value is then re-reported until it has settled.
+  for (int i = 0; i < AmbientLightSensor::kNumStableReadingsToSettle; ++i) {
+    ASSERT_TRUE(observer_.RunUntilAmbientLightUpdated());
+    EXPECT_EQ(200, sensor_->GetAmbientLightLux());
+  }
+  const int num_settled_updates = observer_.num_updates();
+  RunLoopFor(base::TimeDelta::FromMilliseconds(3 * kPollIntervalMs));
+  EXPECT_EQ(num_settled_updates, observer_.num_updates());
+
+  // Small changes are recorded but not reported.
+  factory.PushSample(202);
+  EXPECT_EQ(202, sensor_->GetAmbientLightLux());
+  RunLoopFor(base::TimeDelta::FromMilliseconds(3 * kPollIntervalMs));
+  EXPECT_EQ(num_settled_updates, observer_.num_updates());
+
+  // An error from the reader makes the sensor poll again.
+  factory.ReportError();
+  EXPECT_FALSE(factory.has_reader());
+  EXPECT_FALSE(sensor_->IsReadingPushedSamplesForTesting());
+  factory.set_available(false);
+  EXPECT_TRUE(sensor_->TriggerPollTimerForTesting());
+  ASSERT_TRUE(observer_.RunUntilAmbientLightUpdated());
+  EXPECT_EQ(50, sensor_->GetAmbientLightLux());
+
+  // Destroying the sensor stops the reader.
+  factory.set_available(true);
+  ASSERT_TRUE(observer_.RunUntilAmbientLightUpdated());
+  EXPECT_TRUE(factory.has_reader());
+  sensor_->RemoveObserver(&observer_);
+  sensor_.reset();
+  EXPECT_FALSE(factory.has_reader());
+}
+
+TEST_F(AmbientLightSensorTest, PushedSamplesOnlyWakeUpOnChange) {
+  const base::FilePath iio_dir = temp_dir_.GetPath().Append("iio:device1");
+  CHECK(base::CreateDirectory(iio_dir));
+  CHECK(brillo::WriteStringToFile(iio_dir.Append("in_illuminance_raw"), "50"));
+
+  FakeSampleReaderFactory factory;
+  sensor_.reset(new AmbientLightSensor);
+  sensor_->set_device_list_path_for_testing(temp_dir_.GetPath());
+  sensor_->set_poll_interval_ms_for_testing(kPollIntervalMs);
+  sensor_->set_create_sample_reader_func(factory.GetFunc());
+  sensor_->AddObserver(&observer_);
+  sensor_->Init(false /* read_immediately */);
+  ASSERT_TRUE(observer_.RunUntilAmbientLightUpdated());
+  ASSERT_TRUE(sensor_->IsReadingPushedSamplesForTesting());
+
+  // While the light doesn't change, the reader pushes nothing and the sensor
+  // isn't polled, so nothing wakes powerd up.
+  const int num_wakeups = sensor_->num_wakeups_for_testing();
+  RunLoopFor(base::TimeDelta::FromMilliseconds(10 * kPollIntervalMs));
+  EXPECT_EQ(num_wakeups, sensor_->num_wakeups_for_testing());
+
+  // A change wakes powerd up once, plus once for each re-report while the
+  // value settles.
+  factory.PushSample(200);
+  RunLoopFor(base::TimeDelta::FromMilliseconds(
+      (AmbientLightSensor::kNumStableReadingsToSettle + 5) * kPollIntervalMs));
+  EXPECT_EQ(num_wakeups + 1 + AmbientLightSensor::kNumStableReadingsToSettle,
+            sensor_->num_wakeups_for_testing());
+}
+
+TEST_F(AmbientLightSensorTest, PollWithoutSampleReader) {
+  // Sensors keep polling when no sample reader is available.
+  WriteLux(100);
+  ASSERT_TRUE(observer_.RunUntilAmbientLightUpdated());
+  EXPECT_FALSE(sensor_->IsReadingPushedSamplesForTesting());
+  EXPECT_TRUE(sensor_->TriggerPollTimerForTesting());
+}
+
 }  // namespace system
 }  // namespace power_manager
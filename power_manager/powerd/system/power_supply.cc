@@ -10,7 +10,6 @@
 #include <utility>
 
 #include <base/bind.h>
-#include <base/files/file_enumerator.h>
 #include <base/files/file_path.h>
 #include <base/files/file_util.h>
 #include <base/logging.h>
@@ -25,6 +24,7 @@
 #include "power_manager/common/battery_percentage_converter.h"
 #include "power_manager/common/clock.h"
 #include "power_manager/common/metrics_constants.h"
+#include "power_manager/common/metrics_sender.h"
 #include "power_manager/common/power_constants.h"
 #include "power_manager/common/prefs.h"
 #include "power_manager/common/util.h"
@@ -54,44 +54,49 @@ const int kDefaultBatteryStabilizedAfterLinePowerConnectedDelayMs = 5000;
 const int kDefaultBatteryStabilizedAfterLinePowerDisconnectedDelayMs = 5000;
 const int kDefaultBatteryStabilizedAfterResumeDelayMs = 5000;
 
-// Reads the contents of |filename| within |directory| into |out|, trimming
-// trailing whitespace.  Returns true on success.
-bool ReadAndTrimString(const base::FilePath& directory,
+// Reads the contents of |filename| within |directory| into |out| via |cache|,
+// trimming trailing whitespace.  Returns true on success.
+bool ReadAndTrimString(SysfsAttributeCache* cache,
+                       const base::FilePath& directory,
                        const std::string& filename,
                        std::string* out) {
-  return util::MaybeReadStringFile(directory.Append(filename), out);
+  return cache->ReadString(directory, filename, out);
 }
 
 // Reads a 64-bit integer value from a file and returns true on success.
-bool ReadInt64(const base::FilePath& directory,
+bool ReadInt64(SysfsAttributeCache* cache,
+               const base::FilePath& directory,
                const std::string& filename,
                int64_t* out) {
   std::string buffer;
-  if (!ReadAndTrimString(directory, filename, &buffer))
+  if (!ReadAndTrimString(cache, directory, filename, &buffer))
     return false;
   return base::StringToInt64(buffer, out);
 }
 
 // Reads an integer value and scales it to a double (see |kDoubleScaleFactor|.
 // Returns 0.0 on failure.
-double ReadScaledDouble(const base::FilePath& directory,
+double ReadScaledDouble(SysfsAttributeCache* cache,
+                        const base::FilePath& directory,
                         const std::string& filename) {
   int64_t value = 0;
-  return ReadInt64(directory, filename, &value) ? kDoubleScaleFactor * value
-                                                : 0.0;
+  return ReadInt64(cache, directory, filename, &value)
+             ? kDoubleScaleFactor * value
+             : 0.0;
 }
 
 // Returns the string surrounded by brackets via the |out| parameter.
 // For example, returns "fun" given the string: "This format is not so [fun]"
 // The return value is a boolean indicating true on success or false on failure.
-bool ReadBracketSelectedString(const base::FilePath& directory,
+bool ReadBracketSelectedString(SysfsAttributeCache* cache,
+                               const base::FilePath& directory,
                                const std::string& filename,
                                std::string* out) {
   std::string buffer;
 
   DCHECK(out);
 
-  if (!ReadAndTrimString(directory, filename, &buffer))
+  if (!ReadAndTrimString(cache, directory, filename, &buffer))
     return false;
   size_t start = buffer.find("[");
   if (start == std::string::npos)
@@ -119,13 +124,15 @@ bool IsPdDrpType(const std::string& type) {
 
 // Returns true if |type|, a power supply type read from a "type" file in
 // sysfs, indicates USB_PD_DRP, meaning a USB Power Delivery Dual Role Port.
-bool IsDualRoleType(const std::string& type, const base::FilePath& path) {
+bool IsDualRoleType(SysfsAttributeCache* cache,
+                    const std::string& type,
+                    const base::FilePath& path) {
   // 4.19+ kernels have the type as just "USB", and an extra usb_type file
   // in the form:
   // Unknown SDP DCP CDP C PD [PD_DRP] BrickID
   if (type == PowerSupply::kUsbType) {
     std::string usb_type;
-    if (ReadBracketSelectedString(path, "usb_type", &usb_type))
+    if (ReadBracketSelectedString(cache, path, "usb_type", &usb_type))
       return IsPdDrpType(usb_type);
   }
 
@@ -134,15 +141,16 @@ bool IsDualRoleType(const std::string& type, const base::FilePath& path) {
 
 // Returns true if |path|, a sysfs directory, corresponds to an external
 // peripheral (e.g. a wireless mouse or keyboard).
-bool IsExternalPeripheral(const base::FilePath& path) {
+bool IsExternalPeripheral(SysfsAttributeCache* cache,
+                          const base::FilePath& path) {
   std::string scope;
-  return ReadAndTrimString(path, "scope", &scope) && scope == "Device";
+  return ReadAndTrimString(cache, path, "scope", &scope) && scope == "Device";
 }
 
 // Returns true if |path|, a sysfs directory, corresponds to a battery.
-bool IsBatteryPresent(const base::FilePath& path) {
+bool IsBatteryPresent(SysfsAttributeCache* cache, const base::FilePath& path) {
   int64_t present = 0;
-  return ReadInt64(path, "present", &present) && present != 0;
+  return ReadInt64(cache, path, "present", &present) && present != 0;
 }
 
 // Returns a string describing |type|.
@@ -602,6 +610,7 @@ PowerStatus PowerSupply::GetPowerStatus() const {
 }
 
 bool PowerSupply::RefreshImmediately() {
+  sysfs_cache_.Clear();
   return PerformUpdate(UpdatePolicy::UNCONDITIONALLY,
                        NotifyPolicy::ASYNCHRONOUSLY);
 }
@@ -620,12 +629,17 @@ void PowerSupply::SetSuspended(bool suspended) {
     charge_samples_->Clear();
     current_samples_on_line_power_->Clear();
     has_max_samples_ = false;
+    // Power sources may have been added or removed while suspended.
+    sysfs_cache_.Clear();
     PerformUpdate(UpdatePolicy::UNCONDITIONALLY, NotifyPolicy::ASYNCHRONOUSLY);
   }
 }
 
 void PowerSupply::OnUdevEvent(const UdevEvent& event) {
   VLOG(1) << "Got udev event for " << event.device_info.sysname;
+  // Power supplies or their attributes may have come or gone; re-enumerate
+  // them on the next update.
+  sysfs_cache_.Clear();
   // Bail out of the update if the available power sources didn't actually
   // change to avoid recording new samples and updating battery estimates in
   // response to spurious udev events (see http://crosbug.com/p/37403).
@@ -675,6 +689,9 @@ bool PowerSupply::UpdatePowerStatus(UpdatePolicy policy) {
   CHECK(prefs_) << "PowerSupply::Init() wasn't called";
 
   VLOG(1) << "Updating power status";
+  SysfsAttributeCache* cache = &sysfs_cache_;
+  cache->ResetSyscallCount();
+  const base::TimeTicks start_time = base::TimeTicks::Now();
   PowerStatus status;
 
   // Track whether we found at least one (possibly offline) power source.
@@ -682,18 +699,16 @@ bool PowerSupply::UpdatePowerStatus(UpdatePolicy policy) {
 
   std::vector<base::FilePath> battery_paths;
 
-  // Iterate through sysfs's power supply information.
-  base::FileEnumerator file_enum(power_supply_path_, false,
-                                 base::FileEnumerator::DIRECTORIES);
-  for (base::FilePath path = file_enum.Next(); !path.empty();
-       path = file_enum.Next()) {
-    if (IsExternalPeripheral(path))
+  // Iterate through sysfs's power supply information. The directory is only
+  // re-enumerated after |sysfs_cache_| has been cleared.
+  for (const base::FilePath& path :
+       cache->GetSubdirectories(power_supply_path_)) {
+    if (IsExternalPeripheral(cache, path))
       continue;
 
     std::string type;
-    if (!base::ReadFileToString(path.Append("type"), &type))
+    if (!ReadAndTrimString(cache, path, "type", &type))
       continue;
-    base::TrimWhitespaceASCII(type, base::TRIM_TRAILING, &type);
 
     saw_power_source = true;
 
@@ -707,7 +722,7 @@ bool PowerSupply::UpdatePowerStatus(UpdatePolicy policy) {
 
   // If no battery was found, assume that the system is actually on AC power.
   if (!status.line_power_on &&
-      (battery_paths.empty() || !IsBatteryPresent(battery_paths[0]))) {
+      (battery_paths.empty() || !IsBatteryPresent(cache, battery_paths[0]))) {
     if (saw_power_source) {
       // Batteryless Chromeboxes sometimes don't report any power sources. If we
       // saw at least one source but it wasn't online, the battery status might
@@ -738,14 +753,16 @@ bool PowerSupply::UpdatePowerStatus(UpdatePolicy policy) {
       LOG(WARNING) << "Ignoring extra battery " << battery_paths[i].value();
     battery_paths.resize(1);
   }
+  bool battery_ok = true;
   if (battery_paths.size() == 1) {
-    if (!ReadBatteryDirectory(battery_paths[0], &status,
-                              false /* allow_empty */))
-      return false;
+    battery_ok = ReadBatteryDirectory(battery_paths[0], &status,
+                                      false /* allow_empty */);
   } else if (battery_paths.size() > 1) {
-    if (!ReadMultipleBatteryDirectories(battery_paths, &status))
-      return false;
+    battery_ok = ReadMultipleBatteryDirectories(battery_paths, &status);
   }
+  ReportUpdateCost(base::TimeTicks::Now() - start_time);
+  if (!battery_ok)
+    return false;
 
   // Bail out before recording charge and current samples if this was a spurious
   // update request. A change in |battery_charge_full| is used as a proxy for a
@@ -811,8 +828,25 @@ bool PowerSupply::UpdatePowerStatus(UpdatePolicy policy) {
   return true;
 }
 
+void PowerSupply::ReportUpdateCost(base::TimeDelta duration) {
+  last_update_syscall_count_ = sysfs_cache_.syscall_count();
+  VLOG(1) << "Reading power supplies took " << last_update_syscall_count_
+          << " syscall(s) and " << duration.InMicroseconds() << " us";
+  SendMetric(metrics::kPowerSupplyUpdateSyscallsName,
+             last_update_syscall_count_,
+             metrics::kPowerSupplyUpdateSyscallsMin,
+             metrics::kPowerSupplyUpdateSyscallsMax, metrics::kDefaultBuckets);
+  SendMetric(metrics::kPowerSupplyUpdateDurationUsName,
+             static_cast<int>(duration.InMicroseconds()),
+             metrics::kPowerSupplyUpdateDurationUsMin,
+             metrics::kPowerSupplyUpdateDurationUsMax,
+             metrics::kDefaultBuckets);
+}
+
 void PowerSupply::ReadLinePowerDirectory(const base::FilePath& path,
                                          PowerStatus* status) {
+  SysfsAttributeCache* cache = &sysfs_cache_;
+
   // Add the port and fill in its details as we go.
   status->ports.push_back(PowerStatus::Port());
   PowerStatus::Port* port = &status->ports.back();
@@ -823,23 +857,24 @@ void PowerSupply::ReadLinePowerDirectory(const base::FilePath& path,
 
   // Bidirectional/dual-role ports export a "status" field.
   std::string line_status;
-  ReadAndTrimString(path, "status", &line_status);
+  ReadAndTrimString(cache, path, "status", &line_status);
   const bool dual_role_port = !line_status.empty();
   if (dual_role_port)
     status->supports_dual_role_devices = true;
 
   // An "Unknown" type indicates a sink-only device that can't supply power.
-  ReadAndTrimString(path, "type", &port->type);
+  ReadAndTrimString(cache, path, "type", &port->type);
   if (port->type == kUnknownType)
     return;
 
-  const bool dual_role_connected = IsDualRoleType(port->type, path);
+  const bool dual_role_connected = IsDualRoleType(cache, port->type, path);
 
   // If "online" is 0, nothing is connected unless it is USB_PD_DRP, in which
   // case a value of 0 indicates we're connected to a dual-role device but not
   // sinking power.
   int64_t online = 0;
-  if ((!ReadInt64(path, "online", &online) || !online) && !dual_role_connected)
+  if ((!ReadInt64(cache, path, "online", &online) || !online) &&
+      !dual_role_connected)
     return;
 
   // If we've made it this far, there's a dedicated source or dual-role device
@@ -853,11 +888,12 @@ void PowerSupply::ReadLinePowerDirectory(const base::FilePath& path,
   // additional discussion.
   port->active_by_default = !dual_role_port || !dual_role_connected;
 
-  ReadAndTrimString(path, "manufacturer", &port->manufacturer_id);
-  ReadAndTrimString(path, "model_name", &port->model_id);
+  ReadAndTrimString(cache, path, "manufacturer", &port->manufacturer_id);
+  ReadAndTrimString(cache, path, "model_name", &port->model_id);
 
-  const double max_voltage = ReadScaledDouble(path, "voltage_max_design");
-  const double max_current = ReadScaledDouble(path, "current_max");
+  const double max_voltage =
+      ReadScaledDouble(cache, path, "voltage_max_design");
+  const double max_current = ReadScaledDouble(cache, path, "current_max");
   port->max_power = max_voltage * max_current;  // watts
 
   VLOG(1) << "Added power source " << port->id << ":"
@@ -895,21 +931,22 @@ void PowerSupply::ReadLinePowerDirectory(const base::FilePath& path,
   status->line_power_type = port->type;
   status->line_power_max_voltage = max_voltage;
   status->line_power_max_current = max_current;
-  if (base::PathExists(path.Append("voltage_now"))) {
-    status->line_power_voltage = ReadScaledDouble(path, "voltage_now");
+  if (cache->Exists(path, "voltage_now")) {
+    status->line_power_voltage = ReadScaledDouble(cache, path, "voltage_now");
     status->has_line_power_voltage = true;
   }
-  if (base::PathExists(path.Append("current_now"))) {
-    status->line_power_current = ReadScaledDouble(path, "current_now");
+  if (cache->Exists(path, "current_now")) {
+    status->line_power_current = ReadScaledDouble(cache, path, "current_now");
     status->has_line_power_current = true;
   }
-  if (base::PathExists(path.Append("voltage_max_design"))) {
+  if (cache->Exists(path, "voltage_max_design")) {
     status->line_power_max_voltage =
-        ReadScaledDouble(path, "voltage_max_design");
+        ReadScaledDouble(cache, path, "voltage_max_design");
     status->has_line_power_max_voltage = true;
   }
-  if (base::PathExists(path.Append("current_max"))) {
-    status->line_power_max_current = ReadScaledDouble(path, "current_max");
+  if (cache->Exists(path, "current_max")) {
+    status->line_power_max_current =
+        ReadScaledDouble(cache, path, "current_max");
     status->has_line_power_max_current = true;
   }
 
@@ -940,31 +977,33 @@ bool PowerSupply::ReadBatteryDirectory(const base::FilePath& path,
                                        PowerStatus* status,
                                        bool allow_empty) {
   VLOG(1) << "Reading battery status from " << path.value();
+  SysfsAttributeCache* cache = &sysfs_cache_;
   status->battery_path = path.value();
-  status->battery_is_present = IsBatteryPresent(path);
+  status->battery_is_present = IsBatteryPresent(cache, path);
   if (!status->battery_is_present)
     return true;
 
-  ReadAndTrimString(path, "status", &status->battery_status_string);
+  ReadAndTrimString(cache, path, "status", &status->battery_status_string);
 
   // POWER_SUPPLY_PROP_VENDOR does not seem to be a valid property
   // defined in <linux/power_supply.h>.
   ReadAndTrimString(
-      path,
-      base::PathExists(path.Append("manufacturer")) ? "manufacturer" : "vendor",
+      cache, path,
+      cache->Exists(path, "manufacturer") ? "manufacturer" : "vendor",
       &status->battery_vendor);
-  ReadAndTrimString(path, "model_name", &status->battery_model_name);
-  ReadAndTrimString(path, "technology", &status->battery_technology);
+  ReadAndTrimString(cache, path, "model_name", &status->battery_model_name);
+  ReadAndTrimString(cache, path, "technology", &status->battery_technology);
 
-  double voltage = ReadScaledDouble(path, "voltage_now");
+  double voltage = ReadScaledDouble(cache, path, "voltage_now");
   status->battery_voltage = voltage;
 
   int64_t cycle_count = 0;
-  if (ReadInt64(path, "cycle_count", &cycle_count)) {
+  if (ReadInt64(cache, path, "cycle_count", &cycle_count)) {
     status->battery_cycle_count = cycle_count;
   }
 
-  ReadAndTrimString(path, "serial_number", &status->battery_serial_number);
+  ReadAndTrimString(cache, path, "serial_number",
+                    &status->battery_serial_number);
 
   // Attempt to determine nominal voltage for time-remaining calculations. This
   // may or may not be the same as the instantaneous voltage |battery_voltage|,
@@ -973,12 +1012,12 @@ bool PowerSupply::ReadBatteryDirectory(const base::FilePath& path,
   // the current voltage in that case.
   double nominal_voltage = voltage;
   // TODO(khegde): https://crbug.com/980246
-  if (base::PathExists(path.Append("voltage_min_design"))) {
+  if (cache->Exists(path, "voltage_min_design")) {
     status->battery_voltage_min_design =
-        ReadScaledDouble(path, "voltage_min_design");
+        ReadScaledDouble(cache, path, "voltage_min_design");
     nominal_voltage = status->battery_voltage_min_design;
-  } else if (base::PathExists(path.Append("voltage_max_design"))) {
-    nominal_voltage = ReadScaledDouble(path, "voltage_max_design");
+  } else if (cache->Exists(path, "voltage_max_design")) {
+    nominal_voltage = ReadScaledDouble(cache, path, "voltage_max_design");
   }
 
   // Nominal voltage is not required to obtain the charge level; if it's
@@ -1018,20 +1057,21 @@ bool PowerSupply::ReadBatteryDirectory(const base::FilePath& path,
   double charge = 0;
   double energy = 0;
 
-  if (base::PathExists(path.Append("energy_now")))
-    energy = ReadScaledDouble(path, "energy_now");
+  if (cache->Exists(path, "energy_now"))
+    energy = ReadScaledDouble(cache, path, "energy_now");
 
-  if (base::PathExists(path.Append("charge_full"))) {
-    charge_full = ReadScaledDouble(path, "charge_full");
-    charge_full_design = ReadScaledDouble(path, "charge_full_design");
-    charge = ReadScaledDouble(path, "charge_now");
+  if (cache->Exists(path, "charge_full")) {
+    charge_full = ReadScaledDouble(cache, path, "charge_full");
+    charge_full_design = ReadScaledDouble(cache, path, "charge_full_design");
+    charge = ReadScaledDouble(cache, path, "charge_now");
     if (energy <= 0.0)
       energy = charge * nominal_voltage;
-  } else if (base::PathExists(path.Append("energy_full"))) {
+  } else if (cache->Exists(path, "energy_full")) {
     DCHECK_GT(nominal_voltage, 0);
-    charge_full = ReadScaledDouble(path, "energy_full") / nominal_voltage;
+    charge_full =
+        ReadScaledDouble(cache, path, "energy_full") / nominal_voltage;
     charge_full_design =
-        ReadScaledDouble(path, "energy_full_design") / nominal_voltage;
+        ReadScaledDouble(cache, path, "energy_full_design") / nominal_voltage;
     charge = energy / nominal_voltage;
   } else {
     LOG(WARNING) << "Ignoring reading without battery charge/energy";
@@ -1054,9 +1094,10 @@ bool PowerSupply::ReadBatteryDirectory(const base::FilePath& path,
   // The current can be reported as negative on some systems but not on others,
   // so it can't be used to determine whether the battery is charging or
   // discharging.
-  double current = base::PathExists(path.Append("power_now"))
-                       ? fabs(ReadScaledDouble(path, "power_now")) / voltage
-                       : fabs(ReadScaledDouble(path, "current_now"));
+  double current = cache->Exists(path, "power_now")
+                       ? fabs(ReadScaledDouble(cache, path, "power_now")) /
+                             voltage
+                       : fabs(ReadScaledDouble(cache, path, "current_now"));
   status->battery_current = current;
   status->battery_energy_rate = current * voltage;
 
@@ -22,6 +22,7 @@
 
 #include "power_manager/powerd/system/power_supply_observer.h"
 #include "power_manager/powerd/system/rolling_average.h"
+#include "power_manager/powerd/system/sysfs_attribute_cache.h"
 #include "power_manager/powerd/system/udev_subsystem_observer.h"
 #include "power_manager/proto_bindings/power_supply_properties.pb.h"
 
@@ -228,7 +229,8 @@ class PowerSupplyInterface {
   virtual PowerStatus GetPowerStatus() const = 0;
 
   // Updates the status synchronously, returning true on success. If successful,
-  // observers will be notified asynchronously.
+  // observers will be notified asynchronously. Unlike periodic polls, this
+  // re-enumerates the available power supplies.
   virtual bool RefreshImmediately() = 0;
 
   // On suspend, stops polling. On resume, updates the status immediately,
@@ -263,6 +265,12 @@ class PowerSupply : public PowerSupplyInterface, public UdevSubsystemObserver {
     // Returns false otherwise.
     bool TriggerPollTimeout() WARN_UNUSED_RESULT;
 
+    // Returns the number of syscalls issued to read sysfs during the most
+    // recent update.
+    int last_update_syscall_count() const {
+      return power_supply_->last_update_syscall_count_;
+    }
+
    private:
     PowerSupply* power_supply_;  // weak
 
@@ -383,6 +391,10 @@ class PowerSupply : public PowerSupplyInterface, public UdevSubsystemObserver {
   // connected power sources have not changed.
   bool UpdatePowerStatus(UpdatePolicy policy);
 
+  // Logs and reports metrics about the number of syscalls issued by
+  // |sysfs_cache_| during the current update and the update's |duration|.
+  void ReportUpdateCost(base::TimeDelta duration);
+
   // Helper method for UpdatePowerStatus() that reads |path|, a directory under
   // |power_supply_path_| corresponding to a line power source (e.g. anything
   // that isn't a battery), and updates |status|.
@@ -472,6 +484,15 @@ class PowerSupply : public PowerSupplyInterface, public UdevSubsystemObserver {
   // supplies.
   base::FilePath power_supply_path_;
 
+  // Holds open descriptors for the attributes under |power_supply_path_|.
+  // Cleared when udev reports a power supply change, on resume, and by
+  // RefreshImmediately() so that the directory is re-enumerated; periodic
+  // polls reuse it.
+  SysfsAttributeCache sysfs_cache_;
+
+  // Number of syscalls issued by |sysfs_cache_| during the last update.
+  int last_update_syscall_count_ = 0;
+
   // Should multiple battery directories in sysfs be read and combined?
   bool allow_multiple_batteries_ = false;
 
@@ -1983,6 +1983,43 @@ TEST_F(PowerSupplyTest, NoCurrentOrVoltage) {
   EXPECT_FALSE(status.has_line_power_max_voltage);
 }
 
+TEST_F(PowerSupplyTest, PollsReuseSysfsHandles) {
+  WriteDefaultValues(PowerSource::AC);
+  Init();
+  PowerStatus status;
+  ASSERT_TRUE(UpdateStatus(&status));
+  const int initial_syscalls = test_api_->last_update_syscall_count();
+  EXPECT_GT(initial_syscalls, 0);
+
+  // A poll should pick up new attribute values while only re-reading the
+  // already-open files.
+  UpdateChargeAndCurrent(0.25, kDefaultCurrent);
+  ASSERT_TRUE(test_api_->TriggerPollTimeout());
+  status = power_supply_->GetPowerStatus();
+  EXPECT_DOUBLE_EQ(0.25, status.battery_charge);
+  const int poll_syscalls = test_api_->last_update_syscall_count();
+  EXPECT_GT(poll_syscalls, 0);
+  EXPECT_LT(poll_syscalls, initial_syscalls);
+  ASSERT_TRUE(test_api_->TriggerPollTimeout());
+  EXPECT_EQ(poll_syscalls, test_api_->last_update_syscall_count());
+
+  // A newly-added power supply shouldn't be seen by polls...
+  const char kUsbId[] = "usb";
+  const base::FilePath usb_dir = temp_dir_.GetPath().Append(kUsbId);
+  ASSERT_TRUE(base::CreateDirectory(usb_dir));
+  WriteValue(usb_dir, "type", kUsbType);
+  WriteValue(usb_dir, "online", "1");
+  ASSERT_TRUE(test_api_->TriggerPollTimeout());
+  status = power_supply_->GetPowerStatus();
+  ASSERT_EQ(1u, status.ports.size());
+
+  // ... but it should be after udev reports it.
+  SendUdevEvent();
+  status = power_supply_->GetPowerStatus();
+  ASSERT_EQ(2u, status.ports.size());
+  EXPECT_EQ(kUsbId, status.ports[1].id);
+}
+
 TEST_F(PowerSupplyTest, IgnoreMultipleBatteriesWithoutPref) {
   WriteDefaultValues(PowerSource::AC);
   AddSecondBattery(kCharging);
@@ -0,0 +1,186 @@
+// Copyright 2020 The Chromium OS Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "power_manager/powerd/system/sensor_service_handler.h"
+
+#include <algorithm>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <base/bind.h>
+#include <base/containers/flat_map.h>
+#include <base/logging.h>
+
+namespace power_manager {
+namespace system {
+
+namespace {
+
+// Pushes the samples of an IIO light sensor's illuminance channel, read
+// through iioservice.
+class LightSampleReader : public AmbientLightSensor::SampleReader,
+                          public cros::mojom::SensorDeviceSamplesObserver {
+ public:
+  LightSampleReader(cros::mojom::SensorService* sensor_service,
+                    int iio_device_id,
+                    base::TimeDelta period,
+                    AmbientLightSensor::SampleCallback sample_callback,
+                    base::OnceClosure error_callback)
+      : sample_callback_(sample_callback),
+        error_callback_(std::move(error_callback)) {
+    sensor_service->GetDevice(iio_device_id,
+                              device_.BindNewPipeAndPassReceiver());
+    device_.set_disconnect_handler(base::BindOnce(
+        &LightSampleReader::OnError, base::Unretained(this),
+        std::string("SensorDevice disconnected")));
+    device_->GetAllChannelIds(
+        base::BindOnce(&LightSampleReader::OnGetAllChannelIds,
+                       weak_ptr_factory_.GetWeakPtr(), period));
+  }
+  ~LightSampleReader() override = default;
+
+  // cros::mojom::SensorDeviceSamplesObserver:
+  void OnSampleUpdated(
+      const base::flat_map<int32_t, int64_t>& sample) override {
+    auto it = sample.find(channel_index_);
+    if (it == sample.end())
+      return;
+    sample_callback_.Run(static_cast<int>(std::min<int64_t>(
+        it->second, std::numeric_limits<int>::max())));
+  }
+
+  void OnErrorOccurred(cros::mojom::ObserverErrorType type) override {
+    // Read timeouts are transient; iioservice keeps reading.
+    if (type == cros::mojom::ObserverErrorType::READ_TIMEOUT) {
+      LOG(WARNING) << "Timed out reading ALS samples";
+      return;
+    }
+    OnError("SensorDeviceSamplesObserver error " +
+            std::to_string(static_cast<int>(type)));
+  }
+
+ private:
+  void OnGetAllChannelIds(base::TimeDelta period,
+                          const std::vector<std::string>& channel_ids) {
+    for (size_t i = 0; i < channel_ids.size(); ++i) {
+      if (channel_ids[i] == cros::mojom::kLightChannel)
+        channel_index_ = static_cast<int32_t>(i);
+    }
+    if (channel_index_ < 0) {
+      OnError("No illuminance channel");
+      return;
+    }
+
+    device_->SetFrequency(1.0 / period.InSecondsF(),
+                          base::BindOnce(&LightSampleReader::OnSetFrequency,
+                                         weak_ptr_factory_.GetWeakPtr()));
+    device_->SetChannelsEnabled(
+        {channel_index_}, true,
+        base::BindOnce(&LightSampleReader::OnSetChannelsEnabled,
+                       weak_ptr_factory_.GetWeakPtr()));
+    // iioservice drops the samples that don't change enough, so that powerd is
+    // only woken up when the lux value moves.
+    device_->SetSampleChangeThreshold(
+        AmbientLightSensor::kPushedLuxChangeFraction, 1,
+        base::BindOnce(&LightSampleReader::OnSetSampleChangeThreshold,
+                       weak_ptr_factory_.GetWeakPtr()));
+    device_->StartReadingSamples(receiver_.BindNewPipeAndPassRemote());
+    receiver_.set_disconnect_handler(base::BindOnce(
+        &LightSampleReader::OnError, base::Unretained(this),
+        std::string("SensorDeviceSamplesObserver disconnected")));
+  }
+
+  void OnSetFrequency(double result_freq) {
+    if (result_freq <= 0.0)
+      OnError("Failed to set frequency");
+  }
+
+  void OnSetChannelsEnabled(const std::vector<int32_t>& failed_indices) {
+    if (!failed_indices.empty())
+      OnError("Failed to enable illuminance channel");
+  }
+
+  void OnSetSampleChangeThreshold(bool success) {
+    if (!success)
+      OnError("Failed to set sample change threshold");
+  }
+
+  // Stops reading and runs |error_callback_|, which may delete |this|.
+  void OnError(const std::string& reason) {
+    LOG(ERROR) << reason;
+    receiver_.reset();
+    device_.reset();
+    weak_ptr_factory_.InvalidateWeakPtrs();
+    if (error_callback_)
+      std::move(error_callback_).Run();
+  }
+
+  AmbientLightSensor::SampleCallback sample_callback_;
+  base::OnceClosure error_callback_;
+
+  mojo::Remote<cros::mojom::SensorDevice> device_;
+  mojo::Receiver<cros::mojom::SensorDeviceSamplesObserver> receiver_{this};
+
+  // Index of the illuminance channel in samples, or -1 if not known yet.
+  int32_t channel_index_ = -1;
+
+  base::WeakPtrFactory<LightSampleReader> weak_ptr_factory_{this};
+
+  DISALLOW_COPY_AND_ASSIGN(LightSampleReader);
+};
+
+}  // namespace
+
+SensorServiceHandler::SensorServiceHandler() = default;
+
+SensorServiceHandler::~SensorServiceHandler() = default;
+
+void SensorServiceHandler::Init(dbus::Bus* bus) {
+  SetBus(bus);
+  BootstrapMojoConnection();
+}
+
+std::unique_ptr<AmbientLightSensor::SampleReader>
+SensorServiceHandler::CreateLightSampleReader(
+    int iio_device_id,
+    base::TimeDelta period,
+    AmbientLightSensor::SampleCallback sample_callback,
+    base::OnceClosure error_callback) {
+  if (!sensor_service_.is_bound())
+    return nullptr;
+  return std::make_unique<LightSampleReader>(
+      sensor_service_.get(), iio_device_id, period, sample_callback,
+      std::move(error_callback));
+}
+
+void SensorServiceHandler::OnClientReceived(
+    mojo::PendingReceiver<cros::mojom::SensorHalClient> client) {
+  client_.reset();
+  client_.Bind(std::move(client));
+  client_.set_disconnect_handler(
+      base::BindOnce(&SensorServiceHandler::OnConnectionLost,
+                     weak_ptr_factory_.GetWeakPtr()));
+}
+
+void SensorServiceHandler::SetUpChannel(
+    mojo::PendingRemote<cros::mojom::SensorService> pending_remote) {
+  sensor_service_.reset();
+  sensor_service_.Bind(std::move(pending_remote));
+  sensor_service_.set_disconnect_handler(
+      base::BindOnce(&SensorServiceHandler::OnConnectionLost,
+                     weak_ptr_factory_.GetWeakPtr()));
+  LOG(INFO) << "Connected to iioservice";
+}
+
+void SensorServiceHandler::OnConnectionLost() {
+  LOG(WARNING) << "Lost connection to iioservice";
+  client_.reset();
+  sensor_service_.reset();
+  ReconnectMojoWithDelay();
+}
+
+}  // namespace system
+}  // namespace power_manager
@@ -0,0 +1,74 @@
+// Copyright 2020 The Chromium OS Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef POWER_MANAGER_POWERD_SYSTEM_SENSOR_SERVICE_HANDLER_H_
+#define POWER_MANAGER_POWERD_SYSTEM_SENSOR_SERVICE_HANDLER_H_
+
+#include <memory>
+
+#include <base/macros.h>
+#include <base/memory/weak_ptr.h>
+#include <base/time/time.h>
+#include <mojo/public/cpp/bindings/pending_receiver.h>
+#include <mojo/public/cpp/bindings/pending_remote.h>
+#include <mojo/public/cpp/bindings/receiver.h>
+#include <mojo/public/cpp/bindings/remote.h>
+
+#include "iioservice/libiioservice_ipc/sensor_client_dbus.h"
+#include "mojo/cros_sensor_service.mojom.h"
+#include "mojo/sensor.mojom.h"
+#include "power_manager/powerd/system/ambient_light_sensor.h"
+
+namespace dbus {
+class Bus;
+}  // namespace dbus
+
+namespace power_manager {
+namespace system {
+
+// Connects powerd to iioservice, which owns the IIO buffers of the sensors
+// and shares their samples between all of its clients.
+class SensorServiceHandler : public iioservice::SensorClientDbus,
+                             public cros::mojom::SensorHalClient {
+ public:
+  SensorServiceHandler();
+  ~SensorServiceHandler() override;
+
+  // Asks iioservice for a connection over |bus|. The connection is
+  // re-established if it's lost.
+  void Init(dbus::Bus* bus);
+
+  // Creates a reader pushing the illuminance samples of the IIO device with
+  // ID |iio_device_id|. Returns null if iioservice isn't connected. Matches
+  // AmbientLightSensor::CreateSampleReaderFunc.
+  std::unique_ptr<AmbientLightSensor::SampleReader> CreateLightSampleReader(
+      int iio_device_id,
+      base::TimeDelta period,
+      AmbientLightSensor::SampleCallback sample_callback,
+      base::OnceClosure error_callback);
+
+ private:
+  // iioservice::SensorClientDbus:
+  void OnClientReceived(
+      mojo::PendingReceiver<cros::mojom::SensorHalClient> client) override;
+
+  // cros::mojom::SensorHalClient:
+  void SetUpChannel(
+      mojo::PendingRemote<cros::mojom::SensorService> pending_remote) override;
+
+  // Drops the connection to iioservice and asks for a new one.
+  void OnConnectionLost();
+
+  mojo::Receiver<cros::mojom::SensorHalClient> client_{this};
+  mojo::Remote<cros::mojom::SensorService> sensor_service_;
+
+  base::WeakPtrFactory<SensorServiceHandler> weak_ptr_factory_{this};
+
+  DISALLOW_COPY_AND_ASSIGN(SensorServiceHandler);
+};
+
+}  // namespace system
+}  // namespace power_manager
+
+#endif  // POWER_MANAGER_POWERD_SYSTEM_SENSOR_SERVICE_HANDLER_H_
@@ -0,0 +1,115 @@
+// Copyright 2020 The Chromium OS Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "power_manager/powerd/system/sysfs_attribute_cache.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <utility>
+
+#include <base/files/file_enumerator.h>
+#include <base/logging.h>
+#include <base/posix/eintr_wrapper.h>
+#include <base/strings/string_util.h>
+
+namespace power_manager {
+namespace system {
+
+namespace {
+
+// sysfs attributes are at most a page long, so a single read almost always
+// returns the whole file.
+const size_t kReadSize = 4096;
+
+}  // namespace
+
+SysfsAttributeCache::SysfsAttributeCache() = default;
+
+SysfsAttributeCache::~SysfsAttributeCache() = default;
+
+const std::vector<base::FilePath>& SysfsAttributeCache::GetSubdirectories(
+    const base::FilePath& dir) {
+  auto it = subdirectories_.find(dir);
+  if (it != subdirectories_.end())
+    return it->second;
+
+  std::vector<base::FilePath> paths;
+  base::FileEnumerator file_enum(dir, false, base::FileEnumerator::DIRECTORIES);
+  syscall_count_++;
+  for (base::FilePath path = file_enum.Next(); !path.empty();
+       path = file_enum.Next()) {
+    syscall_count_++;
+    paths.push_back(path);
+  }
+  return subdirectories_.emplace(dir, std::move(paths)).first->second;
+}
+
+bool SysfsAttributeCache::Exists(const base::FilePath& dir,
+                                 const std::string& name) {
+  return GetAttribute(dir.Append(name))->exists;
+}
+
+bool SysfsAttributeCache::ReadString(const base::FilePath& dir,
+                                     const std::string& name,
+                                     std::string* out) {
+  DCHECK(out);
+  const base::FilePath path = dir.Append(name);
+  Attribute* attribute = GetAttribute(path);
+  if (!attribute->fd.is_valid())
+    return false;
+
+  std::string contents;
+  char buffer[kReadSize];
+  off_t offset = 0;
+  while (true) {
+    const ssize_t bytes_read = HANDLE_EINTR(
+        pread(attribute->fd.get(), buffer, sizeof(buffer), offset));
+    syscall_count_++;
+    if (bytes_read < 0) {
+      // The device may have gone away without a udev event having been seen
+      // yet; drop the descriptor so the next read reopens the file.
+      VPLOG(1) << "Unable to read " << path.value();
+      attributes_.erase(path);
+      syscall_count_++;
+      return false;
+    }
+    contents.append(buffer, bytes_read);
+    offset += bytes_read;
+    if (static_cast<size_t>(bytes_read) < sizeof(buffer))
+      break;
+  }
+
+  base::TrimWhitespaceASCII(contents, base::TRIM_TRAILING, out);
+  return true;
+}
+
+void SysfsAttributeCache::Clear() {
+  for (const auto& it : attributes_) {
+    if (it.second.fd.is_valid())
+      syscall_count_++;
+  }
+  attributes_.clear();
+  subdirectories_.clear();
+}
+
+SysfsAttributeCache::Attribute* SysfsAttributeCache::GetAttribute(
+    const base::FilePath& path) {
+  auto it = attributes_.find(path);
+  if (it != attributes_.end())
+    return &it->second;
+
+  Attribute attribute;
+  attribute.fd.reset(
+      HANDLE_EINTR(open(path.value().c_str(), O_RDONLY | O_CLOEXEC)));
+  const int open_errno = errno;
+  syscall_count_++;
+  attribute.exists = attribute.fd.is_valid() ||
+                     (open_errno != ENOENT && open_errno != ENOTDIR);
+  return &attributes_.emplace(path, std::move(attribute)).first->second;
+}
+
+}  // namespace system
+}  // namespace power_manager
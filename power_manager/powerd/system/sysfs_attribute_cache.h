@@ -0,0 +1,81 @@
+// Copyright 2020 The Chromium OS Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef POWER_MANAGER_POWERD_SYSTEM_SYSFS_ATTRIBUTE_CACHE_H_
+#define POWER_MANAGER_POWERD_SYSTEM_SYSFS_ATTRIBUTE_CACHE_H_
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <base/files/file_path.h>
+#include <base/files/scoped_file.h>
+#include <base/macros.h>
+
+namespace power_manager {
+namespace system {
+
+// Keeps sysfs attribute files open so that they can be re-read with pread()
+// instead of being opened and closed every time they're polled. Missing
+// attributes and the subdirectories of enumerated directories are remembered
+// too, so a poll of an unchanged set of devices only issues one read per
+// attribute. Clear() must be called whenever the set of devices (and hence of
+// attributes) may have changed.
+class SysfsAttributeCache {
+ public:
+  SysfsAttributeCache();
+  ~SysfsAttributeCache();
+
+  // Returns the number of system calls issued since the last call to
+  // ResetSyscallCount(). Directory enumeration is counted as one call per
+  // entry.
+  int syscall_count() const { return syscall_count_; }
+  void ResetSyscallCount() { syscall_count_ = 0; }
+
+  // Returns the subdirectories of |dir|, enumerating it only if it hasn't been
+  // enumerated since the last call to Clear().
+  const std::vector<base::FilePath>& GetSubdirectories(
+      const base::FilePath& dir);
+
+  // Returns true if the attribute |name| exists within |dir|.
+  bool Exists(const base::FilePath& dir, const std::string& name);
+
+  // Reads the attribute |name| within |dir| into |out|, trimming trailing
+  // whitespace. Returns true on success.
+  bool ReadString(const base::FilePath& dir,
+                  const std::string& name,
+                  std::string* out);
+
+  // Closes all cached file descriptors and forgets all cached directory
+  // listings.
+  void Clear();
+
+ private:
+  struct Attribute {
+    // Invalid if the file doesn't exist or couldn't be opened.
+    base::ScopedFD fd;
+
+    // True if the file exists, even if it couldn't be opened.
+    bool exists = false;
+  };
+
+  // Returns the cached entry for |path|, opening the file if it hasn't been
+  // looked up since the last call to Clear().
+  Attribute* GetAttribute(const base::FilePath& path);
+
+  // Keyed by full path.
+  std::map<base::FilePath, Attribute> attributes_;
+
+  // Keyed by the enumerated directory.
+  std::map<base::FilePath, std::vector<base::FilePath>> subdirectories_;
+
+  int syscall_count_ = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(SysfsAttributeCache);
+};
+
+}  // namespace system
+}  // namespace power_manager
+
+#endif  // POWER_MANAGER_POWERD_SYSTEM_SYSFS_ATTRIBUTE_CACHE_H_
@@ -0,0 +1,76 @@
+// Copyright 2020 The Chromium OS Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "power_manager/powerd/system/sysfs_attribute_cache.h"
+
+#include <string>
+
+#include <base/files/file_util.h>
+#include <base/files/scoped_temp_dir.h>
+#include <gtest/gtest.h>
+
+namespace power_manager {
+namespace system {
+
+class SysfsAttributeCacheTest : public ::testing::Test {
+ public:
+  SysfsAttributeCacheTest() {}
+  ~SysfsAttributeCacheTest() override {}
+
+  void SetUp() override { ASSERT_TRUE(temp_dir_.CreateUniqueTempDir()); }
+
+ protected:
+  void WriteValue(const std::string& name, const std::string& value) {
+    ASSERT_EQ(static_cast<int>(value.size()),
+              base::WriteFile(temp_dir_.GetPath().Append(name), value.c_str(),
+                              value.size()));
+  }
+
+  base::ScopedTempDir temp_dir_;
+  SysfsAttributeCache cache_;
+};
+
+TEST_F(SysfsAttributeCacheTest, ReadsThroughOpenDescriptor) {
+  WriteValue("charge_now", "1000\n");
+  std::string value;
+  ASSERT_TRUE(cache_.ReadString(temp_dir_.GetPath(), "charge_now", &value));
+  EXPECT_EQ("1000", value);
+  EXPECT_EQ(2, cache_.syscall_count());
+
+  // Later reads should only pread() the already-open file and see its new
+  // contents.
+  cache_.ResetSyscallCount();
+  WriteValue("charge_now", "900\n");
+  ASSERT_TRUE(cache_.ReadString(temp_dir_.GetPath(), "charge_now", &value));
+  EXPECT_EQ("900", value);
+  EXPECT_EQ(1, cache_.syscall_count());
+}
+
+TEST_F(SysfsAttributeCacheTest, RemembersMissingAttributes) {
+  std::string value;
+  EXPECT_FALSE(cache_.Exists(temp_dir_.GetPath(), "power_now"));
+  EXPECT_FALSE(cache_.ReadString(temp_dir_.GetPath(), "power_now", &value));
+  EXPECT_EQ(1, cache_.syscall_count());
+
+  // The file isn't looked up again until the cache is cleared.
+  WriteValue("power_now", "5");
+  EXPECT_FALSE(cache_.Exists(temp_dir_.GetPath(), "power_now"));
+  cache_.Clear();
+  EXPECT_TRUE(cache_.Exists(temp_dir_.GetPath(), "power_now"));
+  ASSERT_TRUE(cache_.ReadString(temp_dir_.GetPath(), "power_now", &value));
+  EXPECT_EQ("5", value);
+}
+
+TEST_F(SysfsAttributeCacheTest, CachesSubdirectories) {
+  ASSERT_TRUE(base::CreateDirectory(temp_dir_.GetPath().Append("AC")));
+  EXPECT_EQ(1u, cache_.GetSubdirectories(temp_dir_.GetPath()).size());
+
+  ASSERT_TRUE(base::CreateDirectory(temp_dir_.GetPath().Append("BAT0")));
+  EXPECT_EQ(1u, cache_.GetSubdirectories(temp_dir_.GetPath()).size());
+  cache_.Clear();
+  EXPECT_EQ(2u, cache_.GetSubdirectories(temp_dir_.GetPath()).size());
+}
+
+}  // namespace system
+}  // namespace power_manager
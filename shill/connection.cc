@@ -16,6 +16,7 @@
 
 #include "shill/control_interface.h"
 #include "shill/device_info.h"
+#include "shill/dns_cache.h"
 #include "shill/logging.h"
 #include "shill/net/rtnl_handler.h"
 #include "shill/resolver.h"
@@ -283,8 +284,10 @@ void Connection::UpdateFromIPConfig(const IPConfigRefPtr& config) {
   UpdateRoutingPolicy();
 
   // Save a copy of the last non-null DNS config.
-  if (!config->properties().dns_servers.empty()) {
+  if (!config->properties().dns_servers.empty() &&
+      config->properties().dns_servers != dns_servers_) {
     dns_servers_ = config->properties().dns_servers;
+    DnsCache::GetInstance()->FlushInterface(interface_name_);
   }
 
   if (!config->properties().domain_search.empty()) {
@@ -495,6 +498,9 @@ void Connection::SetUseDNS(bool enable) {
 }
 
 void Connection::UpdateDNSServers(const vector<string>& dns_servers) {
+  if (dns_servers != dns_servers_) {
+    DnsCache::GetInstance()->FlushInterface(interface_name_);
+  }
   dns_servers_ = dns_servers;
   PushDNSConfig();
 }
@@ -11,6 +11,7 @@
 
 #include "shill/connection.h"
 #include "shill/device_info.h"
+#include "shill/dns_cache.h"
 #include "shill/dns_client.h"
 #include "shill/dns_client_factory.h"
 #include "shill/error.h"
@@ -340,6 +341,7 @@ void ConnectionDiagnostics::ResolveTargetServerIPAddress(
       DnsClient::kDnsTimeoutMilliseconds, dispatcher_,
       Bind(&ConnectionDiagnostics::OnDNSResolutionComplete,
            weak_ptr_factory_.GetWeakPtr()));
+  dns_client_->set_cache(DnsCache::GetInstance());
   if (!dns_client_->Start(target_url_->host(), &e)) {
     LOG(ERROR) << __func__ << ": could not start DNS -- " << e.message();
     AddEventWithMessage(kTypeResolveTargetServerIP, kPhaseStart, kResultFailure,
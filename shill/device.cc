@@ -33,6 +33,7 @@
 #include "shill/dhcp/dhcp_config.h"
 #include "shill/dhcp/dhcp_properties.h"
 #include "shill/dhcp/dhcp_provider.h"
+#include "shill/dns_cache.h"
 #include "shill/error.h"
 #include "shill/event_dispatcher.h"
 #include "shill/icmp.h"
@@ -1258,6 +1259,7 @@ void Device::DestroyConnection() {
     selected_service_->SetConnection(nullptr);
   }
   connection_ = nullptr;
+  DnsCache::GetInstance()->FlushInterface(link_name_);
 }
 
 void Device::GetTrafficCountersCallback(
@@ -1805,6 +1807,11 @@ void Device::PortalDetectorCallback(
     // Set the probe URL. It should be empty if there is no redirect.
     selected_service_->SetProbeUrl(http_result.probe_url_string);
   }
+  // Answers cached behind a portal may have been rewritten by it, and those
+  // cached before it appeared no longer apply.
+  if (!selected_service_ || selected_service_->state() != state) {
+    DnsCache::GetInstance()->FlushInterface(link_name_);
+  }
   if (state == Service::kStateOnline) {
     SetServiceConnectedState(state);
 
@@ -0,0 +1,181 @@
+// Copyright 2020 The Chromium OS Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "shill/dns_cache.h"
+
+#include <algorithm>
+
+#include <base/strings/string_number_conversions.h>
+#include <base/strings/string_util.h>
+
+#include "shill/dns_client.h"
+#include "shill/logging.h"
+#include "shill/net/shill_time.h"
+
+using std::string;
+using std::vector;
+
+namespace shill {
+
+namespace Logging {
+static auto kModuleLogScope = ScopeLogger::kDNS;
+static string ObjectID(const DnsCache* d) {
+  return "(dns_cache)";
+}
+}  // namespace Logging
+
+namespace {
+
+// Only answers that say the name definitively does not resolve are worth
+// remembering; anything else may be a transient failure.
+bool IsCacheableError(const Error& error) {
+  return error.type() == Error::kOperationFailed &&
+         (error.message() == DnsClient::kErrorNotFound ||
+          error.message() == DnsClient::kErrorNoData);
+}
+
+}  // namespace
+
+const time_t DnsCache::kMaxPositiveLifetimeSeconds = 60;
+const time_t DnsCache::kNegativeLifetimeSeconds = 10;
+
+// static
+DnsCache* DnsCache::GetInstance() {
+  static base::NoDestructor<DnsCache> instance(Time::GetInstance());
+  return instance.get();
+}
+
+DnsCache::DnsCache(Time* time)
+    : time_(time), hits_(0), negative_hits_(0), misses_(0), deduplicated_(0) {}
+
+DnsCache::~DnsCache() = default;
+
+// static
+string DnsCache::MakeKey(const string& interface_name,
+                         IPAddress::Family family,
+                         const vector<string>& dns_servers,
+                         const string& hostname) {
+  // Hostnames are case-insensitive, and none of the other fields can contain
+  // the separator.
+  return interface_name + "|" + base::NumberToString(family) + "|" +
+         base::JoinString(dns_servers, ",") + "|" + base::ToLowerASCII(hostname);
+}
+
+bool DnsCache::Lookup(const string& key, Error* error, IPAddress* address) {
+  const auto it = entries_.find(key);
+  if (it == entries_.end()) {
+    misses_++;
+    return false;
+  }
+
+  time_t now;
+  if (!GetNow(&now) || now >= it->second.expiry_seconds) {
+    SLOG(this, 3) << "Expired entry for " << key;
+    entries_.erase(it);
+    misses_++;
+    return false;
+  }
+
+  const Entry& entry = it->second;
+  if (entry.error_type == Error::kSuccess) {
+    hits_++;
+    error->Reset();
+  } else {
+    negative_hits_++;
+    error->Populate(entry.error_type, entry.error_message);
+  }
+  *address = entry.address;
+  SLOG(this, 3) << "Cache hit for " << key;
+  return true;
+}
+
+bool DnsCache::JoinOrStartLookup(const string& key,
+                                 const ResultCallback& on_result,
+                                 const base::Closure& on_abandoned) {
+  const auto it = in_flight_.find(key);
+  if (it == in_flight_.end()) {
+    in_flight_.emplace(key, vector<Waiter>());
+    return false;
+  }
+
+  SLOG(this, 3) << "Joining in-flight lookup for " << key;
+  it->second.emplace_back(on_result, on_abandoned);
+  deduplicated_++;
+  return true;
+}
+
+void DnsCache::CompleteLookup(const string& key,
+                              const Error& error,
+                              const IPAddress& address,
+                              time_t ttl_seconds) {
+  time_t now;
+  if (GetNow(&now)) {
+    if (error.IsSuccess()) {
+      // A TTL of 0 means the answer must not be reused.
+      if (ttl_seconds > 0) {
+        entries_[key] = {
+            Error::kSuccess, string(), address,
+            now + std::min(ttl_seconds, kMaxPositiveLifetimeSeconds)};
+      }
+    } else if (IsCacheableError(error)) {
+      entries_[key] = {error.type(), error.message(), address,
+                       now + kNegativeLifetimeSeconds};
+    }
+  }
+
+  // Waiters may start new lookups of the same key, so detach them first.
+  vector<Waiter> waiters;
+  const auto it = in_flight_.find(key);
+  if (it != in_flight_.end()) {
+    waiters.swap(it->second);
+    in_flight_.erase(it);
+  }
+  for (const auto& waiter : waiters) {
+    waiter.first.Run(error, address);
+  }
+}
+
+void DnsCache::AbandonLookup(const string& key) {
+  vector<Waiter> waiters;
+  const auto it = in_flight_.find(key);
+  if (it == in_flight_.end()) {
+    return;
+  }
+  waiters.swap(it->second);
+  in_flight_.erase(it);
+  for (const auto& waiter : waiters) {
+    waiter.second.Run();
+  }
+}
+
+void DnsCache::FlushInterface(const string& interface_name) {
+  const string prefix = interface_name + "|";
+  size_t flushed = 0;
+  for (auto it = entries_.begin(); it != entries_.end();) {
+    if (base::StartsWith(it->first, prefix, base::CompareCase::SENSITIVE)) {
+      it = entries_.erase(it);
+      ++flushed;
+    } else {
+      ++it;
+    }
+  }
+  // Flushes follow DNS server and portal state changes, so they are rare
+  // enough to report how well the cache has been doing.
+  if (flushed > 0) {
+    LOG(INFO) << "Flushed " << flushed << " DNS cache entries for "
+              << interface_name << "; since start: " << hits_ << " hits, "
+              << negative_hits_ << " negative hits, " << misses_
+              << " misses, " << deduplicated_ << " deduplicated lookups";
+  }
+}
+
+bool DnsCache::GetNow(time_t* now) {
+  if (!time_->GetSecondsBoottime(now)) {
+    LOG(ERROR) << "Unable to read the boottime clock";
+    return false;
+  }
+  return true;
+}
+
+}  // namespace shill
@@ -0,0 +1,118 @@
+// Copyright 2020 The Chromium OS Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef SHILL_DNS_CACHE_H_
+#define SHILL_DNS_CACHE_H_
+
+#include <time.h>
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <base/callback.h>
+#include <base/macros.h>
+#include <base/no_destructor.h>
+
+#include "shill/error.h"
+#include "shill/net/ip_address.h"
+
+namespace shill {
+
+class Time;
+
+// DnsCache holds the results of recent DnsClient lookups so that repeated
+// portal checks and connection diagnostics on the same interface do not
+// re-query the network for every attempt.  Entries are keyed by interface,
+// address family, DNS servers and hostname, so a change of DNS servers never
+// returns a stale answer.  Answers are held for their record TTL, capped so
+// that a captive portal's hijacked answers don't linger.  Definitive negative
+// answers (NXDOMAIN, NODATA) are cached for a short fixed time; timeouts and
+// other transport failures are never cached since they are what connectivity
+// checks are trying to observe.
+//
+// DnsCache also deduplicates concurrent lookups of the same key: while one
+// DnsClient has a query in flight, others wait for its result.
+class DnsCache {
+ public:
+  using ResultCallback = base::Callback<void(const Error&, const IPAddress&)>;
+
+  // Upper bound on how long an answer is held, whatever its TTL.
+  static const time_t kMaxPositiveLifetimeSeconds;
+  // Lifetime of negative answers, whose TTL c-ares does not report.
+  static const time_t kNegativeLifetimeSeconds;
+
+  // This is a singleton. Use DnsCache::GetInstance()->Foo().
+  static DnsCache* GetInstance();
+
+  explicit DnsCache(Time* time);
+  virtual ~DnsCache();
+
+  static std::string MakeKey(const std::string& interface_name,
+                             IPAddress::Family family,
+                             const std::vector<std::string>& dns_servers,
+                             const std::string& hostname);
+
+  // Returns true and fills |error| and |address| if an unexpired result for
+  // |key| is cached.
+  bool Lookup(const std::string& key, Error* error, IPAddress* address);
+
+  // Returns true if a lookup of |key| is already in flight, in which case
+  // |on_result| will be run with its result, or |on_abandoned| if the lookup
+  // is abandoned before completing.  Returns false, and marks the caller as
+  // the owner of a new in-flight lookup of |key|, otherwise.
+  bool JoinOrStartLookup(const std::string& key,
+                         const ResultCallback& on_result,
+                         const base::Closure& on_abandoned);
+
+  // Called by the owner of the in-flight lookup of |key| when it completes.
+  // Caches the result if it is cacheable and runs every waiter.  A successful
+  // |address| is cached for min(|ttl_seconds|, kMaxPositiveLifetimeSeconds).
+  void CompleteLookup(const std::string& key,
+                      const Error& error,
+                      const IPAddress& address,
+                      time_t ttl_seconds);
+
+  // Called by the owner of the in-flight lookup of |key| when it is stopped
+  // before completing.
+  void AbandonLookup(const std::string& key);
+
+  // Drops all cached results for |interface_name|.
+  void FlushInterface(const std::string& interface_name);
+
+  uint64_t hits() const { return hits_; }
+  uint64_t negative_hits() const { return negative_hits_; }
+  uint64_t misses() const { return misses_; }
+  uint64_t deduplicated() const { return deduplicated_; }
+
+ private:
+  friend class base::NoDestructor<DnsCache>;
+  friend class DnsCacheTest;
+
+  // Error is not copyable, so entries keep its parts.
+  struct Entry {
+    Error::Type error_type;
+    std::string error_message;
+    IPAddress address;
+    time_t expiry_seconds;
+  };
+  using Waiter = std::pair<ResultCallback, base::Closure>;
+
+  bool GetNow(time_t* now);
+
+  Time* time_;
+  std::map<std::string, Entry> entries_;
+  std::map<std::string, std::vector<Waiter>> in_flight_;
+  uint64_t hits_;
+  uint64_t negative_hits_;
+  uint64_t misses_;
+  uint64_t deduplicated_;
+
+  DISALLOW_COPY_AND_ASSIGN(DnsCache);
+};
+
+}  // namespace shill
+
+#endif  // SHILL_DNS_CACHE_H_
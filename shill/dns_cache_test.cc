@@ -0,0 +1,205 @@
+// Copyright 2020 The Chromium OS Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "shill/dns_cache.h"
+
+#include <string>
+#include <vector>
+
+#include <base/bind.h>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "shill/dns_client.h"
+#include "shill/net/mock_time.h"
+
+using base::Bind;
+using base::Unretained;
+using std::string;
+using std::vector;
+using testing::_;
+using testing::DoAll;
+using testing::Return;
+using testing::SetArgPointee;
+using testing::Test;
+
+namespace shill {
+
+namespace {
+const char kInterface[] = "eth0";
+const char kHostname[] = "www.gstatic.com";
+const char kAddress[] = "192.0.2.1";
+const char kServer[] = "8.8.8.8";
+const time_t kTtlSeconds = 30;
+}  // namespace
+
+class DnsCacheTest : public Test {
+ public:
+  DnsCacheTest()
+      : cache_(&time_),
+        key_(DnsCache::MakeKey(kInterface,
+                               IPAddress::kFamilyIPv4,
+                               {kServer},
+                               kHostname)),
+        results_(0),
+        abandoned_(0) {}
+
+  void SetUp() override { SetNow(1000); }
+
+  void SetNow(time_t now) {
+    EXPECT_CALL(time_, GetSecondsBoottime(_))
+        .WillRepeatedly(DoAll(SetArgPointee<0>(now), Return(true)));
+  }
+
+  void OnResult(const Error& error, const IPAddress& address) {
+    results_++;
+    last_error_type_ = error.type();
+  }
+
+  void OnAbandoned() { abandoned_++; }
+
+  bool Join() {
+    return cache_.JoinOrStartLookup(
+        key_, Bind(&DnsCacheTest::OnResult, Unretained(this)),
+        Bind(&DnsCacheTest::OnAbandoned, Unretained(this)));
+  }
+
+  size_t EntryCount() const { return cache_.entries_.size(); }
+
+ protected:
+  MockTime time_;
+  DnsCache cache_;
+  const string key_;
+  int results_;
+  int abandoned_;
+  Error::Type last_error_type_;
+};
+
+TEST_F(DnsCacheTest, KeyIncludesServersAndIgnoresCase) {
+  EXPECT_NE(key_, DnsCache::MakeKey(kInterface, IPAddress::kFamilyIPv4,
+                                    {"8.8.4.4"}, kHostname));
+  EXPECT_NE(key_, DnsCache::MakeKey(kInterface, IPAddress::kFamilyIPv6,
+                                    {kServer}, kHostname));
+  EXPECT_EQ(key_, DnsCache::MakeKey(kInterface, IPAddress::kFamilyIPv4,
+                                    {kServer}, "WWW.gstatic.com"));
+}
+
+TEST_F(DnsCacheTest, PositiveResultExpires) {
+  Error error;
+  IPAddress address(IPAddress::kFamilyIPv4);
+  EXPECT_FALSE(cache_.Lookup(key_, &error, &address));
+
+  EXPECT_FALSE(Join());
+  cache_.CompleteLookup(key_, Error(), IPAddress(kAddress), kTtlSeconds);
+
+  SetNow(1000 + kTtlSeconds - 1);
+  EXPECT_TRUE(cache_.Lookup(key_, &error, &address));
+  EXPECT_TRUE(error.IsSuccess());
+  EXPECT_TRUE(address.Equals(IPAddress(kAddress)));
+
+  SetNow(1000 + kTtlSeconds);
+  EXPECT_FALSE(cache_.Lookup(key_, &error, &address));
+  EXPECT_EQ(0u, EntryCount());
+  EXPECT_EQ(1u, cache_.hits());
+  EXPECT_EQ(2u, cache_.misses());
+}
+
+TEST_F(DnsCacheTest, LongTtlIsCapped) {
+  Error error;
+  IPAddress address(IPAddress::kFamilyIPv4);
+
+  EXPECT_FALSE(Join());
+  cache_.CompleteLookup(key_, Error(), IPAddress(kAddress),
+                        DnsCache::kMaxPositiveLifetimeSeconds * 10);
+  SetNow(1000 + DnsCache::kMaxPositiveLifetimeSeconds - 1);
+  EXPECT_TRUE(cache_.Lookup(key_, &error, &address));
+  SetNow(1000 + DnsCache::kMaxPositiveLifetimeSeconds);
+  EXPECT_FALSE(cache_.Lookup(key_, &error, &address));
+}
+
+TEST_F(DnsCacheTest, ZeroTtlIsNotCached) {
+  Error error;
+  IPAddress address(IPAddress::kFamilyIPv4);
+
+  EXPECT_FALSE(Join());
+  EXPECT_TRUE(Join());
+  cache_.CompleteLookup(key_, Error(), IPAddress(kAddress), 0);
+  // Waiters still get the answer.
+  EXPECT_EQ(1, results_);
+  EXPECT_FALSE(cache_.Lookup(key_, &error, &address));
+  EXPECT_EQ(0u, EntryCount());
+}
+
+TEST_F(DnsCacheTest, OnlyDefinitiveFailuresAreCached) {
+  Error error;
+  IPAddress address(IPAddress::kFamilyIPv4);
+
+  EXPECT_FALSE(Join());
+  cache_.CompleteLookup(
+      key_, Error(Error::kOperationTimeout, DnsClient::kErrorTimedOut),
+      IPAddress(IPAddress::kFamilyIPv4), 0);
+  EXPECT_FALSE(cache_.Lookup(key_, &error, &address));
+
+  EXPECT_FALSE(Join());
+  cache_.CompleteLookup(
+      key_, Error(Error::kOperationFailed, DnsClient::kErrorServerFail),
+      IPAddress(IPAddress::kFamilyIPv4), 0);
+  EXPECT_FALSE(cache_.Lookup(key_, &error, &address));
+
+  EXPECT_FALSE(Join());
+  cache_.CompleteLookup(
+      key_, Error(Error::kOperationFailed, DnsClient::kErrorNotFound),
+      IPAddress(IPAddress::kFamilyIPv4), 0);
+  EXPECT_TRUE(cache_.Lookup(key_, &error, &address));
+  EXPECT_EQ(Error::kOperationFailed, error.type());
+  EXPECT_EQ(DnsClient::kErrorNotFound, error.message());
+  EXPECT_EQ(1u, cache_.negative_hits());
+
+  SetNow(1000 + DnsCache::kNegativeLifetimeSeconds);
+  EXPECT_FALSE(cache_.Lookup(key_, &error, &address));
+}
+
+TEST_F(DnsCacheTest, ConcurrentLookupsShareResult) {
+  EXPECT_FALSE(Join());
+  EXPECT_TRUE(Join());
+  EXPECT_TRUE(Join());
+  EXPECT_EQ(2u, cache_.deduplicated());
+
+  cache_.CompleteLookup(key_, Error(), IPAddress(kAddress), kTtlSeconds);
+  EXPECT_EQ(2, results_);
+  EXPECT_EQ(Error::kSuccess, last_error_type_);
+  EXPECT_EQ(0, abandoned_);
+
+  // The lookup is no longer in flight.
+  EXPECT_FALSE(Join());
+}
+
+TEST_F(DnsCacheTest, AbandonedLookupNotifiesWaiters) {
+  EXPECT_FALSE(Join());
+  EXPECT_TRUE(Join());
+  cache_.AbandonLookup(key_);
+  EXPECT_EQ(0, results_);
+  EXPECT_EQ(1, abandoned_);
+  EXPECT_EQ(0u, EntryCount());
+  EXPECT_FALSE(Join());
+}
+
+TEST_F(DnsCacheTest, FlushInterface) {
+  const string other_key = DnsCache::MakeKey("eth1", IPAddress::kFamilyIPv4,
+                                             {kServer}, kHostname);
+  EXPECT_FALSE(Join());
+  cache_.CompleteLookup(key_, Error(), IPAddress(kAddress), kTtlSeconds);
+  EXPECT_FALSE(cache_.JoinOrStartLookup(other_key, DnsCache::ResultCallback(),
+                                        base::Closure()));
+  cache_.CompleteLookup(other_key, Error(), IPAddress(kAddress), kTtlSeconds);
+  EXPECT_EQ(2u, EntryCount());
+
+  cache_.FlushInterface(kInterface);
+  EXPECT_EQ(1u, EntryCount());
+  Error error;
+  IPAddress address(IPAddress::kFamilyIPv4);
+  EXPECT_TRUE(cache_.Lookup(other_key, &error, &address));
+}
+
+}  // namespace shill
@@ -5,6 +5,7 @@
 #include "shill/dns_client.h"
 
 #include <arpa/inet.h>
+#include <arpa/nameser.h>
 #include <netdb.h>
 #include <netinet/in.h>
 #include <sys/socket.h>
@@ -23,6 +24,7 @@
 #include <base/strings/string_number_conversions.h>
 #include <base/strings/string_util.h>
 
+#include "shill/dns_cache.h"
 #include "shill/logging.h"
 #include "shill/net/io_handler.h"
 #include "shill/net/io_handler_factory.h"
@@ -95,7 +97,9 @@ DnsClient::DnsClient(IPAddress::Family family,
       running_(false),
       weak_ptr_factory_(this),
       ares_(Ares::GetInstance()),
-      time_(Time::GetInstance()) {}
+      time_(Time::GetInstance()),
+      cache_(nullptr),
+      ttl_seconds_(0) {}
 
 DnsClient::~DnsClient() {
   Stop();
@@ -108,6 +112,45 @@ bool DnsClient::Start(const string& hostname, Error* error) {
     return false;
   }
 
+  if (cache_) {
+    // Cached lookups don't go through ares_gethostbyname(), so answer IP
+    // literals here as it would, without a query.
+    IPAddress literal(address_.family());
+    if (literal.SetAddressFromString(hostname)) {
+      running_ = true;
+      HandleCachedResult(Error(), literal);
+      return true;
+    }
+
+    const string key = DnsCache::MakeKey(interface_name_, address_.family(),
+                                         dns_servers_, hostname);
+    Error cached_error;
+    IPAddress cached_address(address_.family());
+    if (cache_->Lookup(key, &cached_error, &cached_address)) {
+      running_ = true;
+      HandleCachedResult(cached_error, cached_address);
+      return true;
+    }
+    if (cache_->JoinOrStartLookup(
+            key,
+            Bind(&DnsClient::HandleCachedResult,
+                 weak_ptr_factory_.GetWeakPtr()),
+            Bind(&DnsClient::HandleLookupAbandoned,
+                 weak_ptr_factory_.GetWeakPtr(), hostname))) {
+      running_ = true;
+      return true;
+    }
+    cache_key_ = key;
+  }
+
+  if (!StartQuery(hostname, error)) {
+    AbandonCacheLookup();
+    return false;
+  }
+  return true;
+}
+
+bool DnsClient::StartQuery(const string& hostname, Error* error) {
   if (!resolver_state_) {
     struct ares_options options;
     memset(&options, 0, sizeof(options));
@@ -151,9 +194,28 @@ bool DnsClient::Start(const string& hostname, Error* error) {
   }
 
   running_ = true;
+  ttl_seconds_ = 0;
   time_->GetTimeMonotonic(&resolver_state_->start_time);
-  ares_->GetHostByName(resolver_state_->channel, hostname.c_str(),
-                       address_.family(), ReceiveDnsReplyCB, this);
+  if (cache_) {
+    // ares_gethostbyname() doesn't report TTLs, which the cache needs, so
+    // query the address records directly. Like ares_gethostbyname(), look in
+    // the hosts file first; its answers have no TTL so are never cached.
+    struct hostent* hostent = nullptr;
+    if (ares_->GetHostByNameFile(resolver_state_->channel, hostname.c_str(),
+                                 address_.family(),
+                                 &hostent) == ARES_SUCCESS) {
+      ReceiveDnsReply(ARES_SUCCESS, hostent);
+      ares_->FreeHostent(hostent);
+      return true;
+    }
+    ares_->Search(resolver_state_->channel, hostname.c_str(), ns_c_in,
+                  address_.family() == IPAddress::kFamilyIPv6 ? ns_t_aaaa
+                                                              : ns_t_a,
+                  ReceiveDnsAnswerCB, this);
+  } else {
+    ares_->GetHostByName(resolver_state_->channel, hostname.c_str(),
+                         address_.family(), ReceiveDnsReplyCB, this);
+  }
 
   if (!RefreshHandles()) {
     LOG(ERROR) << interface_name_ << ": Impossibly short timeout.";
@@ -167,7 +229,8 @@ bool DnsClient::Start(const string& hostname, Error* error) {
 
 void DnsClient::Stop() {
   SLOG(this, 3) << "In " << __func__;
-  if (!resolver_state_) {
+  AbandonCacheLookup();
+  if (!resolver_state_ && !running_) {
     return;
   }
 
@@ -175,23 +238,63 @@ void DnsClient::Stop() {
   weak_ptr_factory_.InvalidateWeakPtrs();
   error_.Reset();
   address_.SetAddressToDefault();
-  ares_->Destroy(resolver_state_->channel);
-  resolver_state_ = nullptr;
+  if (resolver_state_) {
+    ares_->Destroy(resolver_state_->channel);
+    resolver_state_ = nullptr;
+  }
 }
 
 bool DnsClient::IsActive() const {
   return running_;
 }
 
+void DnsClient::AbandonCacheLookup() {
+  if (cache_key_.empty()) {
+    return;
+  }
+  string key;
+  key.swap(cache_key_);
+  cache_->AbandonLookup(key);
+}
+
+// Results from the cache are delivered through the same deferred completion
+// as those from the resolver, so callers never see their callback run from
+// within Start().
+void DnsClient::HandleCachedResult(const Error& error,
+                                   const IPAddress& address) {
+  SLOG(this, 3) << "In " << __func__;
+  error_.CopyFrom(error);
+  address_ = address;
+  dispatcher_->PostTask(FROM_HERE, Bind(&DnsClient::HandleCompletion,
+                                        weak_ptr_factory_.GetWeakPtr()));
+}
+
+// The client whose query we were waiting on was stopped, so issue our own.
+void DnsClient::HandleLookupAbandoned(const string& hostname) {
+  SLOG(this, 3) << "In " << __func__;
+  running_ = false;
+  Error error;
+  if (!Start(hostname, &error)) {
+    running_ = true;
+    HandleCachedResult(error, IPAddress(address_.family()));
+  }
+}
+
 // We delay our call to completion so that we exit all IOHandlers, and
 // can clean up all of our local state before calling the callback, or
 // during the process of the execution of the callee (which is free to
 // call our destructor safely).
 void DnsClient::HandleCompletion() {
   SLOG(this, 3) << "In " << __func__;
+  running_ = false;
   Error error;
   error.CopyFrom(error_);
   IPAddress address(address_);
+  if (!cache_key_.empty()) {
+    string key;
+    key.swap(cache_key_);
+    cache_->CompleteLookup(key, error, address, ttl_seconds_);
+  }
   if (!error.IsSuccess()) {
     // If the DNS request did not succeed, do not trust it for future
     // attempts.
@@ -294,6 +397,47 @@ void DnsClient::ReceiveDnsReplyCB(void* arg,
   res->ReceiveDnsReply(status, hostent);
 }
 
+void DnsClient::ReceiveDnsAnswer(int status, unsigned char* abuf, int alen) {
+  if (!running_) {
+    // We can be called during ARES shutdown -- ignore these events.
+    return;
+  }
+
+  struct hostent* hostent = nullptr;
+  if (status == ARES_SUCCESS) {
+    // Only the first address is used, so only its TTL is needed.
+    int naddrttls = 1;
+    if (address_.family() == IPAddress::kFamilyIPv6) {
+      struct ares_addr6ttl addrttl;
+      status =
+          ares_->ParseAaaaReply(abuf, alen, &hostent, &addrttl, &naddrttls);
+      if (status == ARES_SUCCESS && naddrttls > 0) {
+        ttl_seconds_ = addrttl.ttl;
+      }
+    } else {
+      struct ares_addrttl addrttl;
+      status = ares_->ParseAReply(abuf, alen, &hostent, &addrttl, &naddrttls);
+      if (status == ARES_SUCCESS && naddrttls > 0) {
+        ttl_seconds_ = addrttl.ttl;
+      }
+    }
+  }
+
+  ReceiveDnsReply(status, hostent);
+  if (hostent) {
+    ares_->FreeHostent(hostent);
+  }
+}
+
+void DnsClient::ReceiveDnsAnswerCB(void* arg,
+                                   int status,
+                                   int /*timeouts*/,
+                                   unsigned char* abuf,
+                                   int alen) {
+  DnsClient* res = static_cast<DnsClient*>(arg);
+  res->ReceiveDnsAnswer(status, abuf, alen);
+}
+
 bool DnsClient::RefreshHandles() {
   IOHandlerMap old_read(std::move(resolver_state_->read_handlers));
   IOHandlerMap old_write(std::move(resolver_state_->write_handlers));
@@ -5,6 +5,8 @@
 #ifndef SHILL_DNS_CLIENT_H_
 #define SHILL_DNS_CLIENT_H_
 
+#include <time.h>
+
 #include <memory>
 #include <string>
 #include <vector>
@@ -24,6 +26,7 @@ struct hostent;
 namespace shill {
 
 class Ares;
+class DnsCache;
 class IOHandlerFactory;
 class Time;
 struct DnsClientState;
@@ -69,9 +72,18 @@ class DnsClient {
 
   std::string interface_name() const { return interface_name_; }
 
+  // Lets this client answer from, and contribute to, |cache|.  Callers that
+  // need to observe the network itself (e.g. DNS server probes) should not
+  // set a cache.
+  void set_cache(DnsCache* cache) { cache_ = cache; }
+
  private:
   friend class DnsClientTest;
 
+  bool StartQuery(const std::string& hostname, Error* error);
+  void AbandonCacheLookup();
+  void HandleCachedResult(const Error& error, const IPAddress& address);
+  void HandleLookupAbandoned(const std::string& hostname);
   void HandleCompletion();
   void HandleDnsRead(int fd);
   void HandleDnsWrite(int fd);
@@ -81,6 +93,12 @@ class DnsClient {
                                 int status,
                                 int timeouts,
                                 struct hostent* hostent);
+  void ReceiveDnsAnswer(int status, unsigned char* abuf, int alen);
+  static void ReceiveDnsAnswerCB(void* arg,
+                                 int status,
+                                 int timeouts,
+                                 unsigned char* abuf,
+                                 int alen);
   bool RefreshHandles();
 
   Error error_;
@@ -97,6 +115,12 @@ class DnsClient {
   base::WeakPtrFactory<DnsClient> weak_ptr_factory_;
   Ares* ares_;
   Time* time_;
+  DnsCache* cache_;
+  // Key of the cache lookup this client owns, if any.
+  std::string cache_key_;
+  // TTL of the answer being completed, only known for queries issued on
+  // behalf of |cache_|.
+  time_t ttl_seconds_;
 
   DISALLOW_COPY_AND_ASSIGN(DnsClient);
 };
@@ -13,6 +13,7 @@
 #include <base/bind.h>
 #include <base/strings/stringprintf.h>
 
+#include "shill/dns_cache.h"
 #include "shill/error.h"
 #include "shill/event_dispatcher.h"
 #include "shill/mock_ares.h"
@@ -29,6 +30,7 @@ using std::string;
 using std::vector;
 using testing::_;
 using testing::DoAll;
+using testing::Invoke;
 using testing::Not;
 using testing::Return;
 using testing::ReturnArg;
@@ -48,6 +50,8 @@ const char kBadServer[] = "10.9xx8.7";
 const char kNetworkInterface[] = "eth0";
 char kReturnAddressList0[] = {static_cast<char>(224), 0, 0, 1};
 char* kReturnAddressList[] = {kReturnAddressList0, nullptr};
+unsigned char kAnswer[] = {0};
+const int kAnswerTtlSeconds = 30;
 char kFakeAresChannelData = 0;
 const ares_channel kAresChannel =
     reinterpret_cast<ares_channel>(&kFakeAresChannelData);
@@ -59,7 +63,9 @@ const int kAresWaitMS = 1000;     // Time period ARES asks caller to wait
 class DnsClientTest : public Test {
  public:
   DnsClientTest()
-      : ares_result_(ARES_SUCCESS), address_result_(IPAddress::kFamilyUnknown) {
+      : cache_(nullptr),
+        ares_result_(ARES_SUCCESS),
+        address_result_(IPAddress::kFamilyUnknown) {
     time_val_.tv_sec = 0;
     time_val_.tv_usec = 0;
     ares_timeout_.tv_sec = kAresWaitMS / 1000;
@@ -91,10 +97,26 @@ class DnsClientTest : public Test {
   }
 
   void CallReplyCB() {
+    if (cache_) {
+      dns_client_->ReceiveDnsAnswerCB(dns_client_.get(), ares_result_, 0,
+                                      kAnswer, sizeof(kAnswer));
+      return;
+    }
     dns_client_->ReceiveDnsReplyCB(dns_client_.get(), ares_result_, 0,
                                    &hostent_);
   }
 
+  int ParseAReply(const unsigned char* /*abuf*/,
+                  int /*alen*/,
+                  struct hostent** host,
+                  struct ares_addrttl* addrttls,
+                  int* naddrttls) {
+    *host = &hostent_;
+    addrttls[0].ttl = kAnswerTtlSeconds;
+    *naddrttls = 1;
+    return ARES_SUCCESS;
+  }
+
   void CallDnsRead() { dns_client_->HandleDnsRead(kAresFd); }
 
   void CallDnsWrite() { dns_client_->HandleDnsWrite(kAresFd); }
@@ -110,6 +132,7 @@ class DnsClientTest : public Test {
     dns_client_->ares_ = &ares_;
     dns_client_->time_ = &time_;
     dns_client_->io_handler_factory_ = &io_handler_factory_;
+    dns_client_->set_cache(cache_);
   }
 
   void SetActive() {
@@ -135,7 +158,18 @@ class DnsClientTest : public Test {
         .WillOnce(Return(ARES_SUCCESS));
     EXPECT_CALL(ares_, SetLocalDev(kAresChannel, StrEq(kNetworkInterface)))
         .Times(1);
-    EXPECT_CALL(ares_, GetHostByName(kAresChannel, StrEq(name), _, _, _));
+    if (cache_) {
+      // Cached lookups check the hosts file, then query the records directly
+      // to learn their TTL.
+      EXPECT_CALL(ares_, GetHostByNameFile(kAresChannel, StrEq(name), _, _))
+          .WillOnce(Return(ARES_ENOTFOUND));
+      EXPECT_CALL(ares_, Search(kAresChannel, StrEq(name), _, _, _, _));
+      EXPECT_CALL(ares_, ParseAReply(kAnswer, _, _, _, _))
+          .WillRepeatedly(Invoke(this, &DnsClientTest::ParseAReply));
+      EXPECT_CALL(ares_, FreeHostent(&hostent_)).Times(testing::AnyNumber());
+    } else {
+      EXPECT_CALL(ares_, GetHostByName(kAresChannel, StrEq(name), _, _, _));
+    }
   }
 
   void StartValidRequest() {
@@ -210,6 +244,7 @@ class DnsClientTest : public Test {
   StrictMock<DnsCallbackTarget> callback_target_;
   StrictMock<MockAres> ares_;
   StrictMock<MockTime> time_;
+  DnsCache* cache_;
   struct timeval time_val_;
   struct timeval ares_timeout_;
   struct hostent hostent_;
@@ -296,6 +331,94 @@ TEST_F(DnsClientTest, GoodRequest) {
   TestValidCompletion();
 }
 
+// A second client for the same name and servers is answered from the cache
+// without touching the resolver.
+TEST_F(DnsClientTest, GoodRequestFromCache) {
+  MockTime cache_time;
+  EXPECT_CALL(cache_time, GetSecondsBoottime(_))
+      .WillRepeatedly(DoAll(SetArgPointee<0>(100), Return(true)));
+  DnsCache cache(&cache_time);
+  cache_ = &cache;
+  StartValidRequest();
+  TestValidCompletion();
+
+  CreateClient({kGoodServer}, kAresTimeoutMS);
+  ExpectPostCompletionTask();
+  Error error;
+  ASSERT_TRUE(dns_client_->Start(kGoodName, &error));
+  EXPECT_TRUE(dns_client_->IsActive());
+  EXPECT_CALL(callback_target_, CallTarget(IsSuccess(), _))
+      .WillOnce(Invoke(this, &DnsClientTest::SaveCallbackArgs));
+  CallCompletion();
+  EXPECT_FALSE(dns_client_->IsActive());
+  EXPECT_TRUE(IPAddress(kResult).Equals(address_result_));
+  EXPECT_EQ(1u, cache.hits());
+  dns_client_.reset();
+
+  // The answer is dropped once its TTL has passed.
+  EXPECT_CALL(cache_time, GetSecondsBoottime(_))
+      .WillRepeatedly(
+          DoAll(SetArgPointee<0>(100 + kAnswerTtlSeconds), Return(true)));
+  IPAddress address(IPAddress::kFamilyIPv4);
+  EXPECT_FALSE(cache.Lookup(
+      DnsCache::MakeKey(kNetworkInterface, IPAddress::kFamilyIPv4,
+                        {kGoodServer}, kGoodName),
+      &error, &address));
+}
+
+// IP literals are answered without the resolver or the cache.
+TEST_F(DnsClientTest, IpLiteralWithCache) {
+  MockTime cache_time;
+  DnsCache cache(&cache_time);
+  cache_ = &cache;
+  CreateClient({kGoodServer}, kAresTimeoutMS);
+  ExpectPostCompletionTask();
+  Error error;
+  ASSERT_TRUE(dns_client_->Start(kResult, &error));
+  EXPECT_TRUE(dns_client_->IsActive());
+  EXPECT_CALL(callback_target_, CallTarget(IsSuccess(), _))
+      .WillOnce(Invoke(this, &DnsClientTest::SaveCallbackArgs));
+  CallCompletion();
+  EXPECT_TRUE(IPAddress(kResult).Equals(address_result_));
+  EXPECT_EQ(0u, cache.hits());
+  EXPECT_EQ(0u, cache.misses());
+}
+
+// Names in the hosts file are answered from it without a query, and aren't
+// cached since the hosts file gives no TTL.
+TEST_F(DnsClientTest, HostsFileWithCache) {
+  MockTime cache_time;
+  EXPECT_CALL(cache_time, GetSecondsBoottime(_))
+      .WillRepeatedly(DoAll(SetArgPointee<0>(100), Return(true)));
+  DnsCache cache(&cache_time);
+  cache_ = &cache;
+  CreateClient({kGoodServer}, kAresTimeoutMS);
+  EXPECT_CALL(ares_, InitOptions(_, _, _))
+      .WillOnce(DoAll(SetArgPointee<0>(kAresChannel), Return(ARES_SUCCESS)));
+  EXPECT_CALL(ares_, SetServersCsv(_, StrEq(kGoodServer)))
+      .WillOnce(Return(ARES_SUCCESS));
+  EXPECT_CALL(ares_, SetLocalDev(kAresChannel, StrEq(kNetworkInterface)));
+  EXPECT_CALL(ares_, GetHostByNameFile(kAresChannel, StrEq(kGoodName),
+                                       IPAddress::kFamilyIPv4, _))
+      .WillOnce(DoAll(SetArgPointee<3>(&hostent_), Return(ARES_SUCCESS)));
+  EXPECT_CALL(ares_, FreeHostent(&hostent_));
+  ExpectPostCompletionTask();
+  Error error;
+  ASSERT_TRUE(dns_client_->Start(kGoodName, &error));
+  EXPECT_TRUE(error.IsSuccess());
+
+  EXPECT_CALL(callback_target_, CallTarget(IsSuccess(), _))
+      .WillOnce(Invoke(this, &DnsClientTest::SaveCallbackArgs));
+  CallCompletion();
+  EXPECT_TRUE(IPAddress(kResult).Equals(address_result_));
+  IPAddress address(IPAddress::kFamilyIPv4);
+  EXPECT_FALSE(cache.Lookup(
+      DnsCache::MakeKey(kNetworkInterface, IPAddress::kFamilyIPv4,
+                        {kGoodServer}, kGoodName),
+      &error, &address));
+  EXPECT_CALL(ares_, Destroy(kAresChannel));
+}
+
 TEST_F(DnsClientTest, GoodRequestWithTimeout) {
   StartValidRequest();
   // Insert an intermediate HandleTimeout callback.
@@ -12,6 +12,7 @@
 #include <base/time/time.h>
 #include <brillo/http/http_utils.h>
 
+#include "shill/dns_cache.h"
 #include "shill/dns_client.h"
 #include "shill/error.h"
 #include "shill/event_dispatcher.h"
@@ -66,6 +67,7 @@ HttpRequest::HttpRequest(EventDispatcher* dispatcher,
       request_id_(-1),
       server_port_(-1),
       is_running_(false) {
+  dns_client_->set_cache(DnsCache::GetInstance());
   if (allow_non_google_https) {
     transport_->UseCustomCertificate(
         brillo::http::Transport::Certificate::kNss);
@@ -204,6 +204,7 @@ Manager::Manager(ControlInterface* control_interface,
       last_default_physical_service_connected_(false),
       ephemeral_profile_(new EphemeralProfile(this)),
       use_startup_portal_list_(false),
+      full_sort_requested_(false),
       device_status_check_task_(
           Bind(&Manager::DeviceStatusCheckTask, base::Unretained(this))),
       pending_traffic_counter_request_(false),
@@ -400,6 +401,7 @@ void Manager::Stop() {
   device_info_.Stop();
   device_status_check_task_.Cancel();
   sort_services_task_.Cancel();
+  services_to_reposition_.clear();
   init_patchpanel_client_task_.Cancel();
   refresh_traffic_counter_task_.Cancel();
   if (metrics_) {
@@ -1405,7 +1407,7 @@ void Manager::RegisterService(const ServiceRefPtr& to_manage) {
     CHECK(to_manage->serial_number() != service->serial_number());
   }
   services_.push_back(to_manage);
-  SortServices();
+  RepositionService(to_manage);
 }
 
 void Manager::DeregisterService(const ServiceRefPtr& to_forget) {
@@ -1476,7 +1478,7 @@ void Manager::UpdateService(const ServiceRefPtr& to_update) {
     // persist its settings).
     PersistService(to_update);
   }
-  SortServices();
+  RepositionService(to_update);
 }
 
 void Manager::NotifyServiceStateChanged(const ServiceRefPtr& to_update) {
@@ -1743,6 +1745,7 @@ void Manager::HelpRegisterDerivedBool(const string& name,
 }
 
 void Manager::SortServices() {
+  full_sort_requested_ = true;
   // We might be called in the middle of a series of events that
   // may result in multiple calls to Manager::SortServices, or within
   // an outer loop that may also be traversing the services_ list.
@@ -1754,6 +1757,44 @@ void Manager::SortServices() {
   }
 }
 
+void Manager::RepositionService(const ServiceRefPtr& service) {
+  services_to_reposition_.insert(service);
+  if (sort_services_task_.IsCancelled()) {
+    sort_services_task_.Reset(
+        Bind(&Manager::SortServicesTask, weak_factory_.GetWeakPtr()));
+    dispatcher_->PostTask(FROM_HERE, sort_services_task_.callback());
+  }
+}
+
+bool Manager::CompareServices(const ServiceRefPtr& a, const ServiceRefPtr& b) {
+  ++service_sort_stats_.comparisons;
+  return Service::Compare(a, b, true /* compare connectivity */,
+                          technology_order_)
+      .first;
+}
+
+void Manager::RepositionServices() {
+  auto compare = [this](const ServiceRefPtr& a, const ServiceRefPtr& b) {
+    return CompareServices(a, b);
+  };
+  // Take all the changed services out in one pass first, so that each binary
+  // search below runs over services that are all in order. Services
+  // deregistered since they were queued are not in |services_|, so they are
+  // dropped here.
+  auto removed = std::stable_partition(
+      services_.begin(), services_.end(), [this](const ServiceRefPtr& s) {
+        return !base::Contains(services_to_reposition_, s);
+      });
+  std::vector<ServiceRefPtr> changed(removed, services_.end());
+  services_.erase(removed, services_.end());
+
+  for (const auto& service : changed) {
+    services_.insert(
+        std::upper_bound(services_.begin(), services_.end(), service, compare),
+        service);
+  }
+}
+
 void Manager::SortServicesTask() {
   SLOG(this, 4) << "In " << __func__;
   sort_services_task_.Cancel();
@@ -1761,11 +1802,41 @@ void Manager::SortServicesTask() {
   // Refresh all traffic counters before the sort.
   RefreshAllTrafficCountersTask();
 
-  sort(services_.begin(), services_.end(),
-       [&order = technology_order_](ServiceRefPtr a, ServiceRefPtr b) {
-         return Service::Compare(a, b, true /* compare connectivity */, order)
-             .first;
-       });
+  const base::TimeTicks start = base::TimeTicks::Now();
+  const uint64_t start_comparisons = service_sort_stats_.comparisons;
+  // Repositioning costs O(log n) comparisons per changed service, so it only
+  // pays off while few services have changed.
+  const size_t kMaxIncrementalRepositions = 8;
+  const bool incremental =
+      !full_sort_requested_ &&
+      services_to_reposition_.size() <= kMaxIncrementalRepositions;
+  if (incremental) {
+    RepositionServices();
+    ++service_sort_stats_.incremental_sorts;
+  } else {
+    sort(services_.begin(), services_.end(),
+         [this](const ServiceRefPtr& a, const ServiceRefPtr& b) {
+           return CompareServices(a, b);
+         });
+    ++service_sort_stats_.full_sorts;
+  }
+  full_sort_requested_ = false;
+  services_to_reposition_.clear();
+  service_sort_stats_.last_sort_time = base::TimeTicks::Now() - start;
+  service_sort_stats_.total_sort_time += service_sort_stats_.last_sort_time;
+  metrics_->NotifyServicesSorted(incremental,
+                                 service_sort_stats_.last_sort_time);
+  SLOG(this, 2) << __func__ << ": " << (incremental ? "incremental" : "full")
+                << " sort of " << services_.size() << " services took "
+                << service_sort_stats_.last_sort_time.InMicroseconds()
+                << " us and "
+                << service_sort_stats_.comparisons - start_comparisons
+                << " comparisons (totals: "
+                << service_sort_stats_.full_sorts << " full, "
+                << service_sort_stats_.incremental_sorts << " incremental, "
+                << service_sort_stats_.comparisons << " comparisons, "
+                << service_sort_stats_.total_sort_time.InMicroseconds()
+                << " us)";
 
   std::vector<IPAddress> vpn_addresses;
   for (const auto& service : services_) {
@@ -7,6 +7,7 @@
 
 #include <map>
 #include <memory>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -16,6 +17,7 @@
 #include <base/memory/ref_counted.h>
 #include <base/memory/weak_ptr.h>
 #include <base/observer_list.h>
+#include <base/time/time.h>
 #include <chromeos/dbus/service_constants.h>
 #include <chromeos/patchpanel/dbus/client.h>
 #include <gtest/gtest_prod.h>  // for FRIEND_TEST
@@ -132,10 +134,31 @@ class Manager {
   virtual void Stop();
   bool running() const { return running_; }
 
+  // Work done by SortServicesTask(), for judging the cost of service
+  // ranking under scan churn.
+  struct ServiceSortStats {
+    // Sorts that re-sorted the whole service list.
+    uint64_t full_sorts = 0;
+    // Sorts that only repositioned the services that changed.
+    uint64_t incremental_sorts = 0;
+    // Service::Compare() calls made by all sorts.
+    uint64_t comparisons = 0;
+    base::TimeDelta last_sort_time;
+    base::TimeDelta total_sort_time;
+  };
+
   // Requests for Services to be resorted; this method returns immediately
   // without actually performing the sorting.
   void SortServices();
 
+  // Like SortServices(), but only |service| is known to have changed, so that
+  // the pending sort may move just that service instead of re-sorting all.
+  void RepositionService(const ServiceRefPtr& service);
+
+  const ServiceSortStats& service_sort_stats() const {
+    return service_sort_stats_;
+  }
+
   virtual const ProfileRefPtr& ActiveProfile() const;
   bool IsActiveProfile(const ProfileRefPtr& profile) const;
   bool MoveServiceToProfile(const ServiceRefPtr& to_move,
@@ -664,6 +687,13 @@ class Manager {
   void OnProfilesChanged();
 
   void SortServicesTask();
+  // Strict weak ordering of services used for sorting |services_|; counts
+  // the comparisons made in |service_sort_stats_|.
+  bool CompareServices(const ServiceRefPtr& a, const ServiceRefPtr& b);
+  // Removes the services in |services_to_reposition_| from |services_| and
+  // inserts each at its place in the sorted remainder. Every other service
+  // must already be in order.
+  void RepositionServices();
   void DeviceStatusCheckTask();
   void ConnectionStatusCheck();
   void DevicePresenceStatusCheck();
@@ -817,6 +847,11 @@ class Manager {
   std::string accept_hostname_from_;
 
   base::CancelableClosure sort_services_task_;
+  // Services changed since the last sort. Unless |full_sort_requested_| is
+  // set, the next sort only needs to move these.
+  std::set<ServiceRefPtr> services_to_reposition_;
+  bool full_sort_requested_;
+  ServiceSortStats service_sort_stats_;
 
   // Task for periodically checking various device status.
   base::CancelableClosure device_status_check_task_;
@@ -2290,6 +2290,49 @@ TEST_F(ManagerTest, SortServicesWithConnection) {
   manager()->SortServicesTask();
 }
 
+TEST_F(ManagerTest, SortServicesIncrementally) {
+  MockServiceRefPtr mock_service0(new NiceMock<MockService>(manager()));
+  MockServiceRefPtr mock_service1(new NiceMock<MockService>(manager()));
+  MockServiceRefPtr mock_service2(new NiceMock<MockService>(manager()));
+  manager()->RegisterService(mock_service0);
+  manager()->RegisterService(mock_service1);
+  manager()->RegisterService(mock_service2);
+  CompleteServiceSort();
+  Manager::ServiceSortStats stats = manager()->service_sort_stats();
+
+  // Only the changed Service is moved.
+  mock_service2->SetPriority(1, nullptr);
+  manager()->RepositionService(mock_service2);
+  CompleteServiceSort();
+  EXPECT_EQ(stats.full_sorts, manager()->service_sort_stats().full_sorts);
+  EXPECT_EQ(stats.incremental_sorts + 1,
+            manager()->service_sort_stats().incremental_sorts);
+  EXPECT_LT(stats.comparisons, manager()->service_sort_stats().comparisons);
+  EXPECT_TRUE(ServiceOrderIs(mock_service2, mock_service0));
+  stats = manager()->service_sort_stats();
+
+  // An explicit request always re-sorts everything.
+  manager()->SortServices();
+  CompleteServiceSort();
+  EXPECT_EQ(stats.full_sorts + 1, manager()->service_sort_stats().full_sorts);
+  EXPECT_EQ(stats.incremental_sorts,
+            manager()->service_sort_stats().incremental_sorts);
+  stats = manager()->service_sort_stats();
+
+  // Several Services changed at once are each moved into place, and the
+  // sort is reported to UMA.
+  mock_service0->SetPriority(3, nullptr);
+  mock_service1->SetPriority(2, nullptr);
+  manager()->RepositionService(mock_service0);
+  manager()->RepositionService(mock_service1);
+  EXPECT_CALL(*metrics(), NotifyServicesSorted(true, _));
+  CompleteServiceSort();
+  EXPECT_EQ(stats.full_sorts, manager()->service_sort_stats().full_sorts);
+  EXPECT_EQ(stats.incremental_sorts + 1,
+            manager()->service_sort_stats().incremental_sorts);
+  EXPECT_TRUE(ServiceOrderIs(mock_service0, mock_service1));
+}
+
 TEST_F(ManagerTest, UpdateDefaultServices) {
   EXPECT_EQ(GetDefaultServiceObserverCount(), 0);
 
@@ -445,6 +445,15 @@ const int Metrics::kMetricServicesOnSameNetworkMax = 20;
 const int Metrics::kMetricServicesOnSameNetworkMin = 1;
 const int Metrics::kMetricServicesOnSameNetworkNumBuckets = 10;
 
+// Time taken by Manager to sort its services, by kind of sort.
+const char Metrics::kMetricServiceSortTimeMicrosecondsFull[] =
+    "Network.Shill.ServiceSortTime.Full";
+const char Metrics::kMetricServiceSortTimeMicrosecondsIncremental[] =
+    "Network.Shill.ServiceSortTime.Incremental";
+const int Metrics::kMetricServiceSortTimeMicrosecondsMax = 100 * 1000;
+const int Metrics::kMetricServiceSortTimeMicrosecondsMin = 1;
+const int Metrics::kMetricServiceSortTimeMicrosecondsNumBuckets = 50;
+
 // static
 const char Metrics::kMetricUserInitiatedEvents[] =
     "Network.Shill.UserInitiatedEvents";
@@ -1629,6 +1638,15 @@ void Metrics::NotifyServicesOnSameNetwork(int num_services) {
             kMetricServicesOnSameNetworkNumBuckets);
 }
 
+void Metrics::NotifyServicesSorted(bool incremental,
+                                   base::TimeDelta sort_time) {
+  SendToUMA(incremental ? kMetricServiceSortTimeMicrosecondsIncremental
+                        : kMetricServiceSortTimeMicrosecondsFull,
+            sort_time.InMicroseconds(), kMetricServiceSortTimeMicrosecondsMin,
+            kMetricServiceSortTimeMicrosecondsMax,
+            kMetricServiceSortTimeMicrosecondsNumBuckets);
+}
+
 void Metrics::NotifyUserInitiatedEvent(int event) {
   SendEnumToUMA(kMetricUserInitiatedEvents, event, kUserInitiatedEventMax);
 }
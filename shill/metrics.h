@@ -11,6 +11,7 @@
 #include <string>
 #include <vector>
 
+#include <base/time/time.h>
 #include <metrics/cumulative_metrics.h>
 #include <metrics/metrics_library.h>
 #include <metrics/timer.h>
@@ -859,6 +860,13 @@ class Metrics : public DefaultServiceObserver {
   static const int kMetricServicesOnSameNetworkMin;
   static const int kMetricServicesOnSameNetworkNumBuckets;
 
+  // Time taken by Manager to sort its services, by kind of sort.
+  static const char kMetricServiceSortTimeMicrosecondsFull[];
+  static const char kMetricServiceSortTimeMicrosecondsIncremental[];
+  static const int kMetricServiceSortTimeMicrosecondsMax;
+  static const int kMetricServiceSortTimeMicrosecondsMin;
+  static const int kMetricServiceSortTimeMicrosecondsNumBuckets;
+
   // Metric for user-initiated events.
   static const char kMetricUserInitiatedEvents[];
 
@@ -1182,6 +1190,11 @@ class Metrics : public DefaultServiceObserver {
   // currently connected network.
   virtual void NotifyServicesOnSameNetwork(int num_services);
 
+  // Notifies this object that Manager sorted its services, either fully or
+  // by only repositioning the services that changed, in |sort_time|.
+  virtual void NotifyServicesSorted(bool incremental,
+                                    base::TimeDelta sort_time);
+
   // Notifies this object about WIFI TX bitrate in Mbps.
   virtual void NotifyWifiTxBitrate(int bitrate);
 
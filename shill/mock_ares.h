@@ -22,6 +22,31 @@ class MockAres : public Ares {
               GetHostByName,
               (ares_channel, const char*, int, ares_host_callback, void*),
               (override));
+  MOCK_METHOD(int,
+              GetHostByNameFile,
+              (ares_channel, const char*, int, struct hostent**),
+              (override));
+  MOCK_METHOD(void,
+              Search,
+              (ares_channel, const char*, int, int, ares_callback, void*),
+              (override));
+  MOCK_METHOD(int,
+              ParseAReply,
+              (const unsigned char*,
+               int,
+               struct hostent**,
+               struct ares_addrttl*,
+               int*),
+              (override));
+  MOCK_METHOD(int,
+              ParseAaaaReply,
+              (const unsigned char*,
+               int,
+               struct hostent**,
+               struct ares_addr6ttl*,
+               int*),
+              (override));
+  MOCK_METHOD(void, FreeHostent, (struct hostent*), (override));
   MOCK_METHOD(int, GetSock, (ares_channel, ares_socket_t*, int), (override));
   MOCK_METHOD(int,
               InitOptions,
@@ -57,6 +57,7 @@ class MockMetrics : public Metrics {
   MOCK_METHOD(void, NotifyWifiAutoConnectableServices, (int), (override));
   MOCK_METHOD(void, NotifyWifiAvailableBSSes, (int), (override));
   MOCK_METHOD(void, NotifyServicesOnSameNetwork, (int), (override));
+  MOCK_METHOD(void, NotifyServicesSorted, (bool, base::TimeDelta), (override));
   MOCK_METHOD(void, NotifyUserInitiatedEvent, (int), (override));
   MOCK_METHOD(void, NotifyWifiTxBitrate, (int), (override));
   MOCK_METHOD(void,
@@ -22,6 +22,10 @@ class MockSocketInfoReader : public SocketInfoReader {
   ~MockSocketInfoReader() override;
 
   MOCK_METHOD(bool, LoadTcpSocketInfo, (std::vector<SocketInfo>*), (override));
+  MOCK_METHOD(bool,
+              LoadEstablishedTcpSocketInfo,
+              (const std::vector<IPAddress>&, std::vector<SocketInfo>*),
+              (override));
 
  private:
   DISALLOW_COPY_AND_ASSIGN(MockSocketInfoReader);
@@ -25,7 +25,11 @@ NetlinkPacket::NetlinkPacket(const unsigned char* buf, size_t len)
     return;
   }
 
-  payload_.reset(new ByteString(buf + sizeof(header_), len - sizeof(header_)));
+  // Only copy this message's payload; |buf| may hold the rest of a
+  // multi-message datagram (e.g. an nl80211 dump), which the caller parses
+  // separately.
+  payload_.reset(new ByteString(buf + sizeof(header_),
+                                header_.nlmsg_len - sizeof(header_)));
 }
 
 NetlinkPacket::~NetlinkPacket() {}
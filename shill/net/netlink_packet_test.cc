@@ -126,4 +126,31 @@ TEST_F(NetlinkPacketTest, ConsumeData) {
   EXPECT_EQ(0, packet.GetRemainingLength());
 }
 
+TEST_F(NetlinkPacketTest, MultipleMessagesInBuffer) {
+  // Two messages back to back, as in a multi-part dump datagram.  Each
+  // packet only covers its own message.
+  unsigned char data[2 * (sizeof(nlmsghdr) + 4)];
+  memset(data, 0, sizeof(data));
+  nlmsghdr hdr;
+  memset(&hdr, 0, sizeof(hdr));
+  hdr.nlmsg_len = sizeof(nlmsghdr) + 4;
+  hdr.nlmsg_type = 1;
+  memcpy(data, &hdr, sizeof(hdr));
+  hdr.nlmsg_type = 2;
+  memcpy(data + hdr.nlmsg_len, &hdr, sizeof(hdr));
+
+  NetlinkPacket first(data, sizeof(data));
+  EXPECT_TRUE(first.IsValid());
+  EXPECT_EQ(1, first.GetMessageType());
+  EXPECT_EQ(hdr.nlmsg_len, first.GetLength());
+  EXPECT_EQ(4, first.GetRemainingLength());
+  EXPECT_EQ(4, first.GetPayload().GetLength());
+
+  NetlinkPacket second(data + first.GetLength(),
+                       sizeof(data) - first.GetLength());
+  EXPECT_TRUE(second.IsValid());
+  EXPECT_EQ(2, second.GetMessageType());
+  EXPECT_EQ(4, second.GetRemainingLength());
+}
+
 }  // namespace shill
@@ -46,6 +46,56 @@ SockDiagRequest CreateDumpRequest(uint8_t family,
   return request;
 }
 
+// Builds a SOCK_DIAG_BY_FAMILY dump request for sockets in |states| carrying
+// an INET_DIAG_REQ_BYTECODE filter that only accepts sockets whose source
+// address is |saddr|, so that the kernel skips everything else.
+std::vector<uint8_t> CreateFilteredDumpRequest(uint8_t family,
+                                               uint8_t protocol,
+                                               uint32_t states,
+                                               const shill::IPAddress& saddr,
+                                               int sequence_number) {
+  const size_t addr_len = saddr.GetLength();
+  const size_t bytecode_len = sizeof(struct inet_diag_bc_op) +
+                              sizeof(struct inet_diag_hostcond) + addr_len;
+  const size_t attr_len = NLA_HDRLEN + bytecode_len;
+  const size_t msg_len =
+      NLMSG_ALIGN(NLMSG_LENGTH(sizeof(struct inet_diag_req_v2))) +
+      NLA_ALIGN(attr_len);
+
+  std::vector<uint8_t> buffer(msg_len, 0);
+  auto* header = reinterpret_cast<struct nlmsghdr*>(buffer.data());
+  header->nlmsg_len = msg_len;
+  header->nlmsg_type = SOCK_DIAG_BY_FAMILY;
+  header->nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+  header->nlmsg_seq = sequence_number;
+
+  auto* req = reinterpret_cast<struct inet_diag_req_v2*>(NLMSG_DATA(header));
+  req->sdiag_family = family;
+  req->sdiag_protocol = protocol;
+  req->idiag_states = states;
+
+  uint8_t* attr_start = buffer.data() +
+      NLMSG_ALIGN(NLMSG_LENGTH(sizeof(struct inet_diag_req_v2)));
+  auto* attr = reinterpret_cast<struct nlattr*>(attr_start);
+  attr->nla_len = attr_len;
+  attr->nla_type = INET_DIAG_REQ_BYTECODE;
+
+  // A single-instruction filter program: jumping exactly to the end of the
+  // program accepts the socket, jumping 4 bytes past it rejects the socket.
+  auto* op = reinterpret_cast<struct inet_diag_bc_op*>(attr_start + NLA_HDRLEN);
+  op->code = INET_DIAG_BC_S_COND;
+  op->yes = bytecode_len;
+  op->no = bytecode_len + 4;
+
+  auto* cond = reinterpret_cast<struct inet_diag_hostcond*>(op + 1);
+  cond->family = family;
+  cond->prefix_len = addr_len * 8;
+  cond->port = -1;
+  memcpy(cond->addr, saddr.GetConstData(), addr_len);
+
+  return buffer;
+}
+
 SockDiagRequest CreateDestroyRequest(uint8_t family, uint8_t protocol) {
   SockDiagRequest request;
   request.header.nlmsg_len = sizeof(SockDiagRequest);
@@ -150,14 +200,49 @@ bool NetlinkSockDiag::GetSockets(
     return false;
   }
 
-  return ReadDumpContents(out_socks);
+  std::vector<struct inet_diag_msg> msgs;
+  if (!ReadDumpContents(&msgs))
+    return false;
+
+  out_socks->clear();
+  out_socks->reserve(msgs.size());
+  for (const auto& msg : msgs)
+    out_socks->push_back(msg.id);
+  return true;
+}
+
+bool NetlinkSockDiag::GetSocketInfo(uint8_t protocol,
+                                    uint32_t states,
+                                    const IPAddress& saddr,
+                                    std::vector<struct inet_diag_msg>* out_msgs) {
+  CHECK(out_msgs);
+  uint8_t family;
+  if (saddr.family() == IPAddress::kFamilyIPv4) {
+    family = AF_INET;
+  } else if (saddr.family() == IPAddress::kFamilyIPv6) {
+    family = AF_INET6;
+  } else {
+    LOG(ERROR) << "Tried to dump sockets for unsupported family";
+    return false;
+  }
+
+  std::vector<uint8_t> request = CreateFilteredDumpRequest(
+      family, protocol, states, saddr, ++sequence_number_);
+  if (sockets_->Send(file_descriptor_, request.data(), request.size(), 0) <
+      0) {
+    PLOG(ERROR) << "Failed to write sock_diag request to netlink socket "
+                << "(family: " << family << ", protocol: " << protocol << ")";
+    return false;
+  }
+
+  return ReadDumpContents(out_msgs);
 }
 
 bool NetlinkSockDiag::ReadDumpContents(
-    std::vector<struct inet_diag_sockid>* out_socks) {
+    std::vector<struct inet_diag_msg>* out_msgs) {
   char buf[8192];
 
-  out_socks->clear();
+  out_msgs->clear();
 
   for (;;) {
     ssize_t bytes_read = sockets_->RecvFrom(file_descriptor_, buf, sizeof(buf),
@@ -189,7 +274,7 @@ bool NetlinkSockDiag::ReadDumpContents(
         case SOCK_DIAG_BY_FAMILY:
           struct inet_diag_msg current_msg;
           memcpy(&current_msg, NLMSG_DATA(nlh), sizeof(current_msg));
-          out_socks->push_back(current_msg.id);
+          out_msgs->push_back(current_msg);
           break;
         default:
           LOG(WARNING) << "Ignoring unexpected netlink message type "
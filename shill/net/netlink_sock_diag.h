@@ -16,6 +16,7 @@
 #include "shill/net/netlink_fd.h"
 #include "shill/net/shill_export.h"
 
+struct inet_diag_msg;
 struct inet_diag_sockid;
 
 namespace shill {
@@ -41,6 +42,15 @@ class SHILL_EXPORT NetlinkSockDiag {
   // make another connection.
   bool DestroySockets(uint8_t protocol, const IPAddress& saddr);
 
+  // Dumps the sockets of |protocol| whose local address is |saddr| and whose
+  // state is set in |states| (a bitmask of 1 << TCP_* values). Both filters
+  // are evaluated by the kernel, so only matching sockets are copied to user
+  // space. Existing entries in |out_msgs| are discarded.
+  bool GetSocketInfo(uint8_t protocol,
+                     uint32_t states,
+                     const IPAddress& saddr,
+                     std::vector<struct inet_diag_msg>* out_msgs);
+
  private:
   // Hidden; use the static Create function above.
   NetlinkSockDiag(std::unique_ptr<Sockets> sockets, int file_descriptor);
@@ -51,7 +61,7 @@ class SHILL_EXPORT NetlinkSockDiag {
                   std::vector<struct inet_diag_sockid>* out_socks);
 
   // Read the socket dump from the netlink socket.
-  bool ReadDumpContents(std::vector<struct inet_diag_sockid>* out_socks);
+  bool ReadDumpContents(std::vector<struct inet_diag_msg>* out_msgs);
 
   std::unique_ptr<Sockets> sockets_;
   int file_descriptor_;
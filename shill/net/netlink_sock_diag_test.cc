@@ -0,0 +1,326 @@
+// Copyright 2020 The Chromium OS Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "shill/net/netlink_sock_diag.h"
+
+#include <arpa/inet.h>
+#include <linux/inet_diag.h>
+#include <linux/netlink.h>
+#include <linux/sock_diag.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <base/logging.h>
+#include <base/timer/elapsed_timer.h>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "shill/net/mock_sockets.h"
+#include "shill/net/netlink_fd.h"
+
+using testing::_;
+using testing::Invoke;
+using testing::NiceMock;
+using testing::Return;
+using testing::Test;
+
+namespace shill {
+
+namespace {
+
+const int kFakeFd = 99;
+const char kLocalAddress[] = "192.168.1.2";
+const char kOtherAddress[] = "192.168.1.3";
+const char kLocalAddressV6[] = "fe80::1";
+const uint32_t kEstablished = 1 << TCP_ESTABLISHED;
+
+// Size of the datagrams the fake kernel sends, as the kernel fills at most a
+// page per recv().
+const size_t kDatagramSize = 4096;
+
+// Stands in for the kernel side of a NETLINK_SOCK_DIAG socket. Dump requests
+// are answered with the sockets in |sockets_| that match their state mask and
+// INET_DIAG_BC_S_COND filter, split in datagrams the way the kernel does.
+class FakeSockDiagKernel {
+ public:
+  void AddSocket(const std::string& saddr, uint8_t state) {
+    IPAddress address(saddr);
+    struct inet_diag_msg msg = {};
+
+    msg.idiag_family =
+        address.family() == IPAddress::kFamilyIPv4 ? AF_INET : AF_INET6;
+    msg.idiag_state = state;
+    msg.idiag_inode = sockets_.size() + 1;
+    msg.id.idiag_sport = htons(1024 + sockets_.size() % 60000);
+    msg.id.idiag_dport = htons(443);
+    memcpy(msg.id.idiag_src, address.GetConstData(), address.GetLength());
+    sockets_.push_back(msg);
+  }
+
+  void FailNextDump(int error) { error_ = error; }
+
+  const std::vector<uint8_t>& last_request() const { return last_request_; }
+
+  ssize_t Send(int sockfd, const void* buf, size_t len, int flags) {
+    const auto* bytes = static_cast<const uint8_t*>(buf);
+    last_request_.assign(bytes, bytes + len);
+
+    const auto* header = static_cast<const struct nlmsghdr*>(buf);
+    if (len < NLMSG_LENGTH(sizeof(struct inet_diag_req_v2)) ||
+        header->nlmsg_type != SOCK_DIAG_BY_FAMILY) {
+      return -1;
+    }
+    const auto* req =
+        static_cast<const struct inet_diag_req_v2*>(NLMSG_DATA(header));
+    const struct inet_diag_hostcond* cond = nullptr;
+    size_t attr_offset =
+        NLMSG_ALIGN(NLMSG_LENGTH(sizeof(struct inet_diag_req_v2)));
+    if (len > attr_offset) {
+      const auto* attr =
+          reinterpret_cast<const struct nlattr*>(bytes + attr_offset);
+      const auto* op = reinterpret_cast<const struct inet_diag_bc_op*>(
+          bytes + attr_offset + NLA_HDRLEN);
+      if (attr->nla_type == INET_DIAG_REQ_BYTECODE &&
+          op->code == INET_DIAG_BC_S_COND) {
+        cond = reinterpret_cast<const struct inet_diag_hostcond*>(op + 1);
+      }
+    }
+
+    datagrams_.clear();
+    std::vector<uint8_t> datagram;
+    if (error_) {
+      struct nlmsgerr err = {};
+      err.error = -error_;
+      error_ = 0;
+      AppendMessage(NLMSG_ERROR, &err, sizeof(err), &datagram);
+      datagrams_.push_back(datagram);
+      return len;
+    }
+    for (const auto& msg : sockets_) {
+      if (msg.idiag_family != req->sdiag_family ||
+          !(req->idiag_states & (1 << msg.idiag_state))) {
+        continue;
+      }
+      if (cond && memcmp(msg.id.idiag_src, cond->addr,
+                         cond->prefix_len / 8) != 0) {
+        continue;
+      }
+      if (datagram.size() + NLMSG_SPACE(sizeof(msg)) > kDatagramSize) {
+        datagrams_.push_back(datagram);
+        datagram.clear();
+      }
+      AppendMessage(SOCK_DIAG_BY_FAMILY, &msg, sizeof(msg), &datagram);
+    }
+    AppendMessage(NLMSG_DONE, nullptr, 0, &datagram);
+    datagrams_.push_back(datagram);
+    return len;
+  }
+
+  ssize_t RecvFrom(int sockfd,
+                   void* buf,
+                   size_t len,
+                   int flags,
+                   struct sockaddr* src_addr,
+                   socklen_t* addrlen) {
+    if (datagrams_.empty() || datagrams_.front().size() > len)
+      return -1;
+    std::vector<uint8_t> datagram = std::move(datagrams_.front());
+    datagrams_.pop_front();
+    memcpy(buf, datagram.data(), datagram.size());
+    return datagram.size();
+  }
+
+ private:
+  static void AppendMessage(uint16_t type,
+                            const void* payload,
+                            size_t payload_len,
+                            std::vector<uint8_t>* datagram) {
+    size_t offset = datagram->size();
+    datagram->resize(offset + NLMSG_SPACE(payload_len), 0);
+    auto* header =
+        reinterpret_cast<struct nlmsghdr*>(datagram->data() + offset);
+    header->nlmsg_len = NLMSG_LENGTH(payload_len);
+    header->nlmsg_type = type;
+    if (payload_len)
+      memcpy(NLMSG_DATA(header), payload, payload_len);
+  }
+
+  std::vector<struct inet_diag_msg> sockets_;
+  std::deque<std::vector<uint8_t>> datagrams_;
+  std::vector<uint8_t> last_request_;
+  int error_ = 0;
+};
+
+}  // namespace
+
+class NetlinkSockDiagTest : public Test {
+ public:
+  void SetUp() override {
+    auto sockets = std::make_unique<NiceMock<MockSockets>>();
+    mock_sockets_ = sockets.get();
+    EXPECT_CALL(
+        *mock_sockets_,
+        Socket(PF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_SOCK_DIAG))
+        .WillOnce(Return(kFakeFd));
+    EXPECT_CALL(*mock_sockets_, Bind(kFakeFd, _, sizeof(struct sockaddr_nl)))
+        .WillOnce(Return(0));
+    ON_CALL(*mock_sockets_, Send(kFakeFd, _, _, 0))
+        .WillByDefault(Invoke(&kernel_, &FakeSockDiagKernel::Send));
+    ON_CALL(*mock_sockets_, RecvFrom(kFakeFd, _, _, 0, nullptr, nullptr))
+        .WillByDefault(Invoke(&kernel_, &FakeSockDiagKernel::RecvFrom));
+
+    sock_diag_ = NetlinkSockDiag::Create(std::move(sockets));
+    ASSERT_NE(nullptr, sock_diag_);
+  }
+
+ protected:
+  FakeSockDiagKernel kernel_;
+  MockSockets* mock_sockets_;  // Owned by |sock_diag_|.
+  std::unique_ptr<NetlinkSockDiag> sock_diag_;
+};
+
+TEST_F(NetlinkSockDiagTest, FilteredDumpRequest) {
+  std::vector<struct inet_diag_msg> msgs;
+  IPAddress saddr(kLocalAddress);
+  ASSERT_TRUE(
+      sock_diag_->GetSocketInfo(IPPROTO_TCP, kEstablished, saddr, &msgs));
+
+  const std::vector<uint8_t>& request = kernel_.last_request();
+  const size_t attr_offset =
+      NLMSG_ALIGN(NLMSG_LENGTH(sizeof(struct inet_diag_req_v2)));
+  ASSERT_GT(request.size(), attr_offset);
+
+  const auto* header = reinterpret_cast<const struct nlmsghdr*>(request.data());
+  EXPECT_EQ(request.size(), header->nlmsg_len);
+  EXPECT_EQ(NLM_F_REQUEST | NLM_F_DUMP, header->nlmsg_flags);
+  const auto* req =
+      static_cast<const struct inet_diag_req_v2*>(NLMSG_DATA(header));
+  EXPECT_EQ(AF_INET, req->sdiag_family);
+  EXPECT_EQ(IPPROTO_TCP, req->sdiag_protocol);
+  EXPECT_EQ(kEstablished, req->idiag_states);
+
+  const auto* attr =
+      reinterpret_cast<const struct nlattr*>(request.data() + attr_offset);
+  EXPECT_EQ(INET_DIAG_REQ_BYTECODE, attr->nla_type);
+  const size_t bytecode_len = sizeof(struct inet_diag_bc_op) +
+                              sizeof(struct inet_diag_hostcond) +
+                              saddr.GetLength();
+  EXPECT_EQ(NLA_HDRLEN + bytecode_len, attr->nla_len);
+
+  const auto* op = reinterpret_cast<const struct inet_diag_bc_op*>(
+      request.data() + attr_offset + NLA_HDRLEN);
+  EXPECT_EQ(INET_DIAG_BC_S_COND, op->code);
+  EXPECT_EQ(bytecode_len, op->yes);
+  EXPECT_EQ(bytecode_len + 4, op->no);
+
+  const auto* cond = reinterpret_cast<const struct inet_diag_hostcond*>(op + 1);
+  EXPECT_EQ(AF_INET, cond->family);
+  EXPECT_EQ(32, cond->prefix_len);
+  EXPECT_EQ(-1, cond->port);
+  EXPECT_EQ(0, memcmp(cond->addr, saddr.GetConstData(), saddr.GetLength()));
+}
+
+TEST_F(NetlinkSockDiagTest, FilteredDumpRequestIPv6) {
+  std::vector<struct inet_diag_msg> msgs;
+  IPAddress saddr(kLocalAddressV6);
+  ASSERT_TRUE(
+      sock_diag_->GetSocketInfo(IPPROTO_TCP, kEstablished, saddr, &msgs));
+
+  const std::vector<uint8_t>& request = kernel_.last_request();
+  const size_t attr_offset =
+      NLMSG_ALIGN(NLMSG_LENGTH(sizeof(struct inet_diag_req_v2)));
+  const auto* req = reinterpret_cast<const struct inet_diag_req_v2*>(
+      request.data() + NLMSG_HDRLEN);
+  EXPECT_EQ(AF_INET6, req->sdiag_family);
+  const auto* cond = reinterpret_cast<const struct inet_diag_hostcond*>(
+      request.data() + attr_offset + NLA_HDRLEN +
+      sizeof(struct inet_diag_bc_op));
+  EXPECT_EQ(AF_INET6, cond->family);
+  EXPECT_EQ(128, cond->prefix_len);
+  EXPECT_EQ(0, memcmp(cond->addr, saddr.GetConstData(), saddr.GetLength()));
+}
+
+TEST_F(NetlinkSockDiagTest, GetSocketInfo) {
+  kernel_.AddSocket(kLocalAddress, TCP_ESTABLISHED);
+  kernel_.AddSocket(kOtherAddress, TCP_ESTABLISHED);
+  kernel_.AddSocket(kLocalAddress, TCP_TIME_WAIT);
+  kernel_.AddSocket(kLocalAddressV6, TCP_ESTABLISHED);
+  kernel_.AddSocket(kLocalAddress, TCP_ESTABLISHED);
+
+  std::vector<struct inet_diag_msg> msgs(3);
+  ASSERT_TRUE(sock_diag_->GetSocketInfo(IPPROTO_TCP, kEstablished,
+                                        IPAddress(kLocalAddress), &msgs));
+  ASSERT_EQ(2, msgs.size());
+  EXPECT_EQ(1, msgs[0].idiag_inode);
+  EXPECT_EQ(5, msgs[1].idiag_inode);
+}
+
+TEST_F(NetlinkSockDiagTest, GetSocketInfoAcrossDatagrams) {
+  const size_t kNumSockets = 3 * kDatagramSize / sizeof(struct inet_diag_msg);
+  for (size_t i = 0; i < kNumSockets; ++i)
+    kernel_.AddSocket(kLocalAddress, TCP_ESTABLISHED);
+
+  std::vector<struct inet_diag_msg> msgs;
+  ASSERT_TRUE(sock_diag_->GetSocketInfo(IPPROTO_TCP, kEstablished,
+                                        IPAddress(kLocalAddress), &msgs));
+  ASSERT_EQ(kNumSockets, msgs.size());
+  EXPECT_EQ(kNumSockets, msgs.back().idiag_inode);
+}
+
+TEST_F(NetlinkSockDiagTest, GetSocketInfoError) {
+  kernel_.AddSocket(kLocalAddress, TCP_ESTABLISHED);
+  kernel_.FailNextDump(EINVAL);
+
+  std::vector<struct inet_diag_msg> msgs;
+  EXPECT_FALSE(sock_diag_->GetSocketInfo(IPPROTO_TCP, kEstablished,
+                                         IPAddress(kLocalAddress), &msgs));
+}
+
+TEST_F(NetlinkSockDiagTest, GetSocketInfoUnsupportedFamily) {
+  EXPECT_CALL(*mock_sockets_, Send(_, _, _, _)).Times(0);
+
+  std::vector<struct inet_diag_msg> msgs;
+  EXPECT_FALSE(sock_diag_->GetSocketInfo(
+      IPPROTO_TCP, kEstablished, IPAddress(IPAddress::kFamilyUnknown), &msgs));
+}
+
+// Measures GetSocketInfo() against 100, 1k and 10k sockets, a tenth of which
+// are established on the local address, as for TrafficMonitor on a busy
+// device. Only the matching sockets are copied to user space, so the cost of
+// reading the dump follows their number. The time reported also includes the
+// fake kernel walking every socket, as the real one does. Run with
+// --gtest_also_run_disabled_tests.
+TEST_F(NetlinkSockDiagTest, DISABLED_GetSocketInfoBenchmark) {
+  const int kIterations = 200;
+  const IPAddress saddr(kLocalAddress);
+  size_t num_sockets = 0;
+
+  for (size_t target : {100, 1000, 10000}) {
+    for (; num_sockets < target; ++num_sockets) {
+      kernel_.AddSocket(num_sockets % 10 ? kOtherAddress : kLocalAddress,
+                        num_sockets % 3 ? TCP_ESTABLISHED : TCP_TIME_WAIT);
+    }
+
+    std::vector<struct inet_diag_msg> msgs;
+    base::ElapsedTimer timer;
+    for (int i = 0; i < kIterations; ++i) {
+      ASSERT_TRUE(
+          sock_diag_->GetSocketInfo(IPPROTO_TCP, kEstablished, saddr, &msgs));
+    }
+    base::TimeDelta elapsed = timer.Elapsed();
+
+    LOG(INFO) << num_sockets << " sockets, " << msgs.size()
+              << " matching: " << elapsed.InMicroseconds() / kIterations
+              << " us per dump";
+  }
+}
+
+}  // namespace shill
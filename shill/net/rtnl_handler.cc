@@ -275,6 +275,9 @@ void RTNLHandler::NextRequest(uint32_t seq) {
 void RTNLHandler::ParseRTNL(InputData* data) {
   const unsigned char* buf = data->buf;
   const unsigned char* end = buf + data->len;
+  // Reused for every message of the datagram, so that a dump only allocates
+  // attribute storage for its largest message.
+  RTNLMessage msg;
 
   while (buf < end) {
     const struct nlmsghdr* hdr = reinterpret_cast<const struct nlmsghdr*>(buf);
@@ -283,17 +286,17 @@ void RTNLHandler::ParseRTNL(InputData* data) {
 
     SLOG(this, 5) << __func__ << ": received payload (" << end - buf << ")";
 
-    RTNLMessage msg;
-    ByteString payload(reinterpret_cast<const unsigned char*>(hdr),
-                       hdr->nlmsg_len);
-    SLOG(this, 5) << "RTNL received payload length " << payload.GetLength()
-                  << ": \"" << payload.HexEncode() << "\"";
+    msg.Reset();
+    SLOG(this, 5) << "RTNL received payload length " << hdr->nlmsg_len << ": \""
+                  << ByteString(buf, hdr->nlmsg_len).HexEncode() << "\"";
 
     // Swapping out of |stored_requests_| here ensures that the RTNLMessage will
     // be destructed regardless of the control flow below.
     std::unique_ptr<RTNLMessage> request_msg = PopStoredRequest(hdr->nlmsg_seq);
 
-    if (!msg.Decode(payload)) {
+    // Decode straight out of the receive buffer rather than a per-message
+    // copy of it.
+    if (!msg.Decode(buf, hdr->nlmsg_len)) {
       SLOG(this, 5) << __func__ << ": rtnl packet type " << hdr->nlmsg_type
                     << " length " << hdr->nlmsg_len << " sequence "
                     << hdr->nlmsg_seq;
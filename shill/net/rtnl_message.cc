@@ -16,10 +16,10 @@
 #include <sys/socket.h>
 
 #include <map>
-#include <memory>
 #include <utility>
 
 #include <base/logging.h>
+#include <base/stl_util.h>
 #include <base/strings/string_util.h>
 #include <base/strings/stringprintf.h>
 
@@ -221,25 +221,16 @@ std::string GetRouteProtocol(uint8_t protocol) {
   return it->second;
 }
 
-std::unique_ptr<RTNLAttrMap> ParseAttrs(struct rtattr* data, int len) {
-  RTNLAttrMap attrs;
-  ByteString attr_bytes(reinterpret_cast<const char*>(data), len);
-
+// Returns the attribute of |type| within the |len| bytes of attributes at
+// |data| without copying anything, or nullptr if there is none.
+const struct rtattr* FindAttr(const struct rtattr* data, int len,
+                              uint16_t type) {
   while (data && RTA_OK(data, len)) {
-    attrs[data->rta_type] = ByteString(
-        reinterpret_cast<unsigned char*>(RTA_DATA(data)), RTA_PAYLOAD(data));
-    // Note: RTA_NEXT() performs subtraction on 'len'. It's important that
-    // 'len' is a signed integer, so underflow works properly.
+    if (data->rta_type == type)
+      return data;
     data = RTA_NEXT(data, len);
   }
-
-  if (len) {
-    LOG(ERROR) << "Error parsing RTNL attributes <" << attr_bytes.HexEncode()
-               << ">, trailing length: " << len;
-    return nullptr;
-  }
-
-  return std::make_unique<RTNLAttrMap>(attrs);
+  return nullptr;
 }
 
 ByteString PackAttrs(const RTNLAttrMap& attrs) {
@@ -322,19 +313,21 @@ RTNLMessage::RTNLMessage(Type type,
       family_(family) {}
 
 bool RTNLMessage::Decode(const ByteString& msg) {
-  bool ret = DecodeInternal(msg);
+  return Decode(msg.GetConstData(), msg.GetLength());
+}
+
+bool RTNLMessage::Decode(const unsigned char* data, size_t length) {
+  bool ret = DecodeInternal(data, length);
   if (!ret) {
     Reset();
   }
   return ret;
 }
 
-bool RTNLMessage::DecodeInternal(const ByteString& msg) {
-  const RTNLHeader* hdr =
-      reinterpret_cast<const RTNLHeader*>(msg.GetConstData());
+bool RTNLMessage::DecodeInternal(const unsigned char* data, size_t length) {
+  const RTNLHeader* hdr = reinterpret_cast<const RTNLHeader*>(data);
 
-  if (msg.GetLength() < sizeof(hdr->hdr) ||
-      msg.GetLength() < hdr->hdr.nlmsg_len)
+  if (!data || length < sizeof(hdr->hdr) || length < hdr->hdr.nlmsg_len)
     return false;
 
   mode_ = kModeUnknown;
@@ -407,16 +400,58 @@ bool RTNLMessage::DecodeInternal(const ByteString& msg) {
   seq_ = hdr->hdr.nlmsg_seq;
   pid_ = hdr->hdr.nlmsg_pid;
 
-  std::unique_ptr<RTNLAttrMap> attrs = ParseAttrs(attr_data, attr_length);
-  if (!attrs) {
+  return DecodeAttributes(attr_data, attr_length);
+}
+
+bool RTNLMessage::DecodeAttributes(const rtattr* data, int length) {
+  // Copy the attribute data once and only record where each attribute lies
+  // in it: most attributes of a message are never read. The buffers keep
+  // their capacity across Reset(), so a message reused for several decodes
+  // doesn't allocate once they are large enough.
+  attribute_views_.clear();
+  decoded_attributes_.Clear();
+  if (data && length > 0) {
+    decoded_attributes_.Resize(length);
+    memcpy(decoded_attributes_.GetData(), data, length);
+  }
+
+  const unsigned char* base = decoded_attributes_.GetConstData();
+  const struct rtattr* attr = reinterpret_cast<const struct rtattr*>(base);
+  int len = length;
+  while (attr && RTA_OK(attr, len)) {
+    const unsigned char* payload =
+        reinterpret_cast<const unsigned char*>(RTA_DATA(attr));
+    attribute_views_.push_back({attr->rta_type,
+                                static_cast<uint32_t>(payload - base),
+                                static_cast<uint32_t>(RTA_PAYLOAD(attr))});
+    // A decoded attribute replaces one set before.
+    attributes_.erase(attr->rta_type);
+    // Note: RTA_NEXT() performs subtraction on 'len'. It's important that
+    // 'len' is a signed integer, so underflow works properly.
+    attr = RTA_NEXT(attr, len);
+  }
+
+  if (len) {
+    LOG(ERROR) << "Error parsing RTNL attributes <"
+               << decoded_attributes_.HexEncode()
+               << ">, trailing length: " << len;
     attributes_.clear();
+    attribute_views_.clear();
+    decoded_attributes_.Clear();
     return false;
   }
+  return true;
+}
 
-  for (const auto& pair : *attrs) {
-    SetAttribute(pair.first, pair.second);
+const RTNLMessage::AttributeView* RTNLMessage::FindDecodedAttribute(
+    uint16_t attr) const {
+  // Search from the end, so that the last of repeated attributes wins.
+  for (auto it = attribute_views_.rbegin(); it != attribute_views_.rend();
+       ++it) {
+    if (it->type == attr)
+      return &*it;
   }
-  return true;
+  return nullptr;
 }
 
 bool RTNLMessage::DecodeLink(const RTNLHeader* hdr,
@@ -433,29 +468,27 @@ bool RTNLMessage::DecodeLink(const RTNLHeader* hdr,
   family_ = hdr->ifi.ifi_family;
   interface_index_ = hdr->ifi.ifi_index;
 
-  std::unique_ptr<RTNLAttrMap> attrs = ParseAttrs(*attr_data, *attr_length);
-  if (!attrs)
-    return false;
-
+  // Only IFLA_LINKINFO is needed here; the full attribute map is parsed once
+  // by DecodeInternal(), so look it up in place instead of parsing twice.
   base::Optional<std::string> kind_option;
 
-  if (base::Contains(*attrs, IFLA_LINKINFO)) {
-    ByteString& bytes = attrs->find(IFLA_LINKINFO)->second;
-    struct rtattr* link_data =
-        reinterpret_cast<struct rtattr*>(bytes.GetData());
-    size_t link_len = bytes.GetLength();
-    std::unique_ptr<RTNLAttrMap> linkinfo = ParseAttrs(link_data, link_len);
-
-    if (linkinfo && base::Contains(*linkinfo, IFLA_INFO_KIND)) {
-      ByteString& kindBytes = linkinfo->find(IFLA_INFO_KIND)->second;
-      const char* kind = reinterpret_cast<const char*>(kindBytes.GetData());
-      std::string kind_string(kind, strnlen(kind, kindBytes.GetLength()));
-      if (base::IsStringASCII(kind_string))
-        kind_option = kind_string;
-      else
-        LOG(ERROR) << base::StringPrintf(
-            "Invalid kind <%s>, interface index %d",
-            kindBytes.HexEncode().c_str(), interface_index_);
+  const struct rtattr* link_info =
+      FindAttr(*attr_data, *attr_length, IFLA_LINKINFO);
+  const struct rtattr* kind_attr =
+      link_info ? FindAttr(reinterpret_cast<const struct rtattr*>(
+                               RTA_DATA(link_info)),
+                           RTA_PAYLOAD(link_info), IFLA_INFO_KIND)
+                : nullptr;
+  if (kind_attr) {
+    const char* kind = reinterpret_cast<const char*>(RTA_DATA(kind_attr));
+    std::string kind_string(kind, strnlen(kind, RTA_PAYLOAD(kind_attr)));
+    if (base::IsStringASCII(kind_string)) {
+      kind_option = kind_string;
+    } else {
+      ByteString kind_bytes(kind, RTA_PAYLOAD(kind_attr));
+      LOG(ERROR) << base::StringPrintf("Invalid kind <%s>, interface index %d",
+                                       kind_bytes.HexEncode().c_str(),
+                                       interface_index_);
     }
   }
 
@@ -662,7 +695,17 @@ ByteString RTNLMessage::Encode() const {
   }
 
   size_t header_length = hdr.hdr.nlmsg_len;
-  ByteString attributes = PackAttrs(attributes_);
+  ByteString attributes;
+  if (attribute_views_.empty()) {
+    attributes = PackAttrs(attributes_);
+  } else {
+    RTNLAttrMap all_attributes;
+    for (const auto& view : attribute_views_)
+      all_attributes[view.type] = GetAttribute(view.type);
+    for (const auto& pair : attributes_)
+      all_attributes[pair.first] = pair.second;
+    attributes = PackAttrs(all_attributes);
+  }
   hdr.hdr.nlmsg_len = NLMSG_ALIGN(hdr.hdr.nlmsg_len) + attributes.GetLength();
   ByteString packet(reinterpret_cast<unsigned char*>(&hdr), header_length);
   packet.Append(attributes);
@@ -788,6 +831,24 @@ void RTNLMessage::Reset() {
   neighbor_status_ = NeighborStatus();
   rdnss_option_ = RdnssOption();
   attributes_.clear();
+  attribute_views_.clear();
+  decoded_attributes_.Clear();
+}
+
+bool RTNLMessage::HasAttribute(uint16_t attr) const {
+  return base::Contains(attributes_, attr) || FindDecodedAttribute(attr);
+}
+
+const ByteString RTNLMessage::GetAttribute(uint16_t attr) const {
+  const auto it = attributes_.find(attr);
+  if (it != attributes_.end())
+    return it->second;
+
+  const AttributeView* view = FindDecodedAttribute(attr);
+  if (!view)
+    return ByteString(0);
+  return ByteString(decoded_attributes_.GetConstData() + view->offset,
+                    view->length);
 }
 
 uint32_t RTNLMessage::GetUint32Attribute(uint16_t attr) const {
@@ -157,6 +157,9 @@ class SHILL_EXPORT RTNLMessage {
 
   // Parse an RTNL message.  Returns true on success.
   bool Decode(const ByteString& data);
+  // Parse an RTNL message in place from |length| bytes at |data|, e.g.
+  // straight out of a receive buffer.  Returns true on success.
+  bool Decode(const unsigned char* data, size_t length);
   // Encode an RTNL message.  Returns empty ByteString on failure.
   ByteString Encode() const;
   // Reset all fields.
@@ -199,12 +202,8 @@ class SHILL_EXPORT RTNLMessage {
   // GLint hates "unsigned short", and I don't blame it, but that's the
   // type that's used in the system headers.  Use uint16_t instead and hope
   // that the conversion never ends up truncating on some strange platform.
-  bool HasAttribute(uint16_t attr) const {
-    return base::Contains(attributes_, attr);
-  }
-  const ByteString GetAttribute(uint16_t attr) const {
-    return HasAttribute(attr) ? attributes_.find(attr)->second : ByteString(0);
-  }
+  bool HasAttribute(uint16_t attr) const;
+  const ByteString GetAttribute(uint16_t attr) const;
   void SetAttribute(uint16_t attr, const ByteString& val) {
     attributes_[attr] = val;
   }
@@ -261,7 +260,16 @@ class SHILL_EXPORT RTNLMessage {
   IPAddress GetFraDst() const;
 
  private:
-  SHILL_PRIVATE bool DecodeInternal(const ByteString& msg);
+  // Where the payload of a decoded attribute lies in |decoded_attributes_|.
+  struct AttributeView {
+    uint16_t type;
+    uint32_t offset;
+    uint32_t length;
+  };
+
+  SHILL_PRIVATE bool DecodeInternal(const unsigned char* data, size_t length);
+  SHILL_PRIVATE bool DecodeAttributes(const rtattr* data, int length);
+  SHILL_PRIVATE const AttributeView* FindDecodedAttribute(uint16_t attr) const;
   SHILL_PRIVATE bool DecodeLink(const RTNLHeader* hdr,
                                 rtattr** attr_data,
                                 int* attr_length);
@@ -312,8 +320,13 @@ class SHILL_EXPORT RTNLMessage {
   RouteStatus route_status_;
   NeighborStatus neighbor_status_;
   RdnssOption rdnss_option_;
-  // Additional rtattr contained in the message.
+  // Additional rtattr set on the message.
   RTNLAttrMap attributes_;
+  // Additional rtattr of a decoded message, kept as a single copy of its
+  // attribute data and copied out only when read. Attributes set afterwards
+  // in |attributes_| take precedence.
+  ByteString decoded_attributes_;
+  std::vector<AttributeView> attribute_views_;
   // NOTE: Update Reset() accordingly when adding a new member field.
 
   DISALLOW_COPY_AND_ASSIGN(RTNLMessage);
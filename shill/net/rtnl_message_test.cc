@@ -12,7 +12,10 @@
 
 #include <regex>
 #include <string>
+#include <vector>
 
+#include <base/logging.h>
+#include <base/timer/elapsed_timer.h>
 #include <gtest/gtest.h>
 
 #include "shill/net/byte_string.h"
@@ -1076,4 +1079,146 @@ TEST_F(RTNLMessageTest, EncodeGetMessageLength) {
             msg_neighor.Encode().GetLength());
 }
 
+TEST_F(RTNLMessageTest, SetAttributeAfterDecode) {
+  RTNLMessage msg;
+  ASSERT_TRUE(msg.Decode(
+      ByteString(kNewLinkMessageWlan0, sizeof(kNewLinkMessageWlan0))));
+  msg.SetAttribute(IFLA_IFNAME, ByteString(std::string("wlan1"), true));
+  EXPECT_EQ("wlan1", msg.GetIflaIfname());
+
+  // Both the decoded and the set attributes are encoded.
+  RTNLMessage copy;
+  ASSERT_TRUE(copy.Decode(msg.Encode()));
+  EXPECT_EQ("wlan1", copy.GetIflaIfname());
+  EXPECT_EQ(kNewLinkMessageWlan0MTU, copy.GetUint32Attribute(IFLA_MTU));
+  EXPECT_EQ(kNewLinkMessageWlan0Qdisc, copy.GetStringAttribute(IFLA_QDISC));
+}
+
+TEST_F(RTNLMessageTest, DecodeReplacesSetAttribute) {
+  RTNLMessage msg;
+  msg.SetAttribute(IFLA_IFNAME, ByteString(std::string("wlan1"), true));
+  ASSERT_TRUE(msg.Decode(
+      ByteString(kNewLinkMessageWlan0, sizeof(kNewLinkMessageWlan0))));
+  EXPECT_EQ(kNewLinkMessageWlan0InterfaceName, msg.GetIflaIfname());
+}
+
+TEST_F(RTNLMessageTest, RepeatedAttributeLastWins) {
+  RTNLMessage route(RTNLMessage::kTypeRoute, RTNLMessage::kModeAdd, 0, 1, 2, 0,
+                    IPAddress::kFamilyIPv4);
+  route.set_route_status(RTNLMessage::RouteStatus(
+      0, 0, RT_TABLE_MAIN, RTPROT_BOOT, RT_SCOPE_UNIVERSE, RTN_UNICAST, 0));
+  route.SetAttribute(RTA_OIF, ByteString::CreateFromCPUUInt32(12));
+  ByteString packet = route.Encode();
+
+  // Append a second RTA_OIF attribute.
+  struct rtattr attr;
+  attr.rta_len = RTA_LENGTH(sizeof(uint32_t));
+  attr.rta_type = RTA_OIF;
+  packet.Append(
+      ByteString(reinterpret_cast<const unsigned char*>(&attr), sizeof(attr)));
+  packet.Append(ByteString::CreateFromCPUUInt32(13));
+  reinterpret_cast<struct nlmsghdr*>(packet.GetData())->nlmsg_len =
+      packet.GetLength();
+
+  RTNLMessage msg;
+  ASSERT_TRUE(msg.Decode(packet));
+  EXPECT_EQ(13, msg.GetRtaOif());
+}
+
+TEST_F(RTNLMessageTest, DecodeAfterReset) {
+  RTNLMessage msg;
+  ASSERT_TRUE(msg.Decode(
+      ByteString(kNewLinkMessageWlan0, sizeof(kNewLinkMessageWlan0))));
+  msg.Reset();
+  EXPECT_FALSE(msg.HasAttribute(IFLA_IFNAME));
+
+  RTNLMessage route(RTNLMessage::kTypeRoute, RTNLMessage::kModeAdd, 0, 1, 2, 0,
+                    IPAddress::kFamilyIPv4);
+  route.set_route_status(RTNLMessage::RouteStatus(
+      0, 0, RT_TABLE_MAIN, RTPROT_BOOT, RT_SCOPE_UNIVERSE, RTN_UNICAST, 0));
+  route.SetAttribute(RTA_OIF, ByteString::CreateFromCPUUInt32(12));
+  ASSERT_TRUE(msg.Decode(route.Encode()));
+  EXPECT_EQ(RTNLMessage::kTypeRoute, msg.type());
+  EXPECT_EQ(12, msg.GetRtaOif());
+  EXPECT_FALSE(msg.HasAttribute(IFLA_IFNAME));
+}
+
+namespace {
+
+// Reads the attributes RoutingTable and DeviceInfo use.
+uint32_t ReadAttributes(const RTNLMessage& msg) {
+  if (msg.type() == RTNLMessage::kTypeRoute)
+    return msg.GetRtaOif() + msg.GetRtaPriority() + msg.GetRtaDst().prefix();
+  return msg.GetIflaIfname().size();
+}
+
+}  // namespace
+
+// Decodes dumps of 1000 routes and of 100 links the way RTNLHandler does,
+// reading a few attributes of each entry, with a message per entry and with
+// one message reused for the whole dump. Run with
+// --gtest_also_run_disabled_tests.
+TEST_F(RTNLMessageTest, DISABLED_DecodeDumpBenchmark) {
+  const int kIterations = 100;
+
+  RTNLMessage route(RTNLMessage::kTypeRoute, RTNLMessage::kModeAdd, 0, 1, 2, 0,
+                    IPAddress::kFamilyIPv4);
+  IPAddress dst(IPAddress::kFamilyIPv4);
+  IPAddress gateway(IPAddress::kFamilyIPv4);
+  ASSERT_TRUE(dst.SetAddressFromString("10.0.0.0"));
+  ASSERT_TRUE(gateway.SetAddressFromString("192.168.0.1"));
+  route.set_route_status(RTNLMessage::RouteStatus(
+      8, 0, RT_TABLE_MAIN, RTPROT_BOOT, RT_SCOPE_UNIVERSE, RTN_UNICAST, 0));
+  route.SetAttribute(RTA_TABLE, ByteString::CreateFromCPUUInt32(RT_TABLE_MAIN));
+  route.SetAttribute(RTA_DST, dst.address());
+  route.SetAttribute(RTA_GATEWAY, gateway.address());
+  route.SetAttribute(RTA_OIF, ByteString::CreateFromCPUUInt32(12));
+  route.SetAttribute(RTA_PRIORITY, ByteString::CreateFromCPUUInt32(13));
+
+  struct Dump {
+    const char* name;
+    ByteString entry;
+    int count;
+  };
+  const std::vector<Dump> dumps = {
+      {"route", route.Encode(), 1000},
+      {"link", ByteString(kNewLinkMessageWlan0, sizeof(kNewLinkMessageWlan0)),
+       100},
+  };
+
+  for (const auto& dump : dumps) {
+    ByteString datagram;
+    for (int i = 0; i < dump.count; ++i)
+      datagram.Append(dump.entry);
+    const unsigned char* end = datagram.GetConstData() + datagram.GetLength();
+
+    for (bool reuse : {false, true}) {
+      RTNLMessage reused;
+      uint32_t checksum = 0;
+      base::ElapsedTimer timer;
+      for (int i = 0; i < kIterations; ++i) {
+        for (const unsigned char* buf = datagram.GetConstData(); buf < end;) {
+          const auto* hdr = reinterpret_cast<const struct nlmsghdr*>(buf);
+          if (reuse) {
+            reused.Reset();
+            ASSERT_TRUE(reused.Decode(buf, hdr->nlmsg_len));
+            checksum += ReadAttributes(reused);
+          } else {
+            RTNLMessage msg;
+            ASSERT_TRUE(msg.Decode(buf, hdr->nlmsg_len));
+            checksum += ReadAttributes(msg);
+          }
+          buf += NLMSG_ALIGN(hdr->nlmsg_len);
+        }
+      }
+      base::TimeDelta elapsed = timer.Elapsed();
+
+      LOG(INFO) << dump.name << " dump, "
+                << (reuse ? "reused message" : "message per entry") << ": "
+                << elapsed.InNanoseconds() / (kIterations * dump.count)
+                << " ns per entry (checksum " << checksum << ")";
+    }
+  }
+}
+
 }  // namespace shill
@@ -1415,7 +1415,7 @@ void Service::OnPropertyChanged(const string& property) {
     // only necessary if there are multiple connected Services that would be
     // sorted differently by this change, so we can avoid doing this for
     // unconnected Services.
-    manager_->SortServices();
+    manager_->RepositionService(this);
   }
 }
 
@@ -27,6 +27,42 @@ void Ares::GetHostByName(ares_channel channel,
   ares_gethostbyname(channel, hostname, family, callback, arg);
 }
 
+int Ares::GetHostByNameFile(ares_channel channel,
+                            const char* name,
+                            int family,
+                            struct hostent** host) {
+  return ares_gethostbyname_file(channel, name, family, host);
+}
+
+void Ares::Search(ares_channel channel,
+                  const char* name,
+                  int dnsclass,
+                  int type,
+                  ares_callback callback,
+                  void* arg) {
+  ares_search(channel, name, dnsclass, type, callback, arg);
+}
+
+int Ares::ParseAReply(const unsigned char* abuf,
+                      int alen,
+                      struct hostent** host,
+                      struct ares_addrttl* addrttls,
+                      int* naddrttls) {
+  return ares_parse_a_reply(abuf, alen, host, addrttls, naddrttls);
+}
+
+int Ares::ParseAaaaReply(const unsigned char* abuf,
+                         int alen,
+                         struct hostent** host,
+                         struct ares_addr6ttl* addrttls,
+                         int* naddrttls) {
+  return ares_parse_aaaa_reply(abuf, alen, host, addrttls, naddrttls);
+}
+
+void Ares::FreeHostent(struct hostent* host) {
+  ares_free_hostent(host);
+}
+
 int Ares::GetSock(ares_channel channel, ares_socket_t* socks, int numsocks) {
   return ares_getsock(channel, socks, numsocks);
 }
@@ -29,6 +29,37 @@ class Ares {
                              ares_host_callback callback,
                              void* arg);
 
+  // ares_gethostbyname_file
+  virtual int GetHostByNameFile(ares_channel channel,
+                                const char* name,
+                                int family,
+                                struct hostent** host);
+
+  // ares_search
+  virtual void Search(ares_channel channel,
+                      const char* name,
+                      int dnsclass,
+                      int type,
+                      ares_callback callback,
+                      void* arg);
+
+  // ares_parse_a_reply
+  virtual int ParseAReply(const unsigned char* abuf,
+                          int alen,
+                          struct hostent** host,
+                          struct ares_addrttl* addrttls,
+                          int* naddrttls);
+
+  // ares_parse_aaaa_reply
+  virtual int ParseAaaaReply(const unsigned char* abuf,
+                             int alen,
+                             struct hostent** host,
+                             struct ares_addr6ttl* addrttls,
+                             int* naddrttls);
+
+  // ares_free_hostent
+  virtual void FreeHostent(struct hostent* host);
+
   // ares_getsock
   virtual int GetSock(ares_channel channel, ares_socket_t* socks, int numsocks);
 
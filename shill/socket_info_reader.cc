@@ -4,8 +4,12 @@
 
 #include "shill/socket_info_reader.h"
 
+#include <linux/inet_diag.h>
+#include <netinet/in.h>
+
 #include <algorithm>
 #include <limits>
+#include <memory>
 
 #include <base/strings/string_number_conversions.h>
 #include <base/strings/string_split.h>
@@ -13,6 +17,8 @@
 
 #include "shill/file_reader.h"
 #include "shill/logging.h"
+#include "shill/net/netlink_sock_diag.h"
+#include "shill/net/sockets.h"
 
 using base::FilePath;
 using std::string;
@@ -34,7 +40,7 @@ const char kTcpv6SocketInfoFilePath[] = "/proc/net/tcp6";
 
 }  // namespace
 
-SocketInfoReader::SocketInfoReader() = default;
+SocketInfoReader::SocketInfoReader() : sock_diag_unavailable_(false) {}
 
 SocketInfoReader::~SocketInfoReader() = default;
 
@@ -55,6 +61,41 @@ bool SocketInfoReader::LoadTcpSocketInfo(vector<SocketInfo>* info_list) {
   return v4_loaded || v6_loaded;
 }
 
+bool SocketInfoReader::LoadEstablishedTcpSocketInfo(
+    const vector<IPAddress>& local_addresses, vector<SocketInfo>* info_list) {
+  if (!sock_diag_ && !sock_diag_unavailable_) {
+    sock_diag_ = NetlinkSockDiag::Create(std::make_unique<Sockets>());
+    if (!sock_diag_) {
+      LOG(WARNING) << "sock_diag unavailable, falling back to procfs";
+      sock_diag_unavailable_ = true;
+    }
+  }
+  if (!sock_diag_)
+    return LoadTcpSocketInfo(info_list);
+
+  info_list->clear();
+  bool loaded = false;
+  vector<struct inet_diag_msg> msgs;
+  for (const auto& address : local_addresses) {
+    if (!address.IsValid())
+      continue;
+    if (!sock_diag_->GetSocketInfo(
+            IPPROTO_TCP, 1 << SocketInfo::kConnectionStateEstablished, address,
+            &msgs)) {
+      SLOG(this, 2) << __func__ << ": Failed to dump sockets for "
+                    << address.ToString();
+      continue;
+    }
+    loaded = true;
+    for (const auto& msg : msgs) {
+      SocketInfo socket_info;
+      if (ParseInetDiagMsg(msg, &socket_info))
+        info_list->push_back(socket_info);
+    }
+  }
+  return loaded;
+}
+
 bool SocketInfoReader::AppendSocketInfo(const FilePath& info_file_path,
                                         vector<SocketInfo>* info_list) {
   FileReader file_reader;
@@ -214,4 +255,50 @@ bool SocketInfoReader::ParseTimerState(const string& input,
   return true;
 }
 
+bool SocketInfoReader::ParseInetDiagMsg(const struct inet_diag_msg& msg,
+                                        SocketInfo* socket_info) {
+  IPAddress::Family family;
+  if (msg.idiag_family == AF_INET) {
+    family = IPAddress::kFamilyIPv4;
+  } else if (msg.idiag_family == AF_INET6) {
+    family = IPAddress::kFamilyIPv6;
+  } else {
+    return false;
+  }
+  const size_t addr_len = IPAddress::GetAddressLength(family);
+
+  SocketInfo info;
+  info.local_ip_address = IPAddress(
+      family, ByteString(reinterpret_cast<const unsigned char*>(
+                             msg.id.idiag_src),
+                         addr_len));
+  info.local_port = ntohs(msg.id.idiag_sport);
+  info.remote_ip_address = IPAddress(
+      family, ByteString(reinterpret_cast<const unsigned char*>(
+                             msg.id.idiag_dst),
+                         addr_len));
+  info.remote_port = ntohs(msg.id.idiag_dport);
+
+  if (msg.idiag_state > 0 &&
+      msg.idiag_state < SocketInfo::kConnectionStateMax) {
+    info.connection_state =
+        static_cast<SocketInfo::ConnectionState>(msg.idiag_state);
+  } else {
+    info.connection_state = SocketInfo::kConnectionStateUnknown;
+  }
+
+  info.transmit_queue_value = msg.idiag_wqueue;
+  info.receive_queue_value = msg.idiag_rqueue;
+
+  // sock_diag reports the same timer codes as /proc/net/tcp.
+  if (msg.idiag_timer < SocketInfo::kTimerStateMax) {
+    info.timer_state = static_cast<SocketInfo::TimerState>(msg.idiag_timer);
+  } else {
+    info.timer_state = SocketInfo::kTimerStateUnknown;
+  }
+
+  *socket_info = info;
+  return true;
+}
+
 }  // namespace shill
@@ -5,6 +5,7 @@
 #ifndef SHILL_SOCKET_INFO_READER_H_
 #define SHILL_SOCKET_INFO_READER_H_
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -14,8 +15,12 @@
 
 #include "shill/socket_info.h"
 
+struct inet_diag_msg;
+
 namespace shill {
 
+class NetlinkSockDiag;
+
 class SocketInfoReader {
  public:
   SocketInfoReader();
@@ -36,8 +41,18 @@ class SocketInfoReader {
   // if when neither /proc/net/tcp nor /proc/net/tcp6 can be read.
   virtual bool LoadTcpSocketInfo(std::vector<SocketInfo>* info_list);
 
+  // Loads information about established TCP sockets whose local address is
+  // one of |local_addresses|. Uses a NETLINK_SOCK_DIAG dump so that the state
+  // and address filtering is done by the kernel and nothing is text-parsed;
+  // falls back to LoadTcpSocketInfo() (unfiltered) when sock_diag is not
+  // available. Existing entries in |info_list| are always discarded.
+  virtual bool LoadEstablishedTcpSocketInfo(
+      const std::vector<IPAddress>& local_addresses,
+      std::vector<SocketInfo>* info_list);
+
  private:
   FRIEND_TEST(SocketInfoReaderTest, AppendSocketInfo);
+  FRIEND_TEST(SocketInfoReaderTest, ParseInetDiagMsg);
   FRIEND_TEST(SocketInfoReaderTest, ParseConnectionState);
   FRIEND_TEST(SocketInfoReaderTest, ParseIPAddress);
   FRIEND_TEST(SocketInfoReaderTest, ParseIPAddressAndPort);
@@ -61,6 +76,12 @@ class SocketInfoReader {
                             SocketInfo::ConnectionState* connection_state);
   bool ParseTimerState(const std::string& input,
                        SocketInfo::TimerState* timer_state);
+  bool ParseInetDiagMsg(const struct inet_diag_msg& msg,
+                        SocketInfo* socket_info);
+
+  // Lazily created on the first LoadEstablishedTcpSocketInfo() call.
+  std::unique_ptr<NetlinkSockDiag> sock_diag_;
+  bool sock_diag_unavailable_;
 
   DISALLOW_COPY_AND_ASSIGN(SocketInfoReader);
 };
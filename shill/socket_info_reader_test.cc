@@ -4,6 +4,10 @@
 
 #include "shill/socket_info_reader.h"
 
+#include <linux/inet_diag.h>
+#include <netinet/in.h>
+#include <string.h>
+
 #include <base/files/file_util.h>
 #include <base/files/scoped_temp_dir.h>
 #include <base/stl_util.h>
@@ -390,4 +394,43 @@ TEST_F(SocketInfoReaderTest, ParseTimerState) {
   }
 }
 
+TEST_F(SocketInfoReaderTest, ParseInetDiagMsg) {
+  SocketInfo info;
+  struct inet_diag_msg msg;
+  memset(&msg, 0, sizeof(msg));
+
+  msg.idiag_family = AF_UNIX;
+  EXPECT_FALSE(reader_.ParseInetDiagMsg(msg, &info));
+
+  IPAddress local = StringToIPv4Address(kIPv4Address_192_168_1_10);
+  IPAddress remote = StringToIPv4Address(kIPv4Address_127_0_0_1);
+  msg.idiag_family = AF_INET;
+  msg.idiag_state = SocketInfo::kConnectionStateEstablished;
+  msg.idiag_timer = SocketInfo::kTimerStateRetransmitTimerPending;
+  msg.idiag_wqueue = 10;
+  msg.idiag_rqueue = 5;
+  msg.id.idiag_sport = htons(80);
+  msg.id.idiag_dport = htons(1020);
+  memcpy(msg.id.idiag_src, local.GetConstData(), local.GetLength());
+  memcpy(msg.id.idiag_dst, remote.GetConstData(), remote.GetLength());
+  EXPECT_TRUE(reader_.ParseInetDiagMsg(msg, &info));
+  ExpectSocketInfoEqual(
+      SocketInfo(SocketInfo::kConnectionStateEstablished, local, 80, remote,
+                 1020, 10, 5, SocketInfo::kTimerStateRetransmitTimerPending),
+      info);
+
+  IPAddress local6 = StringToIPv6Address(kIPv6AddressPattern1);
+  IPAddress remote6 = StringToIPv6Address(kIPv6AddressAllOnes);
+  msg.idiag_family = AF_INET6;
+  msg.idiag_state = SocketInfo::kConnectionStateMax;
+  msg.idiag_timer = SocketInfo::kTimerStateMax;
+  memcpy(msg.id.idiag_src, local6.GetConstData(), local6.GetLength());
+  memcpy(msg.id.idiag_dst, remote6.GetConstData(), remote6.GetLength());
+  EXPECT_TRUE(reader_.ParseInetDiagMsg(msg, &info));
+  ExpectSocketInfoEqual(
+      SocketInfo(SocketInfo::kConnectionStateUnknown, local6, 80, remote6,
+                 1020, 10, 5, SocketInfo::kTimerStateUnknown),
+      info);
+}
+
 }  // namespace shill
@@ -122,8 +122,25 @@ TrafficMonitor::BuildIPPortToTxQueueLength(
 
 bool TrafficMonitor::IsCongestedTxQueues() {
   SLOG(device_, 4) << __func__;
+  // Only established sockets bound to the device's addresses are of interest,
+  // so let the kernel filter the socket table instead of reading all of it.
+  vector<IPAddress> local_addresses;
+  if (device_->ipconfig()) {
+    IPAddress address(IPAddress::kFamilyIPv4);
+    if (address.SetAddressFromString(device_->ipconfig()->properties().address))
+      local_addresses.push_back(address);
+  }
+  if (device_->ip6config()) {
+    IPAddress address(IPAddress::kFamilyIPv6);
+    if (address.SetAddressFromString(
+            device_->ip6config()->properties().address))
+      local_addresses.push_back(address);
+  }
+
   vector<SocketInfo> socket_infos;
-  if (!socket_info_reader_->LoadTcpSocketInfo(&socket_infos) ||
+  if (local_addresses.empty() ||
+      !socket_info_reader_->LoadEstablishedTcpSocketInfo(local_addresses,
+                                                         &socket_infos) ||
       socket_infos.empty()) {
     SLOG(device_, 3) << __func__ << ": Empty socket info";
     ResetCongestedTxQueuesStatsWithLogging();
@@ -26,8 +26,10 @@ using base::Unretained;
 using std::string;
 using std::vector;
 using testing::_;
+using testing::ElementsAre;
 using testing::Mock;
 using testing::NiceMock;
+using testing::Return;
 using testing::ReturnRef;
 using testing::Test;
 
@@ -109,7 +111,7 @@ class TrafficMonitorTest : public Test {
 
   void SetupMockSocketInfos(const vector<SocketInfo>& socket_infos) {
     mock_socket_infos_ = socket_infos;
-    EXPECT_CALL(*mock_socket_info_reader_, LoadTcpSocketInfo(_))
+    EXPECT_CALL(*mock_socket_info_reader_, LoadEstablishedTcpSocketInfo(_, _))
         .WillRepeatedly(
             Invoke(this, &TrafficMonitorTest::MockLoadTcpSocketInfo));
   }
@@ -122,7 +124,8 @@ class TrafficMonitorTest : public Test {
             Invoke(this, &TrafficMonitorTest::MockLoadConnectionInfo));
   }
 
-  bool MockLoadTcpSocketInfo(vector<SocketInfo>* info_list) {
+  bool MockLoadTcpSocketInfo(const vector<IPAddress>& /*local_addresses*/,
+                             vector<SocketInfo>* info_list) {
     *info_list = mock_socket_infos_;
     return true;
   }
@@ -334,6 +337,28 @@ TEST_F(TrafficMonitorTest, BuildIPPortToTxQueueLengthIPv6) {
   EXPECT_EQ(kTxQueueLength1, tx_queue_lengths[ip_port]);
 }
 
+TEST_F(TrafficMonitorTest, SampleTrafficFiltersByDeviceAddresses) {
+  EXPECT_CALL(*mock_socket_info_reader_,
+              LoadEstablishedTcpSocketInfo(ElementsAre(local_addr_), _))
+      .WillOnce(Return(false));
+  SampleTraffic();
+  Mock::VerifyAndClearExpectations(mock_socket_info_reader_);
+
+  device_->set_ip6config(ip6config_);
+  EXPECT_CALL(*mock_socket_info_reader_,
+              LoadEstablishedTcpSocketInfo(
+                  ElementsAre(local_addr_, local_addr6_), _))
+      .WillOnce(Return(false));
+  SampleTraffic();
+  Mock::VerifyAndClearExpectations(mock_socket_info_reader_);
+
+  device_->set_ipconfig(nullptr);
+  device_->set_ip6config(nullptr);
+  EXPECT_CALL(*mock_socket_info_reader_, LoadEstablishedTcpSocketInfo(_, _))
+      .Times(0);
+  SampleTraffic();
+}
+
 TEST_F(TrafficMonitorTest, SampleTrafficStuckTxQueueSameQueueLength) {
   vector<SocketInfo> socket_infos = {
       SocketInfo(SocketInfo::kConnectionStateEstablished, local_addr_,
@@ -51,6 +51,8 @@ class MockWiFiProvider : public WiFiProvider {
               OnEndpointUpdated,
               (const WiFiEndpointConstRefPtr&),
               (override));
+  MOCK_METHOD(void, StartEndpointUpdateBatch, (), (override));
+  MOCK_METHOD(void, FinishEndpointUpdateBatch, (), (override));
   MOCK_METHOD(bool, OnServiceUnloaded, (const WiFiServiceRefPtr&), (override));
   MOCK_METHOD(ByteArrays, GetHiddenSSIDList, (), (override));
   MOCK_METHOD(int, NumAutoConnectableServices, (), (override));
@@ -1279,6 +1279,9 @@ void WiFi::PendingScanResultsHandler() {
   SLOG(this, 2) << __func__ << " with " << pending_scan_results_->results.size()
                 << " results and is_complete set to "
                 << pending_scan_results_->is_complete;
+  // Let the provider coalesce the per-BSS service updates so that Manager
+  // sees each affected service once per batch of scan results.
+  provider_->StartEndpointUpdateBatch();
   for (const auto& result : pending_scan_results_->results) {
     if (result.is_removal) {
       BSSRemovedTask(result.path);
@@ -1286,6 +1289,7 @@ void WiFi::PendingScanResultsHandler() {
       BSSAddedTask(result.path, result.properties);
     }
   }
+  provider_->FinishEndpointUpdateBatch();
   if (pending_scan_results_->is_complete) {
     ScanDoneTask();
   }
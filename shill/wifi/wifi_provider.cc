@@ -197,7 +197,10 @@ bool GetServiceParametersFromStorage(const StoreInterface* storage,
 }  // namespace
 
 WiFiProvider::WiFiProvider(Manager* manager)
-    : manager_(manager), running_(false), disable_vht_(false) {}
+    : manager_(manager),
+      in_endpoint_update_batch_(false),
+      running_(false),
+      disable_vht_(false) {}
 
 WiFiProvider::~WiFiProvider() = default;
 
@@ -215,6 +218,8 @@ void WiFiProvider::Stop() {
     manager_->DeregisterService(service);
   }
   service_by_endpoint_.clear();
+  services_pending_update_.clear();
+  in_endpoint_update_batch_ = false;
   running_ = false;
 }
 
@@ -378,7 +383,7 @@ void WiFiProvider::OnEndpointAdded(const WiFiEndpointConstRefPtr& endpoint) {
   SLOG(this, 1) << "Assigned endpoint " << endpoint->bssid_string()
                 << " to service " << service->log_name() << ".";
 
-  manager_->UpdateService(service);
+  UpdateServiceForEndpointChange(service);
 }
 
 WiFiServiceRefPtr WiFiProvider::OnEndpointRemoved(
@@ -399,7 +404,7 @@ WiFiServiceRefPtr WiFiProvider::OnEndpointRemoved(
   if (service->HasEndpoints() || service->IsRemembered()) {
     // Keep services around if they are in a profile or have remaining
     // endpoints.
-    manager_->UpdateService(service);
+    UpdateServiceForEndpointChange(service);
     return nullptr;
   }
 
@@ -433,6 +438,31 @@ void WiFiProvider::OnEndpointUpdated(const WiFiEndpointConstRefPtr& endpoint) {
   OnEndpointAdded(endpoint);
 }
 
+void WiFiProvider::StartEndpointUpdateBatch() {
+  in_endpoint_update_batch_ = true;
+}
+
+void WiFiProvider::FinishEndpointUpdateBatch() {
+  in_endpoint_update_batch_ = false;
+  // Take the set first: UpdateService() may re-enter the provider.
+  std::set<WiFiServiceRefPtr> services;
+  services.swap(services_pending_update_);
+  SLOG(this, 2) << __func__ << ": updating " << services.size()
+                << " services";
+  for (const auto& service : services) {
+    manager_->UpdateService(service);
+  }
+}
+
+void WiFiProvider::UpdateServiceForEndpointChange(
+    const WiFiServiceRefPtr& service) {
+  if (in_endpoint_update_batch_) {
+    services_pending_update_.insert(service);
+    return;
+  }
+  manager_->UpdateService(service);
+}
+
 bool WiFiProvider::OnServiceUnloaded(const WiFiServiceRefPtr& service) {
   // If the service still has endpoints, it should remain in the service list.
   if (service->HasEndpoints()) {
@@ -463,20 +493,27 @@ WiFiServiceRefPtr WiFiProvider::AddService(const vector<uint8_t>& ssid,
       new WiFiService(manager_, this, ssid, mode, security_class, is_hidden);
 
   services_.push_back(service);
+  // Keep the first service registered for a key, matching the order in
+  // which a linear search of |services_| would have found it.
+  service_by_key_.emplace(GetServiceKey(ssid, mode, security_class), service);
   manager_->RegisterService(service);
   return service;
 }
 
+// static
+WiFiProvider::ServiceKey WiFiProvider::GetServiceKey(
+    const vector<uint8_t>& ssid, const string& mode, const string& security) {
+  return ServiceKey(ssid, mode, WiFiService::ComputeSecurityClass(security));
+}
+
 WiFiServiceRefPtr WiFiProvider::FindService(const vector<uint8_t>& ssid,
                                             const string& mode,
                                             const string& security) const {
-  for (const auto& service : services_) {
-    if (service->ssid() == ssid && service->mode() == mode &&
-        service->IsSecurityMatch(security)) {
-      return service;
-    }
+  const auto it = service_by_key_.find(GetServiceKey(ssid, mode, security));
+  if (it == service_by_key_.end()) {
+    return nullptr;
   }
-  return nullptr;
+  return it->second;
 }
 
 ByteArrays WiFiProvider::GetHiddenSSIDList() {
@@ -499,6 +536,23 @@ void WiFiProvider::ForgetService(const WiFiServiceRefPtr& service) {
   }
   (*it)->ResetWiFi();
   services_.erase(it);
+  services_pending_update_.erase(service);
+
+  const ServiceKey key =
+      GetServiceKey(service->ssid(), service->mode(), service->security());
+  const auto key_it = service_by_key_.find(key);
+  if (key_it == service_by_key_.end() || key_it->second != service) {
+    return;
+  }
+  service_by_key_.erase(key_it);
+  // Fall back to any other service with the same identity.
+  for (const auto& other : services_) {
+    if (GetServiceKey(other->ssid(), other->mode(), other->security()) ==
+        key) {
+      service_by_key_.emplace(key, other);
+      break;
+    }
+  }
 }
 
 void WiFiProvider::ReportRememberedNetworkCount() {
@@ -6,7 +6,9 @@
 #define SHILL_WIFI_WIFI_PROVIDER_H_
 
 #include <map>
+#include <set>
 #include <string>
+#include <tuple>
 #include <vector>
 
 #include "shill/data_types.h"
@@ -68,6 +70,13 @@ class WiFiProvider : public ProviderInterface {
   // the endpoint.
   virtual void OnEndpointUpdated(const WiFiEndpointConstRefPtr& endpoint);
 
+  // Called by a Device around the processing of a batch of scan results.
+  // While a batch is open, Manager::UpdateService() calls caused by endpoint
+  // additions and removals are coalesced so that each affected service is
+  // updated once, when the batch is finished, rather than once per BSS.
+  virtual void StartEndpointUpdateBatch();
+  virtual void FinishEndpointUpdateBatch();
+
   // Called by a WiFiService when it is unloaded and no longer visible.
   virtual bool OnServiceUnloaded(const WiFiServiceRefPtr& service);
 
@@ -95,6 +104,9 @@ class WiFiProvider : public ProviderInterface {
   friend class WiFiProviderTest;
 
   using EndpointServiceMap = std::map<const WiFiEndpoint*, WiFiServiceRefPtr>;
+  // (SSID, mode, security class) uniquely identifies a WiFi service.
+  using ServiceKey = std::tuple<std::vector<uint8_t>, std::string, std::string>;
+  using ServiceKeyMap = std::map<ServiceKey, WiFiServiceRefPtr>;
 
   // Add a service to the service_ vector and register it with the Manager.
   WiFiServiceRefPtr AddService(const std::vector<uint8_t>& ssid,
@@ -109,6 +121,14 @@ class WiFiProvider : public ProviderInterface {
                                 const std::string& mode,
                                 const std::string& security) const;
 
+  static ServiceKey GetServiceKey(const std::vector<uint8_t>& ssid,
+                                  const std::string& mode,
+                                  const std::string& security);
+
+  // Calls Manager::UpdateService() for |service|, or defers it to the end of
+  // the current endpoint update batch if one is open.
+  void UpdateServiceForEndpointChange(const WiFiServiceRefPtr& service);
+
   // Returns a WiFiServiceRefPtr for unit tests and for down-casting to a
   // ServiceRefPtr in GetService().
   WiFiServiceRefPtr GetWiFiService(const KeyValueStore& args, Error* error);
@@ -125,8 +145,15 @@ class WiFiProvider : public ProviderInterface {
   Manager* manager_;
 
   std::vector<WiFiServiceRefPtr> services_;
+  // Index over |services_| used by FindService().
+  ServiceKeyMap service_by_key_;
   EndpointServiceMap service_by_endpoint_;
 
+  // Services awaiting a Manager::UpdateService() call at the end of the
+  // current endpoint update batch.
+  std::set<WiFiServiceRefPtr> services_pending_update_;
+  bool in_endpoint_update_batch_;
+
   bool running_;
 
   // Disable 802.11ac Very High Throughput (VHT) connections.
@@ -9,10 +9,12 @@
 #include <vector>
 
 #include <base/format_macros.h>
+#include <base/logging.h>
 #include <base/stl_util.h>
 #include <base/strings/string_number_conversions.h>
 #include <base/strings/string_util.h>
 #include <base/strings/stringprintf.h>
+#include <base/timer/elapsed_timer.h>
 #include <chromeos/dbus/service_constants.h>
 #include <gtest/gtest.h>
 
@@ -242,6 +244,8 @@ class WiFiProviderTest : public testing::Test {
     MockWiFiServiceRefPtr service = new MockWiFiService(
         &manager_, &provider_, ssid, mode, security, hidden_ssid);
     provider_.services_.push_back(service);
+    provider_.service_by_key_.emplace(
+        WiFiProvider::GetServiceKey(ssid, mode, security), service);
     return service;
   }
   void AddEndpointToService(WiFiServiceRefPtr service,
@@ -979,6 +983,120 @@ TEST_F(WiFiProviderTest, OnEndpointAdded) {
   EXPECT_TRUE(service1 != service0);
 }
 
+TEST_F(WiFiProviderTest, OnEndpointAddedInBatch) {
+  provider_.Start();
+  const string ssid0("an_ssid");
+  const vector<uint8_t> ssid0_bytes(ssid0.begin(), ssid0.end());
+  const string ssid1("another_ssid");
+  const vector<uint8_t> ssid1_bytes(ssid1.begin(), ssid1.end());
+
+  // Services are created immediately but only updated once the batch ends,
+  // once per service regardless of how many endpoints were added.
+  EXPECT_CALL(manager_, RegisterService(_)).Times(2);
+  EXPECT_CALL(manager_, UpdateService(_)).Times(0);
+  provider_.StartEndpointUpdateBatch();
+  provider_.OnEndpointAdded(MakeOpenEndpoint(ssid0, "00:00:00:00:00:00", 0, 0));
+  provider_.OnEndpointAdded(MakeOpenEndpoint(ssid0, "00:00:00:00:00:01", 0, 0));
+  provider_.OnEndpointAdded(MakeOpenEndpoint(ssid1, "00:00:00:00:00:02", 0, 0));
+  Mock::VerifyAndClearExpectations(&manager_);
+  EXPECT_EQ(2, GetServices().size());
+  WiFiServiceRefPtr service0(
+      FindService(ssid0_bytes, kModeManaged, kSecurityNone));
+  WiFiServiceRefPtr service1(
+      FindService(ssid1_bytes, kModeManaged, kSecurityNone));
+  ASSERT_NE(nullptr, service0);
+  ASSERT_NE(nullptr, service1);
+
+  EXPECT_CALL(manager_, UpdateService(RefPtrMatch(service0))).Times(1);
+  EXPECT_CALL(manager_, UpdateService(RefPtrMatch(service1))).Times(1);
+  provider_.FinishEndpointUpdateBatch();
+  Mock::VerifyAndClearExpectations(&manager_);
+
+  // Outside of a batch, updates are delivered immediately again.
+  EXPECT_CALL(manager_, UpdateService(RefPtrMatch(service0))).Times(1);
+  provider_.OnEndpointAdded(MakeOpenEndpoint(ssid0, "00:00:00:00:00:03", 0, 0));
+  Mock::VerifyAndClearExpectations(&manager_);
+}
+
+TEST_F(WiFiProviderTest, OnEndpointRemovedInBatchForgetsPendingUpdate) {
+  provider_.Start();
+  const string ssid0("an_ssid");
+  WiFiEndpointRefPtr endpoint0 =
+      MakeOpenEndpoint(ssid0, "00:00:00:00:00:00", 0, 0);
+
+  EXPECT_CALL(manager_, RegisterService(_)).Times(1);
+  EXPECT_CALL(manager_, DeregisterService(_)).Times(1);
+  EXPECT_CALL(manager_, UpdateService(_)).Times(0);
+  provider_.StartEndpointUpdateBatch();
+  provider_.OnEndpointAdded(endpoint0);
+  provider_.OnEndpointRemoved(endpoint0);
+  provider_.FinishEndpointUpdateBatch();
+  Mock::VerifyAndClearExpectations(&manager_);
+  EXPECT_TRUE(GetServices().empty());
+  const vector<uint8_t> ssid0_bytes(ssid0.begin(), ssid0.end());
+  EXPECT_FALSE(FindService(ssid0_bytes, kModeManaged, kSecurityNone));
+}
+
+// Replays the scans of a busy environment: 300 BSSes spread over 60 SSIDs,
+// the first scan finding all of them and each later one adding or removing
+// a sixth. Reports the time spent per batch of scan results and the number
+// of Manager::UpdateService() calls with and without batching. Run with
+// --gtest_also_run_disabled_tests.
+TEST_F(WiFiProviderTest, DISABLED_ScanReplayBenchmark) {
+  const int kNumSsids = 60;
+  const int kBssesPerSsid = 5;
+  const int kNumScans = 200;
+  WiFiEndpoint::SecurityFlags rsn_flags;
+  rsn_flags.rsn_psk = true;
+
+  vector<WiFiEndpointRefPtr> endpoints;
+  for (int i = 0; i < kNumSsids * kBssesPerSsid; ++i) {
+    const int ssid_index = i % kNumSsids;
+    const string ssid = StringPrintf("ssid%d", ssid_index);
+    const string bssid =
+        StringPrintf("00:00:00:00:%02x:%02x", i >> 8, i & 0xff);
+    endpoints.push_back(ssid_index % 2
+                            ? MakeEndpoint(ssid, bssid, 2412, -60, rsn_flags)
+                            : MakeOpenEndpoint(ssid, bssid, 5180, -70));
+  }
+
+  int updates = 0;
+  EXPECT_CALL(manager_, RegisterService(_)).Times(AnyNumber());
+  EXPECT_CALL(manager_, DeregisterService(_)).Times(AnyNumber());
+  EXPECT_CALL(manager_, UpdateService(_))
+      .WillRepeatedly(Invoke([&updates](const ServiceRefPtr&) { ++updates; }));
+
+  for (bool batched : {false, true}) {
+    vector<bool> visible(endpoints.size(), false);
+    provider_.Start();
+    updates = 0;
+
+    base::ElapsedTimer timer;
+    for (int scan = 0; scan < kNumScans; ++scan) {
+      if (batched)
+        provider_.StartEndpointUpdateBatch();
+      for (size_t i = 0; i < endpoints.size(); ++i) {
+        if (scan > 0 && i % 6 != scan % 6)
+          continue;
+        if (visible[i])
+          provider_.OnEndpointRemoved(endpoints[i]);
+        else
+          provider_.OnEndpointAdded(endpoints[i]);
+        visible[i] = !visible[i];
+      }
+      if (batched)
+        provider_.FinishEndpointUpdateBatch();
+    }
+    base::TimeDelta elapsed = timer.Elapsed();
+
+    LOG(INFO) << (batched ? "Batched" : "Unbatched") << ": "
+              << elapsed.InMicroseconds() / kNumScans << " us and "
+              << updates / kNumScans << " UpdateService() calls per scan, "
+              << GetServices().size() << " services";
+    provider_.Stop();
+  }
+}
+
 TEST_F(WiFiProviderTest, OnEndpointAddedWithSecurity) {
   provider_.Start();
   const string ssid0("an_ssid");
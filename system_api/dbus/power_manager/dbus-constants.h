@@ -53,6 +53,7 @@ const char kChangeWifiRegDomainMethod[] = "ChangeWifiRegDomain";
 // TODO(b/166543531): Remove after migrating to BlueZ Battery Provider API.
 const char kRefreshBluetoothBatteryMethod[] = "RefreshBluetoothBattery";
 const char kGetThermalStateMethod[] = "GetThermalState";
+const char kGetSuspendTraceMethod[] = "GetSuspendTrace";
 
 // Signals emitted by powerd.
 const char kScreenBrightnessChangedSignal[] = "ScreenBrightnessChanged";
@@ -711,7 +711,8 @@ int ExportDiskImage(dbus::ObjectProxy* proxy,
                     string cryptohome_id,
                     string vm_name,
                     string export_name,
-                    string removable_media) {
+                    string removable_media,
+                    bool use_zstd) {
   if (cryptohome_id.empty()) {
     LOG(ERROR) << "Cryptohome id cannot be empty";
     return -1;
@@ -760,6 +761,7 @@ int ExportDiskImage(dbus::ObjectProxy* proxy,
   vm_tools::concierge::ExportDiskImageRequest request;
   request.set_cryptohome_id(std::move(cryptohome_id));
   request.set_disk_path(std::move(vm_name));
+  request.set_use_zstd(use_zstd);
 
   if (!writer.AppendProtoAsArrayOfBytes(request)) {
     LOG(ERROR) << "Failed to encode ExportDiskImageRequest protobuf";
@@ -1582,6 +1584,7 @@ int main(int argc, char** argv) {
   DEFINE_string(rootfs, "", "Path to the VM rootfs");
   DEFINE_string(name, "", "Name to assign to the VM");
   DEFINE_string(export_name, "", "Name to give the exported disk image");
+  DEFINE_bool(zstd, false, "Compress exported tarballs with zstd");
   DEFINE_string(import_name, "", "Name of the VM image to import");
   DEFINE_string(extra_disks, "",
                 "Additional disk images to be mounted inside the VM");
@@ -1705,7 +1708,7 @@ int main(int argc, char** argv) {
   } else if (FLAGS_export_disk) {
     return ExportDiskImage(proxy, std::move(FLAGS_cryptohome_id),
                            std::move(FLAGS_name), std::move(FLAGS_export_name),
-                           std::move(FLAGS_removable_media));
+                           std::move(FLAGS_removable_media), FLAGS_zstd);
   } else if (FLAGS_import_disk) {
     return ImportDiskImage(proxy, std::move(FLAGS_cryptohome_id),
                            std::move(FLAGS_name), std::move(FLAGS_import_name),
@@ -11,6 +11,7 @@
 #include <memory>
 #include <utility>
 
+#include <base/bind.h>
 #include <base/files/file.h>
 #include <base/files/file_util.h>
 #include <base/guid.h>
@@ -37,7 +38,8 @@ DiskImageOperation::DiskImageOperation()
     : uuid_(base::GenerateGUID()),
       status_(DISK_STATUS_FAILED),
       source_size_(0),
-      processed_size_(0) {
+      processed_size_(0),
+      start_time_(base::TimeTicks::Now()) {
   CHECK(base::IsValidGUID(uuid_));
 }
 
@@ -60,6 +62,14 @@ int DiskImageOperation::GetProgress() const {
   return 100;
 }
 
+uint64_t DiskImageOperation::GetThroughput() const {
+  double seconds = (base::TimeTicks::Now() - start_time_).InSecondsF();
+  if (seconds <= 0)
+    return 0;
+
+  return processed_size_ / seconds;
+}
+
 std::unique_ptr<PluginVmCreateOperation> PluginVmCreateOperation::Create(
     base::ScopedFD fd,
     const base::FilePath& iso_dir,
@@ -106,6 +116,7 @@ bool PluginVmCreateOperation::PrepareOutput(const base::FilePath& iso_dir) {
     return false;
   }
 
+  sparse_copier_ = SparseFileCopier::Create(in_fd_.get(), out_fd_.get());
   return true;
 }
 
@@ -121,6 +132,7 @@ void PluginVmCreateOperation::MarkFailed(const char* msg, int error_code) {
   LOG(ERROR) << vm_id_.name()
              << " PluginVm create operation failed: " << failure_reason();
 
+  sparse_copier_.reset();
   in_fd_.reset();
   out_fd_.reset();
 
@@ -130,6 +142,16 @@ void PluginVmCreateOperation::MarkFailed(const char* msg, int error_code) {
 }
 
 bool PluginVmCreateOperation::ExecuteIo(uint64_t io_limit) {
+  if (sparse_copier_) {
+    uint64_t start = sparse_copier_->position();
+    if (!sparse_copier_->CopyNext(io_limit)) {
+      MarkFailed("failed to copy data", errno);
+      return false;
+    }
+    AccumulateProcessedSize(sparse_copier_->position() - start);
+    return sparse_copier_->done();
+  }
+
   do {
     uint8_t buf[65536];
     int count = HANDLE_EINTR(read(in_fd_.get(), buf, sizeof(buf)));
@@ -159,6 +181,7 @@ bool PluginVmCreateOperation::ExecuteIo(uint64_t io_limit) {
 
 void PluginVmCreateOperation::Finalize() {
   // Close the file descriptors.
+  sparse_copier_.reset();
   in_fd_.reset();
   out_fd_.reset();
 
@@ -226,6 +249,10 @@ VmExportOperation::VmExportOperation(const VmId vm_id,
 }
 
 VmExportOperation::~VmExportOperation() {
+  // Destroying an open writer flushes the rest of the tarball through the
+  // write callback, which must not add it to an unfinished image.
+  abandoned_ = true;
+  compressor_.reset();
   // Ensure that the archive reader and writers are destroyed first, as these
   // can invoke callbacks that rely on data in this object.
   in_.reset();
@@ -274,11 +301,17 @@ bool VmExportOperation::PrepareOutput() {
       }
       break;
     case ArchiveFormat::TAR_GZ:
-      ret = archive_write_add_filter_gzip(out_.get());
-      if (ret != ARCHIVE_OK) {
-        set_failure_reason(base::StringPrintf(
-            "libarchive: failed to initialize gzip filter: %s",
-            archive_error_string(out_.get())));
+    case ArchiveFormat::TAR_ZSTD:
+      // libarchive only writes the uncompressed tarball, which is then
+      // compressed in chunks on several threads.
+      compressor_ = ParallelCompressor::Create(
+          out_fmt_ == ArchiveFormat::TAR_ZSTD
+              ? ParallelCompressor::Format::ZSTD
+              : ParallelCompressor::Format::GZIP,
+          base::BindRepeating(&VmExportOperation::WriteOutput,
+                              base::Unretained(this)));
+      if (!compressor_) {
+        set_failure_reason("failed to start compression threads");
         return false;
       }
 
@@ -317,6 +350,17 @@ ssize_t VmExportOperation::OutputFileWriteCallback(archive* a,
                                                    size_t length) {
   VmExportOperation* op = reinterpret_cast<VmExportOperation*>(data);
 
+  if (op->abandoned_)
+    return length;
+
+  if (op->compressor_) {
+    if (!op->compressor_->Write(buf, length)) {
+      archive_set_error(a, EIO, "Compression error");
+      return -1;
+    }
+    return length;
+  }
+
   ssize_t bytes_written = HANDLE_EINTR(write(op->out_fd_.get(), buf, length));
   if (bytes_written <= 0) {
     archive_set_error(a, errno, "Write error");
@@ -329,9 +373,30 @@ ssize_t VmExportOperation::OutputFileWriteCallback(archive* a,
 
 // static
 int VmExportOperation::OutputFileCloseCallback(archive* a, void* data) {
+  VmExportOperation* op = reinterpret_cast<VmExportOperation*>(data);
+
+  if (op->abandoned_)
+    return ARCHIVE_OK;
+
+  if (op->compressor_ && !op->compressor_->Finish()) {
+    archive_set_error(a, EIO, "Compression error");
+    return ARCHIVE_FATAL;
+  }
+
   return ARCHIVE_OK;
 }
 
+bool VmExportOperation::WriteOutput(const uint8_t* data, size_t size) {
+  if (!base::WriteFileDescriptor(out_fd_.get(),
+                                 reinterpret_cast<const char*>(data), size)) {
+    PLOG(ERROR) << "Failed to write exported image";
+    return false;
+  }
+
+  sha256_->Update(data, size);
+  return true;
+}
+
 void VmExportOperation::MarkFailed(const char* msg, struct archive* a) {
   set_status(DISK_STATUS_FAILED);
 
@@ -344,7 +409,10 @@ void VmExportOperation::MarkFailed(const char* msg, struct archive* a) {
 
   LOG(ERROR) << "Vm export failed: " << failure_reason();
 
-  // Release resources.
+  // Release resources. Freeing |out_| flushes the data it still buffers,
+  // which is dropped rather than appended to the partial image.
+  abandoned_ = true;
+  compressor_.reset();
   out_.reset();
   out_fd_.reset();
   out_digest_fd_.reset();
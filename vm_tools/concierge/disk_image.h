@@ -15,6 +15,7 @@
 #include <base/files/file_path.h>
 #include <base/files/scoped_file.h>
 #include <base/files/scoped_temp_dir.h>
+#include <base/time/time.h>
 #include <crypto/secure_hash.h>
 #include <dbus/exported_object.h>
 #include <dbus/object_proxy.h>
@@ -22,6 +23,8 @@
 #include <vm_concierge/proto_bindings/concierge_service.pb.h>
 
 #include "vm_tools/common/vm_id.h"
+#include "vm_tools/concierge/parallel_compressor.h"
+#include "vm_tools/concierge/sparse_file_copier.h"
 
 namespace vm_tools {
 namespace concierge {
@@ -38,6 +41,10 @@ class DiskImageOperation {
   // Report operation progress, in 0..100 range.
   int GetProgress() const;
 
+  // Report the average rate at which the source has been consumed, in bytes
+  // per second.
+  uint64_t GetThroughput() const;
+
   const std::string& uuid() const { return uuid_; }
   DiskImageStatus status() const { return status_; }
   const std::string& failure_reason() const { return failure_reason_; }
@@ -76,6 +83,9 @@ class DiskImageOperation {
   // Number of bytes consumed from the source.
   uint64_t processed_size_;
 
+  // Time the operation was created at.
+  const base::TimeTicks start_time_;
+
   DISALLOW_COPY_AND_ASSIGN(DiskImageOperation);
 };
 
@@ -117,6 +127,10 @@ class PluginVmCreateOperation : public DiskImageOperation {
   // be written to.
   base::ScopedFD out_fd_;
 
+  // Copies the image without reading its holes when the source is a regular
+  // file. Null if the image has to be streamed through a buffer instead.
+  std::unique_ptr<SparseFileCopier> sparse_copier_;
+
   // Destination directory object.
   base::ScopedTempDir output_dir_;
 
@@ -136,6 +150,7 @@ using ArchiveWriter = std::unique_ptr<struct archive, ArchiveWriteDeleter>;
 enum class ArchiveFormat {
   ZIP,
   TAR_GZ,
+  TAR_ZSTD,
 };
 
 class VmExportOperation : public DiskImageOperation {
@@ -161,6 +176,9 @@ class VmExportOperation : public DiskImageOperation {
                                          size_t length);
   static int OutputFileCloseCallback(archive* a, void* data);
 
+  // Writes |size| bytes of the final image to |out_fd_|.
+  bool WriteOutput(const uint8_t* data, size_t size);
+
   VmExportOperation(const VmId vm_id,
                     const base::FilePath disk_path,
                     base::ScopedFD out_fd,
@@ -209,6 +227,14 @@ class VmExportOperation : public DiskImageOperation {
   // Hasher to generate digest of the produced image.
   std::unique_ptr<crypto::SecureHash> sha256_;
 
+  // Compresses the tarball written by |out_| on several threads. Not used for
+  // zip archives, which compress each of their entries on their own.
+  std::unique_ptr<ParallelCompressor> compressor_;
+
+  // Set once the export has failed or is being destroyed. Makes the output
+  // callbacks drop whatever |out_| still flushes.
+  bool abandoned_ = false;
+
   DISALLOW_COPY_AND_ASSIGN(VmExportOperation);
 };
 
@@ -0,0 +1,232 @@
+// Copyright 2020 The Chromium OS Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "vm_tools/concierge/parallel_compressor.h"
+
+#include <zlib.h>
+#include <zstd.h>
+
+#include <algorithm>
+#include <utility>
+
+#include <base/bind.h>
+#include <base/logging.h>
+#include <base/memory/ptr_util.h>
+#include <base/strings/stringprintf.h>
+#include <base/synchronization/waitable_event.h>
+#include <base/system/sys_info.h>
+
+namespace vm_tools {
+namespace concierge {
+
+namespace {
+
+// Upper bound on the number of threads used by default. Exports run alongside
+// the user's session, so they shouldn't take over every core of the device.
+constexpr int kMaxDefaultThreads = 4;
+
+// Same level as libarchive uses for its gzip filter.
+constexpr int kGzipLevel = Z_DEFAULT_COMPRESSION;
+
+// Default level of the zstd command line tool.
+constexpr int kZstdLevel = 3;
+
+// Compresses |input| into a complete gzip member.
+bool CompressGzip(const std::vector<uint8_t>& input,
+                  std::vector<uint8_t>* output) {
+  z_stream stream = {};
+  // 16 is added to the window bits to write a gzip header and trailer instead
+  // of a zlib wrapper.
+  int ret = deflateInit2(&stream, kGzipLevel, Z_DEFLATED, MAX_WBITS + 16,
+                         8 /* memLevel */, Z_DEFAULT_STRATEGY);
+  if (ret != Z_OK) {
+    LOG(ERROR) << "deflateInit2 failed: " << ret;
+    return false;
+  }
+
+  output->resize(deflateBound(&stream, input.size()));
+  stream.next_in = const_cast<Bytef*>(input.data());
+  stream.avail_in = input.size();
+  stream.next_out = output->data();
+  stream.avail_out = output->size();
+  ret = deflate(&stream, Z_FINISH);
+  deflateEnd(&stream);
+  if (ret != Z_STREAM_END) {
+    LOG(ERROR) << "deflate failed: " << ret;
+    return false;
+  }
+
+  output->resize(stream.total_out);
+  return true;
+}
+
+// Compresses |input| into a complete zstd frame.
+bool CompressZstd(const std::vector<uint8_t>& input,
+                  std::vector<uint8_t>* output) {
+  output->resize(ZSTD_compressBound(input.size()));
+  size_t size = ZSTD_compress(output->data(), output->size(), input.data(),
+                              input.size(), kZstdLevel);
+  if (ZSTD_isError(size)) {
+    LOG(ERROR) << "ZSTD_compress failed: " << ZSTD_getErrorName(size);
+    return false;
+  }
+
+  output->resize(size);
+  return true;
+}
+
+}  // namespace
+
+struct ParallelCompressor::Chunk {
+  std::vector<uint8_t> input;
+  std::vector<uint8_t> output;
+  bool success = false;
+
+  // Signaled by the worker thread once |output| and |success| are set.
+  base::WaitableEvent done{base::WaitableEvent::ResetPolicy::MANUAL,
+                           base::WaitableEvent::InitialState::NOT_SIGNALED};
+};
+
+// static
+constexpr size_t ParallelCompressor::kDefaultChunkSize;
+
+// static
+std::unique_ptr<ParallelCompressor> ParallelCompressor::Create(
+    Format format,
+    int num_threads,
+    size_t chunk_size,
+    OutputCallback output_callback) {
+  auto compressor = base::WrapUnique(
+      new ParallelCompressor(format, chunk_size, std::move(output_callback)));
+  if (!compressor->StartWorkers(num_threads))
+    return nullptr;
+
+  return compressor;
+}
+
+// static
+std::unique_ptr<ParallelCompressor> ParallelCompressor::Create(
+    Format format, OutputCallback output_callback) {
+  int num_threads =
+      std::min(base::SysInfo::NumberOfProcessors(), kMaxDefaultThreads);
+  return Create(format, num_threads, kDefaultChunkSize,
+                std::move(output_callback));
+}
+
+ParallelCompressor::ParallelCompressor(Format format,
+                                       size_t chunk_size,
+                                       OutputCallback output_callback)
+    : format_(format),
+      chunk_size_(chunk_size),
+      output_callback_(std::move(output_callback)) {
+  DCHECK_GT(chunk_size_, 0);
+  input_.reserve(chunk_size_);
+}
+
+ParallelCompressor::~ParallelCompressor() {
+  // Let the workers finish the chunks they were given before the chunks are
+  // freed.
+  workers_.clear();
+}
+
+bool ParallelCompressor::StartWorkers(int num_threads) {
+  DCHECK_GT(num_threads, 0);
+  for (int i = 0; i < num_threads; i++) {
+    auto worker = std::make_unique<base::Thread>(
+        base::StringPrintf("Compressor %d", i));
+    if (!worker->Start()) {
+      LOG(ERROR) << "Failed to start compression thread";
+      return false;
+    }
+    workers_.push_back(std::move(worker));
+  }
+
+  max_chunks_ = 2 * workers_.size();
+  return true;
+}
+
+// static
+void ParallelCompressor::CompressChunk(Format format, Chunk* chunk) {
+  switch (format) {
+    case Format::GZIP:
+      chunk->success = CompressGzip(chunk->input, &chunk->output);
+      break;
+    case Format::ZSTD:
+      chunk->success = CompressZstd(chunk->input, &chunk->output);
+      break;
+  }
+
+  // The input is no longer needed, so don't keep it around until the chunk is
+  // written out.
+  std::vector<uint8_t>().swap(chunk->input);
+  chunk->done.Signal();
+}
+
+bool ParallelCompressor::Write(const void* data, size_t size) {
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  while (size > 0 && !failed_) {
+    size_t count = std::min(size, chunk_size_ - input_.size());
+    input_.insert(input_.end(), bytes, bytes + count);
+    bytes += count;
+    size -= count;
+    if (input_.size() < chunk_size_)
+      break;
+
+    if (chunks_.size() >= max_chunks_ && !WriteOldestChunk())
+      return false;
+    SubmitChunk();
+  }
+
+  // Write out whatever has been compressed already, without waiting.
+  while (!failed_ && !chunks_.empty() && chunks_.front()->done.IsSignaled())
+    WriteOldestChunk();
+
+  return !failed_;
+}
+
+bool ParallelCompressor::Finish() {
+  // An empty stream still needs one gzip member or zstd frame to be valid.
+  const bool empty_stream = output_size_ == 0 && chunks_.empty();
+  if (!failed_ && (!input_.empty() || empty_stream)) {
+    if (chunks_.size() >= max_chunks_ && !WriteOldestChunk())
+      return false;
+    SubmitChunk();
+  }
+
+  while (!failed_ && !chunks_.empty())
+    WriteOldestChunk();
+
+  return !failed_;
+}
+
+void ParallelCompressor::SubmitChunk() {
+  auto chunk = std::make_unique<Chunk>();
+  chunk->input.swap(input_);
+  input_.reserve(chunk_size_);
+
+  workers_[next_worker_]->task_runner()->PostTask(
+      FROM_HERE, base::BindOnce(&ParallelCompressor::CompressChunk, format_,
+                                base::Unretained(chunk.get())));
+  next_worker_ = (next_worker_ + 1) % workers_.size();
+  chunks_.push_back(std::move(chunk));
+}
+
+bool ParallelCompressor::WriteOldestChunk() {
+  DCHECK(!chunks_.empty());
+  std::unique_ptr<Chunk> chunk = std::move(chunks_.front());
+  chunks_.pop_front();
+
+  chunk->done.Wait();
+  if (!chunk->success ||
+      !output_callback_.Run(chunk->output.data(), chunk->output.size())) {
+    failed_ = true;
+    return false;
+  }
+
+  output_size_ += chunk->output.size();
+  return true;
+}
+
+}  // namespace concierge
+}  // namespace vm_tools
@@ -0,0 +1,118 @@
+// Copyright 2020 The Chromium OS Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef VM_TOOLS_CONCIERGE_PARALLEL_COMPRESSOR_H_
+#define VM_TOOLS_CONCIERGE_PARALLEL_COMPRESSOR_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include <base/callback.h>
+#include <base/macros.h>
+#include <base/threading/thread.h>
+
+namespace vm_tools {
+namespace concierge {
+
+// Compresses a stream of data on several threads. The input is cut into
+// chunks that are compressed independently of each other, each into a
+// complete gzip member or zstd frame, and the results are written out in
+// order. Concatenated gzip members and zstd frames are themselves valid gzip
+// and zstd streams, so the output can be read by any decompressor, at the cost
+// of a slightly worse compression ratio than compressing the stream as a
+// whole.
+//
+// All methods must be called on the same sequence. The output callback is
+// invoked from Write() and Finish().
+class ParallelCompressor {
+ public:
+  enum class Format {
+    GZIP,
+    ZSTD,
+  };
+
+  // Writes |size| bytes of compressed data. Returns false on failure.
+  using OutputCallback =
+      base::RepeatingCallback<bool(const uint8_t* data, size_t size)>;
+
+  // Size of the chunks the input is cut into.
+  static constexpr size_t kDefaultChunkSize = 1024 * 1024;
+
+  // Creates a compressor using |num_threads| worker threads. At most twice as
+  // many chunks are held in memory at a time.
+  static std::unique_ptr<ParallelCompressor> Create(
+      Format format,
+      int num_threads,
+      size_t chunk_size,
+      OutputCallback output_callback);
+
+  // Creates a compressor with the default chunk size and one worker thread
+  // per CPU, up to a limit.
+  static std::unique_ptr<ParallelCompressor> Create(
+      Format format, OutputCallback output_callback);
+
+  ~ParallelCompressor();
+
+  // Queues |size| bytes of |data| for compression. Blocks while the maximum
+  // number of chunks are being compressed. Returns false if compressing or
+  // writing out an earlier chunk failed.
+  bool Write(const void* data, size_t size);
+
+  // Compresses the remaining input and writes out all the compressed data.
+  // Returns false on failure.
+  bool Finish();
+
+  // Total number of bytes passed to the output callback.
+  uint64_t output_size() const { return output_size_; }
+
+ private:
+  struct Chunk;
+
+  ParallelCompressor(Format format,
+                     size_t chunk_size,
+                     OutputCallback output_callback);
+
+  bool StartWorkers(int num_threads);
+
+  // Compresses |chunk| on a worker thread.
+  static void CompressChunk(Format format, Chunk* chunk);
+
+  // Hands |input_| to a worker thread.
+  void SubmitChunk();
+
+  // Waits for the oldest chunk to be compressed and writes it out.
+  bool WriteOldestChunk();
+
+  const Format format_;
+  const size_t chunk_size_;
+  OutputCallback output_callback_;
+
+  // Input not yet submitted for compression.
+  std::vector<uint8_t> input_;
+
+  // Chunks submitted for compression, oldest first.
+  std::deque<std::unique_ptr<Chunk>> chunks_;
+  size_t max_chunks_ = 0;
+
+  // Worker thread the next chunk is submitted to.
+  size_t next_worker_ = 0;
+
+  uint64_t output_size_ = 0;
+  bool failed_ = false;
+
+  // Declared last so that the threads are stopped, and are done with
+  // |chunks_|, before anything else is destroyed.
+  std::vector<std::unique_ptr<base::Thread>> workers_;
+
+  DISALLOW_COPY_AND_ASSIGN(ParallelCompressor);
+};
+
+}  // namespace concierge
+}  // namespace vm_tools
+
+#endif  // VM_TOOLS_CONCIERGE_PARALLEL_COMPRESSOR_H_
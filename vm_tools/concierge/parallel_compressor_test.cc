@@ -0,0 +1,154 @@
+// Copyright 2020 The Chromium OS Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "vm_tools/concierge/parallel_compressor.h"
+
+#include <zlib.h>
+#include <zstd.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+
+#include <base/bind.h>
+#include <base/rand_util.h>
+#include <gtest/gtest.h>
+
+namespace vm_tools {
+namespace concierge {
+namespace {
+
+constexpr size_t kChunkSize = 64 * 1024;
+
+// Returns |size| bytes that are partly compressible.
+std::string MakeInput(size_t size) {
+  std::string input;
+  while (input.size() < size) {
+    input += base::RandBytesAsString(512);
+    input += std::string(1536, 'a' + input.size() % 26);
+  }
+  input.resize(size);
+  return input;
+}
+
+// Decompresses a stream of concatenated gzip members. |num_members| receives
+// the number of members in the stream.
+std::string Gunzip(const std::string& compressed, int* num_members) {
+  std::string result;
+  *num_members = 0;
+  z_stream stream = {};
+  EXPECT_EQ(Z_OK, inflateInit2(&stream, MAX_WBITS + 16));
+  stream.next_in =
+      reinterpret_cast<Bytef*>(const_cast<char*>(compressed.data()));
+  stream.avail_in = compressed.size();
+  while (true) {
+    char buf[16384];
+    stream.next_out = reinterpret_cast<Bytef*>(buf);
+    stream.avail_out = sizeof(buf);
+    int ret = inflate(&stream, Z_NO_FLUSH);
+    result.append(buf, sizeof(buf) - stream.avail_out);
+    if (ret == Z_STREAM_END) {
+      ++*num_members;
+      if (stream.avail_in == 0)
+        break;
+      EXPECT_EQ(Z_OK, inflateReset(&stream));
+    } else if (ret != Z_OK) {
+      ADD_FAILURE() << "inflate failed: " << ret;
+      break;
+    }
+  }
+  inflateEnd(&stream);
+  return result;
+}
+
+class ParallelCompressorTest : public ::testing::Test {
+ protected:
+  std::unique_ptr<ParallelCompressor> CreateCompressor(
+      ParallelCompressor::Format format) {
+    return ParallelCompressor::Create(
+        format, 3 /* num_threads */, kChunkSize,
+        base::BindRepeating(&ParallelCompressorTest::OnOutput,
+                            base::Unretained(this)));
+  }
+
+  // Feeds |input| to |compressor| in pieces that don't line up with chunks.
+  void Compress(ParallelCompressor* compressor, const std::string& input) {
+    for (size_t offset = 0; offset < input.size(); offset += 10000) {
+      size_t size = std::min<size_t>(10000, input.size() - offset);
+      ASSERT_TRUE(compressor->Write(input.data() + offset, size));
+    }
+    ASSERT_TRUE(compressor->Finish());
+    EXPECT_EQ(output_.size(), compressor->output_size());
+  }
+
+  bool OnOutput(const uint8_t* data, size_t size) {
+    output_.append(reinterpret_cast<const char*>(data), size);
+    return !fail_output_;
+  }
+
+  std::string output_;
+  bool fail_output_ = false;
+};
+
+TEST_F(ParallelCompressorTest, Gzip) {
+  const std::string input = MakeInput(10 * kChunkSize + 123);
+  auto compressor = CreateCompressor(ParallelCompressor::Format::GZIP);
+  ASSERT_TRUE(compressor);
+  Compress(compressor.get(), input);
+  EXPECT_LT(output_.size(), input.size());
+
+  // Each chunk should be a gzip member of its own, in the input's order.
+  int num_members = 0;
+  EXPECT_EQ(input, Gunzip(output_, &num_members));
+  EXPECT_EQ(11, num_members);
+}
+
+TEST_F(ParallelCompressorTest, Zstd) {
+  const std::string input = MakeInput(10 * kChunkSize + 123);
+  auto compressor = CreateCompressor(ParallelCompressor::Format::ZSTD);
+  ASSERT_TRUE(compressor);
+  Compress(compressor.get(), input);
+  EXPECT_LT(output_.size(), input.size());
+
+  // ZSTD_decompress() decodes all the concatenated frames.
+  std::string result(input.size(), '\0');
+  size_t size = ZSTD_decompress(&result[0], result.size(), output_.data(),
+                                output_.size());
+  ASSERT_FALSE(ZSTD_isError(size)) << ZSTD_getErrorName(size);
+  EXPECT_EQ(input.size(), size);
+  EXPECT_EQ(input, result);
+}
+
+// An empty input should still produce a valid stream.
+TEST_F(ParallelCompressorTest, EmptyInput) {
+  auto compressor = CreateCompressor(ParallelCompressor::Format::GZIP);
+  ASSERT_TRUE(compressor);
+  ASSERT_TRUE(compressor->Finish());
+
+  int num_members = 0;
+  EXPECT_EQ("", Gunzip(output_, &num_members));
+  EXPECT_EQ(1, num_members);
+}
+
+TEST_F(ParallelCompressorTest, OutputFailure) {
+  const std::string input = MakeInput(20 * kChunkSize);
+  auto compressor = CreateCompressor(ParallelCompressor::Format::GZIP);
+  ASSERT_TRUE(compressor);
+  fail_output_ = true;
+
+  // The failure is reported once the compressor has to wait for the first
+  // chunks to be written out.
+  bool success = true;
+  for (size_t offset = 0; offset < input.size() && success;
+       offset += kChunkSize) {
+    success = compressor->Write(input.data() + offset, kChunkSize);
+  }
+  EXPECT_FALSE(success && compressor->Finish());
+  EXPECT_FALSE(compressor->Write(input.data(), 1));
+  EXPECT_FALSE(compressor->Finish());
+}
+
+}  // namespace
+}  // namespace concierge
+}  // namespace vm_tools
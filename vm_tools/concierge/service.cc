@@ -438,6 +438,7 @@ void FormatDiskImageStatus(const DiskImageOperation* op,
   status->set_command_uuid(op->uuid());
   status->set_failure_reason(op->failure_reason());
   status->set_progress(op->GetProgress());
+  status->set_throughput(op->GetThroughput());
 }
 
 uint64_t GetFileUsage(const base::FilePath& path) {
@@ -2426,7 +2427,8 @@ std::unique_ptr<dbus::Response> Service::ExportDiskImage(
   ArchiveFormat fmt;
   switch (location) {
     case STORAGE_CRYPTOHOME_ROOT:
-      fmt = ArchiveFormat::TAR_GZ;
+      fmt = request.use_zstd() ? ArchiveFormat::TAR_ZSTD
+                               : ArchiveFormat::TAR_GZ;
       break;
     case STORAGE_CRYPTOHOME_PLUGINVM:
       fmt = ArchiveFormat::ZIP;
@@ -2558,6 +2560,7 @@ void Service::RunDiskImageOperation(std::string uuid) {
       op->status() != DISK_STATUS_IN_PROGRESS) {
     LOG(INFO) << "Disk Image Operation: UUID=" << uuid
               << " progress: " << op->GetProgress()
+              << " throughput: " << op->GetThroughput() / 1024 << " KiB/s"
               << " status: " << op->status();
 
     // Send the D-Bus signal out updating progress of the operation.
@@ -0,0 +1,174 @@
+// Copyright 2020 The Chromium OS Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "vm_tools/concierge/sparse_file_copier.h"
+
+#include <errno.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include <base/logging.h>
+#include <base/memory/ptr_util.h>
+#include <base/posix/eintr_wrapper.h>
+
+namespace vm_tools {
+namespace concierge {
+
+namespace {
+
+// Largest range handed to a single reflink or copy_file_range() call, so that
+// CopyNext() doesn't overshoot its I/O limit by much.
+constexpr off_t kMaxCopyLength = 16 * 1024 * 1024;
+
+// Size of the buffer used when neither reflinks nor copy_file_range() work.
+constexpr size_t kBufferSize = 1024 * 1024;
+
+// Returns true if |error| means that a copy method isn't supported for this
+// pair of files, rather than that the copy itself failed.
+bool IsUnsupported(int error) {
+  switch (error) {
+    case EINVAL:
+    case ENOSYS:
+    case ENOTTY:
+    case EOPNOTSUPP:
+    case EXDEV:
+      return true;
+  }
+  return false;
+}
+
+}  // namespace
+
+// static
+std::unique_ptr<SparseFileCopier> SparseFileCopier::Create(int in_fd,
+                                                           int out_fd) {
+  struct stat st;
+  if (fstat(in_fd, &st) < 0 || !S_ISREG(st.st_mode))
+    return nullptr;
+
+  // Offsets are preserved, so the source must be read from its start.
+  if (lseek(in_fd, 0, SEEK_CUR) != 0)
+    return nullptr;
+
+  // ENXIO only means that the file has no data at all. The probe moves the
+  // file offset, which callers falling back to read() rely on, so restore it.
+  bool seek_data_works = lseek(in_fd, 0, SEEK_DATA) >= 0 || errno == ENXIO;
+  if (lseek(in_fd, 0, SEEK_SET) != 0 || !seek_data_works)
+    return nullptr;
+
+  // Drop whatever the destination held, then extend it to the final size with
+  // a hole that the data extents are copied into.
+  if (HANDLE_EINTR(ftruncate(out_fd, 0)) < 0 ||
+      HANDLE_EINTR(ftruncate(out_fd, st.st_size)) < 0) {
+    PLOG(ERROR) << "Failed to resize copy destination";
+    return nullptr;
+  }
+
+  return base::WrapUnique(new SparseFileCopier(in_fd, out_fd, st.st_size));
+}
+
+SparseFileCopier::SparseFileCopier(int in_fd, int out_fd, off_t size)
+    : in_fd_(in_fd), out_fd_(out_fd), size_(size) {}
+
+SparseFileCopier::~SparseFileCopier() = default;
+
+bool SparseFileCopier::CopyNext(uint64_t io_limit) {
+  uint64_t copied = 0;
+  while (!done() && copied < io_limit) {
+    if (position_ >= extent_end_) {
+      if (!FindNextExtent())
+        return false;
+      continue;
+    }
+
+    size_t length =
+        static_cast<size_t>(std::min(extent_end_ - position_, kMaxCopyLength));
+    ssize_t ret = CopyRange(length);
+    if (ret < 0)
+      return false;
+    if (ret == 0) {
+      // The source was truncated while being copied.
+      errno = EIO;
+      return false;
+    }
+
+    position_ += ret;
+    data_copied_ += ret;
+    copied += ret;
+  }
+
+  return true;
+}
+
+bool SparseFileCopier::FindNextExtent() {
+  off_t data = lseek(in_fd_, position_, SEEK_DATA);
+  if (data < 0) {
+    if (errno != ENXIO)
+      return false;
+
+    // Only a hole is left.
+    position_ = size_;
+    return true;
+  }
+
+  off_t hole = lseek(in_fd_, data, SEEK_HOLE);
+  if (hole < 0)
+    return false;
+
+  position_ = std::min(data, size_);
+  extent_end_ = std::min(hole, size_);
+  return true;
+}
+
+ssize_t SparseFileCopier::CopyRange(size_t length) {
+  if (try_reflink_) {
+    struct file_clone_range range = {};
+    range.src_fd = in_fd_;
+    range.src_offset = position_;
+    range.src_length = length;
+    range.dest_offset = position_;
+    if (ioctl(out_fd_, FICLONERANGE, &range) == 0)
+      return length;
+    if (!IsUnsupported(errno))
+      return -1;
+
+    // Unaligned ranges are rejected with EINVAL too, but extents are aligned
+    // on file system blocks, so that doesn't happen in practice.
+    try_reflink_ = false;
+  }
+
+  if (try_copy_file_range_) {
+    loff_t in_offset = position_;
+    loff_t out_offset = position_;
+    ssize_t ret = HANDLE_EINTR(
+        copy_file_range(in_fd_, &in_offset, out_fd_, &out_offset, length, 0));
+    if (ret >= 0 || !IsUnsupported(errno))
+      return ret;
+
+    try_copy_file_range_ = false;
+  }
+
+  buffer_.resize(kBufferSize);
+  ssize_t count = HANDLE_EINTR(
+      pread(in_fd_, buffer_.data(), std::min(length, buffer_.size()),
+            position_));
+  if (count <= 0)
+    return count;
+
+  for (ssize_t written = 0; written < count;) {
+    ssize_t ret = HANDLE_EINTR(pwrite(out_fd_, buffer_.data() + written,
+                                      count - written, position_ + written));
+    if (ret < 0)
+      return -1;
+    written += ret;
+  }
+  return count;
+}
+
+}  // namespace concierge
+}  // namespace vm_tools
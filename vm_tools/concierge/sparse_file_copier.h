@@ -0,0 +1,85 @@
+// Copyright 2020 The Chromium OS Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef VM_TOOLS_CONCIERGE_SPARSE_FILE_COPIER_H_
+#define VM_TOOLS_CONCIERGE_SPARSE_FILE_COPIER_H_
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <memory>
+#include <vector>
+
+#include <base/macros.h>
+
+namespace vm_tools {
+namespace concierge {
+
+// Copies a regular file, such as a raw disk image, without reading its holes.
+// The data extents of the source are found with SEEK_DATA and SEEK_HOLE and
+// copied to the same offsets of the destination, sharing the blocks with a
+// reflink if the file system allows it and with copy_file_range() otherwise.
+// The destination is truncated to the size of the source, so the source's
+// holes stay holes.
+//
+// The copy is done in slices, so that it can be interleaved with other work
+// like DiskImageOperation::Run() requires.
+class SparseFileCopier {
+ public:
+  // Returns nullptr if |in_fd| isn't a regular file positioned at its start
+  // whose holes can be found, or if |out_fd| can't be truncated. Neither
+  // descriptor is owned.
+  static std::unique_ptr<SparseFileCopier> Create(int in_fd, int out_fd);
+
+  ~SparseFileCopier();
+
+  // Copies data until at least |io_limit| bytes of data have been copied or
+  // the end of the source has been reached. Returns false on failure, with
+  // errno set.
+  bool CopyNext(uint64_t io_limit);
+
+  // Returns true once the whole source has been copied.
+  bool done() const { return position_ >= size_; }
+
+  // Offset of the source the copy has reached, including skipped holes.
+  uint64_t position() const { return position_; }
+
+  // Number of bytes of data actually copied.
+  uint64_t data_copied() const { return data_copied_; }
+
+ private:
+  SparseFileCopier(int in_fd, int out_fd, off_t size);
+
+  // Finds the data extent at or after |position_|. Returns false on failure.
+  bool FindNextExtent();
+
+  // Copies up to |length| bytes at |position_|, using the fastest method
+  // that works. Returns the number of bytes copied, or -1 with errno set.
+  ssize_t CopyRange(size_t length);
+
+  const int in_fd_;
+  const int out_fd_;
+  const off_t size_;
+
+  off_t position_ = 0;
+  // End of the data extent containing |position_|, or 0 if |position_| may
+  // be in a hole.
+  off_t extent_end_ = 0;
+
+  uint64_t data_copied_ = 0;
+
+  // Cleared once the file system rejects the respective method.
+  bool try_reflink_ = true;
+  bool try_copy_file_range_ = true;
+
+  // Used by the pread()/pwrite() fallback.
+  std::vector<uint8_t> buffer_;
+
+  DISALLOW_COPY_AND_ASSIGN(SparseFileCopier);
+};
+
+}  // namespace concierge
+}  // namespace vm_tools
+
+#endif  // VM_TOOLS_CONCIERGE_SPARSE_FILE_COPIER_H_
@@ -0,0 +1,169 @@
+// Copyright 2020 The Chromium OS Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "vm_tools/concierge/sparse_file_copier.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <base/files/file_path.h>
+#include <base/files/file_util.h>
+#include <base/files/scoped_file.h>
+#include <base/files/scoped_temp_dir.h>
+#include <base/logging.h>
+#include <base/time/time.h>
+#include <gtest/gtest.h>
+
+namespace vm_tools {
+namespace concierge {
+
+class SparseFileCopierTest : public ::testing::Test {
+ public:
+  void SetUp() override { ASSERT_TRUE(temp_dir_.CreateUniqueTempDir()); }
+
+ protected:
+  // Creates a sparse file of |size| bytes holding |data| at each of
+  // |offsets|.
+  base::ScopedFD CreateSource(off_t size,
+                              const std::string& data,
+                              const std::vector<off_t>& offsets) {
+    base::ScopedFD fd(open(source_path().value().c_str(),
+                           O_CREAT | O_RDWR | O_TRUNC, 0600));
+    EXPECT_TRUE(fd.is_valid());
+    EXPECT_EQ(0, ftruncate(fd.get(), size));
+    for (off_t offset : offsets) {
+      EXPECT_EQ(static_cast<ssize_t>(data.size()),
+                pwrite(fd.get(), data.data(), data.size(), offset));
+    }
+    return fd;
+  }
+
+  base::ScopedFD CreateDestination() {
+    return base::ScopedFD(
+        open(dest_path().value().c_str(), O_CREAT | O_RDWR, 0600));
+  }
+
+  // Returns the number of bytes allocated to the file at |path|.
+  int64_t AllocatedSize(const base::FilePath& path) {
+    struct stat st;
+    EXPECT_EQ(0, stat(path.value().c_str(), &st));
+    return st.st_blocks * 512;
+  }
+
+  base::FilePath source_path() const {
+    return temp_dir_.GetPath().Append("source");
+  }
+  base::FilePath dest_path() const {
+    return temp_dir_.GetPath().Append("dest");
+  }
+
+  base::ScopedTempDir temp_dir_;
+};
+
+TEST_F(SparseFileCopierTest, CopyPreservesHoles) {
+  constexpr off_t kSize = 64 * 1024 * 1024 + 123;
+  const std::string data(256 * 1024, 'x');
+  base::ScopedFD in_fd =
+      CreateSource(kSize, data, {0, 10 * 1024 * 1024, kSize - 4096});
+  base::ScopedFD out_fd = CreateDestination();
+  // Leftover data in the destination should be dropped.
+  ASSERT_EQ(8, base::WriteFile(dest_path(), "leftover", 8));
+
+  std::unique_ptr<SparseFileCopier> copier =
+      SparseFileCopier::Create(in_fd.get(), out_fd.get());
+  ASSERT_TRUE(copier);
+
+  // Each call should stop after roughly |io_limit| bytes of data.
+  int calls = 0;
+  while (!copier->done()) {
+    ASSERT_TRUE(copier->CopyNext(128 * 1024));
+    ++calls;
+  }
+  EXPECT_GE(calls, 3);
+  EXPECT_EQ(static_cast<uint64_t>(kSize), copier->position());
+  EXPECT_LT(copier->data_copied(), 4 * data.size());
+
+  std::string source;
+  std::string dest;
+  ASSERT_TRUE(base::ReadFileToString(source_path(), &source));
+  ASSERT_TRUE(base::ReadFileToString(dest_path(), &dest));
+  EXPECT_EQ(source, dest);
+  EXPECT_LE(AllocatedSize(dest_path()), AllocatedSize(source_path()));
+}
+
+TEST_F(SparseFileCopierTest, EmptySource) {
+  base::ScopedFD in_fd = CreateSource(1024 * 1024, "", {});
+  base::ScopedFD out_fd = CreateDestination();
+  std::unique_ptr<SparseFileCopier> copier =
+      SparseFileCopier::Create(in_fd.get(), out_fd.get());
+  ASSERT_TRUE(copier);
+  ASSERT_TRUE(copier->CopyNext(1));
+  EXPECT_TRUE(copier->done());
+  EXPECT_EQ(0u, copier->data_copied());
+
+  int64_t size = 0;
+  ASSERT_TRUE(base::GetFileSize(dest_path(), &size));
+  EXPECT_EQ(1024 * 1024, size);
+}
+
+// Pipes can't be walked for holes, so callers have to stream them instead.
+TEST_F(SparseFileCopierTest, RejectsPipe) {
+  int fds[2];
+  ASSERT_EQ(0, pipe(fds));
+  base::ScopedFD read_fd(fds[0]);
+  base::ScopedFD write_fd(fds[1]);
+  base::ScopedFD out_fd = CreateDestination();
+  EXPECT_FALSE(SparseFileCopier::Create(read_fd.get(), out_fd.get()));
+}
+
+// Compares SparseFileCopier with a plain read()/write() loop on a mostly
+// empty 8 GiB image. Run with --gtest_also_run_disabled_tests.
+TEST_F(SparseFileCopierTest, DISABLED_Benchmark) {
+  constexpr off_t kSize = 8LL * 1024 * 1024 * 1024;
+  constexpr off_t kDataInterval = 256 * 1024 * 1024;
+  const std::string data(4 * 1024 * 1024, 'x');
+  std::vector<off_t> offsets;
+  for (off_t offset = 0; offset < kSize; offset += kDataInterval)
+    offsets.push_back(offset);
+  base::ScopedFD in_fd = CreateSource(kSize, data, offsets);
+
+  {
+    base::ScopedFD out_fd = CreateDestination();
+    const base::TimeTicks start = base::TimeTicks::Now();
+    std::unique_ptr<SparseFileCopier> copier =
+        SparseFileCopier::Create(in_fd.get(), out_fd.get());
+    ASSERT_TRUE(copier);
+    while (!copier->done())
+      ASSERT_TRUE(copier->CopyNext(1024 * 1024));
+    LOG(INFO) << "SparseFileCopier: "
+              << (base::TimeTicks::Now() - start).InMilliseconds() << " ms, "
+              << AllocatedSize(dest_path()) / (1024 * 1024) << " MiB used";
+  }
+
+  {
+    ASSERT_EQ(0, lseek(in_fd.get(), 0, SEEK_SET));
+    base::ScopedFD out_fd = CreateDestination();
+    ASSERT_EQ(0, ftruncate(out_fd.get(), 0));
+    const base::TimeTicks start = base::TimeTicks::Now();
+    std::vector<char> buf(65536);
+    while (true) {
+      ssize_t count = read(in_fd.get(), buf.data(), buf.size());
+      ASSERT_GE(count, 0);
+      if (count == 0)
+        break;
+      ASSERT_TRUE(base::WriteFileDescriptor(out_fd.get(), buf.data(), count));
+    }
+    LOG(INFO) << "read/write: "
+              << (base::TimeTicks::Now() - start).InMilliseconds() << " ms, "
+              << AllocatedSize(dest_path()) / (1024 * 1024) << " MiB used";
+  }
+}
+
+}  // namespace concierge
+}  // namespace vm_tools
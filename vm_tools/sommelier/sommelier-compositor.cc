@@ -2,8 +2,9 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
-#include "sommelier.h"          // NOLINT(build/include_directory)
-#include "sommelier-tracing.h"  // NOLINT(build/include_directory)
+#include "sommelier.h"           // NOLINT(build/include_directory)
+#include "sommelier-shm-copy.h"  // NOLINT(build/include_directory)
+#include "sommelier-tracing.h"   // NOLINT(build/include_directory)
 
 #include <assert.h>
 #include <errno.h>
@@ -173,6 +174,8 @@ static void sl_host_surface_attach(struct wl_client* client,
   struct sl_window* window;
   double scale = host->ctx->scale;
 
+  TRACE_LATENCY("surface", "sl_host_surface_attach", SL_LATENCY_SURFACE);
+
   host->current_buffer = NULL;
   host->source = NULL;
   host->target = NULL;
@@ -391,6 +394,8 @@ static void sl_host_surface_damage(struct wl_client* client,
   struct sl_output_buffer* buffer;
   int64_t x1, y1, x2, y2;
 
+  TRACE_LATENCY("surface", "sl_host_surface_damage", SL_LATENCY_SURFACE);
+
   wl_list_for_each(buffer, &host->busy_buffers, link) {
     pixman_region32_union_rect(&buffer->damage, &buffer->damage, x, y, width,
                                height);
@@ -421,6 +426,9 @@ static void sl_frame_callback_done(void* data,
   struct sl_host_callback* host =
       static_cast<sl_host_callback*>(wl_callback_get_user_data(callback));
 
+  TRACE_EVENT("surface", "sl_frame_callback_done");
+  sl_latency_record(SL_LATENCY_FRAME_CALLBACK, host->request_time);
+
   wl_callback_send_done(host->resource, time);
   wl_resource_destroy(host->resource);
 }
@@ -446,6 +454,9 @@ static void sl_host_surface_frame(struct wl_client* client,
       static_cast<sl_host_callback*>(malloc(sizeof(*host_callback)));
   assert(host_callback);
 
+  TRACE_LATENCY("surface", "sl_host_surface_frame", SL_LATENCY_SURFACE);
+
+  host_callback->request_time = sl_latency_now();
   host_callback->resource =
       wl_resource_create(client, &wl_callback_interface, 1, callback);
   wl_resource_set_implementation(host_callback->resource, NULL, host_callback,
@@ -493,7 +504,7 @@ static void sl_host_surface_commit(struct wl_client* client,
   struct sl_viewport* viewport = NULL;
   struct sl_window* window;
 
-  TRACE_EVENT("surface", "sl_host_surface_commit");
+  TRACE_LATENCY("surface", "sl_host_surface_commit", SL_LATENCY_HOST_COMMIT);
 
   if (!wl_list_empty(&host->contents_viewport))
     viewport = wl_container_of(host->contents_viewport.next, viewport, link);
@@ -512,6 +523,8 @@ static void sl_host_surface_commit(struct wl_client* client,
     double contents_scale_y = host->contents_scale;
     double contents_offset_x = 0.0;
     double contents_offset_y = 0.0;
+    struct sl_shm_copy_job jobs[SL_SHM_COPY_MAX_RECTS * 2];
+    size_t num_jobs = 0;
     pixman_box32_t* rect;
     int n;
 
@@ -541,10 +554,30 @@ static void sl_host_surface_commit(struct wl_client* client,
       }
     }
 
-    if (host->current_buffer->mmap->begin_write)
-      host->current_buffer->mmap->begin_write(host->current_buffer->mmap->fd);
-
     rect = pixman_region32_rectangles(&host->current_buffer->damage, &n);
+
+    // Copy the bounding box of the damage instead of its rectangles when it's
+    // mostly damaged anyway, or made of many rectangles. The rest of the box
+    // already matches the contents, so copying it again is harmless, and a
+    // few large copies are faster than many small ones.
+    if (n > 1) {
+      pixman_box32_t* extents =
+          pixman_region32_extents(&host->current_buffer->damage);
+      int64_t extents_area = static_cast<int64_t>(extents->x2 - extents->x1) *
+                             (extents->y2 - extents->y1);
+      int64_t damage_area = 0;
+      int i;
+
+      for (i = 0; i < n; ++i) {
+        damage_area += static_cast<int64_t>(rect[i].x2 - rect[i].x1) *
+                       (rect[i].y2 - rect[i].y1);
+      }
+      if (sl_shm_copy_use_extents(n, damage_area, extents_area)) {
+        rect = extents;
+        n = 1;
+      }
+    }
+
     while (n--) {
       int32_t x1, y1, x2, y2;
 
@@ -563,27 +596,32 @@ static void sl_host_surface_commit(struct wl_client* client,
         size_t i;
 
         for (i = 0; i < num_planes; ++i) {
-          uint8_t* src_base = src_addr + src_offset[i];
-          uint8_t* dst_base = dst_addr + dst_offset[i];
-          uint8_t* src = src_base + y1 * src_stride[i] + x1 * bpp;
-          uint8_t* dst = dst_base + y1 * dst_stride[i] + x1 * bpp;
-          int32_t width = x2 - x1;
-          int32_t height = (y2 - y1) / y_ss[i];
-          size_t bytes = width * bpp;
-
-          while (height--) {
-            memcpy(dst, src, bytes);
-            dst += dst_stride[i];
-            src += src_stride[i];
-          }
+          struct sl_shm_copy_job* job = &jobs[num_jobs++];
+
+          job->src = src_addr + src_offset[i] + y1 * src_stride[i] + x1 * bpp;
+          job->dst = dst_addr + dst_offset[i] + y1 * dst_stride[i] + x1 * bpp;
+          job->src_stride = src_stride[i];
+          job->dst_stride = dst_stride[i];
+          job->bytes = (x2 - x1) * bpp;
+          job->rows = (y2 - y1) / y_ss[i];
         }
       }
 
       ++rect;
     }
 
-    if (host->current_buffer->mmap->end_write)
-      host->current_buffer->mmap->end_write(host->current_buffer->mmap->fd);
+    {
+      TRACE_LATENCY("shm", "sl_shm_copy", SL_LATENCY_DAMAGE_COPY);
+
+      if (host->current_buffer->mmap->begin_write)
+        host->current_buffer->mmap->begin_write(
+            host->current_buffer->mmap->fd);
+
+      sl_shm_copy(host->ctx->shm_copy_pool, jobs, num_jobs);
+
+      if (host->current_buffer->mmap->end_write)
+        host->current_buffer->mmap->end_write(host->current_buffer->mmap->fd);
+    }
 
     pixman_region32_clear(&host->current_buffer->damage);
 
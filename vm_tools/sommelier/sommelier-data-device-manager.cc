@@ -2,7 +2,8 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
-#include "sommelier.h"  // NOLINT(build/include_directory)
+#include "sommelier.h"          // NOLINT(build/include_directory)
+#include "sommelier-tracing.h"  // NOLINT(build/include_directory)
 
 #include <assert.h>
 #include <errno.h>
@@ -179,6 +180,8 @@ static void sl_data_offer_receive(struct wl_client* client,
   struct sl_host_data_offer* host =
       static_cast<sl_host_data_offer*>(wl_resource_get_user_data(resource));
 
+  TRACE_LATENCY("data", "sl_data_offer_receive", SL_LATENCY_DATA_DEVICE);
+
   switch (host->ctx->data_driver) {
     case DATA_DRIVER_VIRTWL: {
       struct virtwl_ioctl_new new_pipe = {};
@@ -316,6 +319,8 @@ static void sl_data_source_send(void* data,
   struct sl_host_data_source* host = static_cast<sl_host_data_source*>(
       wl_data_source_get_user_data(data_source));
 
+  TRACE_LATENCY("data", "sl_data_source_send", SL_LATENCY_DATA_DEVICE);
+
   wl_data_source_send_send(host->resource, mime_type, fd);
   close(fd);
 }
@@ -406,6 +411,8 @@ static void sl_data_device_set_selection(struct wl_client* client,
                             wl_resource_get_user_data(source_resource))
                       : NULL;
 
+  TRACE_LATENCY("data", "sl_data_device_set_selection", SL_LATENCY_DATA_DEVICE);
+
   wl_data_device_set_selection(host->proxy,
                                host_source ? host_source->proxy : NULL, serial);
 }  // NOLINT(whitespace/indent)
@@ -428,6 +435,8 @@ static void sl_data_device_data_offer(void* data,
       static_cast<sl_host_data_offer*>(malloc(sizeof(*host_data_offer)));
   assert(host_data_offer);
 
+  TRACE_LATENCY("data", "sl_data_device_data_offer", SL_LATENCY_DATA_DEVICE);
+
   host_data_offer->ctx = host->ctx;
   host_data_offer->resource = wl_resource_create(
       wl_resource_get_client(host->resource), &wl_data_offer_interface,
@@ -502,6 +511,8 @@ static void sl_data_device_selection(void* data,
   struct sl_host_data_offer* host_data_offer =
       static_cast<sl_host_data_offer*>(wl_data_offer_get_user_data(data_offer));
 
+  TRACE_LATENCY("data", "sl_data_device_selection", SL_LATENCY_DATA_DEVICE);
+
   wl_data_device_send_selection(host->resource, host_data_offer->resource);
 }
 
@@ -532,6 +543,9 @@ static void sl_data_device_manager_create_data_source(
       static_cast<sl_host_data_source*>(malloc(sizeof(*host_data_source)));
   assert(host_data_source);
 
+  TRACE_LATENCY("data", "sl_data_device_manager_create_data_source",
+                SL_LATENCY_DATA_DEVICE);
+
   host_data_source->resource = wl_resource_create(
       client, &wl_data_source_interface, wl_resource_get_version(resource), id);
   wl_resource_set_implementation(host_data_source->resource,
@@ -65,6 +65,7 @@ static void sl_display_sync(struct wl_client* client,
       static_cast<sl_host_callback*>(malloc(sizeof(*host_callback)));
   assert(host_callback);
 
+  host_callback->request_time = 0;
   host_callback->resource =
       wl_resource_create(client, &wl_callback_interface, 1, id);
   wl_resource_set_implementation(host_callback->resource, NULL, host_callback,
@@ -0,0 +1,273 @@
+// Copyright 2020 The Chromium OS Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "sommelier-shm-copy.h"  // NOLINT(build/include_directory)
+
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Upper bound on the number of worker threads used by default. Copies are
+// limited by memory bandwidth, which a few threads already saturate.
+#define MAX_DEFAULT_THREADS 4
+
+// Amount of data each thread copies at a time.
+#define BAND_BYTES (128 * 1024)
+
+// Copies smaller than this are done on the calling thread with memcpy(), as
+// waking up workers costs more than they save and the destination may as
+// well stay in the cache.
+#define LARGE_COPY_BYTES (256 * 1024)
+
+// Rows shorter than this are copied with memcpy() even for large copies.
+#define STREAM_MIN_ROW_BYTES 256
+
+struct sl_shm_copy_band {
+  const struct sl_shm_copy_job* job;
+  size_t first_row;
+  size_t num_rows;
+};
+
+struct sl_shm_copy_pool {
+  std::vector<std::thread> threads;
+  std::mutex mutex;
+  // Signaled when a new batch of bands is ready or the pool is destroyed.
+  std::condition_variable work_cv;
+  // Signaled when the last active worker leaves a batch.
+  std::condition_variable idle_cv;
+  // Bands of the current batch, only modified while no worker is active.
+  std::vector<struct sl_shm_copy_band> bands;
+  std::atomic<size_t> next_band;
+  int stream;
+  uint64_t generation;
+  int active;
+  int quit;
+};
+
+// Copies a row without pulling the destination into the cache. The host
+// buffer is read by the host compositor, not by sommelier, so caching it only
+// evicts the client's pixels that are about to be read.
+static void sl_shm_copy_row_stream(uint8_t* dst,
+                                   const uint8_t* src,
+                                   size_t bytes) {
+#if defined(__SSE2__)
+  size_t head = (16 - (reinterpret_cast<uintptr_t>(dst) & 15)) & 15;
+
+  memcpy(dst, src, head);
+  dst += head;
+  src += head;
+  bytes -= head;
+
+  while (bytes >= 64) {
+    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+    __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 16));
+    __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 32));
+    __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 48));
+    _mm_stream_si128(reinterpret_cast<__m128i*>(dst), a);
+    _mm_stream_si128(reinterpret_cast<__m128i*>(dst + 16), b);
+    _mm_stream_si128(reinterpret_cast<__m128i*>(dst + 32), c);
+    _mm_stream_si128(reinterpret_cast<__m128i*>(dst + 48), d);
+    dst += 64;
+    src += 64;
+    bytes -= 64;
+  }
+  while (bytes >= 16) {
+    _mm_stream_si128(
+        reinterpret_cast<__m128i*>(dst),
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src)));
+    dst += 16;
+    src += 16;
+    bytes -= 16;
+  }
+#endif
+  memcpy(dst, src, bytes);
+}
+
+static void sl_shm_copy_rows(const struct sl_shm_copy_job* job,
+                             size_t first_row,
+                             size_t num_rows,
+                             int stream) {
+  const uint8_t* src = job->src + first_row * job->src_stride;
+  uint8_t* dst = job->dst + first_row * job->dst_stride;
+
+  stream = stream && job->bytes >= STREAM_MIN_ROW_BYTES;
+  while (num_rows--) {
+    if (stream)
+      sl_shm_copy_row_stream(dst, src, job->bytes);
+    else
+      memcpy(dst, src, job->bytes);
+    dst += job->dst_stride;
+    src += job->src_stride;
+  }
+
+#if defined(__SSE2__)
+  // Streaming stores are weakly ordered, so make them visible before the
+  // band is reported as done.
+  if (stream)
+    _mm_sfence();
+#endif
+}
+
+// Copies bands of the current batch until none is left.
+static void sl_shm_copy_run_bands(struct sl_shm_copy_pool* pool,
+                                  size_t num_bands) {
+  size_t i;
+
+  while ((i = pool->next_band.fetch_add(1)) < num_bands) {
+    const struct sl_shm_copy_band* band = &pool->bands[i];
+
+    sl_shm_copy_rows(band->job, band->first_row, band->num_rows, pool->stream);
+  }
+}
+
+static void sl_shm_copy_worker(struct sl_shm_copy_pool* pool) {
+  uint64_t generation = 0;
+
+  for (;;) {
+    size_t num_bands;
+    {
+      std::unique_lock<std::mutex> lock(pool->mutex);
+      pool->work_cv.wait(lock, [pool, generation] {
+        return pool->quit || pool->generation != generation;
+      });
+      if (pool->quit)
+        return;
+      generation = pool->generation;
+      num_bands = pool->bands.size();
+      ++pool->active;
+    }
+
+    sl_shm_copy_run_bands(pool, num_bands);
+
+    {
+      std::lock_guard<std::mutex> lock(pool->mutex);
+      if (--pool->active == 0)
+        pool->idle_cv.notify_one();
+    }
+  }
+}
+
+int sl_shm_copy_default_threads() {
+  int num_cpus = std::thread::hardware_concurrency();
+
+  // The event loop thread takes part in copies too.
+  return std::max(0, std::min(num_cpus - 1, MAX_DEFAULT_THREADS));
+}
+
+struct sl_shm_copy_pool* sl_shm_copy_pool_create(int num_threads) {
+  struct sl_shm_copy_pool* pool;
+  int i;
+
+  if (num_threads <= 0)
+    return NULL;
+
+  pool = new sl_shm_copy_pool();
+  pool->next_band = 0;
+  pool->stream = 0;
+  pool->generation = 0;
+  pool->active = 0;
+  pool->quit = 0;
+
+  for (i = 0; i < num_threads; ++i) {
+    try {
+      pool->threads.emplace_back(sl_shm_copy_worker, pool);
+    } catch (const std::system_error&) {
+      break;
+    }
+  }
+  if (pool->threads.empty()) {
+    delete pool;
+    return NULL;
+  }
+
+  return pool;
+}
+
+void sl_shm_copy_pool_destroy(struct sl_shm_copy_pool* pool) {
+  if (!pool)
+    return;
+
+  {
+    std::lock_guard<std::mutex> lock(pool->mutex);
+    pool->quit = 1;
+  }
+  pool->work_cv.notify_all();
+  for (auto& thread : pool->threads)
+    thread.join();
+
+  delete pool;
+}
+
+void sl_shm_copy(struct sl_shm_copy_pool* pool,
+                 const struct sl_shm_copy_job* jobs,
+                 size_t num_jobs) {
+  size_t total_bytes = 0;
+  size_t num_bands;
+  int stream;
+  size_t i;
+
+  for (i = 0; i < num_jobs; ++i)
+    total_bytes += jobs[i].bytes * jobs[i].rows;
+
+  stream = total_bytes >= LARGE_COPY_BYTES;
+  if (!pool || !stream) {
+    for (i = 0; i < num_jobs; ++i)
+      sl_shm_copy_rows(&jobs[i], 0, jobs[i].rows, stream);
+    return;
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(pool->mutex);
+
+    // A worker that woke up too late for the previous batch may still be
+    // looking at it.
+    pool->idle_cv.wait(lock, [pool] { return pool->active == 0; });
+
+    pool->bands.clear();
+    for (i = 0; i < num_jobs; ++i) {
+      const struct sl_shm_copy_job* job = &jobs[i];
+      size_t rows_per_band =
+          std::max<size_t>(1, BAND_BYTES / std::max<size_t>(1, job->bytes));
+      size_t row;
+
+      for (row = 0; row < job->rows; row += rows_per_band) {
+        struct sl_shm_copy_band band = {
+            job, row, std::min(rows_per_band, job->rows - row)};
+        pool->bands.push_back(band);
+      }
+    }
+    num_bands = pool->bands.size();
+    pool->next_band = 0;
+    pool->stream = 1;
+    ++pool->generation;
+  }
+  pool->work_cv.notify_all();
+
+  sl_shm_copy_run_bands(pool, num_bands);
+
+  // Every band has been claimed, so the copy is done once the workers that
+  // claimed the remaining ones are idle.
+  std::unique_lock<std::mutex> lock(pool->mutex);
+  pool->idle_cv.wait(lock, [pool] { return pool->active == 0; });
+}
+
+int sl_shm_copy_use_extents(int num_rects,
+                            int64_t damage_area,
+                            int64_t extents_area) {
+  if (num_rects <= 1)
+    return 0;
+
+  return num_rects > SL_SHM_COPY_MAX_RECTS ||
+         damage_area * 4 >= extents_area * 3;
+}
@@ -0,0 +1,52 @@
+// Copyright 2020 The Chromium OS Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef VM_TOOLS_SOMMELIER_SOMMELIER_SHM_COPY_H_
+#define VM_TOOLS_SOMMELIER_SOMMELIER_SHM_COPY_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Maximum number of rectangles copied separately on commit. Damage made of
+// more rectangles is copied as its bounding box instead.
+#define SL_SHM_COPY_MAX_RECTS 16
+
+struct sl_shm_copy_pool;
+
+// Copy of |rows| rows of |bytes| bytes each from |src| to |dst|.
+struct sl_shm_copy_job {
+  const uint8_t* src;
+  uint8_t* dst;
+  size_t src_stride;
+  size_t dst_stride;
+  size_t bytes;
+  size_t rows;
+};
+
+// Returns the number of worker threads used when none is requested.
+int sl_shm_copy_default_threads();
+
+// Creates a pool of |num_threads| worker threads. Returns NULL if
+// |num_threads| is zero or the threads can't be started, in which case
+// copies are done on the calling thread only.
+struct sl_shm_copy_pool* sl_shm_copy_pool_create(int num_threads);
+void sl_shm_copy_pool_destroy(struct sl_shm_copy_pool* pool);
+
+// Runs |jobs| and returns once all of them are done. Large copies are split
+// in bands of rows that are shared between the calling thread and the
+// threads of |pool|, which may be NULL.
+void sl_shm_copy(struct sl_shm_copy_pool* pool,
+                 const struct sl_shm_copy_job* jobs,
+                 size_t num_jobs);
+
+// Returns non-zero if damage made of |num_rects| rectangles that cover
+// |damage_area| pixels should be copied as its bounding box of |extents_area|
+// pixels instead. That is the case when it's made of more than
+// SL_SHM_COPY_MAX_RECTS rectangles, or when they cover at least three
+// quarters of the box anyway.
+int sl_shm_copy_use_extents(int num_rects,
+                            int64_t damage_area,
+                            int64_t extents_area);
+
+#endif  // VM_TOOLS_SOMMELIER_SOMMELIER_SHM_COPY_H_
@@ -0,0 +1,339 @@
+// Copyright 2020 The Chromium OS Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "sommelier-shm-copy.h"  // NOLINT(build/include_directory)
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace {
+
+// Same as in sommelier-shm-copy.cc.
+constexpr size_t kBandBytes = 128 * 1024;
+constexpr size_t kLargeCopyBytes = 256 * 1024;
+constexpr size_t kStreamMinRowBytes = 256;
+
+// A 2D buffer with |stride| bytes per row, surrounded by guard bytes so that
+// writes past the copied area are caught.
+class Buffer {
+ public:
+  Buffer(size_t stride, size_t rows, size_t offset)
+      : storage_(offset + stride * rows + kGuardBytes), offset_(offset) {}
+
+  uint8_t* data() { return storage_.data() + offset_; }
+
+  void Fill(uint8_t seed) {
+    for (size_t i = 0; i < storage_.size(); ++i)
+      storage_[i] = static_cast<uint8_t>(seed + i * 31 + (i >> 8));
+  }
+
+  const std::vector<uint8_t>& storage() const { return storage_; }
+
+ private:
+  static constexpr size_t kGuardBytes = 64;
+
+  std::vector<uint8_t> storage_;
+  size_t offset_;
+};
+
+// Copies |jobs| row by row with memcpy() into a copy of |dst|.
+std::vector<uint8_t> ReferenceCopy(const Buffer& dst,
+                                   const std::vector<sl_shm_copy_job>& jobs) {
+  std::vector<uint8_t> expected = dst.storage();
+
+  for (const sl_shm_copy_job& job : jobs) {
+    uint8_t* out = expected.data() + (job.dst - dst.storage().data());
+
+    for (size_t row = 0; row < job.rows; ++row) {
+      memcpy(out + row * job.dst_stride, job.src + row * job.src_stride,
+             job.bytes);
+    }
+  }
+  return expected;
+}
+
+class ShmCopyTest : public ::testing::TestWithParam<int> {
+ protected:
+  void SetUp() override { pool_ = sl_shm_copy_pool_create(GetParam()); }
+
+  void TearDown() override { sl_shm_copy_pool_destroy(pool_); }
+
+  // Copies |rows| rows of |bytes| bytes at the given misalignments and checks
+  // the result against memcpy().
+  void CheckCopy(size_t bytes,
+                 size_t rows,
+                 size_t src_offset,
+                 size_t dst_offset) {
+    size_t src_stride = bytes + 64 + src_offset;
+    size_t dst_stride = bytes + 32 + dst_offset;
+    Buffer src(src_stride, rows, src_offset);
+    Buffer dst(dst_stride, rows, dst_offset);
+
+    src.Fill(1);
+    dst.Fill(2);
+
+    sl_shm_copy_job job = {src.data(), dst.data(), src_stride,
+                           dst_stride, bytes,      rows};
+    std::vector<uint8_t> expected = ReferenceCopy(dst, {job});
+
+    sl_shm_copy(pool_, &job, 1);
+    EXPECT_EQ(expected, dst.storage())
+        << bytes << " bytes x " << rows << " rows, src offset " << src_offset
+        << ", dst offset " << dst_offset;
+  }
+
+  sl_shm_copy_pool* pool_ = nullptr;
+};
+
+TEST_P(ShmCopyTest, SmallCopy) {
+  CheckCopy(64, 4, 0, 0);
+  CheckCopy(3, 1, 1, 7);
+}
+
+TEST_P(ShmCopyTest, EmptyCopy) {
+  CheckCopy(0, 16, 0, 0);
+  CheckCopy(256, 0, 0, 0);
+  sl_shm_copy(pool_, nullptr, 0);
+}
+
+// Large copies use streaming stores for rows of at least
+// kStreamMinRowBytes, whatever the alignment of either buffer.
+TEST_P(ShmCopyTest, StreamingMatchesMemcpy) {
+  const size_t kWidths[] = {kStreamMinRowBytes, 4096, 7680};
+
+  for (size_t bytes : kWidths) {
+    size_t rows = kLargeCopyBytes / bytes + 1;
+
+    CheckCopy(bytes, rows, 0, 0);
+  }
+}
+
+TEST_P(ShmCopyTest, UnalignedRows) {
+  for (size_t src_offset = 0; src_offset < 16; src_offset += 3) {
+    for (size_t dst_offset = 0; dst_offset < 16; ++dst_offset)
+      CheckCopy(4097, 80, src_offset, dst_offset);
+  }
+}
+
+TEST_P(ShmCopyTest, OddWidthRows) {
+  const size_t kWidths[] = {1,   15,  17,   63,   65,  255,
+                            257, 999, 1023, 1025, 4099};
+
+  for (size_t bytes : kWidths) {
+    size_t rows = kLargeCopyBytes / bytes + 3;
+
+    CheckCopy(bytes, rows, 5, 11);
+  }
+}
+
+// Rows shorter than the streaming threshold in a large copy are copied with
+// memcpy(), and many of them fit in a band.
+TEST_P(ShmCopyTest, NarrowRowsInLargeCopy) {
+  CheckCopy(kStreamMinRowBytes - 1, kLargeCopyBytes / 64, 1, 2);
+}
+
+// A single job spanning many bands, with a last band shorter than the others.
+TEST_P(ShmCopyTest, BandSplitting) {
+  size_t bytes = 1920 * 4;
+  size_t rows_per_band = kBandBytes / bytes;
+
+  CheckCopy(bytes, rows_per_band * 9 + 1, 0, 0);
+  CheckCopy(bytes, rows_per_band * 9 - 1, 4, 8);
+}
+
+// Rows wider than a band are copied one row per band.
+TEST_P(ShmCopyTest, RowsWiderThanBand) {
+  CheckCopy(kBandBytes + 4, 4, 0, 4);
+}
+
+// Jobs of a batch share the bands between threads, and a copy of one job
+// must not spill into the area of another one.
+TEST_P(ShmCopyTest, MultipleJobs) {
+  const size_t kStride = 1920 * 4;
+  const size_t kRows = 1080;
+  Buffer src(kStride, kRows, 0);
+  Buffer dst(kStride, kRows, 0);
+
+  src.Fill(3);
+  dst.Fill(4);
+
+  std::vector<sl_shm_copy_job> jobs;
+  // Y plane sized and UV plane sized copies, plus a small one.
+  jobs.push_back({src.data(), dst.data(), kStride, kStride, 1280 * 4, 600});
+  jobs.push_back({src.data() + 700 * kStride + 12,
+                  dst.data() + 700 * kStride + 12, kStride, kStride, 1001,
+                  300});
+  jobs.push_back({src.data() + 1050 * kStride + 4000,
+                  dst.data() + 1050 * kStride + 4000, kStride, kStride, 40,
+                  20});
+
+  std::vector<uint8_t> expected = ReferenceCopy(dst, jobs);
+  sl_shm_copy(pool_, jobs.data(), jobs.size());
+  EXPECT_EQ(expected, dst.storage());
+}
+
+// Back to back batches, as on consecutive commits, must not see the bands of
+// the previous one.
+TEST_P(ShmCopyTest, ConsecutiveCopies) {
+  for (int i = 0; i < 20; ++i)
+    CheckCopy(2048 + i, 200 + i * 7, i % 16, (i * 5) % 16);
+}
+
+INSTANTIATE_TEST_SUITE_P(Threads, ShmCopyTest, ::testing::Values(0, 1, 3));
+
+TEST(ShmCopyPoolTest, CreateWithoutThreads) {
+  EXPECT_EQ(nullptr, sl_shm_copy_pool_create(0));
+  EXPECT_EQ(nullptr, sl_shm_copy_pool_create(-1));
+  sl_shm_copy_pool_destroy(nullptr);
+}
+
+TEST(ShmCopyPoolTest, DefaultThreads) {
+  int num_threads = sl_shm_copy_default_threads();
+
+  EXPECT_GE(num_threads, 0);
+  EXPECT_LE(num_threads, 4);
+}
+
+TEST(ShmCopyDamageTest, SingleRectIsKept) {
+  EXPECT_FALSE(sl_shm_copy_use_extents(0, 0, 0));
+  EXPECT_FALSE(sl_shm_copy_use_extents(1, 100, 100));
+}
+
+TEST(ShmCopyDamageTest, TooManyRects) {
+  EXPECT_FALSE(sl_shm_copy_use_extents(SL_SHM_COPY_MAX_RECTS, 16, 1000000));
+  EXPECT_TRUE(sl_shm_copy_use_extents(SL_SHM_COPY_MAX_RECTS + 1, 17, 1000000));
+}
+
+TEST(ShmCopyDamageTest, MostlyDamaged) {
+  // Three quarters of the bounding box is the threshold.
+  EXPECT_FALSE(sl_shm_copy_use_extents(2, 749, 1000));
+  EXPECT_TRUE(sl_shm_copy_use_extents(2, 750, 1000));
+  EXPECT_TRUE(sl_shm_copy_use_extents(2, 1000, 1000));
+}
+
+TEST(ShmCopyDamageTest, LargeAreas) {
+  // Areas of 8K surfaces don't overflow.
+  int64_t extents_area = static_cast<int64_t>(7680) * 4320;
+
+  EXPECT_FALSE(
+      sl_shm_copy_use_extents(3, extents_area * 3 / 4 - 1, extents_area));
+  EXPECT_TRUE(sl_shm_copy_use_extents(3, extents_area * 3 / 4, extents_area));
+}
+
+struct DamageRect {
+  int32_t x1, y1, x2, y2;
+};
+
+// Builds the jobs for a commit of |damage| the way sl_host_surface_commit()
+// does for a single plane buffer.
+size_t BuildJobs(const std::vector<DamageRect>& damage,
+                 const uint8_t* src,
+                 uint8_t* dst,
+                 size_t stride,
+                 size_t bpp,
+                 sl_shm_copy_job* jobs) {
+  DamageRect extents = damage[0];
+  int64_t damage_area = 0;
+  size_t num_jobs = 0;
+
+  for (const DamageRect& rect : damage) {
+    extents.x1 = std::min(extents.x1, rect.x1);
+    extents.y1 = std::min(extents.y1, rect.y1);
+    extents.x2 = std::max(extents.x2, rect.x2);
+    extents.y2 = std::max(extents.y2, rect.y2);
+    damage_area += static_cast<int64_t>(rect.x2 - rect.x1) * (rect.y2 - rect.y1);
+  }
+
+  std::vector<DamageRect> rects = damage;
+  if (sl_shm_copy_use_extents(
+          damage.size(), damage_area,
+          static_cast<int64_t>(extents.x2 - extents.x1) *
+              (extents.y2 - extents.y1))) {
+    rects.assign(1, extents);
+  }
+
+  for (const DamageRect& rect : rects) {
+    sl_shm_copy_job* job = &jobs[num_jobs++];
+
+    job->src = src + rect.y1 * stride + rect.x1 * bpp;
+    job->dst = dst + rect.y1 * stride + rect.x1 * bpp;
+    job->src_stride = stride;
+    job->dst_stride = stride;
+    job->bytes = (rect.x2 - rect.x1) * bpp;
+    job->rows = rect.y2 - rect.y1;
+  }
+  return num_jobs;
+}
+
+// Replays commits typical of a 1080p client and reports the time spent
+// copying damage with and without worker threads. Run with
+// --gtest_also_run_disabled_tests.
+TEST(ShmCopyBenchmark, DISABLED_ReplayCommits) {
+  const int32_t kWidth = 1920;
+  const int32_t kHeight = 1080;
+  const size_t kBpp = 4;
+  const size_t kStride = kWidth * kBpp;
+  const int kCommits = 300;
+
+  struct Sequence {
+    const char* name;
+    std::vector<DamageRect> damage;
+  };
+  std::vector<Sequence> sequences;
+  sequences.push_back({"full frame", {{0, 0, kWidth, kHeight}}});
+  sequences.push_back({"scroll", {{0, 80, kWidth, kHeight - 40}}});
+  sequences.push_back({"cursor blink", {{400, 300, 402, 320}}});
+  sequences.push_back(
+      {"two panes", {{0, 0, kWidth / 2, kHeight}, {kWidth / 2 + 8, 0, kWidth,
+                                                   kHeight}}});
+  // Scattered tiles, copied separately or as their bounding box depending on
+  // their number.
+  Sequence few_tiles = {"few tiles", {}};
+  Sequence many_tiles = {"many tiles", {}};
+  for (int i = 0; i < 32; ++i) {
+    int32_t x = (i % 8) * 240;
+    int32_t y = (i / 8) * 270;
+    if (i < 12)
+      few_tiles.damage.push_back({x, y, x + 64, y + 64});
+    many_tiles.damage.push_back({x, y, x + 64, y + 64});
+  }
+  sequences.push_back(few_tiles);
+  sequences.push_back(many_tiles);
+
+  std::vector<uint8_t> src(kStride * kHeight, 1);
+  std::vector<uint8_t> dst(kStride * kHeight, 2);
+  sl_shm_copy_job jobs[SL_SHM_COPY_MAX_RECTS];
+  int num_threads = std::max(1, sl_shm_copy_default_threads());
+  sl_shm_copy_pool* pool = sl_shm_copy_pool_create(num_threads);
+
+  for (const Sequence& sequence : sequences) {
+    size_t num_jobs = BuildJobs(sequence.damage, src.data(), dst.data(),
+                                kStride, kBpp, jobs);
+
+    for (sl_shm_copy_pool* p : {static_cast<sl_shm_copy_pool*>(nullptr),
+                                pool}) {
+      auto start = std::chrono::steady_clock::now();
+      for (int i = 0; i < kCommits; ++i) {
+        src[i % src.size()] = static_cast<uint8_t>(i);
+        sl_shm_copy(p, jobs, num_jobs);
+      }
+      std::chrono::duration<double, std::micro> elapsed =
+          std::chrono::steady_clock::now() - start;
+
+      printf("%-12s %zu job(s), %d thread(s): %.1f us per commit\n",
+             sequence.name, num_jobs, p ? num_threads : 0,
+             elapsed.count() / kCommits);
+    }
+  }
+
+  sl_shm_copy_pool_destroy(pool);
+}
+
+}  // namespace
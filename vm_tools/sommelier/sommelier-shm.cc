@@ -2,7 +2,8 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
-#include "sommelier.h"  // NOLINT(build/include_directory)
+#include "sommelier.h"          // NOLINT(build/include_directory)
+#include "sommelier-tracing.h"  // NOLINT(build/include_directory)
 
 #include <assert.h>
 #include <stdlib.h>
@@ -132,6 +133,8 @@ static void sl_host_shm_pool_create_host_buffer(struct wl_client* client,
   struct sl_host_shm_pool* host =
       static_cast<sl_host_shm_pool*>(wl_resource_get_user_data(resource));
 
+  TRACE_LATENCY("shm", "sl_host_shm_pool_create_host_buffer", SL_LATENCY_SHM);
+
   if (host->shm->ctx->shm_driver == SHM_DRIVER_NOOP) {
     assert(host->proxy);
     sl_create_host_buffer(client, id,
@@ -203,6 +206,8 @@ static void sl_shm_create_host_pool(struct wl_client* client,
       static_cast<sl_host_shm_pool*>(malloc(sizeof(*host_shm_pool)));
   assert(host_shm_pool);
 
+  TRACE_LATENCY("shm", "sl_shm_create_host_pool", SL_LATENCY_SHM);
+
   host_shm_pool->shm = host->shm;
   host_shm_pool->fd = -1;
   host_shm_pool->proxy = NULL;
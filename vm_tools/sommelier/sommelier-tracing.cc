@@ -4,11 +4,17 @@
 
 #include "sommelier-tracing.h"  // NOLINT(build/include_directory)
 
+#include <algorithm>
 #include <assert.h>
+#include <errno.h>
 #include <fcntl.h>
 #include <memory>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <time.h>
 #include <vector>
 
 #if defined(PERFETTO_TRACING)
@@ -77,3 +83,134 @@ void enable_tracing() {}
 void dump_trace(const char* trace_filename) {}
 
 #endif
+
+// Latency histograms.
+
+// Each power of two is split into this many buckets, which bounds the error
+// of the reported percentiles to 25%.
+#define LATENCY_SUB_BUCKET_BITS 2
+#define LATENCY_BUCKETS (64 << LATENCY_SUB_BUCKET_BITS)
+
+struct sl_latency_histogram {
+  uint64_t count;
+  uint64_t total_ns;
+  uint64_t max_ns;
+  uint64_t buckets[LATENCY_BUCKETS];
+};
+
+static const char* const latency_stage_names[SL_LATENCY_LAST + 1] = {
+    "request", "surface", "shm", "xdg_shell", "data_device",
+    "damage_copy", "host_commit", "frame_callback", "x11_event",
+};
+
+static const char* latency_summary_filename;
+static struct sl_latency_histogram latency_histograms[SL_LATENCY_LAST + 1];
+static uint64_t latency_request_start;
+
+static int latency_bucket(uint64_t ns) {
+  int msb;
+
+  if (ns < (1u << LATENCY_SUB_BUCKET_BITS))
+    return ns;
+
+  msb = 63 - __builtin_clzll(ns);
+  return ((msb - LATENCY_SUB_BUCKET_BITS + 1) << LATENCY_SUB_BUCKET_BITS) +
+         ((ns >> (msb - LATENCY_SUB_BUCKET_BITS)) &
+          ((1 << LATENCY_SUB_BUCKET_BITS) - 1));
+}
+
+// Returns the largest latency that falls in |bucket|.
+static uint64_t latency_bucket_limit(int bucket) {
+  int shift = (bucket >> LATENCY_SUB_BUCKET_BITS) - 1;
+  uint64_t base = (bucket & ((1 << LATENCY_SUB_BUCKET_BITS) - 1)) |
+                  (1 << LATENCY_SUB_BUCKET_BITS);
+
+  if (shift < 0)
+    return bucket;
+  return ((base + 1) << shift) - 1;
+}
+
+static uint64_t latency_percentile(const struct sl_latency_histogram* h,
+                                   int percent) {
+  uint64_t rank = (h->count * percent + 99) / 100;
+  uint64_t seen = 0;
+  int i;
+
+  for (i = 0; i < LATENCY_BUCKETS; ++i) {
+    seen += h->buckets[i];
+    if (seen >= rank)
+      return std::min(latency_bucket_limit(i), h->max_ns);
+  }
+  return h->max_ns;
+}
+
+void enable_latency_histograms(const char* summary_filename) {
+  if (!latency_summary_filename)
+    atexit(dump_latency_summary);
+  latency_summary_filename = summary_filename;
+}
+
+void dump_latency_summary() {
+  FILE* file;
+  int i;
+
+  if (!latency_summary_filename || !*latency_summary_filename)
+    return;
+
+  file = fopen(latency_summary_filename, "w");
+  if (!file) {
+    fprintf(stderr, "error: unable to open latency summary %s: %s\n",
+            latency_summary_filename, strerror(errno));
+    return;
+  }
+
+  fprintf(file, "%-16s %10s %10s %10s %10s %10s %10s\n", "stage (us)",
+          "count", "mean", "p50", "p90", "p99", "max");
+  for (i = 0; i <= SL_LATENCY_LAST; ++i) {
+    const struct sl_latency_histogram* h = &latency_histograms[i];
+
+    if (!h->count)
+      continue;
+    fprintf(file, "%-16s %10llu %10.1f %10.1f %10.1f %10.1f %10.1f\n",
+            latency_stage_names[i], static_cast<unsigned long long>(h->count),
+            h->total_ns / 1000.0 / h->count,
+            latency_percentile(h, 50) / 1000.0,
+            latency_percentile(h, 90) / 1000.0,
+            latency_percentile(h, 99) / 1000.0, h->max_ns / 1000.0);
+  }
+  fclose(file);
+}
+
+uint64_t sl_latency_now() {
+  struct timespec ts;
+
+  if (!latency_summary_filename)
+    return 0;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+void sl_latency_record(enum sl_latency_stage stage, uint64_t start) {
+  struct sl_latency_histogram* h = &latency_histograms[stage];
+  uint64_t ns;
+
+  if (!start)
+    return;
+
+  ns = sl_latency_now() - start;
+  ++h->count;
+  h->total_ns += ns;
+  h->max_ns = std::max(h->max_ns, ns);
+  ++h->buckets[latency_bucket(ns)];
+}
+
+void sl_latency_request_received() {
+  if (!latency_request_start)
+    latency_request_start = sl_latency_now();
+}
+
+void sl_latency_requests_flushed() {
+  sl_latency_record(SL_LATENCY_REQUEST, latency_request_start);
+  latency_request_start = 0;
+}
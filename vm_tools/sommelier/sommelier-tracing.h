@@ -5,11 +5,22 @@
 #ifndef VM_TOOLS_SOMMELIER_SOMMELIER_TRACING_H_
 #define VM_TOOLS_SOMMELIER_SOMMELIER_TRACING_H_
 
+#include <stdint.h>
+
 #if defined(PERFETTO_TRACING)
 #include <perfetto.h>
 
-PERFETTO_DEFINE_CATEGORIES(perfetto::Category("surface").SetDescription(
-    "Events for Wayland surface management"));
+PERFETTO_DEFINE_CATEGORIES(
+    perfetto::Category("surface").SetDescription(
+        "Events for Wayland surface management"),
+    perfetto::Category("shm").SetDescription(
+        "Events for Wayland shared memory pools and buffers"),
+    perfetto::Category("shell").SetDescription(
+        "Events for xdg-shell window management"),
+    perfetto::Category("data").SetDescription(
+        "Events for Wayland data devices"),
+    perfetto::Category("x11").SetDescription(
+        "Events for X11 event translation"));
 #else
 #define TRACE_EVENT(category, name)
 #endif
@@ -18,4 +29,65 @@ void initialize_tracing();
 void enable_tracing();
 void dump_trace(char const* filename);
 
+// Stages of the path between clients and the host compositor whose latency
+// is recorded.
+enum sl_latency_stage {
+  // From receiving a client request to flushing it to the host.
+  SL_LATENCY_REQUEST,
+  // Dispatch of wl_surface requests other than commit.
+  SL_LATENCY_SURFACE,
+  // Dispatch of wl_shm and wl_shm_pool requests.
+  SL_LATENCY_SHM,
+  // Dispatch of xdg-shell requests and events.
+  SL_LATENCY_XDG_SHELL,
+  // Dispatch of data device requests and events.
+  SL_LATENCY_DATA_DEVICE,
+  // Copy of the damaged part of a shm buffer to the host buffer.
+  SL_LATENCY_DAMAGE_COPY,
+  // Dispatch of wl_surface.commit, including the damage copy.
+  SL_LATENCY_HOST_COMMIT,
+  // From a client's frame request to the host's frame callback.
+  SL_LATENCY_FRAME_CALLBACK,
+  // Translation of a single X11 event.
+  SL_LATENCY_X11_EVENT,
+  SL_LATENCY_LAST = SL_LATENCY_X11_EVENT,
+};
+
+// Starts recording latencies. A summary is written to |summary_filename|
+// when sommelier exits and when dump_latency_summary() is called.
+void enable_latency_histograms(const char* summary_filename);
+void dump_latency_summary();
+
+// Returns a timestamp to pass to sl_latency_record(), or 0 if latencies
+// aren't recorded.
+uint64_t sl_latency_now();
+
+// Records the time elapsed since |start| for |stage|. Does nothing if |start|
+// is 0.
+void sl_latency_record(enum sl_latency_stage stage, uint64_t start);
+
+// Called when a client request is received and when the requests received so
+// far have been flushed to the host, to record SL_LATENCY_REQUEST.
+void sl_latency_request_received();
+void sl_latency_requests_flushed();
+
+// Records the lifetime of the enclosing scope for a stage.
+class sl_latency_scope {
+ public:
+  explicit sl_latency_scope(enum sl_latency_stage stage)
+      : stage_(stage), start_(sl_latency_now()) {}
+  sl_latency_scope(const sl_latency_scope&) = delete;
+  sl_latency_scope& operator=(const sl_latency_scope&) = delete;
+  ~sl_latency_scope() { sl_latency_record(stage_, start_); }
+
+ private:
+  const enum sl_latency_stage stage_;
+  const uint64_t start_;
+};
+
+// Traces the enclosing scope as |name| and records its duration for |stage|.
+#define TRACE_LATENCY(category, name, stage) \
+  TRACE_EVENT(category, name);               \
+  sl_latency_scope sl_latency_scope_for_trace(stage)
+
 #endif  // VM_TOOLS_SOMMELIER_SOMMELIER_TRACING_H_
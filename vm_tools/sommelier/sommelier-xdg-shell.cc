@@ -2,7 +2,8 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
-#include "sommelier.h"  // NOLINT(build/include_directory)
+#include "sommelier.h"          // NOLINT(build/include_directory)
+#include "sommelier-tracing.h"  // NOLINT(build/include_directory)
 
 #include <assert.h>
 #include <stdlib.h>
@@ -165,6 +166,8 @@ static void sl_xdg_popup_configure(void* data,
   double scale = host->ctx->scale;
   int32_t x1, y1, x2, y2;
 
+  TRACE_LATENCY("shell", "sl_xdg_popup_configure", SL_LATENCY_XDG_SHELL);
+
   x1 = x * scale;
   y1 = y * scale;
   x2 = (x + width) * scale;
@@ -363,6 +366,8 @@ static void sl_xdg_toplevel_configure(void* data,
       zxdg_toplevel_v6_get_user_data(xdg_toplevel));
   double scale = host->ctx->scale;
 
+  TRACE_LATENCY("shell", "sl_xdg_toplevel_configure", SL_LATENCY_XDG_SHELL);
+
   zxdg_toplevel_v6_send_configure(host->resource, width * scale, height * scale,
                                   states);
 }
@@ -401,6 +406,8 @@ static void sl_xdg_surface_get_toplevel(struct wl_client* client,
       static_cast<sl_host_xdg_toplevel*>(malloc(sizeof(*host_xdg_toplevel)));
   assert(host_xdg_toplevel);
 
+  TRACE_LATENCY("shell", "sl_xdg_surface_get_toplevel", SL_LATENCY_XDG_SHELL);
+
   host_xdg_toplevel->ctx = host->ctx;
   host_xdg_toplevel->resource =
       wl_resource_create(client, &zxdg_toplevel_v6_interface, 1, id);
@@ -429,6 +436,8 @@ static void sl_xdg_surface_get_popup(struct wl_client* client,
       static_cast<sl_host_xdg_popup*>(malloc(sizeof(*host_xdg_popup)));
   assert(host_xdg_popup);
 
+  TRACE_LATENCY("shell", "sl_xdg_surface_get_popup", SL_LATENCY_XDG_SHELL);
+
   host_xdg_popup->ctx = host->ctx;
   host_xdg_popup->resource =
       wl_resource_create(client, &zxdg_popup_v6_interface, 1, id);
@@ -453,6 +462,9 @@ static void sl_xdg_surface_set_window_geometry(struct wl_client* client,
   double scale = host->ctx->scale;
   int32_t x1, y1, x2, y2;
 
+  TRACE_LATENCY("shell", "sl_xdg_surface_set_window_geometry",
+                SL_LATENCY_XDG_SHELL);
+
   x1 = x / scale;
   y1 = y / scale;
   x2 = (x + width) / scale;
@@ -467,6 +479,8 @@ static void sl_xdg_surface_ack_configure(struct wl_client* client,
   struct sl_host_xdg_surface* host =
       static_cast<sl_host_xdg_surface*>(wl_resource_get_user_data(resource));
 
+  TRACE_LATENCY("shell", "sl_xdg_surface_ack_configure", SL_LATENCY_XDG_SHELL);
+
   zxdg_surface_v6_ack_configure(host->proxy, serial);
 }
 
@@ -481,6 +495,8 @@ static void sl_xdg_surface_configure(void* data,
   struct sl_host_xdg_surface* host = static_cast<sl_host_xdg_surface*>(
       zxdg_surface_v6_get_user_data(xdg_surface));
 
+  TRACE_LATENCY("shell", "sl_xdg_surface_configure", SL_LATENCY_XDG_SHELL);
+
   zxdg_surface_v6_send_configure(host->resource, serial);
 }
 
@@ -534,6 +550,8 @@ static void sl_xdg_shell_get_xdg_surface(struct wl_client* client,
       static_cast<sl_host_xdg_surface*>(malloc(sizeof(*host_xdg_surface)));
   assert(host_xdg_surface);
 
+  TRACE_LATENCY("shell", "sl_xdg_shell_get_xdg_surface", SL_LATENCY_XDG_SHELL);
+
   host_xdg_surface->ctx = host->ctx;
   host_xdg_surface->resource =
       wl_resource_create(client, &zxdg_surface_v6_interface, 1, id);
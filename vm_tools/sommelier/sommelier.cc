@@ -2,8 +2,9 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
-#include "sommelier.h"          // NOLINT(build/include_directory)
-#include "sommelier-tracing.h"  // NOLINT(build/include_directory)
+#include "sommelier.h"           // NOLINT(build/include_directory)
+#include "sommelier-shm-copy.h"  // NOLINT(build/include_directory)
+#include "sommelier-tracing.h"   // NOLINT(build/include_directory)
 
 #include <assert.h>
 #include <errno.h>
@@ -3000,6 +3001,8 @@ static int sl_handle_x_connection_event(int fd, uint32_t mask, void* data) {
   }
 
   while ((event = xcb_poll_for_event(ctx->connection))) {
+    TRACE_LATENCY("x11", "sl_handle_x_connection_event", SL_LATENCY_X11_EVENT);
+
     switch (event->response_type & ~SEND_EVENT_MASK) {
       case XCB_CREATE_NOTIFY:
         sl_handle_create_notify(
@@ -3304,11 +3307,26 @@ static int sl_handle_sigchld(int signal_number, void* data) {
 
 static int sl_handle_sigusr1(int signal_number, void* data) {
   struct sl_context* ctx = (struct sl_context*)data;
-  fprintf(stderr, "dumping trace %s\n", ctx->trace_filename);
-  dump_trace(ctx->trace_filename);
+  if (ctx->trace_filename) {
+    fprintf(stderr, "dumping trace %s\n", ctx->trace_filename);
+    dump_trace(ctx->trace_filename);
+  }
+  if (ctx->latency_summary_filename) {
+    fprintf(stderr, "dumping latency summary %s\n",
+            ctx->latency_summary_filename);
+    dump_latency_summary();
+  }
   return 1;
 }
 
+static void sl_protocol_logger(
+    void* user_data,
+    enum wl_protocol_logger_type type,
+    const struct wl_protocol_logger_message* message) {
+  if (type == WL_PROTOCOL_LOGGER_REQUEST)
+    sl_latency_request_received();
+}
+
 static void sl_execvp(const char* file,
                       char* const argv[],
                       int wayland_socked_fd) {
@@ -3430,6 +3448,16 @@ static void sl_client_destroy_notify(struct wl_listener* listener, void* data) {
   exit(0);
 }
 
+// Pool of shm copy threads to stop at exit. Sommelier exits from many event
+// handlers, so this is done by an atexit() handler rather than after the
+// event loop.
+static struct sl_shm_copy_pool* sl_exit_shm_copy_pool = NULL;
+
+static void sl_destroy_shm_copy_pool() {
+  sl_shm_copy_pool_destroy(sl_exit_shm_copy_pool);
+  sl_exit_shm_copy_pool = NULL;
+}
+
 static int sl_handle_virtwl_ctx_event(int fd, uint32_t mask, void* data) {
   struct sl_context* ctx = (struct sl_context*)data;
   uint8_t ioctl_buffer[4096];
@@ -3613,6 +3641,7 @@ static void sl_print_usage() {
       "  --socket=SOCKET\t\tName of socket to listen on\n"
       "  --display=DISPLAY\t\tWayland display to connect to\n"
       "  --shm-driver=DRIVER\t\tSHM driver to use (noop, dmabuf, virtwl)\n"
+      "  --shm-copy-threads=COUNT\tExtra threads used to copy SHM buffers\n"
       "  --data-driver=DRIVER\t\tData driver to use (noop, virtwl)\n"
       "  --scale=SCALE\t\t\tScale factor for contents\n"
       "  --dpi=[DPI[,DPI...]]\t\tDPI buckets\n"
@@ -3632,6 +3661,7 @@ static void sl_print_usage() {
 #ifdef PERFETTO_TRACING
       "  --trace-filename=PATH\t\tPath to Perfetto trace filename\n"
 #endif
+      "  --latency-summary=PATH\tPath to write a latency summary to\n"
       "  --fullscreen-mode=MODE\tDefault fullscreen behavior (immersive,"
       " plain)\n");
 }
@@ -3747,6 +3777,8 @@ int main(int argc, char** argv) {
   ctx.atoms[ATOM_WL_SELECTION] = {"_WL_SELECTION"};
   ctx.atoms[ATOM_GTK_THEME_VARIANT] = {"_GTK_THEME_VARIANT"};
   ctx.trace_filename = NULL;
+  ctx.shm_copy_pool = NULL;
+  ctx.latency_summary_filename = getenv("SOMMELIER_LATENCY_SUMMARY");
   const char* display = getenv("SOMMELIER_DISPLAY");
   const char* scale = getenv("SOMMELIER_SCALE");
   const char* dpi = getenv("SOMMELIER_DPI");
@@ -3758,6 +3790,7 @@ int main(int argc, char** argv) {
   const char* glamor = getenv("SOMMELIER_GLAMOR");
   const char* fullscreen_mode = getenv("SOMMELIER_FULLSCREEN_MODE");
   const char* shm_driver = getenv("SOMMELIER_SHM_DRIVER");
+  const char* shm_copy_threads = getenv("SOMMELIER_SHM_COPY_THREADS");
   const char* data_driver = getenv("SOMMELIER_DATA_DRIVER");
   const char* peer_cmd_prefix = getenv("SOMMELIER_PEER_CMD_PREFIX");
   const char* xwayland_cmd_prefix = getenv("SOMMELIER_XWAYLAND_CMD_PREFIX");
@@ -3803,6 +3836,8 @@ int main(int argc, char** argv) {
       display = sl_arg_value(arg);
     } else if (strstr(arg, "--shm-driver") == arg) {
       shm_driver = sl_arg_value(arg);
+    } else if (strstr(arg, "--shm-copy-threads") == arg) {
+      shm_copy_threads = sl_arg_value(arg);
     } else if (strstr(arg, "--data-driver") == arg) {
       data_driver = sl_arg_value(arg);
     } else if (strstr(arg, "--peer-pid") == arg) {
@@ -3857,6 +3892,8 @@ int main(int argc, char** argv) {
     } else if (strstr(arg, "--trace-filename") == arg) {
       ctx.trace_filename = sl_arg_value(arg);
 #endif
+    } else if (strstr(arg, "--latency-summary") == arg) {
+      ctx.latency_summary_filename = sl_arg_value(arg);
     } else if (arg[0] == '-') {
       if (strcmp(arg, "--") == 0) {
         ctx.runprog = &argv[i + 1];
@@ -4436,10 +4473,31 @@ int main(int argc, char** argv) {
   if (ctx.trace_filename) {
     initialize_tracing();
     enable_tracing();
+  }
+  if (ctx.latency_summary_filename) {
+    enable_latency_histograms(ctx.latency_summary_filename);
+    wl_display_add_protocol_logger(ctx.host_display, sl_protocol_logger, NULL);
+  }
+  if (ctx.trace_filename || ctx.latency_summary_filename) {
     ctx.sigusr1_event_source =
         wl_event_loop_add_signal(event_loop, SIGUSR1, sl_handle_sigusr1, &ctx);
   }
 
+  // The children spawned above are forked before the threads exist. In X11
+  // mode, |runprog| is only forked later, by sl_handle_display_ready_event()
+  // on this thread, while the workers may be running. That child only sets
+  // environment variables before exec and never touches the pool, so the
+  // locks the workers may hold at that point don't matter to it.
+  if (ctx.shm_driver != SHM_DRIVER_NOOP) {
+    ctx.shm_copy_pool = sl_shm_copy_pool_create(
+        shm_copy_threads ? atoi(shm_copy_threads)
+                         : sl_shm_copy_default_threads());
+    if (ctx.shm_copy_pool) {
+      sl_exit_shm_copy_pool = ctx.shm_copy_pool;
+      atexit(sl_destroy_shm_copy_pool);
+    }
+  }
+
   wl_client_add_destroy_listener(ctx.client, &client_destroy_listener);
 
   do {
@@ -4453,6 +4511,7 @@ int main(int argc, char** argv) {
     }
     if (wl_display_flush(ctx.display) < 0)
       return EXIT_FAILURE;
+    sl_latency_requests_flushed();
   } while (wl_event_loop_dispatch(event_loop, -1) != -1);
 
   return EXIT_SUCCESS;
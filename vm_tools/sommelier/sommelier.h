@@ -40,6 +40,7 @@ struct sl_keyboard_extension;
 struct sl_text_input_manager;
 struct sl_relative_pointer_manager;
 struct sl_pointer_constraints;
+struct sl_shm_copy_pool;
 struct sl_window;
 struct zaura_shell;
 struct zcr_keyboard_extension_v1;
@@ -179,6 +180,8 @@ struct sl_context {
   xcb_visualid_t visual_ids[256];
   xcb_colormap_t colormaps[256];
   const char* trace_filename;
+  struct sl_shm_copy_pool* shm_copy_pool;
+  const char* latency_summary_filename;
 };
 
 struct sl_compositor {
@@ -237,6 +240,8 @@ struct sl_viewport {
 struct sl_host_callback {
   struct wl_resource* resource;
   struct wl_callback* proxy;
+  // Time of the client's frame request, see sl_latency_now().
+  uint64_t request_time;
 };
 
 struct sl_host_surface {